@@ -156,6 +156,7 @@ static int http_api_v2(struct aclk_query_thread *query_thr, aclk_query_t query)
             if(deflateInit2(&w->response.zstream, web_gzip_level, Z_DEFLATED, 15 + 16, 8, web_gzip_strategy) == Z_OK) {
                 w->response.zinitialized = 1;
                 w->response.zoutput = 1;
+                w->response.encoding = WEB_CONTENT_ENCODING_GZIP;
             } else
                 error("Failed to initialize zlib. Proceeding without compression.");
         }
@@ -452,10 +452,8 @@ PARSER_RC pluginsd_dimension(char **words, size_t num_words, void *user)
         should_update_dimension = !rrddim_flag_check(rd, RRDDIM_FLAG_META_HIDDEN);
     }
 
-    if (should_update_dimension) {
-        rrddim_flag_set(rd, RRDDIM_FLAG_METADATA_UPDATE);
-        rrdhost_flag_set(rd->rrdset->rrdhost, RRDHOST_FLAG_METADATA_UPDATE);
-    }
+    if (should_update_dimension)
+        rrddim_metadata_updated(rd);
 
     return PARSER_RC_OK;
 }
@@ -932,8 +930,7 @@ PARSER_RC pluginsd_clabel_commit(char **words __maybe_unused, size_t num_words _
 
     rrdlabels_remove_all_unmarked(((PARSER_USER_OBJECT *)user)->chart_rrdlabels_linked_temporarily);
 
-    rrdset_flag_set(st, RRDSET_FLAG_METADATA_UPDATE);
-    rrdhost_flag_set(st->rrdhost, RRDHOST_FLAG_METADATA_UPDATE);
+    rrdset_metadata_updated(st);
 
     ((PARSER_USER_OBJECT *)user)->chart_rrdlabels_linked_temporarily = NULL;
     return PARSER_RC_OK;
@@ -60,6 +60,8 @@ typedef struct statsd_histogram_extensions {
     size_t size;
     size_t used;
     NETDATA_DOUBLE *values;   // dynamic array of values collected
+
+    QUANTILE_SKETCH *sketch;  // when quantile sketches are enabled, this is used instead of values
 } STATSD_METRIC_HISTOGRAM_EXTENSIONS;
 
 typedef struct statsd_metric_histogram { // histogram and timer
@@ -68,6 +70,7 @@ typedef struct statsd_metric_histogram { // histogram and timer
 
 typedef struct statsd_metric_set {
     DICTIONARY *dict;
+    HYPERLOGLOG *hll;         // when hyperloglog is enabled, this is used instead of dict
     size_t unique;
 } STATSD_METRIC_SET;
 
@@ -236,8 +239,17 @@ typedef struct statsd_app {
 struct collection_thread_status {
     SPINLOCK spinlock;
     bool running;
+    bool started;                   // the thread has been created, so it has to be joined
     size_t max_sockets;
 
+    LISTEN_SOCKETS *sockets;        // the sockets this thread polls
+
+    // thread local aggregation of gauges, counters and meters, when collector threads are sharded
+    SPINLOCK local_spinlock;        // held by the collector while processing, and by the flushing thread while merging
+    DICTIONARY *local_gauges;
+    DICTIONARY *local_counters;
+    DICTIONARY *local_meters;
+
     netdata_thread_t thread;
 };
 
@@ -278,9 +290,15 @@ static struct statsd {
     size_t histogram_increase_step;
     double histogram_percentile;
     char *histogram_percentile_str;
+    int histogram_sketches;
+    double histogram_sketch_relative_error;
+    int set_hyperloglog;
+    size_t set_hyperloglog_precision;
     size_t dictionary_max_unique;
 
     int threads;
+    bool sharded;                   // each collector thread has its own SO_REUSEPORT udp sockets and aggregation tables
+    SPINLOCK shared_spinlock;       // serializes the collector threads on the shared metrics, when sharded
     struct collection_thread_status *collection_threads_status;
 
     LISTEN_SOCKETS sockets;
@@ -353,6 +371,10 @@ static struct statsd {
         .apps = NULL,
         .histogram_percentile = 95.0,
         .histogram_increase_step = 10,
+        .histogram_sketches = 0,
+        .histogram_sketch_relative_error = QUANTILE_SKETCH_DEFAULT_RELATIVE_ERROR,
+        .set_hyperloglog = 0,
+        .set_hyperloglog_precision = HYPERLOGLOG_DEFAULT_PRECISION,
         .dictionary_max_unique = 200,
         .threads = 0,
         .collection_threads_status = NULL,
@@ -384,6 +406,11 @@ static void dictionary_metric_insert_callback(const DICTIONARY_ITEM *item, void
     if (m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
         m->histogram.ext = callocz(1,sizeof(STATSD_METRIC_HISTOGRAM_EXTENSIONS));
         netdata_mutex_init(&m->histogram.ext->mutex);
+
+        if(statsd.histogram_sketches) {
+            m->histogram.ext->sketch = mallocz(sizeof(QUANTILE_SKETCH));
+            quantile_sketch_init(m->histogram.ext->sketch, statsd.histogram_sketch_relative_error, QUANTILE_SKETCH_DEFAULT_MAX_BUCKETS);
+        }
     }
 
     __atomic_fetch_add(&index->metrics, 1, __ATOMIC_RELAXED);
@@ -395,16 +422,32 @@ static void dictionary_metric_delete_callback(const DICTIONARY_ITEM *item, void
     STATSD_METRIC *m = (STATSD_METRIC *)value;
 
     if(m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
+        if(m->histogram.ext->sketch) {
+            quantile_sketch_free(m->histogram.ext->sketch);
+            freez(m->histogram.ext->sketch);
+        }
+        freez(m->histogram.ext->values);
         freez(m->histogram.ext);
         m->histogram.ext = NULL;
     }
+    else if(m->type == STATSD_METRIC_TYPE_SET) {
+        if(m->set.hll) {
+            hyperloglog_free(m->set.hll);
+            freez(m->set.hll);
+            m->set.hll = NULL;
+        }
+        if(m->set.dict) {
+            dictionary_destroy(m->set.dict);
+            m->set.dict = NULL;
+        }
+    }
 
     freez(m->units);
     freez(m->family);
     freez(m->dimname);
 }
 
-static inline STATSD_METRIC *statsd_find_or_add_metric(STATSD_INDEX *index, const char *name) {
+static inline STATSD_METRIC *statsd_get_or_create_metric(STATSD_INDEX *index, const char *name) {
     debug(D_STATSD, "searching for metric '%s' under '%s'", name, index->name);
 
 #ifdef STATSD_MULTITHREADED
@@ -419,6 +462,11 @@ static inline STATSD_METRIC *statsd_find_or_add_metric(STATSD_INDEX *index, cons
     STATSD_METRIC *m = dictionary_set(index->dict, name, NULL, sizeof(STATSD_METRIC));
 #endif
 
+    return m;
+}
+
+static inline STATSD_METRIC *statsd_find_or_add_metric(STATSD_INDEX *index, const char *name) {
+    STATSD_METRIC *m = statsd_get_or_create_metric(index, name);
     index->events++;
     return m;
 }
@@ -538,6 +586,13 @@ static inline void statsd_process_histogram_or_timer(STATSD_METRIC *m, const cha
 
     if(unlikely(m->reset)) {
         m->histogram.ext->used = 0;
+
+        if(m->histogram.ext->sketch) {
+            netdata_mutex_lock(&m->histogram.ext->mutex);
+            quantile_sketch_reset(m->histogram.ext->sketch);
+            netdata_mutex_unlock(&m->histogram.ext->mutex);
+        }
+
         statsd_reset_metric(m);
     }
 
@@ -551,6 +606,15 @@ static inline void statsd_process_histogram_or_timer(STATSD_METRIC *m, const cha
         if(unlikely(isgreater(sampling_rate, 1.0))) sampling_rate = 1.0;
 
         long long samples = llrintndd(1.0 / sampling_rate);
+
+        if(m->histogram.ext->sketch) {
+            // the sampled value is added once, weighted by the samples it represents
+            netdata_mutex_lock(&m->histogram.ext->mutex);
+            quantile_sketch_add(m->histogram.ext->sketch, v, (NETDATA_DOUBLE)samples);
+            netdata_mutex_unlock(&m->histogram.ext->mutex);
+            samples = 0;
+        }
+
         while(samples-- > 0) {
 
             if(unlikely(m->histogram.ext->used == m->histogram.ext->size)) {
@@ -591,9 +655,29 @@ static inline void statsd_process_set(STATSD_METRIC *m, const char *value) {
             dictionary_destroy(m->set.dict);
             m->set.dict = NULL;
         }
+        if(m->set.hll) {
+            hyperloglog_reset(m->set.hll);
+            m->set.unique = 0;
+        }
         statsd_reset_metric(m);
     }
 
+    if(statsd.set_hyperloglog) {
+        // fixed memory per metric, the unique values are estimated at flush time
+        if(unlikely(!m->set.hll)) {
+            m->set.hll = mallocz(sizeof(HYPERLOGLOG));
+            hyperloglog_init(m->set.hll, (uint8_t)statsd.set_hyperloglog_precision);
+            m->set.unique = 0;
+        }
+
+        if(likely(!value_is_zinit(value))) {
+            hyperloglog_add(m->set.hll, value, strlen(value));
+            m->events++;
+            m->count++;
+        }
+        return;
+    }
+
     if (unlikely(!m->set.dict)) {
         m->set.dict   = dictionary_create(STATSD_DICTIONARY_OPTIONS);
         dictionary_register_insert_callback(m->set.dict, dictionary_metric_set_value_insert_callback, m);
@@ -696,6 +780,120 @@ static inline const char *statsd_parse_field_trim(const char *start, char *end)
     return start;
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+// thread local aggregation, when collector threads are sharded
+//
+// Each collector thread aggregates gauges, counters and meters in its own tables,
+// without touching the shared metrics. The flushing thread merges them into
+// the shared metrics, just before flushing them.
+
+typedef struct statsd_local_metric {
+    STATSD_METRIC *m;               // the shared metric this is merged into
+    size_t count;                   // the number of events since the last merge
+    bool absolute;                  // gauges: an absolute value has been received since the last merge
+    NETDATA_DOUBLE gauge;           // gauges: the last absolute value, plus the relative changes received after it
+    collected_number counter;       // counters and meters: the sum of the values received
+} STATSD_LOCAL_METRIC;
+
+// set only on collector threads, when sharded
+static __thread struct collection_thread_status *statsd_thread_status = NULL;
+
+static inline STATSD_LOCAL_METRIC *statsd_find_or_add_local_metric(DICTIONARY *local, STATSD_INDEX *index, const char *name) {
+    STATSD_LOCAL_METRIC *lm = dictionary_get(local, name);
+
+    if(unlikely(!lm)) {
+        STATSD_LOCAL_METRIC tmp = {
+            .m = statsd_get_or_create_metric(index, name),
+        };
+        lm = dictionary_set(local, name, &tmp, sizeof(tmp));
+    }
+
+    return lm;
+}
+
+static inline void statsd_local_process_gauge(STATSD_LOCAL_METRIC *lm, const char *value, const char *sampling) {
+    if(!is_metric_useful_for_collection(lm->m)) return;
+
+    if(unlikely(!value || !*value)) {
+        error("STATSD: metric '%s' of type gauge, with empty value is ignored.", lm->m->name);
+        return;
+    }
+
+    if(unlikely(value_is_zinit(value))) {
+        // magic loading of metric, without affecting anything
+    }
+    else {
+        if (unlikely(*value == '+' || *value == '-'))
+            lm->gauge += statsd_parse_float(value, 1.0) / statsd_parse_sampling_rate(sampling);
+        else {
+            lm->gauge = statsd_parse_float(value, 1.0);
+            lm->absolute = true;
+        }
+
+        lm->count++;
+    }
+}
+
+static inline void statsd_local_process_counter_or_meter(STATSD_LOCAL_METRIC *lm, const char *value, const char *sampling) {
+    if(!is_metric_useful_for_collection(lm->m)) return;
+
+    // we accept empty values for counters
+
+    if(unlikely(value_is_zinit(value))) {
+        // magic loading of metric, without affecting anything
+    }
+    else {
+        lm->counter += llrintndd((NETDATA_DOUBLE) statsd_parse_int(value, 1) / statsd_parse_sampling_rate(sampling));
+        lm->count++;
+    }
+}
+
+static inline void statsd_merge_local_index(DICTIONARY *local, STATSD_INDEX *index) {
+    STATSD_LOCAL_METRIC *lm;
+    dfe_start_read(local, lm) {
+        if(!lm->count) continue;
+
+        STATSD_METRIC *m = lm->m;
+        if(unlikely(m->reset)) statsd_reset_metric(m);
+
+        if(index->type == STATSD_METRIC_TYPE_GAUGE) {
+            if(lm->absolute)
+                m->gauge.value = lm->gauge;
+            else
+                m->gauge.value += lm->gauge;
+        }
+        else
+            m->counter.value += lm->counter;
+
+        m->events += (collected_number)lm->count;
+        m->count += lm->count;
+        index->events += lm->count;
+
+        lm->count = 0;
+        lm->absolute = false;
+        lm->gauge = 0.0;
+        lm->counter = 0;
+    }
+    dfe_done(lm);
+}
+
+static void statsd_merge_thread_local_metrics(void) {
+    for(int i = 0; i < statsd.threads ; i++) {
+        struct collection_thread_status *status = &statsd.collection_threads_status[i];
+
+        netdata_spinlock_lock(&status->local_spinlock);
+        statsd_merge_local_index(status->local_gauges, &statsd.gauges);
+        statsd_merge_local_index(status->local_counters, &statsd.counters);
+        statsd_merge_local_index(status->local_meters, &statsd.meters);
+        netdata_spinlock_unlock(&status->local_spinlock);
+    }
+}
+
+#define statsd_shared_lock() do { if(statsd_thread_status) netdata_spinlock_lock(&statsd.shared_spinlock); } while(0)
+#define statsd_shared_unlock() do { if(statsd_thread_status) netdata_spinlock_unlock(&statsd.shared_spinlock); } while(0)
+
+// --------------------------------------------------------------------------------------------------------------------
+
 static void statsd_process_metric(const char *name, const char *value, const char *type, const char *sampling, const char *tags) {
     debug(D_STATSD, "STATSD: raw metric '%s', value '%s', type '%s', sampling '%s', tags '%s'", name?name:"(null)", value?value:"(null)", type?type:"(null)", sampling?sampling:"(null)", tags?tags:"(null)");
 
@@ -704,43 +902,75 @@ static void statsd_process_metric(const char *name, const char *value, const cha
 
     STATSD_METRIC *m = NULL;
 
+    struct collection_thread_status *local = statsd_thread_status;
+    STATSD_LOCAL_METRIC *lm;
+
     char t0 = type[0], t1 = type[1];
     if(unlikely(t0 == 'g' && t1 == '\0')) {
-        statsd_process_gauge(
-            m = statsd_find_or_add_metric(&statsd.gauges, name),
-            value, sampling);
+        if(local) {
+            statsd_local_process_gauge(
+                lm = statsd_find_or_add_local_metric(local->local_gauges, &statsd.gauges, name),
+                value, sampling);
+            m = lm->m;
+        }
+        else
+            statsd_process_gauge(
+                m = statsd_find_or_add_metric(&statsd.gauges, name),
+                value, sampling);
     }
     else if(unlikely((t0 == 'c' || t0 == 'C') && t1 == '\0')) {
         // etsy/statsd uses 'c'
         // brubeck     uses 'C'
-        statsd_process_counter(
-            m = statsd_find_or_add_metric(&statsd.counters, name),
-            value, sampling);
+        if(local) {
+            statsd_local_process_counter_or_meter(
+                lm = statsd_find_or_add_local_metric(local->local_counters, &statsd.counters, name),
+                value, sampling);
+            m = lm->m;
+        }
+        else
+            statsd_process_counter(
+                m = statsd_find_or_add_metric(&statsd.counters, name),
+                value, sampling);
     }
     else if(unlikely(t0 == 'm' && t1 == '\0')) {
-        statsd_process_meter(
-            m = statsd_find_or_add_metric(&statsd.meters, name),
-            value, sampling);
+        if(local) {
+            statsd_local_process_counter_or_meter(
+                lm = statsd_find_or_add_local_metric(local->local_meters, &statsd.meters, name),
+                value, sampling);
+            m = lm->m;
+        }
+        else
+            statsd_process_meter(
+                m = statsd_find_or_add_metric(&statsd.meters, name),
+                value, sampling);
     }
     else if(unlikely(t0 == 'h' && t1 == '\0')) {
+        statsd_shared_lock();
         statsd_process_histogram(
             m = statsd_find_or_add_metric(&statsd.histograms, name),
             value, sampling);
+        statsd_shared_unlock();
     }
     else if(unlikely(t0 == 's' && t1 == '\0')) {
+        statsd_shared_lock();
         statsd_process_set(
             m = statsd_find_or_add_metric(&statsd.sets, name),
             value);
+        statsd_shared_unlock();
     }
     else if(unlikely(t0 == 'd' && t1 == '\0')) {
+        statsd_shared_lock();
         statsd_process_dictionary(
             m = statsd_find_or_add_metric(&statsd.dictionaries, name),
             value);
+        statsd_shared_unlock();
     }
     else if(unlikely(t0 == 'm' && t1 == 's' && type[2] == '\0')) {
+        statsd_shared_lock();
         statsd_process_timer(
             m = statsd_find_or_add_metric(&statsd.timers, name),
             value, sampling);
+        statsd_shared_unlock();
     }
     else {
         statsd.unknown_types++;
@@ -748,6 +978,8 @@ static void statsd_process_metric(const char *name, const char *value, const cha
     }
 
     if(m && tags && *tags) {
+        statsd_shared_lock();
+
         const char *s = tags;
         while(*s) {
             const char *tagkey = NULL, *tagvalue = NULL;
@@ -787,6 +1019,8 @@ static void statsd_process_metric(const char *name, const char *value, const cha
                 }
             }
         }
+
+        statsd_shared_unlock();
     }
 }
 
@@ -794,6 +1028,9 @@ static inline size_t statsd_process(char *buffer, size_t size, int require_newli
     buffer[size] = '\0';
     debug(D_STATSD, "RECEIVED: %zu bytes: '%s'", size, buffer);
 
+    if(statsd_thread_status)
+        netdata_spinlock_lock(&statsd_thread_status->local_spinlock);
+
     const char *s = buffer;
     while(*s) {
         const char *name = NULL, *value = NULL, *type = NULL, *sampling = NULL, *tags = NULL;
@@ -838,6 +1075,10 @@ static inline size_t statsd_process(char *buffer, size_t size, int require_newli
             // move the remaining data to the beginning
             size -= (name - buffer);
             memmove(buffer, name, size);
+
+            if(statsd_thread_status)
+                netdata_spinlock_unlock(&statsd_thread_status->local_spinlock);
+
             return size;
         }
         else
@@ -852,6 +1093,9 @@ static inline size_t statsd_process(char *buffer, size_t size, int require_newli
         );
     }
 
+    if(statsd_thread_status)
+        netdata_spinlock_unlock(&statsd_thread_status->local_spinlock);
+
     return 0;
 }
 
@@ -1135,6 +1379,9 @@ void *statsd_collector_thread(void *ptr) {
 
     info("STATSD collector thread started with taskid %d", gettid());
 
+    if(statsd.sharded)
+        statsd_thread_status = status;
+
     struct statsd_udp *d = callocz(sizeof(struct statsd_udp), 1);
     d->status = status;
 
@@ -1155,7 +1402,7 @@ void *statsd_collector_thread(void *ptr) {
     }
 #endif
 
-    poll_events(&statsd.sockets
+    poll_events(status->sockets
             , statsd_add_callback
             , statsd_del_callback
             , statsd_rcv_callback
@@ -1911,6 +2158,9 @@ static inline void statsd_flush_set(STATSD_METRIC *m) {
 
     int updated = 0;
     if(unlikely(!m->reset && m->count)) {
+        if(m->set.hll)
+            m->set.unique = (size_t)roundndd(hyperloglog_estimate(m->set.hll));
+
         m->last = (collected_number)m->set.unique;
 
         m->reset = 1;
@@ -1956,7 +2206,31 @@ static inline void statsd_flush_timer_or_histogram(STATSD_METRIC *m, const char
     debug(D_STATSD, "flushing %s metric '%s'", dim, m->name);
 
     int updated = 0;
-    if(unlikely(!m->reset && m->count && m->histogram.ext->used > 0)) {
+    QUANTILE_SKETCH *qs = m->histogram.ext->sketch;
+    if(unlikely(qs && !m->reset && m->count && isgreater(qs->count, 0.0))) {
+        netdata_mutex_lock(&m->histogram.ext->mutex);
+
+        m->histogram.ext->last_min = (collected_number)roundndd(qs->min * statsd.decimal_detail);
+        m->histogram.ext->last_max = (collected_number)roundndd(qs->max * statsd.decimal_detail);
+        m->last = (collected_number)roundndd(qs->sum / qs->count * statsd.decimal_detail);
+        m->histogram.ext->last_median = (collected_number)roundndd(quantile_sketch_quantile(qs, 0.5) * statsd.decimal_detail);
+        m->histogram.ext->last_sum = (collected_number)roundndd(qs->sum * statsd.decimal_detail);
+        m->histogram.ext->last_percentile = (collected_number)roundndd(quantile_sketch_quantile(qs, statsd.histogram_percentile / 100.0) * statsd.decimal_detail);
+
+        // standard_deviation() returns the value itself for a single sample
+        NETDATA_DOUBLE stddev = (qs->count == 1.0) ? qs->min : quantile_sketch_standard_deviation(qs);
+        m->histogram.ext->last_stddev = (collected_number)roundndd(stddev * statsd.decimal_detail);
+
+        netdata_mutex_unlock(&m->histogram.ext->mutex);
+
+        debug(D_STATSD, "STATSD %s metric %s (sketch of %zu bytes): min " COLLECTED_NUMBER_FORMAT ", max " COLLECTED_NUMBER_FORMAT ", last " COLLECTED_NUMBER_FORMAT ", pcent " COLLECTED_NUMBER_FORMAT ", median " COLLECTED_NUMBER_FORMAT ", stddev " COLLECTED_NUMBER_FORMAT ", sum " COLLECTED_NUMBER_FORMAT,
+              dim, m->name, quantile_sketch_memory(qs), m->histogram.ext->last_min, m->histogram.ext->last_max, m->last, m->histogram.ext->last_percentile, m->histogram.ext->last_median, m->histogram.ext->last_stddev, m->histogram.ext->last_sum);
+
+        m->histogram.ext->zeroed = 0;
+        m->reset = 1;
+        updated = 1;
+    }
+    else if(unlikely(!qs && !m->reset && m->count && m->histogram.ext->used > 0)) {
         netdata_mutex_lock(&m->histogram.ext->mutex);
 
         size_t len = m->histogram.ext->used;
@@ -2360,6 +2634,33 @@ static int statsd_listen_sockets_setup(void) {
     return listen_sockets_setup(&statsd.sockets);
 }
 
+// the udp entries of the statsd bind to configuration
+static size_t statsd_udp_bind_to(char *dst, size_t size) {
+    const char *s = config_get(CONFIG_SECTION_STATSD, "bind to", statsd.sockets.default_bind_to);
+    size_t len = 0, entries = 0;
+
+    while(*s) {
+        while(isspace(*s) || *s == ',') s++;
+
+        const char *e = s;
+        while(*e && !isspace(*e) && *e != ',') e++;
+
+        if(s == e) break;
+
+        if((size_t)(e - s) > 4 && !strncmp(s, "udp:", 4) && len + (e - s) + 1 < size) {
+            if(len) dst[len++] = ' ';
+            memcpy(&dst[len], s, e - s);
+            len += e - s;
+            entries++;
+        }
+
+        s = e;
+    }
+
+    dst[len] = '\0';
+    return entries;
+}
+
 static void statsd_main_cleanup(void *data) {
     struct netdata_static_thread *static_thread = (struct netdata_static_thread *)data;
     static_thread->enabled = NETDATA_MAIN_THREAD_EXITING;
@@ -2378,11 +2679,35 @@ static void statsd_main_cleanup(void *data) {
             }
             netdata_spinlock_unlock(&statsd.collection_threads_status[i].spinlock);
         }
+
+        // the collection threads use their sockets and dictionaries until they exit
+        for (i = 0; i < statsd.threads; i++) {
+            if(statsd.collection_threads_status[i].started) {
+                netdata_thread_join(statsd.collection_threads_status[i].thread, NULL);
+                statsd.collection_threads_status[i].started = false;
+            }
+        }
     }
 
     info("STATSD: closing sockets...");
     listen_sockets_close(&statsd.sockets);
 
+    if (statsd.collection_threads_status) {
+        int i;
+        for (i = 0; i < statsd.threads; i++) {
+            struct collection_thread_status *status = &statsd.collection_threads_status[i];
+
+            if(status->sockets && status->sockets != &statsd.sockets) {
+                listen_sockets_close(status->sockets);
+                freez(status->sockets);
+            }
+
+            if(status->local_gauges) dictionary_destroy(status->local_gauges);
+            if(status->local_counters) dictionary_destroy(status->local_counters);
+            if(status->local_meters) dictionary_destroy(status->local_meters);
+        }
+    }
+
     // destroy the dictionaries
     dictionary_destroy(statsd.gauges.dict);
     dictionary_destroy(statsd.meters.dict);
@@ -2406,9 +2731,10 @@ static void statsd_main_cleanup(void *data) {
 #define WORKER_STATSD_FLUSH_SETS 5
 #define WORKER_STATSD_FLUSH_DICTIONARIES 6
 #define WORKER_STATSD_FLUSH_STATS 7
+#define WORKER_STATSD_MERGE_THREADS 8
 
-#if WORKER_UTILIZATION_MAX_JOB_TYPES < 8
-#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 8
+#if WORKER_UTILIZATION_MAX_JOB_TYPES < 9
+#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 9
 #endif
 
 void *statsd_main(void *ptr) {
@@ -2421,12 +2747,13 @@ void *statsd_main(void *ptr) {
     worker_register_job_name(WORKER_STATSD_FLUSH_SETS, "sets");
     worker_register_job_name(WORKER_STATSD_FLUSH_DICTIONARIES, "dictionaries");
     worker_register_job_name(WORKER_STATSD_FLUSH_STATS, "statistics");
+    worker_register_job_name(WORKER_STATSD_MERGE_THREADS, "merge threads");
 
     netdata_thread_cleanup_push(statsd_main_cleanup, ptr);
 
-    statsd.gauges.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS);
+    statsd.gauges.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS | DICT_OPTION_INDEX_PARTITIONED);
     statsd.meters.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS);
-    statsd.counters.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS);
+    statsd.counters.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS | DICT_OPTION_INDEX_PARTITIONED);
     statsd.histograms.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS);
     statsd.dictionaries.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS);
     statsd.sets.dict = dictionary_create(STATSD_DICTIONARY_OPTIONS);
@@ -2472,6 +2799,14 @@ void *statsd_main(void *ptr) {
     statsd.private_charts_hidden = (unsigned int)config_get_boolean(CONFIG_SECTION_STATSD, "private charts hidden", statsd.private_charts_hidden);
 
     statsd.histogram_percentile = (double)config_get_float(CONFIG_SECTION_STATSD, "histograms and timers percentile (percentThreshold)", statsd.histogram_percentile);
+    statsd.histogram_sketches = config_get_boolean(CONFIG_SECTION_STATSD, "histograms and timers use quantile sketches", statsd.histogram_sketches);
+    statsd.histogram_sketch_relative_error = (double)config_get_float(CONFIG_SECTION_STATSD, "histograms and timers sketch relative error", statsd.histogram_sketch_relative_error);
+    statsd.set_hyperloglog = config_get_boolean(CONFIG_SECTION_STATSD, "sets use hyperloglog", statsd.set_hyperloglog);
+    statsd.set_hyperloglog_precision = (size_t)config_get_number(CONFIG_SECTION_STATSD, "sets hyperloglog precision", (long long)statsd.set_hyperloglog_precision);
+    if(statsd.set_hyperloglog_precision < HYPERLOGLOG_MIN_PRECISION || statsd.set_hyperloglog_precision > HYPERLOGLOG_MAX_PRECISION) {
+        error("STATSD: invalid sets hyperloglog precision %zu given, allowed values are %d to %d", statsd.set_hyperloglog_precision, HYPERLOGLOG_MIN_PRECISION, HYPERLOGLOG_MAX_PRECISION);
+        statsd.set_hyperloglog_precision = HYPERLOGLOG_DEFAULT_PRECISION;
+    }
     if(isless(statsd.histogram_percentile, 0) || isgreater(statsd.histogram_percentile, 100)) {
         error("STATSD: invalid histograms and timers percentile %0.5f given", statsd.histogram_percentile);
         statsd.histogram_percentile = 95.0;
@@ -2525,7 +2860,18 @@ void *statsd_main(void *ptr) {
         config_set_number(CONFIG_SECTION_STATSD, "collector threads", statsd.threads);
     }
 #else
-    statsd.threads = 1;
+    statsd.threads = (int)config_get_number(CONFIG_SECTION_STATSD, "collector threads", 1);
+    if(statsd.threads < 1) {
+        error("STATSD: Invalid number of collector threads %d, using 1", statsd.threads);
+        statsd.threads = 1;
+    }
+#ifndef SO_REUSEPORT
+    if(statsd.threads > 1) {
+        error("STATSD: multiple collector threads need SO_REUSEPORT, which is not available on this system. Using 1.");
+        statsd.threads = 1;
+    }
+#endif
+    statsd.sharded = (statsd.threads > 1);
 #endif
 
     // read custom application definitions
@@ -2542,15 +2888,51 @@ void *statsd_main(void *ptr) {
         goto cleanup;
     }
 
+    char udp_bind_to[CONFIG_MAX_VALUE + 1] = "";
+    if(statsd.sharded && !statsd_udp_bind_to(udp_bind_to, CONFIG_MAX_VALUE)) {
+        error("STATSD: multiple collector threads need udp sockets, but none is configured. Using 1 collector thread.");
+        statsd.threads = 1;
+        statsd.sharded = false;
+    }
+
     statsd.collection_threads_status = callocz((size_t)statsd.threads, sizeof(struct collection_thread_status));
 
     int i;
     for(i = 0; i < statsd.threads ;i++) {
-        statsd.collection_threads_status[i].max_sockets = max_sockets / statsd.threads;
+        struct collection_thread_status *status = &statsd.collection_threads_status[i];
+        netdata_spinlock_init(&status->spinlock);
+        status->sockets = &statsd.sockets;
+
+        if(statsd.sharded) {
+            // the first thread uses all the configured sockets,
+            // the rest open their own SO_REUSEPORT udp sockets, so that the kernel balances the packets among them
+            if(i > 0) {
+                status->sockets = callocz(1, sizeof(LISTEN_SOCKETS));
+                status->sockets->config = statsd.sockets.config;
+                status->sockets->config_section = statsd.sockets.config_section;
+                status->sockets->default_bind_to = statsd.sockets.default_bind_to;
+                status->sockets->default_port = statsd.sockets.default_port;
+                status->sockets->backlog = statsd.sockets.backlog;
+                listen_sockets_setup_bind_to(status->sockets, udp_bind_to);
+            }
+
+            netdata_spinlock_init(&status->local_spinlock);
+            status->local_gauges = dictionary_create(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE);
+            status->local_counters = dictionary_create(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE);
+            status->local_meters = dictionary_create(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE);
+        }
+
+        if(!status->sockets->opened) {
+            error("STATSD: collector thread %d has no sockets to listen to, not starting it.", i + 1);
+            continue;
+        }
+
+        // when sharded, only the first thread accepts tcp connections
+        status->max_sockets = statsd.sharded ? max_sockets : max_sockets / statsd.threads;
         char tag[NETDATA_THREAD_TAG_MAX + 1];
         snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STATSD_COLLECTOR[%d]", i + 1);
-        netdata_spinlock_init(&statsd.collection_threads_status[i].spinlock);
-        netdata_thread_create(&statsd.collection_threads_status[i].thread, tag, NETDATA_THREAD_OPTION_DEFAULT, statsd_collector_thread, &statsd.collection_threads_status[i]);
+        if(netdata_thread_create(&status->thread, tag, NETDATA_THREAD_OPTION_JOINABLE, statsd_collector_thread, status) == 0)
+            status->started = true;
     }
 
     // ----------------------------------------------------------------------------------------------------------------
@@ -2770,6 +3152,11 @@ void *statsd_main(void *ptr) {
         worker_is_idle();
         heartbeat_next(&hb, step);
 
+        if(statsd.sharded) {
+            worker_is_busy(WORKER_STATSD_MERGE_THREADS);
+            statsd_merge_thread_local_metrics();
+        }
+
         worker_is_busy(WORKER_STATSD_FLUSH_GAUGES);
         statsd_flush_index_metrics(&statsd.gauges,     statsd_flush_gauge);
 
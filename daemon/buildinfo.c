@@ -95,6 +95,18 @@
 #define FEAT_ZLIB 0
 #endif
 
+#ifdef NETDATA_WITH_ZSTD
+#define FEAT_ZSTD 1
+#else
+#define FEAT_ZSTD 0
+#endif
+
+#ifdef NETDATA_WITH_BROTLI
+#define FEAT_BROTLI 1
+#else
+#define FEAT_BROTLI 0
+#endif
+
 #ifdef STORAGE_WITH_MATH
 #define FEAT_LIBM 1
 #else
@@ -285,6 +297,8 @@ void print_build_info(void) {
     printf("    libm:                    %s\n", FEAT_YES_NO(FEAT_LIBM));
     printf("    tcalloc:                 %s\n", FEAT_YES_NO(FEAT_TCMALLOC));
     printf("    zlib:                    %s\n", FEAT_YES_NO(FEAT_ZLIB));
+    printf("    zstd:                    %s\n", FEAT_YES_NO(FEAT_ZSTD));
+    printf("    brotli:                  %s\n", FEAT_YES_NO(FEAT_BROTLI));
 
     printf("Plugins:\n");
     printf("    apps:                    %s\n", FEAT_YES_NO(FEAT_APPS_PLUGIN));
@@ -340,7 +354,9 @@ void print_build_info_json(void) {
     printf("    \"libcrypto\": %s,\n",        FEAT_JSON_BOOL(FEAT_CRYPTO));
     printf("    \"libm\": %s,\n",             FEAT_JSON_BOOL(FEAT_LIBM));
     printf("    \"tcmalloc\": %s,\n",         FEAT_JSON_BOOL(FEAT_TCMALLOC));
-    printf("    \"zlib\": %s\n",              FEAT_JSON_BOOL(FEAT_ZLIB));
+    printf("    \"zlib\": %s,\n",             FEAT_JSON_BOOL(FEAT_ZLIB));
+    printf("    \"zstd\": %s,\n",             FEAT_JSON_BOOL(FEAT_ZSTD));
+    printf("    \"brotli\": %s\n",            FEAT_JSON_BOOL(FEAT_BROTLI));
     printf("  },\n");
 
     printf("  \"plugins\": {\n");
@@ -420,6 +436,12 @@ void analytics_build_info(BUFFER *b) {
 #ifdef NETDATA_WITH_ZLIB
     add_to_bi(b, "zlib");
 #endif
+#ifdef NETDATA_WITH_ZSTD
+    add_to_bi(b, "zstd");
+#endif
+#ifdef NETDATA_WITH_BROTLI
+    add_to_bi(b, "brotli");
+#endif
 
 #ifdef ENABLE_APPS_PLUGIN
     add_to_bi(b, "apps");
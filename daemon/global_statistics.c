@@ -13,9 +13,10 @@
 #define WORKER_JOB_DICTIONARIES       6
 #define WORKER_JOB_MALLOC_TRACE       7
 #define WORKER_JOB_SQLITE3            8
+#define WORKER_JOB_ARAL               9
 
-#if WORKER_UTILIZATION_MAX_JOB_TYPES < 9
-#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 9
+#if WORKER_UTILIZATION_MAX_JOB_TYPES < 10
+#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 10
 #endif
 
 bool global_statistics_enabled = true;
@@ -60,6 +61,11 @@ static struct global_statistics {
     uint64_t backfill_queries_made;
     uint64_t backfill_db_points_read;
 
+    uint64_t queries_cancelled_timeout;
+    uint64_t queries_cancelled_interrupted;
+    uint64_t queries_cancelled_timeout_db_points_read;
+    uint64_t queries_cancelled_interrupted_db_points_read;
+
     uint64_t db_points_stored_per_tier[RRD_STORAGE_TIERS];
 
 } global_statistics = {
@@ -142,6 +148,18 @@ void global_statistics_rrdr_query_completed(size_t queries, uint64_t db_points_r
     }
 }
 
+// the queries that stopped before completing their work, and the db points they read for nothing
+void global_statistics_rrdr_query_cancelled(bool timeout, uint64_t db_points_read) {
+    if(timeout) {
+        __atomic_fetch_add(&global_statistics.queries_cancelled_timeout, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&global_statistics.queries_cancelled_timeout_db_points_read, db_points_read, __ATOMIC_RELAXED);
+    }
+    else {
+        __atomic_fetch_add(&global_statistics.queries_cancelled_interrupted, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&global_statistics.queries_cancelled_interrupted_db_points_read, db_points_read, __ATOMIC_RELAXED);
+    }
+}
+
 void global_statistics_web_request_completed(uint64_t dt,
                                              uint64_t bytes_received,
                                              uint64_t bytes_sent,
@@ -205,6 +223,11 @@ static inline void global_statistics_copy(struct global_statistics *gs, uint8_t
     gs->backfill_queries_made       = __atomic_load_n(&global_statistics.backfill_queries_made, __ATOMIC_RELAXED);
     gs->backfill_db_points_read     = __atomic_load_n(&global_statistics.backfill_db_points_read, __ATOMIC_RELAXED);
 
+    gs->queries_cancelled_timeout      = __atomic_load_n(&global_statistics.queries_cancelled_timeout, __ATOMIC_RELAXED);
+    gs->queries_cancelled_interrupted  = __atomic_load_n(&global_statistics.queries_cancelled_interrupted, __ATOMIC_RELAXED);
+    gs->queries_cancelled_timeout_db_points_read     = __atomic_load_n(&global_statistics.queries_cancelled_timeout_db_points_read, __ATOMIC_RELAXED);
+    gs->queries_cancelled_interrupted_db_points_read = __atomic_load_n(&global_statistics.queries_cancelled_interrupted_db_points_read, __ATOMIC_RELAXED);
+
     for(size_t tier = 0; tier < storage_tiers ;tier++)
         gs->db_points_stored_per_tier[tier] = __atomic_load_n(&global_statistics.db_points_stored_per_tier[tier], __ATOMIC_RELAXED);
 
@@ -660,6 +683,64 @@ static void global_statistics_charts(void) {
         rrdset_done(st_points_stored);
     }
 
+    // ----------------------------------------------------------------
+
+    if(gs.queries_cancelled_timeout || gs.queries_cancelled_interrupted) {
+        static RRDSET *st_cancelled = NULL;
+        static RRDDIM *rd_timeout = NULL;
+        static RRDDIM *rd_interrupted = NULL;
+
+        static RRDSET *st_points_wasted = NULL;
+        static RRDDIM *rd_timeout_points = NULL;
+        static RRDDIM *rd_interrupted_points = NULL;
+
+        if (unlikely(!st_cancelled)) {
+            st_cancelled = rrdset_create_localhost(
+                    "netdata"
+                    , "queries_cancelled"
+                    , NULL
+                    , "queries"
+                    , NULL
+                    , "Netdata DB Queries Cancelled"
+                    , "queries/s"
+                    , "netdata"
+                    , "stats"
+                    , 131004
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_STACKED
+            );
+
+            rd_timeout = rrddim_add(st_cancelled, "timeout", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_interrupted = rrddim_add(st_cancelled, "interrupted", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+
+            st_points_wasted = rrdset_create_localhost(
+                    "netdata"
+                    , "db_points_wasted"
+                    , NULL
+                    , "queries"
+                    , NULL
+                    , "Netdata DB Points Read By Cancelled Queries"
+                    , "points/s"
+                    , "netdata"
+                    , "stats"
+                    , 131005
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_STACKED
+            );
+
+            rd_timeout_points = rrddim_add(st_points_wasted, "timeout", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_interrupted_points = rrddim_add(st_points_wasted, "interrupted", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+
+        rrddim_set_by_pointer(st_cancelled, rd_timeout, (collected_number)gs.queries_cancelled_timeout);
+        rrddim_set_by_pointer(st_cancelled, rd_interrupted, (collected_number)gs.queries_cancelled_interrupted);
+        rrdset_done(st_cancelled);
+
+        rrddim_set_by_pointer(st_points_wasted, rd_timeout_points, (collected_number)gs.queries_cancelled_timeout_db_points_read);
+        rrddim_set_by_pointer(st_points_wasted, rd_interrupted_points, (collected_number)gs.queries_cancelled_interrupted_db_points_read);
+        rrdset_done(st_points_wasted);
+    }
+
     {
         static RRDSET *st = NULL;
         static RRDDIM *rd = NULL;
@@ -687,6 +768,44 @@ static void global_statistics_charts(void) {
 
         rrdset_done(st);
     }
+
+    // ----------------------------------------------------------------
+
+    if(log_async_enabled) {
+        static RRDSET *st_log = NULL;
+        static RRDDIM *rd_queued = NULL, *rd_written = NULL, *rd_dropped = NULL, *rd_writes = NULL;
+
+        size_t queued, written, dropped, writes;
+        log_async_statistics(&queued, &written, &dropped, &writes);
+
+        if (unlikely(!st_log)) {
+            st_log = rrdset_create_localhost(
+                    "netdata"
+                    , "log_messages"
+                    , NULL
+                    , "logs"
+                    , NULL
+                    , "Netdata Asynchronous Logging"
+                    , "messages/s"
+                    , "netdata"
+                    , "stats"
+                    , 130510
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_LINE
+            );
+
+            rd_queued  = rrddim_add(st_log, "queued",  NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_written = rrddim_add(st_log, "written", NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_dropped = rrddim_add(st_log, "dropped", NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_writes  = rrddim_add(st_log, "writes",  NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+
+        rrddim_set_by_pointer(st_log, rd_queued,  (collected_number)queued);
+        rrddim_set_by_pointer(st_log, rd_written, (collected_number)written);
+        rrddim_set_by_pointer(st_log, rd_dropped, (collected_number)dropped);
+        rrddim_set_by_pointer(st_log, rd_writes,  (collected_number)writes);
+        rrdset_done(st_log);
+    }
 }
 
 // ----------------------------------------------------------------------------
@@ -1550,6 +1669,23 @@ static void dbengine2_cache_statistics_charts(struct dbengine2_cache_pointers *p
 }
 
 
+// the upper limit of the log2 latency histogram bucket the percentile falls into
+static usec_t dbengine2_latency_percentile(size_t *buckets, size_t total, double percentile) {
+    if(!total)
+        return 0;
+
+    size_t wanted = (size_t)ceil((double)total * percentile / 100.0);
+    size_t sum = 0;
+
+    for(size_t i = 0; i < RRDENG_COLLECTION_LATENCY_BUCKETS ; i++) {
+        sum += buckets[i];
+        if(sum >= wanted)
+            return 1ULL << i;
+    }
+
+    return 1ULL << (RRDENG_COLLECTION_LATENCY_BUCKETS - 1);
+}
+
 static void dbengine2_statistics_charts(void) {
     if(!main_cache || !main_mrg)
         return;
@@ -1809,6 +1945,7 @@ static void dbengine2_statistics_charts(void) {
         static RRDDIM *rd_jv2 = NULL;
         static RRDDIM *rd_planned_with_gaps = NULL;
         static RRDDIM *rd_executed_with_gaps = NULL;
+        static RRDDIM *rd_cancelled_before_prep = NULL;
 
         if (unlikely(!st_queries)) {
             st_queries = rrdset_create_localhost(
@@ -1830,6 +1967,7 @@ static void dbengine2_statistics_charts(void) {
             rd_jv2 = rrddim_add(st_queries, "journal v2", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
             rd_planned_with_gaps = rrddim_add(st_queries, "planned with gaps", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
             rd_executed_with_gaps = rrddim_add(st_queries, "executed with gaps", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_cancelled_before_prep = rrddim_add(st_queries, "cancelled before prep", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
         }
         priority++;
 
@@ -1838,6 +1976,7 @@ static void dbengine2_statistics_charts(void) {
         rrddim_set_by_pointer(st_queries, rd_jv2, (collected_number)cache_efficiency_stats.queries_journal_v2);
         rrddim_set_by_pointer(st_queries, rd_planned_with_gaps, (collected_number)cache_efficiency_stats.queries_planned_with_gaps);
         rrddim_set_by_pointer(st_queries, rd_executed_with_gaps, (collected_number)cache_efficiency_stats.queries_executed_with_gaps);
+        rrddim_set_by_pointer(st_queries, rd_cancelled_before_prep, (collected_number)cache_efficiency_stats.queries_cancelled_before_prep);
 
         rrdset_done(st_queries);
     }
@@ -1870,6 +2009,84 @@ static void dbengine2_statistics_charts(void) {
         rrdset_done(st_queries_running);
     }
 
+    {
+        static RRDSET *st_collection_latency = NULL;
+        static RRDDIM *rd_p50 = NULL;
+        static RRDDIM *rd_p95 = NULL;
+        static RRDDIM *rd_p99 = NULL;
+        static RRDDIM *rd_max = NULL;
+
+        if (unlikely(!st_collection_latency)) {
+            st_collection_latency = rrdset_create_localhost(
+                    "netdata",
+                    "dbengine_collection_rollover_latency",
+                    NULL,
+                    "dbengine collection",
+                    NULL,
+                    "Netdata Collection Page Rollover Latency",
+                    "microseconds",
+                    "netdata",
+                    "stats",
+                    priority,
+                    localhost->rrd_update_every,
+                    RRDSET_TYPE_LINE);
+
+            rd_p50 = rrddim_add(st_collection_latency, "p50", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            rd_p95 = rrddim_add(st_collection_latency, "p95", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            rd_p99 = rrddim_add(st_collection_latency, "p99", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            rd_max = rrddim_add(st_collection_latency, "max", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+        }
+        priority++;
+
+        // the samples of this iteration
+        size_t buckets[RRDENG_COLLECTION_LATENCY_BUCKETS], total = 0;
+        for(size_t i = 0; i < RRDENG_COLLECTION_LATENCY_BUCKETS ; i++) {
+            buckets[i] = cache_efficiency_stats.collection_rollover_latency_ut[i] - cache_efficiency_stats_old.collection_rollover_latency_ut[i];
+            total += buckets[i];
+        }
+
+        rrddim_set_by_pointer(st_collection_latency, rd_p50, (collected_number)dbengine2_latency_percentile(buckets, total, 50.0));
+        rrddim_set_by_pointer(st_collection_latency, rd_p95, (collected_number)dbengine2_latency_percentile(buckets, total, 95.0));
+        rrddim_set_by_pointer(st_collection_latency, rd_p99, (collected_number)dbengine2_latency_percentile(buckets, total, 99.0));
+        rrddim_set_by_pointer(st_collection_latency, rd_max, (collected_number)dbengine2_latency_percentile(buckets, total, 100.0));
+
+        rrdset_done(st_collection_latency);
+    }
+
+    {
+        static RRDSET *st_collection_pages = NULL;
+        static RRDDIM *rd_spare = NULL;
+        static RRDDIM *rd_batched = NULL;
+        static RRDDIM *rd_batches = NULL;
+
+        if (unlikely(!st_collection_pages)) {
+            st_collection_pages = rrdset_create_localhost(
+                    "netdata",
+                    "dbengine_collection_pages",
+                    NULL,
+                    "dbengine collection",
+                    NULL,
+                    "Netdata Collection Page Rollovers",
+                    "pages/s",
+                    "netdata",
+                    "stats",
+                    priority,
+                    localhost->rrd_update_every,
+                    RRDSET_TYPE_LINE);
+
+            rd_spare   = rrddim_add(st_collection_pages, "preallocated", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_batched = rrddim_add(st_collection_pages, "batched to dirty", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_batches = rrddim_add(st_collection_pages, "batches", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+        priority++;
+
+        rrddim_set_by_pointer(st_collection_pages, rd_spare, (collected_number)cache_efficiency_stats.collection_spare_pages_used);
+        rrddim_set_by_pointer(st_collection_pages, rd_batched, (collected_number)cache_efficiency_stats.collection_pages_batched);
+        rrddim_set_by_pointer(st_collection_pages, rd_batches, (collected_number)cache_efficiency_stats.collection_batches);
+
+        rrdset_done(st_collection_pages);
+    }
+
     {
         static RRDSET *st_query_pages_metadata_source = NULL;
         static RRDDIM *rd_cache = NULL;
@@ -1904,11 +2121,43 @@ static void dbengine2_statistics_charts(void) {
         rrdset_done(st_query_pages_metadata_source);
     }
 
+    {
+        static RRDSET *st_query_journal_v2_files = NULL;
+        static RRDDIM *rd_searched = NULL;
+        static RRDDIM *rd_skipped = NULL;
+
+        if (unlikely(!st_query_journal_v2_files)) {
+            st_query_journal_v2_files = rrdset_create_localhost(
+                    "netdata",
+                    "dbengine_query_journal_v2_files",
+                    NULL,
+                    "dbengine query router",
+                    NULL,
+                    "Netdata Query Journal v2 Files Lookups",
+                    "files/s",
+                    "netdata",
+                    "stats",
+                    priority,
+                    localhost->rrd_update_every,
+                    RRDSET_TYPE_STACKED);
+
+            rd_searched = rrddim_add(st_query_journal_v2_files, "searched", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_skipped  = rrddim_add(st_query_journal_v2_files, "skipped", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+        priority++;
+
+        rrddim_set_by_pointer(st_query_journal_v2_files, rd_searched, (collected_number)cache_efficiency_stats.journal_v2_files_searched);
+        rrddim_set_by_pointer(st_query_journal_v2_files, rd_skipped, (collected_number)cache_efficiency_stats.journal_v2_files_skipped);
+
+        rrdset_done(st_query_journal_v2_files);
+    }
+
     {
         static RRDSET *st_query_pages_data_source = NULL;
         static RRDDIM *rd_pages_main_cache = NULL;
         static RRDDIM *rd_pages_disk = NULL;
         static RRDDIM *rd_pages_extent_cache = NULL;
+        static RRDDIM *rd_pages_inflight_extent = NULL;
 
         if (unlikely(!st_query_pages_data_source)) {
             st_query_pages_data_source = rrdset_create_localhost(
@@ -1928,12 +2177,14 @@ static void dbengine2_statistics_charts(void) {
             rd_pages_main_cache = rrddim_add(st_query_pages_data_source, "main cache", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
             rd_pages_disk = rrddim_add(st_query_pages_data_source, "disk", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
             rd_pages_extent_cache = rrddim_add(st_query_pages_data_source, "extent cache", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_pages_inflight_extent = rrddim_add(st_query_pages_data_source, "inflight extent", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
         }
         priority++;
 
         rrddim_set_by_pointer(st_query_pages_data_source, rd_pages_main_cache, (collected_number)cache_efficiency_stats.pages_data_source_main_cache + (collected_number)cache_efficiency_stats.pages_data_source_main_cache_at_pass4);
         rrddim_set_by_pointer(st_query_pages_data_source, rd_pages_disk, (collected_number)cache_efficiency_stats.pages_to_load_from_disk);
         rrddim_set_by_pointer(st_query_pages_data_source, rd_pages_extent_cache, (collected_number)cache_efficiency_stats.pages_data_source_extent_cache);
+        rrddim_set_by_pointer(st_query_pages_data_source, rd_pages_inflight_extent, (collected_number)cache_efficiency_stats.pages_data_source_inflight_extent);
 
         rrdset_done(st_query_pages_data_source);
     }
@@ -2031,6 +2282,7 @@ static void dbengine2_statistics_charts(void) {
         static RRDDIM *rd_unroutable = NULL;
         static RRDDIM *rd_not_found = NULL;
         static RRDDIM *rd_cancelled = NULL;
+        static RRDDIM *rd_extent_followed = NULL;
         static RRDDIM *rd_invalid_extent = NULL;
         static RRDDIM *rd_extent_merged = NULL;
 
@@ -2058,6 +2310,7 @@ static void dbengine2_statistics_charts(void) {
             rd_not_found = rrddim_add(st_query_pages_from_disk, "fail not found", NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
             rd_invalid_extent = rrddim_add(st_query_pages_from_disk, "fail invalid extent", NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
             rd_extent_merged = rrddim_add(st_query_pages_from_disk, "extent merged", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_extent_followed = rrddim_add(st_query_pages_from_disk, "extent followed", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
             rd_cancelled = rrddim_add(st_query_pages_from_disk, "cancelled", NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
         }
         priority++;
@@ -2072,6 +2325,7 @@ static void dbengine2_statistics_charts(void) {
         rrddim_set_by_pointer(st_query_pages_from_disk, rd_cancelled, (collected_number)cache_efficiency_stats.pages_load_fail_cancelled);
         rrddim_set_by_pointer(st_query_pages_from_disk, rd_invalid_extent, (collected_number)cache_efficiency_stats.pages_load_fail_invalid_extent);
         rrddim_set_by_pointer(st_query_pages_from_disk, rd_extent_merged, (collected_number)cache_efficiency_stats.pages_load_extent_merged);
+        rrddim_set_by_pointer(st_query_pages_from_disk, rd_extent_followed, (collected_number)cache_efficiency_stats.pages_load_extent_followed);
 
         rrdset_done(st_query_pages_from_disk);
     }
@@ -2992,6 +3246,124 @@ static void dictionary_statistics(void) {
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// array allocators
+
+struct aral_charts {
+    const char *name;
+    int priority;
+
+    RRDSET *st_ops;
+    RRDDIM *rd_ops_allocations;
+    RRDDIM *rd_ops_frees;
+    RRDDIM *rd_ops_magazine_hits;
+    RRDDIM *rd_ops_magazine_stores;
+    RRDDIM *rd_ops_refills;
+    RRDDIM *rd_ops_flushes;
+
+    RRDSET *st_memory;
+    RRDDIM *rd_memory_allocated;
+    RRDDIM *rd_memory_used;
+    RRDDIM *rd_memory_cached;
+
+    struct aral_charts *next;
+};
+
+static void update_aral_charts(const char *name, struct aral_statistics *stats, void *data) {
+    struct aral_charts **base = data, *c;
+
+    for(c = *base; c ; c = c->next)
+        if(!strcmp(c->name, name)) break;
+
+    if(unlikely(!c)) {
+        static int priority = 910100;
+
+        c = callocz(1, sizeof(struct aral_charts));
+        c->name = strdupz(name);
+        c->priority = priority;
+        priority += 2;
+        c->next = *base;
+        *base = c;
+    }
+
+    if(c->st_ops || stats->allocations || stats->frees) {
+        if (unlikely(!c->st_ops)) {
+            char id[RRD_ID_LENGTH_MAX + 1];
+            snprintfz(id, RRD_ID_LENGTH_MAX, "aral.%s.ops", c->name);
+
+            c->st_ops = rrdset_create_localhost(
+                "netdata"
+                , id
+                , NULL
+                , "aral"
+                , "netdata.aral.ops"
+                , "Array Allocator Operations"
+                , "ops/s"
+                , "netdata"
+                , "stats"
+                , c->priority + 0
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            c->rd_ops_allocations     = rrddim_add(c->st_ops, "allocations",     NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+            c->rd_ops_frees           = rrddim_add(c->st_ops, "frees",           NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
+            c->rd_ops_magazine_hits   = rrddim_add(c->st_ops, "magazine hits",   NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+            c->rd_ops_magazine_stores = rrddim_add(c->st_ops, "magazine stores", NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
+            c->rd_ops_refills         = rrddim_add(c->st_ops, "refills",         NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+            c->rd_ops_flushes         = rrddim_add(c->st_ops, "flushes",         NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
+
+            rrdlabels_add(c->st_ops->rrdlabels, "aral", c->name, RRDLABEL_SRC_AUTO);
+        }
+
+        rrddim_set_by_pointer(c->st_ops, c->rd_ops_allocations,     (collected_number)stats->allocations);
+        rrddim_set_by_pointer(c->st_ops, c->rd_ops_frees,           (collected_number)stats->frees);
+        rrddim_set_by_pointer(c->st_ops, c->rd_ops_magazine_hits,   (collected_number)stats->magazine_hits);
+        rrddim_set_by_pointer(c->st_ops, c->rd_ops_magazine_stores, (collected_number)stats->magazine_stores);
+        rrddim_set_by_pointer(c->st_ops, c->rd_ops_refills,         (collected_number)stats->refills);
+        rrddim_set_by_pointer(c->st_ops, c->rd_ops_flushes,         (collected_number)stats->flushes);
+        rrdset_done(c->st_ops);
+    }
+
+    if(c->st_memory || stats->allocated_bytes) {
+        if (unlikely(!c->st_memory)) {
+            char id[RRD_ID_LENGTH_MAX + 1];
+            snprintfz(id, RRD_ID_LENGTH_MAX, "aral.%s.memory", c->name);
+
+            c->st_memory = rrdset_create_localhost(
+                "netdata"
+                , id
+                , NULL
+                , "aral"
+                , "netdata.aral.memory"
+                , "Array Allocator Memory"
+                , "bytes"
+                , "netdata"
+                , "stats"
+                , c->priority + 1
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            c->rd_memory_allocated = rrddim_add(c->st_memory, "allocated", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            c->rd_memory_used      = rrddim_add(c->st_memory, "used",      NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            c->rd_memory_cached    = rrddim_add(c->st_memory, "magazines", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+            rrdlabels_add(c->st_memory->rrdlabels, "aral", c->name, RRDLABEL_SRC_AUTO);
+        }
+
+        rrddim_set_by_pointer(c->st_memory, c->rd_memory_allocated, (collected_number)stats->allocated_bytes);
+        rrddim_set_by_pointer(c->st_memory, c->rd_memory_used,      (collected_number)stats->used_bytes);
+        rrddim_set_by_pointer(c->st_memory, c->rd_memory_cached,    (collected_number)stats->cached_bytes);
+        rrdset_done(c->st_memory);
+    }
+}
+
+static void aral_statistics(void) {
+    static struct aral_charts *charts = NULL;
+    arrayalloc_foreach_statistics(update_aral_charts, &charts);
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // worker utilization
 
@@ -3796,6 +4168,7 @@ static void global_statistics_register_workers(void) {
     worker_register_job_name(WORKER_JOB_MALLOC_TRACE, "malloc_trace");
     worker_register_job_name(WORKER_JOB_WORKERS, "workers");
     worker_register_job_name(WORKER_JOB_SQLITE3, "sqlite3");
+    worker_register_job_name(WORKER_JOB_ARAL, "aral");
 }
 
 static void global_statistics_cleanup(void *ptr)
@@ -3855,6 +4228,9 @@ void *global_statistics_main(void *ptr)
         worker_is_busy(WORKER_JOB_DICTIONARIES);
         dictionary_statistics();
 
+        worker_is_busy(WORKER_JOB_ARAL);
+        aral_statistics();
+
 #ifdef NETDATA_TRACE_ALLOCATIONS
         worker_is_busy(WORKER_JOB_MALLOC_TRACE);
         malloc_trace_statistics();
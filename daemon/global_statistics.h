@@ -13,6 +13,7 @@ void global_statistics_ml_models_consulted(size_t models_consulted);
 void global_statistics_exporters_query_completed(size_t points_read);
 void global_statistics_backfill_query_completed(size_t points_read);
 void global_statistics_rrdr_query_completed(size_t queries, uint64_t db_points_read, uint64_t result_points_generated, QUERY_SOURCE query_source);
+void global_statistics_rrdr_query_cancelled(bool timeout, uint64_t db_points_read);
 void global_statistics_sqlite3_query_completed(bool success, bool busy, bool locked);
 void global_statistics_sqlite3_row_completed(void);
 void global_statistics_rrdset_done_chart_collection_completed(size_t *points_read_per_tier_array);
@@ -410,6 +410,10 @@ void netdata_cleanup_and_exit(int ret) {
 
         rrdhost_free_all();
 
+        delta_shutdown_time("close ML models db");
+
+        ml_fini();
+
         delta_shutdown_time("stop metasync threads");
 
         metadata_sync_shutdown();
@@ -452,6 +456,7 @@ void netdata_cleanup_and_exit(int ret) {
 
     usec_t ended_ut = now_monotonic_usec();
     info("NETDATA SHUTDOWN: completed in %llu ms - netdata is now exiting - bye bye...", (ended_ut - started_ut) / USEC_PER_MS);
+    log_async_stop();
     exit(ret);
 }
 
@@ -562,6 +567,34 @@ void web_server_config_options(void)
         web_gzip_level = 9;
     }
 #endif /* NETDATA_WITH_ZLIB */
+
+#ifdef NETDATA_WITH_ZSTD
+    web_enable_zstd = config_get_boolean(CONFIG_SECTION_WEB, "enable zstd compression", web_enable_zstd);
+    web_zstd_level = (int)config_get_number(CONFIG_SECTION_WEB, "zstd compression level", web_zstd_level);
+    if(web_zstd_level < 1) {
+        error("Invalid zstd compression level %d. Valid levels are 1 (fastest) to 19 (best ratio). Proceeding with level 1 (fastest compression).", web_zstd_level);
+        web_zstd_level = 1;
+    }
+    else if(web_zstd_level > 19) {
+        error("Invalid zstd compression level %d. Valid levels are 1 (fastest) to 19 (best ratio). Proceeding with level 19 (best compression).", web_zstd_level);
+        web_zstd_level = 19;
+    }
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+    web_enable_brotli = config_get_boolean(CONFIG_SECTION_WEB, "enable brotli compression", web_enable_brotli);
+    web_brotli_quality = (int)config_get_number(CONFIG_SECTION_WEB, "brotli compression level", web_brotli_quality);
+    if(web_brotli_quality < 0) {
+        error("Invalid brotli compression level %d. Valid levels are 0 (fastest) to 11 (best ratio). Proceeding with level 0 (fastest compression).", web_brotli_quality);
+        web_brotli_quality = 0;
+    }
+    else if(web_brotli_quality > 11) {
+        error("Invalid brotli compression level %d. Valid levels are 0 (fastest) to 11 (best ratio). Proceeding with level 11 (best compression).", web_brotli_quality);
+        web_brotli_quality = 11;
+    }
+#endif /* NETDATA_WITH_BROTLI */
+
+    web_precompress_static_files = config_get_boolean(CONFIG_SECTION_WEB, "precompress static files", web_precompress_static_files);
 }
 
 
@@ -713,17 +746,29 @@ int help(int exitcode) {
             "  -W stacksize=N           Set the stacksize (in bytes).\n\n"
             "  -W debug_flags=N         Set runtime tracing to debug.log.\n\n"
             "  -W unittest              Run internal unittests and exit.\n\n"
+            "  -W grouptest             Check the percentile, trimmed mean and median\n"
+            "                           grouping methods, benchmark them at several\n"
+            "                           group sizes, and exit.\n\n"
+            "  -W mltest                Check the ML features and models, benchmark\n"
+            "                           the trainings and anomaly predictions per\n"
+            "                           second, and exit.\n\n"
             "  -W sqlite-check          Check metadata database integrity and exit.\n\n"
             "  -W sqlite-fix            Check metadata database integrity, fix if needed and exit.\n\n"
             "  -W sqlite-compact        Reclaim metadata database unused space and exit.\n\n"
 #ifdef ENABLE_DBENGINE
             "  -W createdataset=N       Create a DB engine dataset of N seconds and exit.\n\n"
-            "  -W stresstest=A,B,C,D,E,F,G\n"
+            "  -W loaddataset=M         Time loading the DB engine dataset created by\n"
+            "                           createdataset, with M 'serial' or 'parallel'\n"
+            "                           journal loading, and exit.\n\n"
+            "  -W stresstest=A,B,C,D,E,F,G,H\n"
             "                           Run a DB engine stress test for A seconds,\n"
             "                           with B writers and C readers, with a ramp up\n"
             "                           time of D seconds for writers, a page cache\n"
             "                           size of E MiB, an optional disk space limit\n"
-            "                           of F MiB, G libuv workers (default 16) and exit.\n\n"
+            "                           of F MiB, G libuv workers (default 16), an\n"
+            "                           optional extent compression H (none, lz4,\n"
+            "                           lz4hc or zstd, with an optional :level)\n"
+            "                           and exit.\n\n"
 #endif
             "  -W set section option value\n"
             "                           set netdata.conf option from the command line.\n\n"
@@ -796,6 +841,9 @@ static void log_init(void) {
     error_log_errors_per_period = (unsigned long)config_get_number(CONFIG_SECTION_LOGS, "errors to trigger flood protection", (long long int)error_log_errors_per_period);
     error_log_errors_per_period_backup = error_log_errors_per_period;
 
+    log_async_enabled = config_get_boolean(CONFIG_SECTION_LOGS, "async logging", log_async_enabled);
+    log_async_buffer_size = (size_t)config_get_number(CONFIG_SECTION_LOGS, "async log buffer per thread", (long long)log_async_buffer_size);
+
     setenv("NETDATA_ERRORS_THROTTLE_PERIOD", config_get(CONFIG_SECTION_LOGS, "errors flood protection period"    , ""), 1);
     setenv("NETDATA_ERRORS_PER_PERIOD",      config_get(CONFIG_SECTION_LOGS, "errors to trigger flood protection", ""), 1);
 }
@@ -1047,6 +1095,7 @@ static void get_netdata_configured_variables() {
 
     default_rrdeng_page_cache_mb = (int) config_get_number(CONFIG_SECTION_DB, "dbengine page cache size MB", default_rrdeng_page_cache_mb);
     db_engine_journal_check = config_get_boolean(CONFIG_SECTION_DB, "dbengine enable journal integrity check", CONFIG_BOOLEAN_NO);
+    db_engine_parallel_initialization = config_get_boolean(CONFIG_SECTION_DB, "dbengine parallel initialization", CONFIG_BOOLEAN_YES);
 
     if(default_rrdeng_page_cache_mb < RRDENG_MIN_PAGE_CACHE_SIZE_MB) {
         error("Invalid page cache size %d given. Defaulting to %d.", default_rrdeng_page_cache_mb, RRDENG_MIN_PAGE_CACHE_SIZE_MB);
@@ -1095,6 +1144,9 @@ static void get_netdata_configured_variables() {
     default_metric_correlations_method = weights_string_to_method(config_get(
         CONFIG_SECTION_GLOBAL, "metric correlations method",
         weights_method_to_string(default_metric_correlations_method)));
+    metric_correlations_threads = (int)config_get_number(CONFIG_SECTION_GLOBAL, "metric correlations threads", metric_correlations_threads);
+    if(metric_correlations_threads < 1)
+        metric_correlations_threads = 1;
 
     // --------------------------------------------------------------------
 
@@ -1242,6 +1294,27 @@ void post_conf_load(char **user)
     appconfig_get(&cloud_config, CONFIG_SECTION_GLOBAL, "cloud base url", DEFAULT_CLOUD_BASE_URL);
 }
 
+#ifdef ENABLE_DBENGINE
+// the minimum initialization the DB engine dataset tools need, like the unittests do
+static int dbengine_dataset_init(char **user)
+{
+    post_conf_load(user);
+    get_netdata_configured_variables();
+    default_rrd_update_every = 1;
+    default_rrd_memory_mode = RRD_MEMORY_MODE_RAM;
+    default_health_enabled = 0;
+    default_rrdpush_enabled = 0;
+    storage_tiers = 1;
+    registry_init();
+    if(rrd_init("unittest", NULL, true)) {
+        fprintf(stderr, "rrd_init failed for the DB engine dataset\n");
+        return 1;
+    }
+
+    return 0;
+}
+#endif
+
 #define delta_startup_time(msg)                         \
     {                                                   \
         usec_t now_ut = now_monotonic_usec();           \
@@ -1354,6 +1427,7 @@ int main(int argc, char **argv) {
                         char* claim_string = "claim";
 #ifdef ENABLE_DBENGINE
                         char* createdataset_string = "createdataset=";
+                        char* loaddataset_string = "loaddataset=";
                         char* stresstest_string = "stresstest=";
 #endif
                         if(strcmp(optarg, "sqlite-check") == 0) {
@@ -1382,6 +1456,14 @@ int main(int argc, char **argv) {
                                 return 1;
                             if (unit_test_bitmap256())
                                 return 1;
+                            if (quantile_sketch_unittest())
+                                return 1;
+                            if (hyperloglog_unittest())
+                                return 1;
+                            if (grouping_unittest(false))
+                                return 1;
+                            if (query_plan_unittest())
+                                return 1;
                             // No call to load the config file on this code-path
                             post_conf_load(&user);
                             get_netdata_configured_variables();
@@ -1397,6 +1479,7 @@ int main(int argc, char **argv) {
                             default_rrdpush_enabled = 0;
                             if(run_all_mockup_tests()) return 1;
                             if(unit_test_storage()) return 1;
+                            if(unit_test_query_interruption()) return 1;
 #ifdef ENABLE_DBENGINE
                             if(test_dbengine()) return 1;
 #endif
@@ -1416,6 +1499,10 @@ int main(int argc, char **argv) {
                         else if(strcmp(optarg, "escapetest") == 0) {
                             return command_argument_sanitization_tests();
                         }
+                        else if(strcmp(optarg, "grouptest") == 0) {
+                            unittest_running = true;
+                            return grouping_unittest(true);
+                        }
 #ifdef ENABLE_DBENGINE
                         else if(strcmp(optarg, "mctest") == 0) {
                             unittest_running = true;
@@ -1453,6 +1540,10 @@ int main(int argc, char **argv) {
                             unittest_running = true;
                             return mrg_unittest();
                         }
+                        else if(strcmp(optarg, "mltest") == 0) {
+                            unittest_running = true;
+                            return ml_unittest();
+                        }
                         else if(strcmp(optarg, "julytest") == 0) {
                             unittest_running = true;
                             return julytest();
@@ -1460,9 +1551,26 @@ int main(int argc, char **argv) {
                         else if(strncmp(optarg, createdataset_string, strlen(createdataset_string)) == 0) {
                             optarg += strlen(createdataset_string);
                             unsigned history_seconds = strtoul(optarg, NULL, 0);
+                            if(dbengine_dataset_init(&user))
+                                return 1;
                             generate_dbengine_dataset(history_seconds);
                             return 0;
                         }
+                        else if(strncmp(optarg, loaddataset_string, strlen(loaddataset_string)) == 0) {
+                            optarg += strlen(loaddataset_string);
+                            int parallel;
+                            if(strcmp(optarg, "serial") == 0)
+                                parallel = 0;
+                            else if(strcmp(optarg, "parallel") == 0)
+                                parallel = 1;
+                            else {
+                                fprintf(stderr, "loaddataset accepts 'serial' or 'parallel'\n");
+                                return 1;
+                            }
+                            if(dbengine_dataset_init(&user))
+                                return 1;
+                            return load_dbengine_dataset(parallel);
+                        }
                         else if(strncmp(optarg, stresstest_string, strlen(stresstest_string)) == 0) {
                             char *endptr;
                             unsigned test_duration_sec = 0, dset_charts = 0, query_threads = 0, ramp_up_seconds = 0,
@@ -1482,6 +1590,9 @@ int main(int argc, char **argv) {
                                 disk_space_mb = (unsigned)strtoul(endptr + 1, &endptr, 0);
                             if (',' == *endptr)
                                 workers = (unsigned)strtoul(endptr + 1, &endptr, 0);
+                            const char *compression = NULL;
+                            if (',' == *endptr)
+                                compression = endptr + 1;
 
                             if (workers > 1024)
                                 workers = 1024;
@@ -1489,8 +1600,10 @@ int main(int argc, char **argv) {
                             char workers_str[16];
                             snprintf(workers_str, 15, "%u", workers);
                             setenv("UV_THREADPOOL_SIZE", workers_str, 1);
+                            if(dbengine_dataset_init(&user))
+                                return 1;
                             dbengine_stress_test(test_duration_sec, dset_charts, query_threads, ramp_up_seconds,
-                                                 page_cache_mb, disk_space_mb);
+                                                 page_cache_mb, disk_space_mb, compression);
                             return 0;
                         }
 #endif
@@ -1972,6 +2085,10 @@ int main(int argc, char **argv) {
     // ------------------------------------------------------------------------
     // spawn the threads
 
+    delta_startup_time("start the logger thread");
+
+    log_async_start();
+
     delta_startup_time("start the static threads");
 
     web_server_config_options();
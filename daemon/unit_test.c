@@ -1575,6 +1575,160 @@ int unit_test(long delay, long shift)
     return ret;
 }
 
+// ----------------------------------------------------------------------------
+// the queries of a web client are interrupted when the client goes away
+
+struct query_interruption_test {
+    const char *name;
+    bool http10;            // the client made an HTTP/1.0 request
+    int client_action;      // what the client does while the query runs
+    bool expect_cancel;     // true when the query should be interrupted
+
+    struct web_client w;
+    int client_fd;
+    size_t calls;
+};
+
+#define QIT_CLIENT_WAITS    0
+#define QIT_CLIENT_CLOSES   1
+#define QIT_CLIENT_SHUTDOWN 2
+
+static bool query_interruption_test_callback(void *data) {
+    struct query_interruption_test *t = data;
+
+    // the first call is made after the first dimension has been queried
+    if(!t->calls++) {
+        if(t->client_action == QIT_CLIENT_CLOSES) {
+            close(t->client_fd);
+            t->client_fd = -1;
+        }
+        else if(t->client_action == QIT_CLIENT_SHUTDOWN)
+            shutdown(t->client_fd, SHUT_WR);
+    }
+
+    return web_client_interrupt_callback(&t->w);
+}
+
+// connects a client to a listening socket on localhost, over TCP like the web clients
+static bool query_interruption_test_connect(int *server_fd, int *client_fd) {
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK), .sin_port = 0 };
+    socklen_t sa_len = sizeof(sa);
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(listen_fd == -1)
+        return false;
+
+    if(bind(listen_fd, (struct sockaddr *)&sa, sa_len) == -1 ||
+       listen(listen_fd, 1) == -1 ||
+       getsockname(listen_fd, (struct sockaddr *)&sa, &sa_len) == -1) {
+        close(listen_fd);
+        return false;
+    }
+
+    *client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(*client_fd == -1 || connect(*client_fd, (struct sockaddr *)&sa, sa_len) == -1) {
+        if(*client_fd != -1) close(*client_fd);
+        close(listen_fd);
+        return false;
+    }
+
+    *server_fd = accept(listen_fd, NULL, NULL);
+    close(listen_fd);
+
+    if(*server_fd == -1) {
+        close(*client_fd);
+        return false;
+    }
+
+    return true;
+}
+
+int unit_test_query_interruption(void) {
+    fprintf(stderr, "%s() running...\n", __FUNCTION__ );
+
+    default_rrd_memory_mode = RRD_MEMORY_MODE_ALLOC;
+    default_rrd_update_every = 1;
+
+    RRDSET *st = rrdset_create_localhost("netdata", "unittest-query-interruption", NULL, "netdata", NULL
+                                         , "Unit Testing Query Interruption", "a value", "unittest", NULL, 1, 1
+                                         , RRDSET_TYPE_LINE);
+    RRDDIM *rd1 = rrddim_add(st, "dim1", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+    RRDDIM *rd2 = rrddim_add(st, "dim2", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+    for(collected_number c = 0; c < 100 ; c++) {
+        if(c)
+            st->usec_since_last_update = USEC_PER_SEC;
+
+        rrddim_set_by_pointer(st, rd1, c);
+        rrddim_set_by_pointer(st, rd2, c);
+
+        struct timeval now;
+        now_realtime_timeval(&now);
+        rrdset_timed_done(st, now, false);
+    }
+
+    struct query_interruption_test tests[] = {
+        { .name = "client waits",                   .http10 = false, .client_action = QIT_CLIENT_WAITS,    .expect_cancel = false },
+        { .name = "keep-alive client closes",       .http10 = false, .client_action = QIT_CLIENT_CLOSES,   .expect_cancel = true  },
+        { .name = "keep-alive client shuts down",   .http10 = false, .client_action = QIT_CLIENT_SHUTDOWN, .expect_cancel = true  },
+        { .name = "HTTP/1.0 client shuts down",     .http10 = true,  .client_action = QIT_CLIENT_SHUTDOWN, .expect_cancel = false },
+        { .name = NULL },
+    };
+
+    int errors = 0;
+    for(struct query_interruption_test *t = tests; t->name ; t++) {
+        int server_fd;
+        if(!query_interruption_test_connect(&server_fd, &t->client_fd)) {
+            fprintf(stderr, "    query interruption: cannot connect a client on localhost ### E R R O R ###\n");
+            return 1;
+        }
+
+        t->w.ifd = t->w.ofd = server_fd;
+        t->w.acl = WEB_CLIENT_ACL_DASHBOARD;
+        if(t->http10)
+            web_client_enable_half_close(&t->w);
+
+        QUERY_TARGET_REQUEST qtr = {
+                .st = st,
+                .points = 10,
+                .after = rrdset_first_entry_s(st),
+                .before = rrdset_last_entry_s(st),
+                .group_method = RRDR_GROUPING_AVERAGE,
+                .query_source = QUERY_SOURCE_UNITTEST,
+                .priority = STORAGE_PRIORITY_NORMAL,
+                .interrupt_callback = query_interruption_test_callback,
+                .interrupt_callback_data = t,
+        };
+
+        ONEWAYALLOC *owa = onewayalloc_create(0);
+        RRDR *r = rrd2rrdr(owa, query_target_create(&qtr));
+        if(!r) {
+            fprintf(stderr, "    query interruption: %s, empty RRDR ### E R R O R ###\n", t->name);
+            errors++;
+        }
+        else {
+            bool cancelled = (r->result_options & RRDR_RESULT_OPTION_CANCEL) ? true : false;
+            if(cancelled != t->expect_cancel || !t->calls) {
+                fprintf(stderr, "    query interruption: %s, the query was %s after %zu callback calls ### E R R O R ###\n",
+                        t->name, cancelled ? "cancelled" : "not cancelled", t->calls);
+                errors++;
+            }
+            else
+                fprintf(stderr, "    query interruption: %s, the query was %s - passed\n",
+                        t->name, cancelled ? "cancelled" : "not cancelled");
+
+            rrdr_free(owa, r);
+        }
+        onewayalloc_destroy(owa);
+
+        close(server_fd);
+        if(t->client_fd != -1)
+            close(t->client_fd);
+    }
+
+    return errors;
+}
+
 int test_sqlite(void) {
     fprintf(stderr, "%s() running...\n", __FUNCTION__ );
     sqlite3  *db_meta;
@@ -2266,7 +2420,10 @@ static void generate_dbengine_chart(void *arg)
             rrddim_set_by_pointer_fake_time(rd[j], value, time_current);
             ++thread_info->stored_metrics_nr;
         }
-        rrdset_done(st);
+
+        // store the points at their fake time, not now
+        struct timeval now = { .tv_sec = time_current, .tv_usec = 0 };
+        rrdset_timed_done(st, now, false);
         thread_info->time_max = time_current;
     }
     for (j = 0; j < DSET_DIMS; ++j) {
@@ -2330,10 +2487,50 @@ void generate_dbengine_dataset(unsigned history_seconds)
     }
     freez(thread_info);
     rrd_wrlock();
-    rrdhost_free___while_having_rrd_wrlock(host, true);
+    // flush the dataset to disk, but keep its files
+    rrdeng_prepare_exit((struct rrdengine_instance *)host->db[0].instance);
+    rrdeng_exit((struct rrdengine_instance *)host->db[0].instance);
     rrd_unlock();
 }
 
+int load_dbengine_dataset(int parallel)
+{
+    struct rrdengine_instance *ctx = NULL;
+    char dbenginepath[FILENAME_MAX + 1];
+    struct stat st;
+
+    // the directory generate_dbengine_dataset() writes to
+    snprintfz(dbenginepath, FILENAME_MAX, "%s/dbengine-dataset/dbengine", netdata_configured_cache_dir);
+    if (stat(dbenginepath, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "DB engine dataset not found in '%s', create it with -W createdataset=N\n", dbenginepath);
+        return 1;
+    }
+
+    default_rrdeng_page_cache_mb = 128;
+    db_engine_parallel_initialization = parallel;
+    error_log_limit_unlimited();
+
+    fprintf(stderr, "\nLoading the DB engine dataset from '%s' with %s journal loading...\n",
+            dbenginepath, parallel ? "parallel" : "serial");
+
+    usec_t started_ut = now_monotonic_usec();
+    int ret = rrdeng_init(NULL, &ctx, dbenginepath, default_rrdeng_page_cache_mb, default_rrdeng_disk_quota_mb, 0);
+    usec_t ended_ut = now_monotonic_usec();
+
+    if (ret) {
+        fprintf(stderr, "Failed to load the DB engine dataset from '%s'\n", dbenginepath);
+        return 1;
+    }
+
+    RRDENG_SIZE_STATS stats = rrdeng_size_statistics(ctx);
+    fprintf(stderr, "Loaded %zu datafiles with %zu metrics, %zu pages and %zu points in %llu ms\n",
+            stats.datafiles, stats.metrics, stats.metrics_pages, stats.points, (ended_ut - started_ut) / USEC_PER_MS);
+
+    rrdeng_prepare_exit(ctx);
+    rrdeng_exit(ctx);
+    return 0;
+}
+
 struct dbengine_query_thread {
     uv_thread_t thread;
     RRDHOST *host;
@@ -2455,7 +2652,8 @@ static void query_dbengine_chart(void *arg)
 }
 
 void dbengine_stress_test(unsigned TEST_DURATION_SEC, unsigned DSET_CHARTS, unsigned QUERY_THREADS,
-                          unsigned RAMP_UP_SECONDS, unsigned PAGE_CACHE_MB, unsigned DISK_SPACE_MB)
+                          unsigned RAMP_UP_SECONDS, unsigned PAGE_CACHE_MB, unsigned DISK_SPACE_MB,
+                          const char *COMPRESSION)
 {
     fprintf(stderr, "%s() running...\n", __FUNCTION__ );
     const unsigned DSET_DIMS = 128;
@@ -2491,6 +2689,25 @@ void dbengine_stress_test(unsigned TEST_DURATION_SEC, unsigned DSET_CHARTS, unsi
         default_rrdeng_disk_quota_mb -= default_rrdeng_disk_quota_mb * EXPECTED_COMPRESSION_RATIO / 100;
     }
 
+    if (COMPRESSION && *COMPRESSION) {
+        // METHOD or METHOD:LEVEL
+        char method[20 + 1];
+        strncpyz(method, COMPRESSION, 20);
+        int level = 0;
+        char *colon = strchr(method, ':');
+        if (colon) {
+            *colon = '\0';
+            level = (int)str2l(colon + 1);
+        }
+
+        if (!rrdeng_compression_set(&rrdeng_tier_compression[0], method, level)) {
+            fprintf(stderr, "Unknown or unsupported compression '%s'.\n", COMPRESSION);
+            return;
+        }
+    }
+    fprintf(stderr, "Extents are compressed with %s, level %d.\n",
+            rrdeng_compression_method_name(rrdeng_tier_compression[0].method), rrdeng_tier_compression[0].level);
+
     fprintf(stderr, "Initializing localhost with hostname 'dbengine-stress-test'\n");
 
     (void) sql_init_database(DB_CHECK_NONE, 1);
@@ -2592,9 +2809,29 @@ void dbengine_stress_test(unsigned TEST_DURATION_SEC, unsigned DSET_CHARTS, unsi
     }
     freez(query_threads);
     rrd_wrlock();
-    rrdeng_prepare_exit((struct rrdengine_instance *)host->db[0].instance);
-    rrdhost_delete_charts(host);
-    rrdeng_exit((struct rrdengine_instance *)host->db[0].instance);
+    // flush the dataset to disk, but keep its files
+    struct rrdengine_instance *ctx = (struct rrdengine_instance *)host->db[0].instance;
+    rrdeng_prepare_exit(ctx);
+
+    // everything has been flushed at this point
+    time_t flush_duration = now_realtime_sec() - (time_start - HISTORY_SECONDS);
+    if (!flush_duration)
+        flush_duration = 1;
+
+    uint64_t before_compress_bytes = ctx->stats.before_compress_bytes;
+    uint64_t after_compress_bytes = ctx->stats.after_compress_bytes;
+    uint64_t extent_bytes = ctx->stats.io_write_extent_bytes;
+    uint64_t extents = ctx->stats.io_write_extents;
+    fprintf(stderr, "%llu extents were written (%llu KiB on disk on average), with %s level %d.\n",
+            (unsigned long long)extents, (unsigned long long)(extents ? extent_bytes / extents / 1024 : 0),
+            rrdeng_compression_method_name(ctx->compression.method), ctx->compression.level);
+    fprintf(stderr, "Compression ratio is %0.2f (%llu MiB to %llu MiB), "
+                    "flush throughput is %llu uncompressed KiB/sec (%lld seconds including the final flush).\n",
+            after_compress_bytes ? (double)before_compress_bytes / (double)after_compress_bytes : 0.0,
+            (unsigned long long)(before_compress_bytes / (1024 * 1024)), (unsigned long long)(after_compress_bytes / (1024 * 1024)),
+            (unsigned long long)(before_compress_bytes / 1024 / flush_duration), (long long)flush_duration);
+
+    rrdeng_exit(ctx);
     rrd_unlock();
 }
 
@@ -11,13 +11,16 @@ int run_all_mockup_tests(void);
 int unit_test_str2ld(void);
 int unit_test_buffer(void);
 int unit_test_static_threads(void);
+int unit_test_query_interruption(void);
 int test_sqlite(void);
 int unit_test_bitmap256(void);
 #ifdef ENABLE_DBENGINE
 int test_dbengine(void);
 void generate_dbengine_dataset(unsigned history_seconds);
+int load_dbengine_dataset(int parallel);
 void dbengine_stress_test(unsigned TEST_DURATION_SEC, unsigned DSET_CHARTS, unsigned QUERY_THREADS,
-                                 unsigned RAMP_UP_SECONDS, unsigned PAGE_CACHE_MB, unsigned DISK_SPACE_MB);
+                                 unsigned RAMP_UP_SECONDS, unsigned PAGE_CACHE_MB, unsigned DISK_SPACE_MB,
+                                 const char *COMPRESSION);
 
 #endif
 
@@ -420,11 +420,12 @@ struct section_pages {
 };
 
 static ARAL section_pages_aral = {
-        .filename = NULL,
+        .filename = "pgc_section_pages",
         .cache_dir = NULL,
         .use_mmap = false,
         .initial_elements = 16384 / sizeof(struct section_pages),
         .requested_element_size = sizeof(struct section_pages),
+        .magazine_elements = ARAL_DEFAULT_MAGAZINE_ELEMENTS,
 };
 
 static void pgc_stats_ll_judy_change(PGC *cache, struct pgc_linked_list *ll, size_t mem_before_judyl, size_t mem_after_judyl) {
@@ -1752,7 +1753,7 @@ PGC *pgc_create(size_t clean_size_bytes, free_clean_page_callback pgc_free_cb,
 
 #ifdef PGC_WITH_ARAL
     cache->aral = arrayalloc_create(sizeof(PGC_PAGE) + cache->config.additional_bytes_per_page, 65536 / sizeof(PGC_PAGE),
-                                    NULL, NULL, false, false);
+                                    "pgc_pages", NULL, false, false, ARAL_DEFAULT_MAGAZINE_ELEMENTS);
 #endif
 
     pointer_index_init(cache);
@@ -1828,6 +1829,76 @@ void pgc_page_hot_to_dirty_and_release(PGC *cache, PGC_PAGE *page) {
     }
 }
 
+void pgc_pages_hot_to_dirty_and_release(PGC *cache, PGC_PAGE **pages, size_t count) {
+    if(unlikely(!count))
+        return;
+
+    __atomic_add_fetch(&cache->stats.workers_hot2dirty, 1, __ATOMIC_RELAXED);
+
+    // the pages we move from hot to dirty in one go
+    // are kept transition locked from the hot queue to the dirty queue
+    bool moved[count];
+    size_t moved_count = 0;
+
+    // to avoid deadlocks, we have to get the hot lock before the page transitions
+    // since this is what all_hot_to_dirty() does
+    pgc_ll_lock(cache, &cache->hot);
+
+    for(size_t i = 0; i < count ; i++) {
+        PGC_PAGE *page = pages[i];
+        moved[i] = false;
+
+        page_transition_lock(cache, page);
+
+        if(likely(is_page_hot(page))) {
+            pgc_ll_del(cache, &cache->hot, page, true);
+            moved[i] = true;
+            moved_count++;
+        }
+        else
+            page_transition_unlock(cache, page);
+    }
+
+    pgc_ll_unlock(cache, &cache->hot);
+
+    if(moved_count) {
+        pgc_ll_lock(cache, &cache->dirty);
+
+        for(size_t i = 0; i < count ; i++) {
+            if(!moved[i])
+                continue;
+
+            // first add to linked list, the set the flag (required for move_page_last())
+            pgc_ll_add(cache, &cache->dirty, pages[i], true);
+        }
+
+        pgc_ll_unlock(cache, &cache->dirty);
+
+        for(size_t i = 0; i < count ; i++) {
+            if(moved[i])
+                page_transition_unlock(cache, pages[i]);
+        }
+    }
+
+    for(size_t i = 0; i < count ; i++) {
+        // pages that were not hot anymore, take the slow path
+        if(unlikely(!moved[i]))
+            page_set_dirty(cache, pages[i], false);
+
+        // release the page
+        page_release(cache, pages[i], i == count - 1);
+        // page ptr may be invalid now
+    }
+
+    __atomic_sub_fetch(&cache->stats.workers_hot2dirty, 1, __ATOMIC_RELAXED);
+
+    // flush, if we have to
+    if((cache->config.options & PGC_OPTIONS_FLUSH_PAGES_INLINE) || flushing_critical(cache)) {
+        flush_pages(cache, cache->config.max_flushes_inline, PGC_SECTION_ALL,
+                    false, false);
+    }
+}
+
 bool pgc_page_to_clean_evict_or_release(PGC *cache, PGC_PAGE *page) {
     bool ret;
 
@@ -2634,6 +2705,25 @@ int pgc_unittest(void) {
     pgc_page_hot_set_end_time_s(cache, page3, 2001);
     pgc_page_hot_to_dirty_and_release(cache, page3);
 
+    // make dirty many hot pages in one batch
+    PGC_PAGE *batch[3];
+    for(size_t i = 0; i < 3 ; i++) {
+        batch[i] = pgc_page_add_and_acquire(cache, (PGC_ENTRY){
+                .section = 4,
+                .metric_id = 10 + i,
+                .start_time_s = 1001,
+                .end_time_s = 2000,
+                .size = 4096,
+                .data = NULL,
+                .hot = true,
+        }, NULL);
+    }
+
+    size_t dirty_entries = __atomic_load_n(&cache->dirty.stats->entries, __ATOMIC_RELAXED);
+    pgc_pages_hot_to_dirty_and_release(cache, batch, 3);
+    if(__atomic_load_n(&cache->dirty.stats->entries, __ATOMIC_RELAXED) != dirty_entries + 3)
+        fatal("batch of hot pages was not made dirty");
+
     pgc_destroy(cache);
 
 #ifdef PGC_STRESS_TEST
@@ -186,6 +186,9 @@ void pgc_page_release(PGC *cache, PGC_PAGE *page);
 // mark a hot page dirty, and release it
 void pgc_page_hot_to_dirty_and_release(PGC *cache, PGC_PAGE *page);
 
+// mark many hot pages dirty and release them, locking the hot and dirty queues once
+void pgc_pages_hot_to_dirty_and_release(PGC *cache, PGC_PAGE **pages, size_t count);
+
 // find a page from the cache
 typedef enum {
     PGC_SEARCH_EXACT,
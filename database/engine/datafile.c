@@ -350,7 +350,7 @@ static int load_data_file(struct rrdengine_datafile *datafile)
     generate_datafilepath(datafile, path, sizeof(path));
     fd = open_file_direct_io(path, O_RDWR, &file);
     if (fd < 0) {
-        ++ctx->stats.fs_errors;
+        __atomic_add_fetch(&ctx->stats.fs_errors, 1, __ATOMIC_RELAXED);
         rrd_stat_atomic_add(&global_fs_errors, 1);
         return fd;
     }
@@ -364,8 +364,8 @@ static int load_data_file(struct rrdengine_datafile *datafile)
     ret = check_data_file_superblock(file);
     if (ret)
         goto error;
-    ctx->stats.io_read_bytes += sizeof(struct rrdeng_df_sb);
-    ++ctx->stats.io_read_requests;
+    __atomic_add_fetch(&ctx->stats.io_read_bytes, sizeof(struct rrdeng_df_sb), __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ctx->stats.io_read_requests, 1, __ATOMIC_RELAXED);
 
     datafile->file = file;
     datafile->pos = file_size;
@@ -378,7 +378,7 @@ static int load_data_file(struct rrdengine_datafile *datafile)
     ret = uv_fs_close(NULL, &req, file, NULL);
     if (ret < 0) {
         error("DBENGINE: uv_fs_close(%s): %s", path, uv_strerror(ret));
-        ++ctx->stats.fs_errors;
+        __atomic_add_fetch(&ctx->stats.fs_errors, 1, __ATOMIC_RELAXED);
         rrd_stat_atomic_add(&global_fs_errors, 1);
     }
     uv_fs_req_cleanup(&req);
@@ -397,12 +397,65 @@ static int scan_data_files_cmp(const void *a, const void *b)
     return strcmp(path1, path2);
 }
 
+struct datafile_loading {
+    struct rrdengine_datafile **datafiles;
+    int *datafile_ret;
+    bool *journal_v2_loaded;
+    unsigned files;
+    unsigned next;
+};
+
+/*
+ * Opens a datafile and loads the journal v2 of it, populating the MRG.
+ * Safe to run in parallel for different datafiles of the same instance.
+ */
+static void load_data_and_journal_v2_file(struct datafile_loading *dl, unsigned i)
+{
+    struct rrdengine_datafile *datafile = dl->datafiles[i];
+    struct rrdengine_instance *ctx = datafile->ctx;
+
+    dl->datafile_ret[i] = load_data_file(datafile);
+    dl->journal_v2_loaded[i] = false;
+
+    // Do not try to load the latest file (always rebuild and live migrate)
+    if (!dl->datafile_ret[i] && datafile->fileno != ctx->last_fileno)
+        dl->journal_v2_loaded[i] = !load_journal_file_v2(ctx, datafile->journalfile, datafile);
+}
+
+static void load_data_and_journal_v2_files_worker(void *arg)
+{
+    struct datafile_loading *dl = arg;
+    unsigned i;
+
+    while ((i = __atomic_fetch_add(&dl->next, 1, __ATOMIC_RELAXED)) < dl->files)
+        load_data_and_journal_v2_file(dl, i);
+}
+
+static void load_data_and_journal_v2_files(struct datafile_loading *dl)
+{
+    unsigned threads = 1;
+    if (db_engine_parallel_initialization)
+        threads = MIN(dl->files, (unsigned)get_system_cpus());
+
+    if (threads <= 1) {
+        load_data_and_journal_v2_files_worker(dl);
+        return;
+    }
+
+    uv_thread_t workers[threads];
+    for (unsigned t = 0; t < threads; t++)
+        fatal_assert(0 == uv_thread_create(&workers[t], load_data_and_journal_v2_files_worker, dl));
+
+    for (unsigned t = 0; t < threads; t++)
+        fatal_assert(0 == uv_thread_join(&workers[t]));
+}
+
 /* Returns number of datafiles that were loaded or < 0 on error */
 static int scan_data_files(struct rrdengine_instance *ctx)
 {
     int ret;
     unsigned tier, no, matched_files, i,failed_to_load;
-    static uv_fs_t req;
+    uv_fs_t req;
     uv_dirent_t dent;
     struct rrdengine_datafile **datafiles, *datafile;
     struct rrdengine_journalfile *journalfile;
@@ -439,22 +492,38 @@ static int scan_data_files(struct rrdengine_instance *ctx)
     /* TODO: change this when tiering is implemented */
     ctx->last_fileno = datafiles[matched_files - 1]->fileno;
 
+    for (i = 0 ; i < matched_files ; ++i) {
+        datafile = datafiles[i];
+        journalfile = mallocz(sizeof(*journalfile));
+        datafile->journalfile = journalfile;
+        journalfile_init(journalfile, datafile);
+    }
+
+    // open the datafiles and load their journal v2 files in parallel,
+    // the rest of the loading depends on the order of the files
+    struct datafile_loading dl = {
+        .datafiles = datafiles,
+        .datafile_ret = callocz(matched_files, sizeof(int)),
+        .journal_v2_loaded = callocz(matched_files, sizeof(bool)),
+        .files = matched_files,
+        .next = 0,
+    };
+    load_data_and_journal_v2_files(&dl);
+
     for (failed_to_load = 0, i = 0 ; i < matched_files ; ++i) {
         uint8_t must_delete_pair = 0;
 
         datafile = datafiles[i];
-        ret = load_data_file(datafile);
-        if (0 != ret) {
+        journalfile = datafile->journalfile;
+        if (0 != dl.datafile_ret[i]) {
             must_delete_pair = 1;
         }
-        journalfile = mallocz(sizeof(*journalfile));
-        datafile->journalfile = journalfile;
-        journalfile_init(journalfile, datafile);
-        ret = load_journal_file(ctx, journalfile, datafile);
-        if (0 != ret) {
-            if (!must_delete_pair) /* If datafile is still open close it */
+        else if (!dl.journal_v2_loaded[i]) {
+            ret = load_journal_file(ctx, journalfile, datafile);
+            if (0 != ret) {
                 close_data_file(datafile);
-            must_delete_pair = 1;
+                must_delete_pair = 1;
+            }
         }
         if (must_delete_pair) {
             char path[RRDENG_PATH_MAX];
@@ -480,6 +549,8 @@ static int scan_data_files(struct rrdengine_instance *ctx)
         ctx->disk_space += datafile->pos + journalfile->pos;
     }
     matched_files -= failed_to_load;
+    freez(dl.datafile_ret);
+    freez(dl.journal_v2_loaded);
     freez(datafiles);
 
     return matched_files;
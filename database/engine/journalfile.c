@@ -4,10 +4,10 @@
 
 // DBENGINE2: Helper
 
-static void update_metric_retention_and_granularity_by_uuid(
-        struct rrdengine_instance *ctx, uuid_t *uuid,
+static void metric_retention_and_granularity_by_uuid_to_mrg_entry(
+        MRG_ENTRY *entry, struct rrdengine_instance *ctx, uuid_t *uuid,
         time_t first_time_s, time_t last_time_s,
-        time_t update_every_s, time_t now_s)
+        time_t update_every_s, time_t now_s, unsigned datafile_fileno)
 {
     if(last_time_s > now_s) {
         error_limit_static_global_var(erl, 1, 0);
@@ -35,21 +35,12 @@ static void update_metric_retention_and_granularity_by_uuid(
                     first_time_s, last_time_s, now_s);
     }
 
-    MRG_ENTRY entry = {
-            .section = (Word_t)ctx,
-            .first_time_s = first_time_s,
-            .last_time_s = last_time_s,
-            .latest_update_every_s = update_every_s
-    };
-    uuid_copy(entry.uuid, *uuid);
-
-    bool added;
-    METRIC *metric = mrg_metric_add_and_acquire(main_mrg, entry, &added);
-
-    if (likely(!added))
-        mrg_metric_expand_retention(main_mrg, metric, first_time_s, last_time_s, update_every_s);
-
-    mrg_metric_release(main_mrg, metric);
+    entry->section = (Word_t)ctx;
+    entry->first_time_s = first_time_s;
+    entry->last_time_s = last_time_s;
+    entry->latest_update_every_s = update_every_s;
+    entry->datafiles_bitmap = MRG_DATAFILE_BIT(datafile_fileno);
+    uuid_copy(entry->uuid, *uuid);
 }
 
 static void flush_transaction_buffer_cb(uv_fs_t* req)
@@ -84,26 +75,29 @@ void wal_flush_transaction_buffer(struct rrdengine_instance *ctx, struct rrdengi
     struct generic_io_descriptor *io_descr;
     struct rrdengine_journalfile *journalfile = datafile->journalfile;
 
+    /* transactions may span multiple blocks - write only the blocks used */
+    size_t bytes = ALIGN_BYTES_CEILING(wal->size);
+
     io_descr = &wal->io_descr;
     io_descr->ctx = ctx;
-    if (wal->size < wal->buf_size) {
+    if (wal->size < bytes) {
         /* simulate an empty transaction to skip the rest of the block */
         *(uint8_t *) (wal->buf + wal->size) = STORE_PADDING;
     }
     io_descr->buf = wal->buf;
-    io_descr->bytes = wal->buf_size;
+    io_descr->bytes = bytes;
     io_descr->pos = journalfile->pos;
     io_descr->req.data = wal;
     io_descr->data = journalfile;
     io_descr->completion = NULL;
 
-    io_descr->iov = uv_buf_init((void *)io_descr->buf, wal->buf_size);
+    io_descr->iov = uv_buf_init((void *)io_descr->buf, bytes);
     ret = uv_fs_write(loop, &io_descr->req, journalfile->file, &io_descr->iov, 1,
                       journalfile->pos, flush_transaction_buffer_cb);
     fatal_assert(-1 != ret);
-    journalfile->pos += wal->buf_size;
-    ctx->disk_space += wal->buf_size;
-    ctx->stats.io_write_bytes += wal->buf_size;
+    journalfile->pos += bytes;
+    ctx->disk_space += bytes;
+    ctx->stats.io_write_bytes += bytes;
     ++ctx->stats.io_write_requests;
 }
 
@@ -458,6 +452,20 @@ static unsigned replay_transaction(struct rrdengine_instance *ctx, struct rrdeng
 
 
 #define READAHEAD_BYTES (RRDENG_BLOCK_SIZE * 256)
+
+/*
+ * Returns true when the transaction starting at buf is not padding and does not fit in max_size bytes.
+ */
+static bool transaction_is_truncated(void *buf, unsigned max_size)
+{
+    struct rrdeng_jf_transaction_header *jf_header = buf;
+
+    if (STORE_PADDING == jf_header->type || sizeof(*jf_header) > max_size)
+        return false;
+
+    return sizeof(*jf_header) + jf_header->payload_length + sizeof(struct rrdeng_jf_transaction_trailer) > max_size;
+}
+
 /*
  * Iterates journal file transactions and populates the page cache.
  * Page cache must already be initialized.
@@ -470,7 +478,7 @@ static uint64_t iterate_transactions(struct rrdengine_instance *ctx, struct rrde
     int ret;
     uint64_t pos, pos_i, max_id, id;
     unsigned size_bytes;
-    void *buf;
+    void *buf, *window;
     uv_buf_t iov;
     uv_fs_t req;
 
@@ -486,11 +494,13 @@ static uint64_t iterate_transactions(struct rrdengine_instance *ctx, struct rrde
             fatal("DBENGINE: posix_memalign:%s", strerror(ret));
     }
     else
-        buf = journalfile->data +  sizeof(struct rrdeng_jf_sb);
-    for (pos = sizeof(struct rrdeng_jf_sb) ; pos < file_size ; pos += READAHEAD_BYTES) {
+        buf = NULL;
+
+    for (pos = sizeof(struct rrdeng_jf_sb) ; pos < file_size ; pos += size_bytes) {
         size_bytes = MIN(READAHEAD_BYTES, file_size - pos);
         if (unlikely(!journal_is_mmapped)) {
-            iov = uv_buf_init(buf, size_bytes);
+            window = buf;
+            iov = uv_buf_init(window, size_bytes);
             ret = uv_fs_read(NULL, &req, file, &iov, 1, pos, NULL);
             if (ret < 0) {
                 error("DBENGINE: uv_fs_read: pos=%" PRIu64 ", %s", pos, uv_strerror(ret));
@@ -502,21 +512,27 @@ static uint64_t iterate_transactions(struct rrdengine_instance *ctx, struct rrde
             ++ctx->stats.io_read_requests;
             ctx->stats.io_read_bytes += size_bytes;
         }
+        else
+            window = journalfile->data + pos;
 
         for (pos_i = 0 ; pos_i < size_bytes ; ) {
             unsigned max_size;
 
-            max_size = pos + size_bytes - pos_i;
-            ret = replay_transaction(ctx, journalfile, buf + pos_i, &id, max_size);
-            if (!ret) /* TODO: support transactions bigger than 4K */
+            max_size = size_bytes - pos_i;
+            if (unlikely(pos_i && pos_i == ALIGN_BYTES_FLOOR(pos_i) && transaction_is_truncated(window + pos_i, max_size))) {
+                /* a multi-block transaction crosses the end of the window, read it again with the next one */
+                size_bytes = pos_i;
+                break;
+            }
+
+            ret = replay_transaction(ctx, journalfile, window + pos_i, &id, max_size);
+            if (!ret)
                 /* unknown transaction size, move on to the next block */
                 pos_i = ALIGN_BYTES_FLOOR(pos_i + RRDENG_BLOCK_SIZE);
             else
                 pos_i += ret;
             max_id = MAX(max_id, id);
         }
-        if (likely(journal_is_mmapped))
-            buf += size_bytes;
     }
 skip_file:
     if (unlikely(!journal_is_mmapped))
@@ -686,7 +702,7 @@ int load_journal_file_v2(struct rrdengine_instance *ctx, struct rrdengine_journa
     if (fd < 0) {
         if (errno == ENOENT)
             return 1;
-        ++ctx->stats.fs_errors;
+        __atomic_add_fetch(&ctx->stats.fs_errors, 1, __ATOMIC_RELAXED);
         rrd_stat_atomic_add(&global_fs_errors, 1);
         error("DBENGINE: failed to open '%s'", path);
         return 1;
@@ -746,19 +762,25 @@ int load_journal_file_v2(struct rrdengine_instance *ctx, struct rrdengine_journa
 
     struct journal_metric_list *metric = (struct journal_metric_list *) (data_start + j2_header->metric_offset);
 
-    // Initialize the journal file to be able to access the data
-    SET_JOURNAL_DATA(journalfile, data_start);
-    SET_JOURNAL_DATA_SIZE(journalfile, file_size);
-
     time_t header_start_time_s  = (time_t) (j2_header->start_time_ut / USEC_PER_SEC);
 
+    // populate the MRG in batches, to lock its index once per batch, not once per metric
+    size_t batch_size = MIN(entries, JOURNAL_V2_MRG_BATCH_SIZE);
+    MRG_ENTRY *batch = mallocz(batch_size * sizeof(MRG_ENTRY));
+    size_t batched = 0;
+
     time_t now_s = now_realtime_sec();
     for (size_t i=0; i < entries; i++) {
         time_t start_time_s = header_start_time_s + metric->delta_start_s;
         time_t end_time_s = header_start_time_s + metric->delta_end_s;
         time_t update_every_s = (metric->entries > 1) ? ((end_time_s - start_time_s) / (entries - 1)) : 0;
-        update_metric_retention_and_granularity_by_uuid(
-                ctx, &metric->uuid, start_time_s, end_time_s, update_every_s, now_s);
+        metric_retention_and_granularity_by_uuid_to_mrg_entry(
+                &batch[batched++], ctx, &metric->uuid, start_time_s, end_time_s, update_every_s, now_s, datafile->fileno);
+
+        if (batched == batch_size) {
+            mrg_metrics_add_or_expand_retention(main_mrg, batch, batched);
+            batched = 0;
+        }
 
 #ifdef NETDATA_INTERNAL_CHECKS
         struct journal_page_header *metric_list_header = (void *) (data_start + metric->page_offset);
@@ -768,6 +790,15 @@ int load_journal_file_v2(struct rrdengine_instance *ctx, struct rrdengine_journa
         metric++;
     }
 
+    if (batched)
+        mrg_metrics_add_or_expand_retention(main_mrg, batch, batched);
+    freez(batch);
+
+    // Initialize the journal file to be able to access the data
+    // after the metrics know they are in this datafile, so that queries do not skip it
+    SET_JOURNAL_DATA(journalfile, data_start);
+    SET_JOURNAL_DATA_SIZE(journalfile, file_size);
+
     info("DBENGINE: journal file '%s' loaded (size:%"PRIu64") with %u metrics in %d ms", path, file_size, entries,
          (int) ((now_realtime_usec() - start_loading) / USEC_PER_MS));
 
@@ -1017,6 +1048,9 @@ void do_migrate_to_v2_callback(Word_t section, unsigned datafile_fileno __maybe_
 
         fatal_assert(count < number_of_metrics);
         uuid_list[count++].metric_info = metric_info;
+
+        // queries need to search this datafile for the metric, once its index is activated
+        mrg_metric_add_datafile(main_mrg, (METRIC *) Index, datafile->fileno);
         min_time_s = MIN(min_time_s, metric_info->first_time_s);
         max_time_s = MAX(max_time_s, metric_info->last_time_s);
     }
@@ -1136,11 +1170,7 @@ int load_journal_file(struct rrdengine_instance *ctx, struct rrdengine_journalfi
     uint64_t file_size, max_id;
     char path[RRDENG_PATH_MAX];
 
-    // Do not try to load the latest file (always rebuild and live migrate)
-    if (datafile->fileno != ctx->last_fileno) {
-        if (!load_journal_file_v2(ctx, journalfile, datafile))
-            return 0;
-    }
+    // the caller has already tried to load the journal v2 of this file
 
     generate_journalfilepath(datafile, path, sizeof(path));
 
@@ -101,6 +101,9 @@ struct journal_v2_header {
 
 #define JOURNAL_V2_HEADER_PADDING_SZ (RRDENG_BLOCK_SIZE - (sizeof(struct journal_v2_header)))
 
+// metrics added to the MRG at once, while loading a journal v2 file
+#define JOURNAL_V2_MRG_BATCH_SIZE (1024)
+
 
 
 /* only one event loop is supported for now */
@@ -120,6 +123,8 @@ int destroy_journal_file_unsafe(struct rrdengine_journalfile *journalfile, struc
 int create_journal_file(struct rrdengine_journalfile *journalfile, struct rrdengine_datafile *datafile);
 int load_journal_file(struct rrdengine_instance *ctx, struct rrdengine_journalfile *journalfile,
                              struct rrdengine_datafile *datafile);
+int load_journal_file_v2(struct rrdengine_instance *ctx, struct rrdengine_journalfile *journalfile,
+                         struct rrdengine_datafile *datafile);
 void init_commit_log(struct rrdengine_instance *ctx);
 
 void do_migrate_to_v2_callback(Word_t section, unsigned datafile_fileno __maybe_unused, uint8_t type __maybe_unused,
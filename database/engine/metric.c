@@ -3,13 +3,24 @@
 typedef int32_t REFCOUNT;
 #define REFCOUNT_DELETING (-100)
 
-struct metric {
+// the MRG is partitioned by uuid, each partition has its own index and lock
+#define MRG_PARTITIONS 16
+
+// the uuid of a metric, shared by all the sections (tiers) the metric is in
+struct mrg_uuid {
     uuid_t uuid;                    // never changes
+    Pvoid_t sections_judy;          // a JudyL of the metrics of this uuid, by section
+};
+
+struct metric {
     Word_t section;                 // never changes
-    time_t first_time_s;            //
-    time_t latest_time_s_clean;     // archived pages latest time
-    time_t latest_time_s_hot;       // latest time of the currently collected page
+    uint32_t first_time_s;          // timestamps are stored as unsigned 32-bit seconds
+    uint32_t latest_time_s_clean;   // archived pages latest time
+    uint32_t latest_time_s_hot;     // latest time of the currently collected page
     uint32_t latest_update_every_s; //
+    uint64_t datafiles_bitmap;      // journal v2 indexed datafiles having pages of the metric
+
+    struct mrg_uuid *mu;            // never changes
     SPINLOCK timestamps_lock;       // protects the 3 timestamps
 
     // THIS IS allocated with malloc()
@@ -18,10 +29,11 @@ struct metric {
 
 struct mrg {
     struct pgc_index {
-        ARAL *aral;
+        ARAL *aral;                 // the metrics of this partition
+        ARAL *aral_uuids;           // the uuids of this partition
         netdata_rwlock_t rwlock;
         Pvoid_t uuid_judy;          // each UUID has a JudyL of sections (tiers)
-    } index;
+    } index[MRG_PARTITIONS];
 
     struct mrg_statistics stats;
 };
@@ -54,17 +66,23 @@ static inline void MRG_STATS_DELETE_MISS(MRG *mrg) {
     __atomic_add_fetch(&mrg->stats.delete_misses, 1, __ATOMIC_RELAXED);
 }
 
-static void mrg_index_read_lock(MRG *mrg) {
-    netdata_rwlock_rdlock(&mrg->index.rwlock);
+static inline size_t uuid_partition(uuid_t *uuid) {
+    uint64_t parts[2];
+    memcpy(parts, uuid, sizeof(parts));
+    return (size_t)((parts[0] ^ parts[1]) % MRG_PARTITIONS);
 }
-static void mrg_index_read_unlock(MRG *mrg) {
-    netdata_rwlock_unlock(&mrg->index.rwlock);
+
+static void mrg_index_read_lock(MRG *mrg, size_t partition) {
+    netdata_rwlock_rdlock(&mrg->index[partition].rwlock);
+}
+static void mrg_index_read_unlock(MRG *mrg, size_t partition) {
+    netdata_rwlock_unlock(&mrg->index[partition].rwlock);
 }
-static void mrg_index_write_lock(MRG *mrg) {
-    netdata_rwlock_wrlock(&mrg->index.rwlock);
+static void mrg_index_write_lock(MRG *mrg, size_t partition) {
+    netdata_rwlock_wrlock(&mrg->index[partition].rwlock);
 }
-static void mrg_index_write_unlock(MRG *mrg) {
-    netdata_rwlock_unlock(&mrg->index.rwlock);
+static void mrg_index_write_unlock(MRG *mrg, size_t partition) {
+    netdata_rwlock_unlock(&mrg->index[partition].rwlock);
 }
 
 static inline void mrg_stats_size_judyl_change(MRG *mrg, size_t mem_before_judyl, size_t mem_after_judyl) {
@@ -75,28 +93,38 @@ static inline void mrg_stats_size_judyl_change(MRG *mrg, size_t mem_before_judyl
 }
 
 static inline void mrg_stats_size_judyhs_added_uuid(MRG *mrg) {
-    __atomic_add_fetch(&mrg->stats.size, sizeof(uuid_t) * 3, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&mrg->stats.size, sizeof(uuid_t) * 2 + sizeof(struct mrg_uuid), __ATOMIC_RELAXED);
 }
 
 static inline void mrg_stats_size_judyhs_removed_uuid(MRG *mrg) {
-    __atomic_sub_fetch(&mrg->stats.size, sizeof(uuid_t) * 3, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&mrg->stats.size, sizeof(uuid_t) * 2 + sizeof(struct mrg_uuid), __ATOMIC_RELAXED);
 }
 
-static METRIC *metric_add(MRG *mrg, MRG_ENTRY *entry, bool *ret) {
-    mrg_index_write_lock(mrg);
+static inline uint32_t time_s_to_u32(time_t time_s) {
+    return (time_s > 0) ? (uint32_t)time_s : 0;
+}
 
+// the caller must hold the write lock of the partition
+static METRIC *metric_add_unsafe(MRG *mrg, size_t partition, MRG_ENTRY *entry, bool *ret) {
+    struct pgc_index *index = &mrg->index[partition];
     size_t mem_before_judyl, mem_after_judyl;
 
-    Pvoid_t *sections_judy_pptr = JudyHSIns(&mrg->index.uuid_judy, &entry->uuid, sizeof(uuid_t), PJE0);
-    if(!sections_judy_pptr || sections_judy_pptr == PJERR)
+    Pvoid_t *mu_pptr = JudyHSIns(&index->uuid_judy, &entry->uuid, sizeof(uuid_t), PJE0);
+    if(!mu_pptr || mu_pptr == PJERR)
         fatal("DBENGINE METRIC: corrupted UUIDs JudyHS array");
 
-    if(!*sections_judy_pptr)
+    struct mrg_uuid *mu = *mu_pptr;
+    if(!mu) {
+        mu = arrayalloc_mallocz(index->aral_uuids);
+        uuid_copy(mu->uuid, entry->uuid);
+        mu->sections_judy = NULL;
+        *mu_pptr = mu;
         mrg_stats_size_judyhs_added_uuid(mrg);
+    }
 
-    mem_before_judyl = JudyLMemUsed(*sections_judy_pptr);
-    Pvoid_t *PValue = JudyLIns(sections_judy_pptr, entry->section, PJE0);
-    mem_after_judyl = JudyLMemUsed(*sections_judy_pptr);
+    mem_before_judyl = JudyLMemUsed(mu->sections_judy);
+    Pvoid_t *PValue = JudyLIns(&mu->sections_judy, entry->section, PJE0);
+    mem_after_judyl = JudyLMemUsed(mu->sections_judy);
     mrg_stats_size_judyl_change(mrg, mem_before_judyl, mem_after_judyl);
 
     if(!PValue || PValue == PJERR)
@@ -104,7 +132,6 @@ static METRIC *metric_add(MRG *mrg, MRG_ENTRY *entry, bool *ret) {
 
     if(*PValue != NULL) {
         METRIC *metric = *PValue;
-        mrg_index_write_unlock(mrg);
 
         if(ret)
             *ret = false;
@@ -113,18 +140,17 @@ static METRIC *metric_add(MRG *mrg, MRG_ENTRY *entry, bool *ret) {
         return metric;
     }
 
-    METRIC *metric = arrayalloc_mallocz(mrg->index.aral);
-    uuid_copy(metric->uuid, entry->uuid);
+    METRIC *metric = arrayalloc_mallocz(index->aral);
+    metric->mu = mu;
     metric->section = entry->section;
-    metric->first_time_s = entry->first_time_s;
-    metric->latest_time_s_clean = entry->last_time_s;
+    metric->first_time_s = time_s_to_u32(entry->first_time_s);
+    metric->latest_time_s_clean = time_s_to_u32(entry->last_time_s);
     metric->latest_time_s_hot = 0;
     metric->latest_update_every_s = entry->latest_update_every_s;
+    metric->datafiles_bitmap = entry->datafiles_bitmap;
     netdata_spinlock_init(&metric->timestamps_lock);
     *PValue = metric;
 
-    mrg_index_write_unlock(mrg);
-
     if(ret)
         *ret = true;
 
@@ -133,65 +159,93 @@ static METRIC *metric_add(MRG *mrg, MRG_ENTRY *entry, bool *ret) {
     return metric;
 }
 
+static METRIC *metric_add(MRG *mrg, MRG_ENTRY *entry, bool *ret) {
+    size_t partition = uuid_partition(&entry->uuid);
+
+    mrg_index_write_lock(mrg, partition);
+    METRIC *metric = metric_add_unsafe(mrg, partition, entry, ret);
+    mrg_index_write_unlock(mrg, partition);
+
+    return metric;
+}
+
 static METRIC *metric_get(MRG *mrg, uuid_t *uuid, Word_t section) {
-    mrg_index_read_lock(mrg);
+    size_t partition = uuid_partition(uuid);
 
-    Pvoid_t *sections_judy_pptr = JudyHSGet(mrg->index.uuid_judy, uuid, sizeof(uuid_t));
-    if(!sections_judy_pptr) {
-        mrg_index_read_unlock(mrg);
+    mrg_index_read_lock(mrg, partition);
+
+    Pvoid_t *mu_pptr = JudyHSGet(mrg->index[partition].uuid_judy, uuid, sizeof(uuid_t));
+    if(!mu_pptr) {
+        mrg_index_read_unlock(mrg, partition);
         MRG_STATS_SEARCH_MISS(mrg);
         return NULL;
     }
 
-    Pvoid_t *PValue = JudyLGet(*sections_judy_pptr, section, PJE0);
+    struct mrg_uuid *mu = *mu_pptr;
+    Pvoid_t *PValue = JudyLGet(mu->sections_judy, section, PJE0);
     if(!PValue) {
-        mrg_index_read_unlock(mrg);
+        mrg_index_read_unlock(mrg, partition);
         MRG_STATS_SEARCH_MISS(mrg);
         return NULL;
     }
 
     METRIC *metric = *PValue;
 
-    mrg_index_read_unlock(mrg);
+    mrg_index_read_unlock(mrg, partition);
 
     MRG_STATS_SEARCH_HIT(mrg);
     return metric;
 }
 
-static bool metric_del(MRG *mrg, METRIC *metric) {
+// the metric may have been deleted already, so it is never dereferenced here
+// it is only compared with the one found in the index for the uuid and section given
+static bool metric_del(MRG *mrg, METRIC *metric, uuid_t *uuid, Word_t section) {
     size_t mem_before_judyl, mem_after_judyl;
 
-    mrg_index_write_lock(mrg);
+    size_t partition = uuid_partition(uuid);
+    struct pgc_index *index = &mrg->index[partition];
+
+    mrg_index_write_lock(mrg, partition);
 
-    Pvoid_t *sections_judy_pptr = JudyHSGet(mrg->index.uuid_judy, &metric->uuid, sizeof(uuid_t));
-    if(!sections_judy_pptr || !*sections_judy_pptr) {
-        mrg_index_write_unlock(mrg);
+    Pvoid_t *mu_pptr = JudyHSGet(index->uuid_judy, uuid, sizeof(uuid_t));
+    if(!mu_pptr || !*mu_pptr) {
+        mrg_index_write_unlock(mrg, partition);
         MRG_STATS_DELETE_MISS(mrg);
         return false;
     }
 
-    mem_before_judyl = JudyLMemUsed(*sections_judy_pptr);
-    int rc = JudyLDel(sections_judy_pptr, metric->section, PJE0);
-    mem_after_judyl = JudyLMemUsed(*sections_judy_pptr);
+    struct mrg_uuid *mu = *mu_pptr;
+
+    Pvoid_t *PValue = JudyLGet(mu->sections_judy, section, PJE0);
+    if(!PValue || *PValue != metric) {
+        mrg_index_write_unlock(mrg, partition);
+        MRG_STATS_DELETE_MISS(mrg);
+        return false;
+    }
+
+    mem_before_judyl = JudyLMemUsed(mu->sections_judy);
+    int rc = JudyLDel(&mu->sections_judy, section, PJE0);
+    mem_after_judyl = JudyLMemUsed(mu->sections_judy);
     mrg_stats_size_judyl_change(mrg, mem_before_judyl, mem_after_judyl);
 
     if(!rc) {
-        mrg_index_write_unlock(mrg);
+        mrg_index_write_unlock(mrg, partition);
         MRG_STATS_DELETE_MISS(mrg);
         return false;
     }
 
-    if(!*sections_judy_pptr) {
-        rc = JudyHSDel(&mrg->index.uuid_judy, &metric->uuid, sizeof(uuid_t), PJE0);
+    if(!mu->sections_judy) {
+        rc = JudyHSDel(&index->uuid_judy, uuid, sizeof(uuid_t), PJE0);
         if(!rc)
             fatal("DBENGINE METRIC: cannot delete UUID from JudyHS");
+        arrayalloc_freez(index->aral_uuids, mu);
         mrg_stats_size_judyhs_removed_uuid(mrg);
     }
 
     // arrayalloc is running lockless here
-    arrayalloc_freez(mrg->index.aral, metric);
+    arrayalloc_freez(index->aral, metric);
 
-    mrg_index_write_unlock(mrg);
+    mrg_index_write_unlock(mrg, partition);
 
     MRG_STATS_DELETED_METRIC(mrg);
 
@@ -203,8 +257,13 @@ static bool metric_del(MRG *mrg, METRIC *metric) {
 
 MRG *mrg_create(void) {
     MRG *mrg = callocz(1, sizeof(MRG));
-    netdata_rwlock_init(&mrg->index.rwlock);
-    mrg->index.aral = arrayalloc_create(sizeof(METRIC), 65536 / sizeof(METRIC), NULL, NULL, false, true);
+
+    for(size_t i = 0; i < MRG_PARTITIONS ; i++) {
+        netdata_rwlock_init(&mrg->index[i].rwlock);
+        mrg->index[i].aral = arrayalloc_create(sizeof(METRIC), 65536 / sizeof(METRIC), "mrg_metrics", NULL, false, true, 0);
+        mrg->index[i].aral_uuids = arrayalloc_create(sizeof(struct mrg_uuid), 65536 / sizeof(struct mrg_uuid), "mrg_uuids", NULL, false, true, 0);
+    }
+
     mrg->stats.size = sizeof(MRG);
     return mrg;
 }
@@ -228,14 +287,51 @@ METRIC *mrg_metric_add_and_acquire(MRG *mrg, MRG_ENTRY entry, bool *ret) {
     return metric_add(mrg, &entry, ret);
 }
 
+// add many metrics at once, holding the lock of each partition once for all of them
+// metrics that already exist get their retention expanded
+// returns the number of metrics added
+size_t mrg_metrics_add_or_expand_retention(MRG *mrg, MRG_ENTRY *entries, size_t count) {
+    size_t added = 0;
+    bool ret;
+
+    for(size_t partition = 0; partition < MRG_PARTITIONS ; partition++) {
+        bool locked = false;
+
+        for(size_t i = 0; i < count ; i++) {
+            if(uuid_partition(&entries[i].uuid) != partition)
+                continue;
+
+            if(!locked) {
+                mrg_index_write_lock(mrg, partition);
+                locked = true;
+            }
+
+            METRIC *metric = metric_add_unsafe(mrg, partition, &entries[i], &ret);
+
+            if(ret)
+                added++;
+            else {
+                mrg_metric_expand_retention(mrg, metric, entries[i].first_time_s, entries[i].last_time_s, entries[i].latest_update_every_s);
+                __atomic_or_fetch(&metric->datafiles_bitmap, entries[i].datafiles_bitmap, __ATOMIC_RELAXED);
+            }
+        }
+
+        if(locked)
+            mrg_index_write_unlock(mrg, partition);
+    }
+
+    return added;
+}
+
 METRIC *mrg_metric_get_and_acquire(MRG *mrg, uuid_t *uuid, Word_t section) {
     // FIXME - support refcount
     return metric_get(mrg, uuid, section);
 }
 
-bool mrg_metric_release_and_delete(MRG *mrg, METRIC *metric) {
+// the uuid and the section have to be taken by the caller while the metric is still referenced
+bool mrg_metric_release_and_delete(MRG *mrg, METRIC *metric, uuid_t *uuid, Word_t section) {
     // FIXME - support refcount
-    return metric_del(mrg, metric);
+    return metric_del(mrg, metric, uuid, section);
 }
 
 METRIC *mrg_metric_dup(MRG *mrg __maybe_unused, METRIC *metric) {
@@ -253,7 +349,7 @@ Word_t mrg_metric_id(MRG *mrg __maybe_unused, METRIC *metric) {
 }
 
 uuid_t *mrg_metric_uuid(MRG *mrg __maybe_unused, METRIC *metric) {
-    return &metric->uuid;
+    return &metric->mu->uuid;
 }
 
 Word_t mrg_metric_section(MRG *mrg __maybe_unused, METRIC *metric) {
@@ -262,7 +358,7 @@ Word_t mrg_metric_section(MRG *mrg __maybe_unused, METRIC *metric) {
 
 bool mrg_metric_set_first_time_s(MRG *mrg __maybe_unused, METRIC *metric, time_t first_time_s) {
     netdata_spinlock_lock(&metric->timestamps_lock);
-    metric->first_time_s = first_time_s;
+    metric->first_time_s = time_s_to_u32(first_time_s);
     netdata_spinlock_unlock(&metric->timestamps_lock);
 
     return true;
@@ -275,19 +371,22 @@ void mrg_metric_expand_retention(MRG *mrg __maybe_unused, METRIC *metric, time_t
     internal_fatal(last_time_s > now_realtime_sec() + 1,
                    "DBENGINE METRIC: metric last time is in the future");
 
+    uint32_t first_u32 = time_s_to_u32(first_time_s);
+    uint32_t last_u32 = time_s_to_u32(last_time_s);
+
     netdata_spinlock_lock(&metric->timestamps_lock);
 
-    if(first_time_s && (!metric->first_time_s || first_time_s < metric->first_time_s))
-        metric->first_time_s = first_time_s;
+    if(first_u32 && (!metric->first_time_s || first_u32 < metric->first_time_s))
+        metric->first_time_s = first_u32;
 
-    if(last_time_s && (!metric->latest_time_s_clean || last_time_s > metric->latest_time_s_clean)) {
-        metric->latest_time_s_clean = last_time_s;
+    if(last_u32 && (!metric->latest_time_s_clean || last_u32 > metric->latest_time_s_clean)) {
+        metric->latest_time_s_clean = last_u32;
 
         if(update_every_s)
-            metric->latest_update_every_s = update_every_s;
+            metric->latest_update_every_s = (uint32_t)update_every_s;
     }
     else if(!metric->latest_update_every_s && update_every_s)
-        metric->latest_update_every_s = update_every_s;
+        metric->latest_update_every_s = (uint32_t)update_every_s;
 
     netdata_spinlock_unlock(&metric->timestamps_lock);
 }
@@ -297,7 +396,7 @@ bool mrg_metric_set_first_time_s_if_zero(MRG *mrg __maybe_unused, METRIC *metric
 
     netdata_spinlock_lock(&metric->timestamps_lock);
     if(!metric->first_time_s) {
-        metric->first_time_s = first_time_s;
+        metric->first_time_s = time_s_to_u32(first_time_s);
 
 //        if(unlikely(metric->latest_time_s_clean < metric->first_time_s))
 //            metric->latest_time_s_clean = metric->first_time_s;
@@ -337,10 +436,10 @@ bool mrg_metric_set_clean_latest_time_s(MRG *mrg __maybe_unused, METRIC *metric,
 //    internal_fatal(metric->latest_time_s_clean > latest_time_s,
 //                   "DBENGINE METRIC: metric new clean latest time is older than the previous one");
 
-    metric->latest_time_s_clean = latest_time_s;
+    metric->latest_time_s_clean = time_s_to_u32(latest_time_s);
 
     if(unlikely(!metric->first_time_s))
-        metric->first_time_s = latest_time_s;
+        metric->first_time_s = metric->latest_time_s_clean;
 
 //    if(unlikely(metric->first_time_s > latest_time_s))
 //        metric->first_time_s = latest_time_s;
@@ -354,10 +453,10 @@ bool mrg_metric_set_hot_latest_time_s(MRG *mrg __maybe_unused, METRIC *metric, t
 //                   "DBENGINE METRIC: metric latest time is in the future");
 
     netdata_spinlock_lock(&metric->timestamps_lock);
-    metric->latest_time_s_hot = latest_time_s;
+    metric->latest_time_s_hot = time_s_to_u32(latest_time_s);
 
     if(unlikely(!metric->first_time_s))
-        metric->first_time_s = latest_time_s;
+        metric->first_time_s = metric->latest_time_s_hot;
 
 //    if(unlikely(metric->first_time_s > latest_time_s))
 //        metric->first_time_s = latest_time_s;
@@ -379,7 +478,7 @@ bool mrg_metric_set_update_every(MRG *mrg __maybe_unused, METRIC *metric, time_t
         return false;
 
     netdata_spinlock_lock(&metric->timestamps_lock);
-    metric->latest_update_every_s = update_every_s;
+    metric->latest_update_every_s = (uint32_t)update_every_s;
     netdata_spinlock_unlock(&metric->timestamps_lock);
 
     return true;
@@ -391,7 +490,7 @@ bool mrg_metric_set_update_every_s_if_zero(MRG *mrg __maybe_unused, METRIC *metr
 
     netdata_spinlock_lock(&metric->timestamps_lock);
     if(!metric->latest_update_every_s)
-        metric->latest_update_every_s = update_every_s;
+        metric->latest_update_every_s = (uint32_t)update_every_s;
     netdata_spinlock_unlock(&metric->timestamps_lock);
 
     return true;
@@ -407,6 +506,14 @@ time_t mrg_metric_get_update_every_s(MRG *mrg __maybe_unused, METRIC *metric) {
     return update_every_s;
 }
 
+void mrg_metric_add_datafile(MRG *mrg __maybe_unused, METRIC *metric, unsigned datafile_fileno) {
+    __atomic_or_fetch(&metric->datafiles_bitmap, MRG_DATAFILE_BIT(datafile_fileno), __ATOMIC_RELEASE);
+}
+
+bool mrg_metric_may_be_in_datafile(MRG *mrg __maybe_unused, METRIC *metric, unsigned datafile_fileno) {
+    return __atomic_load_n(&metric->datafiles_bitmap, __ATOMIC_ACQUIRE) & MRG_DATAFILE_BIT(datafile_fileno);
+}
+
 struct mrg_statistics mrg_get_statistics(MRG *mrg) {
     // FIXME - use atomics
     return mrg->stats;
@@ -487,7 +594,9 @@ static void mrg_stress(MRG *mrg, size_t entries, size_t sections) {
 
     for(size_t i = 0; i < entries ; i++) {
         for (size_t section = 0; section < sections; section++) {
-            if(!mrg_metric_release_and_delete(mrg, array[i][section]))
+            uuid_t uuid;
+            uuid_copy(uuid, *mrg_metric_uuid(mrg, array[i][section]));
+            if(!mrg_metric_release_and_delete(mrg, array[i][section], &uuid, section))
                 fatal("DBENGINE METRIC: failed to delete metric");
         }
     }
@@ -521,6 +630,137 @@ static void *mrg_stress_test_thread3(void *ptr) {
 }
 #endif
 
+// ----------------------------------------------------------------------------
+// concurrent benchmark
+
+#define MRG_BENCHMARK_SECTIONS 5
+
+struct mrg_benchmark_thread {
+    netdata_thread_t thread;
+    MRG *mrg;
+    uuid_t *uuids;
+    METRIC **metrics;
+    size_t entries;
+    size_t errors;
+    enum {
+        MRG_BENCHMARK_ADD,
+        MRG_BENCHMARK_GET,
+        MRG_BENCHMARK_DEL,
+    } phase;
+};
+
+static void *mrg_benchmark_thread(void *ptr) {
+    struct mrg_benchmark_thread *t = ptr;
+    bool ret;
+
+    for(size_t i = 0; i < t->entries ; i++) {
+        for(size_t section = 0; section < MRG_BENCHMARK_SECTIONS ; section++) {
+            METRIC **m = &t->metrics[i * MRG_BENCHMARK_SECTIONS + section];
+
+            switch(t->phase) {
+                case MRG_BENCHMARK_ADD: {
+                    MRG_ENTRY e = {
+                            .section = section,
+                            .first_time_s = (time_t)(i + 1),
+                            .last_time_s = (time_t)(i + 2),
+                            .latest_update_every_s = 1,
+                    };
+                    uuid_copy(e.uuid, t->uuids[i]);
+                    *m = mrg_metric_add_and_acquire(t->mrg, e, &ret);
+                    if(!ret)
+                        t->errors++;
+                    break;
+                }
+
+                case MRG_BENCHMARK_GET:
+                    if(mrg_metric_get_and_acquire(t->mrg, &t->uuids[i], section) != *m)
+                        t->errors++;
+                    break;
+
+                case MRG_BENCHMARK_DEL:
+                    if(!mrg_metric_release_and_delete(t->mrg, *m, &t->uuids[i], section))
+                        t->errors++;
+                    break;
+            }
+        }
+    }
+
+    return ptr;
+}
+
+static size_t mrg_benchmark_phase(struct mrg_benchmark_thread *threads, size_t nthreads, int phase, const char *name) {
+    size_t errors = 0, ops = 0;
+    char tag[NETDATA_THREAD_TAG_MAX + 1];
+
+    usec_t started_ut = now_monotonic_usec();
+
+    for(size_t i = 0; i < nthreads ; i++) {
+        threads[i].phase = phase;
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "MRGBENCH[%zu]", i);
+        netdata_thread_create(&threads[i].thread, tag,
+                              NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG,
+                              mrg_benchmark_thread, &threads[i]);
+    }
+
+    for(size_t i = 0; i < nthreads ; i++) {
+        netdata_thread_join(threads[i].thread, NULL);
+        errors += threads[i].errors;
+        threads[i].errors = 0;
+        ops += threads[i].entries * MRG_BENCHMARK_SECTIONS;
+    }
+
+    usec_t ended_ut = now_monotonic_usec();
+    usec_t dt = (ended_ut > started_ut) ? ended_ut - started_ut : 1;
+
+    info("DBENGINE METRIC: benchmark %zu threads, %s %zu metrics in %llu usecs, %0.0f ops/s, %zu errors",
+         nthreads, name, ops, dt, (double)ops * USEC_PER_SEC / (double)dt, errors);
+
+    return errors;
+}
+
+static size_t mrg_benchmark(size_t nthreads, size_t entries_per_thread) {
+    MRG *mrg = mrg_create();
+    size_t errors = 0;
+
+    struct mrg_benchmark_thread *threads = callocz(nthreads, sizeof(*threads));
+    for(size_t i = 0; i < nthreads ; i++) {
+        threads[i].mrg = mrg;
+        threads[i].entries = entries_per_thread;
+        threads[i].uuids = mallocz(entries_per_thread * sizeof(uuid_t));
+        threads[i].metrics = mallocz(entries_per_thread * MRG_BENCHMARK_SECTIONS * sizeof(METRIC *));
+
+        for(size_t e = 0; e < entries_per_thread ; e++)
+            uuid_generate_random(threads[i].uuids[e]);
+    }
+
+    errors += mrg_benchmark_phase(threads, nthreads, MRG_BENCHMARK_ADD, "added");
+
+    struct mrg_statistics stats = mrg_get_statistics(mrg);
+    info("DBENGINE METRIC: benchmark %zu metrics of %zu uuids use %zu bytes, %0.2f bytes per metric",
+         stats.entries, nthreads * entries_per_thread, stats.size,
+         stats.entries ? (double)stats.size / (double)stats.entries : 0.0);
+
+    if(stats.entries != nthreads * entries_per_thread * MRG_BENCHMARK_SECTIONS)
+        errors++;
+
+    errors += mrg_benchmark_phase(threads, nthreads, MRG_BENCHMARK_GET, "looked up");
+    errors += mrg_benchmark_phase(threads, nthreads, MRG_BENCHMARK_DEL, "deleted");
+
+    stats = mrg_get_statistics(mrg);
+    if(stats.entries != 0)
+        errors++;
+
+    for(size_t i = 0; i < nthreads ; i++) {
+        freez(threads[i].uuids);
+        freez(threads[i].metrics);
+    }
+    freez(threads);
+
+    mrg_destroy(mrg);
+
+    return errors;
+}
+
 int mrg_unittest(void) {
     MRG *mrg = mrg_create();
     METRIC *metric1, *metric2;
@@ -568,14 +808,14 @@ int mrg_unittest(void) {
         fatal("DBENGINE METRIC: cannot find the metric added (section 0)");
 
     // delete the first metric
-    if(!mrg_metric_release_and_delete(mrg, metric1))
+    if(!mrg_metric_release_and_delete(mrg, metric1, &entry.uuid, 1))
         fatal("DBENGINE METRIC: cannot delete the first metric");
 
     if(mrg_metric_get_and_acquire(mrg, &entry.uuid, entry.section) != metric2)
         fatal("DBENGINE METRIC: cannot find the metric added (section 0), after deleting the first one");
 
     // delete the first metric again - metric1 pointer is invalid now
-    if(mrg_metric_release_and_delete(mrg, metric1))
+    if(mrg_metric_release_and_delete(mrg, metric1, &entry.uuid, 1))
         fatal("DBENGINE METRIC: deleted again an already deleted metric");
 
     // find the section 0 metric again
@@ -583,16 +823,48 @@ int mrg_unittest(void) {
         fatal("DBENGINE METRIC: cannot find the metric added (section 0), after deleting the first one twice");
 
     // delete the second metric
-    if(!mrg_metric_release_and_delete(mrg, metric2))
+    if(!mrg_metric_release_and_delete(mrg, metric2, &entry.uuid, 0))
         fatal("DBENGINE METRIC: cannot delete the second metric");
 
     // delete the second metric again
-    if(mrg_metric_release_and_delete(mrg, metric2))
+    if(mrg_metric_release_and_delete(mrg, metric2, &entry.uuid, 0))
         fatal("DBENGINE METRIC: managed to delete an already deleted metric");
 
     if(mrg->stats.entries != 0)
         fatal("DBENGINE METRIC: invalid entries counter");
 
+    // add metrics in a batch, with one of them twice
+    MRG_ENTRY batch[3] = { entry, entry, entry };
+    uuid_generate(batch[1].uuid);
+    batch[0].datafiles_bitmap = MRG_DATAFILE_BIT(1);
+    batch[2].first_time_s = 1;
+    batch[2].last_time_s = 5;
+    batch[2].datafiles_bitmap = MRG_DATAFILE_BIT(66);
+    if(mrg_metrics_add_or_expand_retention(mrg, batch, 3) != 2)
+        fatal("DBENGINE METRIC: batch did not add 2 metrics");
+
+    metric1 = mrg_metric_get_and_acquire(mrg, &entry.uuid, entry.section);
+    if(!metric1 || mrg_metric_get_first_time_s(mrg, metric1) != 1 || mrg_metric_get_latest_time_s(mrg, metric1) != 5)
+        fatal("DBENGINE METRIC: batch did not expand the retention of the metric added twice");
+
+    if(!mrg_metric_may_be_in_datafile(mrg, metric1, 1) || !mrg_metric_may_be_in_datafile(mrg, metric1, 2) || mrg_metric_may_be_in_datafile(mrg, metric1, 3))
+        fatal("DBENGINE METRIC: batch did not merge the datafiles of the metric added twice");
+
+    mrg_metric_add_datafile(mrg, metric1, 3);
+    if(!mrg_metric_may_be_in_datafile(mrg, metric1, 3))
+        fatal("DBENGINE METRIC: cannot add a datafile to a metric");
+
+    metric2 = mrg_metric_get_and_acquire(mrg, &batch[1].uuid, batch[1].section);
+    if(!metric2)
+        fatal("DBENGINE METRIC: cannot find the second metric of the batch");
+
+    if(!mrg_metric_release_and_delete(mrg, metric1, &entry.uuid, entry.section) ||
+       !mrg_metric_release_and_delete(mrg, metric2, &batch[1].uuid, batch[1].section))
+        fatal("DBENGINE METRIC: cannot delete the metrics of the batch");
+
+    if(mrg->stats.entries != 0)
+        fatal("DBENGINE METRIC: invalid entries counter after the batch");
+
 #ifdef MRG_STRESS_TEST
     usec_t started_ut = now_realtime_usec();
     pthread_t thread1;
@@ -637,6 +909,9 @@ int mrg_unittest(void) {
 
     mrg_destroy(mrg);
 
+    if(mrg_benchmark(4, 50000))
+        fatal("DBENGINE METRIC: concurrent benchmark failed");
+
     info("DBENGINE METRIC: all tests passed!");
 
     return 0;
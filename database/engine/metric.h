@@ -12,8 +12,14 @@ typedef struct mrg_entry {
     time_t first_time_s;
     time_t last_time_s;
     uint32_t latest_update_every_s;
+    uint64_t datafiles_bitmap;      // the journal v2 indexed datafiles of the metric, see MRG_DATAFILE_BIT()
 } MRG_ENTRY;
 
+// metrics keep a bitmap of the datafiles that have their pages indexed in journal v2,
+// by datafile number modulo 64, so that queries skip the journals that certainly do
+// not have them - datafiles sharing a bit, or deleted ones, are searched as before
+#define MRG_DATAFILE_BIT(datafile_fileno) ((uint64_t)1 << ((datafile_fileno) % 64))
+
 struct mrg_statistics {
     size_t entries;
     size_t size;                // memory without indexing
@@ -34,8 +40,9 @@ METRIC *mrg_metric_dup(MRG *mrg, METRIC *metric);
 void mrg_metric_release(MRG *mrg, METRIC *metric);
 
 METRIC *mrg_metric_add_and_acquire(MRG *mrg, MRG_ENTRY entry, bool *ret);
+size_t mrg_metrics_add_or_expand_retention(MRG *mrg, MRG_ENTRY *entries, size_t count);
 METRIC *mrg_metric_get_and_acquire(MRG *mrg, uuid_t *uuid, Word_t section);
-bool mrg_metric_release_and_delete(MRG *mrg, METRIC *metric);
+bool mrg_metric_release_and_delete(MRG *mrg, METRIC *metric, uuid_t *uuid, Word_t section);
 
 Word_t mrg_metric_id(MRG *mrg, METRIC *metric);
 uuid_t *mrg_metric_uuid(MRG *mrg, METRIC *metric);
@@ -53,6 +60,9 @@ time_t mrg_metric_get_latest_time_s(MRG *mrg, METRIC *metric);
 bool mrg_metric_set_update_every(MRG *mrg, METRIC *metric, time_t update_every_s);
 time_t mrg_metric_get_update_every_s(MRG *mrg, METRIC *metric);
 
+void mrg_metric_add_datafile(MRG *mrg, METRIC *metric, unsigned datafile_fileno);
+bool mrg_metric_may_be_in_datafile(MRG *mrg, METRIC *metric, unsigned datafile_fileno);
+
 bool mrg_metric_set_update_every_s_if_zero(MRG *mrg, METRIC *metric, time_t update_every_s);
 
 struct mrg_statistics mrg_get_statistics(MRG *mrg);
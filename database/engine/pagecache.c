@@ -15,16 +15,24 @@ static void main_cache_free_clean_page_callback(PGC *cache __maybe_unused, PGC_E
     freez(entry.data);
 }
 
+static int page_descr_compar(const void *a, const void *b) {
+    const struct page_descr_with_data *d1 = *(struct page_descr_with_data * const *)a;
+    const struct page_descr_with_data *d2 = *(struct page_descr_with_data * const *)b;
+
+    if(d1->metric_id < d2->metric_id) return -1;
+    if(d1->metric_id > d2->metric_id) return 1;
+    if(d1->start_time_ut < d2->start_time_ut) return -1;
+    if(d1->start_time_ut > d2->start_time_ut) return 1;
+    return 0;
+}
+
 static void main_cache_flush_dirty_page_callback(PGC *cache __maybe_unused, PGC_ENTRY *entries_array __maybe_unused, PGC_PAGE **pages_array __maybe_unused, size_t entries __maybe_unused)
 {
-     struct rrdengine_instance *ctx = (struct rrdengine_instance *) entries_array[0].section;
-
-     // mark ctx as having flushing in progress
-    __atomic_add_fetch(&ctx->worker_config.atomics.extents_currently_being_flushed, 1, __ATOMIC_RELAXED);
+    struct rrdengine_instance *ctx = (struct rrdengine_instance *) entries_array[0].section;
 
     size_t bytes_per_point =  PAGE_POINT_CTX_SIZE_BYTES(ctx);
 
-    struct page_descr_with_data *base = NULL;
+    struct page_descr_with_data *descr_array[entries];
 
     for (size_t Index = 0 ; Index < entries; Index++) {
         time_t start_time_s = entries_array[Index].start_time_s;
@@ -48,16 +56,48 @@ static void main_cache_flush_dirty_page_callback(PGC *cache __maybe_unused, PGC_
         }
 
         memcpy(descr->page, pgc_page_data(pages_array[Index]), descr->page_length);
-        DOUBLE_LINKED_LIST_APPEND_UNSAFE(base, descr, link.prev, link.next);
+        descr_array[Index] = descr;
 
         internal_fatal(descr->page_length > RRDENG_BLOCK_SIZE, "DBENGINE: faulty page length calculation");
     }
 
-    struct completion completion;
-    completion_init(&completion);
-    rrdeng_enq_cmd(ctx, RRDENG_OPCODE_FLUSH_PAGES, base, &completion, STORAGE_PRIORITY_CRITICAL, NULL, NULL);
-    completion_wait_for(&completion);
-    completion_destroy(&completion);
+    // keep the pages of each metric together and in time order,
+    // so that queries touch as few extents as possible
+    qsort(descr_array, entries, sizeof(descr_array[0]), page_descr_compar);
+
+    // cut the pages into extents of rrdeng_extent_target_size uncompressed bytes,
+    // so that tiers with small pages get extents with more pages
+    struct page_descr_with_data *bases[entries];
+    size_t extents = 0, extent_pages = 0, extent_bytes = 0;
+    for (size_t Index = 0 ; Index < entries; Index++) {
+        struct page_descr_with_data *descr = descr_array[Index];
+
+        if(!extents || extent_pages >= rrdeng_pages_per_extent ||
+           (extent_pages && extent_bytes + descr->page_length > rrdeng_extent_target_size)) {
+            bases[extents++] = NULL;
+            extent_pages = 0;
+            extent_bytes = 0;
+        }
+
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(bases[extents - 1], descr, link.prev, link.next);
+        extent_pages++;
+        extent_bytes += descr->page_length;
+    }
+
+    struct completion *completions = mallocz(sizeof(struct completion) * extents);
+    for(size_t e = 0; e < extents ; e++) {
+        // mark ctx as having flushing in progress
+        __atomic_add_fetch(&ctx->worker_config.atomics.extents_currently_being_flushed, 1, __ATOMIC_RELAXED);
+
+        completion_init(&completions[e]);
+        rrdeng_enq_cmd(ctx, RRDENG_OPCODE_FLUSH_PAGES, bases[e], &completions[e], STORAGE_PRIORITY_CRITICAL, NULL, NULL);
+    }
+
+    for(size_t e = 0; e < extents ; e++) {
+        completion_wait_for(&completions[e]);
+        completion_destroy(&completions[e]);
+    }
+    freez(completions);
 }
 
 static void open_cache_free_clean_page_callback(PGC *cache __maybe_unused, PGC_ENTRY entry __maybe_unused)
@@ -474,6 +514,7 @@ size_t get_page_list_from_journal_v2(struct rrdengine_instance *ctx, METRIC *met
     time_t wanted_end_time_s = (time_t)(end_time_ut / USEC_PER_SEC);
 
     size_t pages_found = 0;
+    size_t journals_searched = 0, journals_skipped = 0;
 
     uv_rwlock_rdlock(&ctx->datafiles.rwlock);
     struct rrdengine_datafile *datafile;
@@ -493,6 +534,14 @@ size_t get_page_list_from_journal_v2(struct rrdengine_instance *ctx, METRIC *met
 
         // the datafile possibly contains useful data for this query
 
+        if(!mrg_metric_may_be_in_datafile(main_mrg, metric, datafile->fileno)) {
+            // our metric has not been indexed in this datafile
+            journals_skipped++;
+            continue;
+        }
+
+        journals_searched++;
+
         size_t journal_metric_count = (size_t)journal_header->metric_count;
         struct journal_metric_list *uuid_list = (struct journal_metric_list *)((uint8_t *) journal_header + journal_header->metric_offset);
         struct journal_metric_list *uuid_entry = bsearch(uuid,uuid_list,journal_metric_count,sizeof(*uuid_list), journal_metric_uuid_compare);
@@ -558,6 +607,12 @@ size_t get_page_list_from_journal_v2(struct rrdengine_instance *ctx, METRIC *met
     }
     uv_rwlock_rdunlock(&ctx->datafiles.rwlock);
 
+    if(journals_searched)
+        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.journal_v2_files_searched, journals_searched, __ATOMIC_RELAXED);
+
+    if(journals_skipped)
+        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.journal_v2_files_skipped, journals_skipped, __ATOMIC_RELAXED);
+
     return pages_found;
 }
 
@@ -732,11 +787,18 @@ inline void rrdeng_prep_wait(PDC *pdc) {
 
 void rrdeng_prep_query(PDC *pdc) {
     size_t pages_to_load = 0;
-    pdc->page_list_JudyL = get_page_list(pdc->ctx, pdc->metric,
-                                                 pdc->start_time_s * USEC_PER_SEC,
-                                                 pdc->end_time_s * USEC_PER_SEC,
-                                                 &pages_to_load,
-                                                 &pdc->optimal_end_time_s);
+
+    if(unlikely(__atomic_load_n(&pdc->workers_should_stop, __ATOMIC_RELAXED))) {
+        // the query thread left while this was queued, there is no reason to look for pages
+        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.queries_cancelled_before_prep, 1, __ATOMIC_RELAXED);
+        pdc->page_list_JudyL = NULL;
+    }
+    else
+        pdc->page_list_JudyL = get_page_list(pdc->ctx, pdc->metric,
+                                             pdc->start_time_s * USEC_PER_SEC,
+                                             pdc->end_time_s * USEC_PER_SEC,
+                                             &pages_to_load,
+                                             &pdc->optimal_end_time_s);
 
     if (pages_to_load && pdc->page_list_JudyL) {
         pdc_acquire(pdc); // we get 1 for the 1st worker in the chain: do_read_page_list_work()
@@ -49,11 +49,29 @@ struct rrdeng_page_info {
     uint32_t page_length;
 };
 
+// full hot pages of a metrics group, waiting to be made dirty in one batch
+#define PG_ALIGNMENT_PENDING_PAGES 32
+
+// the flush worker makes dirty the pending pages of groups that have not
+// been collected for this many update_every iterations
+#define PG_ALIGNMENT_PENDING_MAX_ITERATIONS 3
+
 struct pg_alignment {
     uint32_t page_position;
     uint32_t refcount;
+
+    SPINLOCK spinlock;                // protects the pending pages
+    uint32_t pending_pages;
+    usec_t pending_since_ut;          // the end time of the first pending page
+    usec_t pending_expire_ut;         // the monotonic time the pending pages have to be made dirty
+    struct pgc_page *pending[PG_ALIGNMENT_PENDING_PAGES];
+
+    struct pg_alignment *prev;        // all the groups, protected by the lock of their list
+    struct pg_alignment *next;
 };
 
+void rrdeng_page_alignments_flush_expired_pending_pages(void);
+
 struct rrdeng_query_handle;
 struct page_details_control;
 
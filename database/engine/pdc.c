@@ -13,6 +13,8 @@ struct extent_page_details_list {
 
     struct rrdeng_cmd *cmd;
     bool head_to_datafile_extent_queries_pending_for_extent;
+    bool head_is_populating_pages;                 // the list of this head is closed, new queries follow it
+    struct extent_page_details_list *followers;    // queries that came while the head was populating pages
 
     struct {
         struct extent_page_details_list *prev;
@@ -379,12 +381,16 @@ static struct {
                 .allocated = 0,
                 .allocated_bytes = 0,
         },
-        .max_size = MAX_PAGES_PER_EXTENT * RRDENG_BLOCK_SIZE,
+        .max_size = MAX_EXTENT_UNCOMPRESSED_SIZE,
 };
 
 void extent_buffer_init(void) {
-    size_t max_extent_uncompressed = MAX_PAGES_PER_EXTENT * RRDENG_BLOCK_SIZE;
-    size_t max_size = (size_t)LZ4_compressBound(MAX_PAGES_PER_EXTENT * RRDENG_BLOCK_SIZE);
+    size_t max_extent_uncompressed = MAX_EXTENT_UNCOMPRESSED_SIZE;
+    size_t max_size = (size_t)LZ4_compressBound(MAX_EXTENT_UNCOMPRESSED_SIZE);
+#ifdef NETDATA_WITH_ZSTD
+    if(max_size < ZSTD_compressBound(MAX_EXTENT_UNCOMPRESSED_SIZE))
+        max_size = ZSTD_compressBound(MAX_EXTENT_UNCOMPRESSED_SIZE);
+#endif
     if(max_size < max_extent_uncompressed)
         max_size = max_extent_uncompressed;
 
@@ -503,7 +509,6 @@ static void epdl_mark_all_not_loaded_pages_as_failed(EPDL *epdl, PDC_PAGE_STATUS
     if(pages_matched && statistics_counter)
         __atomic_add_fetch(statistics_counter, pages_matched, __ATOMIC_RELAXED);
 }
-/*
 static bool epdl_check_if_pages_are_already_in_cache(struct rrdengine_instance *ctx, EPDL *epdl, PDC_PAGE_STATUS tags)
 {
     size_t count_remaining = 0;
@@ -519,12 +524,13 @@ static bool epdl_check_if_pages_are_already_in_cache(struct rrdengine_instance *
         Pvoid_t *PValue;
         while ((PValue = PDCJudyLFirstThenNext(*pd_by_start_time_s_JudyL, &start_time_index, &start_time_first))) {
             struct page_details *pd = *PValue;
-            if (pd->page)
+            if (pd->page || pdc_page_status_check(pd, PDC_PAGE_FAILED | PDC_PAGE_READY))
                 continue;
 
             pd->page = pgc_page_get_and_acquire(main_cache, (Word_t) ctx, pd->metric_id, pd->first_time_s, PGC_SEARCH_EXACT);
             if (pd->page) {
                 found++;
+                pd->page_length = pgc_page_data_size(main_cache, pd->page);
                 pdc_page_status_set(pd, PDC_PAGE_READY | tags);
             }
             else
@@ -532,14 +538,11 @@ static bool epdl_check_if_pages_are_already_in_cache(struct rrdengine_instance *
         }
     }
 
-    if(found) {
-        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.pages_load_ok_preloaded, found, __ATOMIC_RELAXED);
-        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.pages_data_source_main_cache, found, __ATOMIC_RELAXED);
-    }
+    if(found)
+        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.pages_data_source_inflight_extent, found, __ATOMIC_RELAXED);
 
     return count_remaining == 0;
 }
-*/
 
 // ----------------------------------------------------------------------------
 // PDC logic
@@ -659,6 +662,16 @@ static bool epdl_pending_add(EPDL *epdl) {
         added_new = true;
         epdl->head_to_datafile_extent_queries_pending_for_extent = true;
     }
+    else if(base->head_is_populating_pages) {
+        // the extent is being populated by another query, that cannot take more pages,
+        // it will give us our pages from the same data, or the main cache when it finishes
+        epdl->head_to_datafile_extent_queries_pending_for_extent = false;
+        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.pages_load_extent_followed, 1, __ATOMIC_RELAXED);
+
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(base->followers, epdl, query.prev, query.next);
+        netdata_spinlock_unlock(&epdl->datafile->extent_queries.spinlock);
+        return false;
+    }
     else {
         added_new = false;
         epdl->head_to_datafile_extent_queries_pending_for_extent = false;
@@ -676,15 +689,47 @@ static bool epdl_pending_add(EPDL *epdl) {
     return added_new;
 }
 
-static void epdl_pending_del(EPDL *epdl) {
+// stop appending more pages to the list of this head,
+// the queries that need this extent from now on will follow it
+static void epdl_pending_populating(EPDL *epdl) {
+    netdata_spinlock_lock(&epdl->datafile->extent_queries.spinlock);
+    epdl->head_is_populating_pages = true;
+    netdata_spinlock_unlock(&epdl->datafile->extent_queries.spinlock);
+}
+
+// the queries that followed this head so far join its list, so that they are
+// completed with it - returns the first of them
+static EPDL *epdl_pending_join_followers(EPDL *epdl) {
+    netdata_spinlock_lock(&epdl->datafile->extent_queries.spinlock);
+    EPDL *followers = epdl->followers;
+    epdl->followers = NULL;
+    netdata_spinlock_unlock(&epdl->datafile->extent_queries.spinlock);
+
+    for(EPDL *ep = followers, *next = NULL; ep ; ep = next) {
+        next = ep->query.next;
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(epdl, ep, query.prev, query.next);
+    }
+
+    return followers;
+}
+
+// returns the queries that followed this head
+static EPDL *epdl_pending_del(EPDL *epdl) {
+    EPDL *followers = NULL;
+
     netdata_spinlock_lock(&epdl->datafile->extent_queries.spinlock);
     if(epdl->head_to_datafile_extent_queries_pending_for_extent) {
         epdl->head_to_datafile_extent_queries_pending_for_extent = false;
         int rc = JudyLDel(&epdl->datafile->extent_queries.pending_epdl_by_extent_offset_judyL, epdl->extent_offset, PJE0);
         (void) rc;
         internal_fatal(!rc, "DBENGINE: epdl not found in pending list");
+
+        followers = epdl->followers;
+        epdl->followers = NULL;
     }
     netdata_spinlock_unlock(&epdl->datafile->extent_queries.spinlock);
+
+    return followers;
 }
 
 void pdc_to_epdl_router(struct rrdengine_instance *ctx, PDC *pdc, execute_extent_page_details_list_t exec_first_extent_list, execute_extent_page_details_list_t exec_rest_extent_list)
@@ -902,10 +947,6 @@ inline VALIDATED_PAGE_DESCRIPTOR validate_extent_page_descr(const struct rrdeng_
 
 static inline struct page_details *epdl_get_pd_load_link_list_from_metric_start_time(EPDL *epdl, Word_t metric_id, time_t start_time_s) {
 
-    if(unlikely(epdl->head_to_datafile_extent_queries_pending_for_extent))
-        // stop appending more pages to this epdl
-        epdl_pending_del(epdl);
-
     struct page_details *pd_list = NULL;
 
     for(EPDL *ep = epdl; ep ;ep = ep->query.next) {
@@ -933,6 +974,44 @@ static inline struct page_details *epdl_get_pd_load_link_list_from_metric_start_
     return pd_list;
 }
 
+static inline bool extent_compression_algorithm_is_supported(uint8_t algorithm) {
+    switch(algorithm) {
+        case RRD_NO_COMPRESSION:
+        case RRD_LZ4:
+#ifdef NETDATA_WITH_ZSTD
+        case RRD_ZSTD:
+#endif
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// returns the number of bytes decompressed, or a negative number on failure
+static int extent_decompress(uint8_t algorithm, const char *src, char *dst, int src_size, int dst_capacity) {
+    switch(algorithm) {
+#ifdef NETDATA_WITH_ZSTD
+        case RRD_ZSTD: {
+            // one context per query worker thread, to avoid allocating it for every extent
+            static __thread ZSTD_DCtx *zstd_dctx = NULL;
+            if(unlikely(!zstd_dctx)) {
+                zstd_dctx = ZSTD_createDCtx();
+                if(unlikely(!zstd_dctx))
+                    return -1;
+            }
+
+            size_t ret = ZSTD_decompressDCtx(zstd_dctx, dst, dst_capacity, src, src_size);
+            return ZSTD_isError(ret) ? -1 : (int)ret;
+        }
+#endif
+
+        default:
+        case RRD_LZ4:
+            return LZ4_decompress_safe(src, dst, src_size, dst_capacity);
+    }
+}
+
 static bool epdl_populate_pages_from_extent_data(
         struct rrdengine_instance *ctx,
         void *data,
@@ -977,7 +1056,7 @@ static bool epdl_populate_pages_from_extent_data(
     if( !can_use_data ||
         count < 1 ||
         count > MAX_PAGES_PER_EXTENT ||
-        (header->compression_algorithm != RRD_NO_COMPRESSION && header->compression_algorithm != RRD_LZ4) ||
+        !extent_compression_algorithm_is_supported(header->compression_algorithm) ||
         (payload_length != trailer_offset - payload_offset) ||
         (data_length != payload_offset + payload_length + sizeof(*trailer))
             ) {
@@ -1018,18 +1097,27 @@ static bool epdl_populate_pages_from_extent_data(
             uncompressed_payload_length += header->descr[i].page_length;
         }
 
-        if(unlikely(uncompressed_payload_length > MAX_PAGES_PER_EXTENT * RRDENG_BLOCK_SIZE))
+        if(unlikely(uncompressed_payload_length > MAX_EXTENT_UNCOMPRESSED_SIZE))
             have_read_error = true;
 
         if(likely(!have_read_error)) {
             eb = extent_buffer_get(uncompressed_payload_length);
             uncompressed_buf = eb->data;
 
-            ret = LZ4_decompress_safe(data + payload_offset, uncompressed_buf,
-                                      (int) payload_length, (int) uncompressed_payload_length);
-            ctx->stats.before_decompress_bytes += payload_length;
-            ctx->stats.after_decompress_bytes += ret;
-            debug(D_RRDENGINE, "LZ4 decompressed %u bytes to %d bytes.", payload_length, ret);
+            ret = extent_decompress(header->compression_algorithm, data + payload_offset, uncompressed_buf,
+                                    (int) payload_length, (int) uncompressed_payload_length);
+            if(unlikely(ret < 0)) {
+                have_read_error = true;
+
+                error_limit_static_global_var(erl, 1, 0);
+                error_limit(&erl, "%s: Extent at offset %"PRIu64" (%u bytes) was read from datafile %u, but it cannot be decompressed",
+                            __func__, epdl->extent_offset, epdl->extent_size, epdl->datafile->fileno);
+            }
+            else {
+                ctx->stats.before_decompress_bytes += payload_length;
+                ctx->stats.after_decompress_bytes += ret;
+                debug(D_RRDENGINE, "Decompressed %u bytes to %d bytes.", payload_length, ret);
+            }
         }
     }
 
@@ -1042,107 +1130,129 @@ static bool epdl_populate_pages_from_extent_data(
     size_t stats_load_uncompressed = 0;
     size_t stats_load_invalid_page = 0;
     size_t stats_cache_hit_while_inserting = 0;
+    size_t stats_data_from_inflight_extent = 0;
 
-    uint32_t page_offset = 0, page_length;
-    time_t now_s = now_realtime_sec();
-    for (i = 0; i < count; i++, page_offset += page_length) {
-        page_length = header->descr[i].page_length;
-        time_t start_time_s = (time_t) (header->descr[i].start_time_ut / USEC_PER_SEC);
-
-        if(!page_length || !start_time_s) {
-            error_limit_static_global_var(erl, 1, 0);
-            error_limit(&erl, "%s: Extent at offset %"PRIu64" (%u bytes) was read from datafile %u, having page %u (out of %u) EMPTY",
-                        __func__, epdl->extent_offset, epdl->extent_size, epdl->datafile->fileno, i, count);
-            continue;
-        }
-
-        METRIC *metric = mrg_metric_get_and_acquire(main_mrg, &header->descr[i].uuid, (Word_t)ctx);
-        Word_t metric_id = (Word_t)metric;
-        if(!metric) {
-            error_limit_static_global_var(erl, 1, 0);
-            error_limit(&erl, "%s: Extent at offset %"PRIu64" (%u bytes) was read from datafile %u, having page %u (out of %u) for unknown UUID",
-                        __func__, epdl->extent_offset, epdl->extent_size, epdl->datafile->fileno, i, count);
-            continue;
-        }
-        mrg_metric_release(main_mrg, metric);
+    // the queries that need this extent from now on, will get their pages
+    // from the data we have already read and decompressed
+    if(epdl->head_to_datafile_extent_queries_pending_for_extent)
+        epdl_pending_populating(epdl);
 
-        struct page_details *pd_list = epdl_get_pd_load_link_list_from_metric_start_time(epdl, metric_id, start_time_s);
-        if(likely(!pd_list))
-            continue;
-
-        VALIDATED_PAGE_DESCRIPTOR vd = validate_extent_page_descr(
-                &header->descr[i], now_s,
-                (pd_list) ? pd_list->update_every_s : 0,
-                have_read_error);
+    EPDL *list = epdl;
+    time_t now_s = now_realtime_sec();
+    while(list) {
+        uint32_t page_offset = 0, page_length;
+        for (i = 0; i < count; i++, page_offset += page_length) {
+            page_length = header->descr[i].page_length;
+            time_t start_time_s = (time_t) (header->descr[i].start_time_ut / USEC_PER_SEC);
+
+            if(!page_length || !start_time_s) {
+                error_limit_static_global_var(erl, 1, 0);
+                error_limit(&erl, "%s: Extent at offset %"PRIu64" (%u bytes) was read from datafile %u, having page %u (out of %u) EMPTY",
+                            __func__, epdl->extent_offset, epdl->extent_size, epdl->datafile->fileno, i, count);
+                continue;
+            }
 
-        if(worker)
-            worker_is_busy(UV_EVENT_PAGE_POPULATION);
+            METRIC *metric = mrg_metric_get_and_acquire(main_mrg, &header->descr[i].uuid, (Word_t)ctx);
+            Word_t metric_id = (Word_t)metric;
+            if(!metric) {
+                error_limit_static_global_var(erl, 1, 0);
+                error_limit(&erl, "%s: Extent at offset %"PRIu64" (%u bytes) was read from datafile %u, having page %u (out of %u) for unknown UUID",
+                            __func__, epdl->extent_offset, epdl->extent_size, epdl->datafile->fileno, i, count);
+                continue;
+            }
+            mrg_metric_release(main_mrg, metric);
 
-        void *page_data = dbengine_page_alloc(ctx, vd.page_length);
+            struct page_details *pd_list = epdl_get_pd_load_link_list_from_metric_start_time(list, metric_id, start_time_s);
+            if(likely(!pd_list))
+                continue;
 
-        if (unlikely(!vd.data_on_disk_valid)) {
-            fill_page_with_nulls(page_data, vd.page_length, vd.type);
-            stats_load_invalid_page++;
-        }
+            VALIDATED_PAGE_DESCRIPTOR vd = validate_extent_page_descr(
+                    &header->descr[i], now_s,
+                    (pd_list) ? pd_list->update_every_s : 0,
+                    have_read_error);
 
-        else if (RRD_NO_COMPRESSION == header->compression_algorithm) {
-            memcpy(page_data, data + payload_offset + page_offset, (size_t) vd.page_length);
-            stats_load_uncompressed++;
-        }
+            if(worker)
+                worker_is_busy(UV_EVENT_PAGE_POPULATION);
 
-        else {
-            if(unlikely(page_offset + vd.page_length > uncompressed_payload_length)) {
-                error_limit_static_global_var(erl, 10, 0);
-                error_limit(&erl,
-                            "DBENGINE: page %u offset %u + page length %zu exceeds the uncompressed buffer size %u",
-                            i, page_offset, vd.page_length, uncompressed_payload_length);
+            void *page_data = dbengine_page_alloc(ctx, vd.page_length);
 
+            if (unlikely(!vd.data_on_disk_valid)) {
                 fill_page_with_nulls(page_data, vd.page_length, vd.type);
                 stats_load_invalid_page++;
             }
+
+            else if (RRD_NO_COMPRESSION == header->compression_algorithm) {
+                memcpy(page_data, data + payload_offset + page_offset, (size_t) vd.page_length);
+                stats_load_uncompressed++;
+            }
+
             else {
-                memcpy(page_data, uncompressed_buf + page_offset, vd.page_length);
-                stats_load_compressed++;
+                if(unlikely(page_offset + vd.page_length > uncompressed_payload_length)) {
+                    error_limit_static_global_var(erl, 10, 0);
+                    error_limit(&erl,
+                                "DBENGINE: page %u offset %u + page length %zu exceeds the uncompressed buffer size %u",
+                                i, page_offset, vd.page_length, uncompressed_payload_length);
+
+                    fill_page_with_nulls(page_data, vd.page_length, vd.type);
+                    stats_load_invalid_page++;
+                }
+                else {
+                    memcpy(page_data, uncompressed_buf + page_offset, vd.page_length);
+                    stats_load_compressed++;
+                }
             }
-        }
 
-        PGC_ENTRY page_entry = {
-                .hot = false,
-                .section = (Word_t)ctx,
-                .metric_id = metric_id,
-                .start_time_s = vd.start_time_s,
-                .end_time_s = vd.end_time_s,
-                .update_every_s = vd.update_every_s,
-                .size = (size_t) vd.page_length,
-                .data = page_data
-        };
-
-        bool added = true;
-        PGC_PAGE *page = pgc_page_add_and_acquire(main_cache, page_entry, &added);
-        if (false == added) {
-            dbengine_page_free(page_data);
-            stats_cache_hit_while_inserting++;
-            stats_data_from_main_cache++;
-        }
-        else
-            stats_data_from_extent++;
+            PGC_ENTRY page_entry = {
+                    .hot = false,
+                    .section = (Word_t)ctx,
+                    .metric_id = metric_id,
+                    .start_time_s = vd.start_time_s,
+                    .end_time_s = vd.end_time_s,
+                    .update_every_s = vd.update_every_s,
+                    .size = (size_t) vd.page_length,
+                    .data = page_data
+            };
 
-        struct page_details *pd = pd_list;
-        do {
-            if(pd != pd_list)
-                pgc_page_dup(main_cache, page);
+            bool added = true;
+            PGC_PAGE *page = pgc_page_add_and_acquire(main_cache, page_entry, &added);
+            if (false == added) {
+                dbengine_page_free(page_data);
 
-            pd->page = page;
-            pd->page_length = pgc_page_data_size(main_cache, page);
-            pdc_page_status_set(pd, PDC_PAGE_READY | tags);
+                if(list == epdl) {
+                    stats_cache_hit_while_inserting++;
+                    stats_data_from_main_cache++;
+                }
+                else
+                    stats_data_from_inflight_extent++;
+            }
+            else if(list == epdl)
+                stats_data_from_extent++;
+            else
+                stats_data_from_inflight_extent++;
 
-            pd = pd->load.next;
-        } while(pd);
+            struct page_details *pd = pd_list;
+            do {
+                if(pd != pd_list)
+                    pgc_page_dup(main_cache, page);
 
-        if(worker)
-            worker_is_busy(UV_EVENT_PAGE_LOOKUP);
+                pd->page = page;
+                pd->page_length = pgc_page_data_size(main_cache, page);
+                pdc_page_status_set(pd, PDC_PAGE_READY | ((list == epdl) ? tags : PDC_PAGE_EXTENT_FROM_INFLIGHT));
+
+                pd = pd->load.next;
+            } while(pd);
+
+            if(worker)
+                worker_is_busy(UV_EVENT_PAGE_LOOKUP);
+        }
+
+        // serve the queries that came while we were populating pages, from the same data
+        list = (epdl->head_to_datafile_extent_queries_pending_for_extent) ? epdl_pending_join_followers(epdl) : NULL;
     }
 
+    if(stats_data_from_inflight_extent)
+        __atomic_add_fetch(&rrdeng_cache_efficiency_stats.pages_data_source_inflight_extent, stats_data_from_inflight_extent, __ATOMIC_RELAXED);
+
     if(stats_data_from_main_cache)
         __atomic_add_fetch(&rrdeng_cache_efficiency_stats.pages_data_source_main_cache, stats_data_from_main_cache, __ATOMIC_RELAXED);
 
@@ -1173,9 +1283,12 @@ static bool epdl_populate_pages_from_extent_data(
     return true;
 }
 
+static void epdl_populate_pages_of_followers(struct rrdengine_instance *ctx, EPDL *followers, bool worker);
+
 void epdl_find_extent_and_populate_pages(struct rrdengine_instance *ctx, EPDL *epdl, bool worker) {
     size_t *statistics_counter = NULL;
     PDC_PAGE_STATUS not_loaded_pages_tag = 0, loaded_pages_tag = 0;
+    EPDL *followers = NULL;
 
     bool should_stop = __atomic_load_n(&epdl->pdc->workers_should_stop, __ATOMIC_RELAXED);
     for(EPDL *ep = epdl->query.next; ep ;ep = ep->query.next) {
@@ -1289,7 +1402,7 @@ void epdl_find_extent_and_populate_pages(struct rrdengine_instance *ctx, EPDL *e
 cleanup:
     // remove it from the datafile extent_queries
     // this can be called multiple times safely
-    epdl_pending_del(epdl);
+    followers = epdl_pending_del(epdl);
 
     // mark all pending pages as failed
     for(EPDL *ep = epdl; ep ;ep = ep->query.next) {
@@ -1307,6 +1420,34 @@ void epdl_find_extent_and_populate_pages(struct rrdengine_instance *ctx, EPDL *e
         epdl_destroy(ep);
     }
 
+    if(followers)
+        epdl_populate_pages_of_followers(ctx, followers, worker);
+
     if(worker)
         worker_is_idle();
 }
+
+// The queries that followed an extent while it was populating pages, most probably
+// find their pages in the main cache now, without reading and decompressing it again.
+// If some are missing (e.g. already evicted), the extent is processed for them.
+static void epdl_populate_pages_of_followers(struct rrdengine_instance *ctx, EPDL *followers, bool worker) {
+    bool all_found = true;
+
+    for(EPDL *ep = followers; ep ;ep = ep->query.next) {
+        if(!epdl_check_if_pages_are_already_in_cache(ctx, ep, PDC_PAGE_EXTENT_FROM_INFLIGHT))
+            all_found = false;
+    }
+
+    if(!all_found) {
+        epdl_find_extent_and_populate_pages(ctx, followers, worker);
+        return;
+    }
+
+    for(EPDL *ep = followers, *next = NULL; ep ; ep = next) {
+        next = ep->query.next;
+
+        completion_mark_complete_a_job(&ep->pdc->page_completion);
+        pdc_release_and_destroy_if_unreferenced(ep->pdc, true, false);
+        epdl_destroy(ep);
+    }
+}
@@ -19,6 +19,7 @@
 
 #define RRD_NO_COMPRESSION (0)
 #define RRD_LZ4 (1)
+#define RRD_ZSTD (2)
 
 #define RRDENG_DF_SB_PADDING_SZ (RRDENG_BLOCK_SIZE - (RRDENG_MAGIC_SZ + RRDENG_VER_SZ + sizeof(uint8_t)))
 /*
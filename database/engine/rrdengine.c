@@ -10,7 +10,8 @@ rrdeng_stats_t rrdeng_reserved_file_descriptors = 0;
 rrdeng_stats_t global_pg_cache_over_half_dirty_events = 0;
 rrdeng_stats_t global_flushing_pressure_page_deletions = 0;
 
-unsigned rrdeng_pages_per_extent = MAX_PAGES_PER_EXTENT;
+unsigned rrdeng_pages_per_extent = RRDENG_DEFAULT_PAGES_PER_EXTENT;
+unsigned rrdeng_extent_target_size = RRDENG_EXTENT_TARGET_SIZE;
 
 #if WORKER_UTILIZATION_MAX_JOB_TYPES < (RRDENG_OPCODE_MAX + 2)
 #error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least (RRDENG_MAX_OPCODE + 2)
@@ -54,6 +55,16 @@ static void sanity_check(void)
     /* page count must fit in 8 bits */
     BUILD_BUG_ON(MAX_PAGES_PER_EXTENT > 255);
 
+    /* a journal transaction must be able to describe a full extent */
+    BUILD_BUG_ON(sizeof(struct rrdeng_jf_transaction_header) + sizeof(struct rrdeng_jf_store_data) +
+                 MAX_PAGES_PER_EXTENT * sizeof(struct rrdeng_extent_page_descr) +
+                 sizeof(struct rrdeng_jf_transaction_trailer) > MAX_JOURNAL_TRANSACTION_SIZE);
+
+    /* with the default pages per extent, journal transactions fit in one block, as older agents expect */
+    BUILD_BUG_ON(sizeof(struct rrdeng_jf_transaction_header) + sizeof(struct rrdeng_jf_store_data) +
+                 RRDENG_DEFAULT_PAGES_PER_EXTENT * sizeof(struct rrdeng_extent_page_descr) +
+                 sizeof(struct rrdeng_jf_transaction_trailer) > RRDENG_BLOCK_SIZE);
+
     /* extent cache count must fit in 32 bits */
 //    BUILD_BUG_ON(MAX_CACHED_EXTENTS > 32);
 
@@ -483,7 +494,7 @@ static void wal_cleanup1(void) {
 }
 
 WAL *wal_get(struct rrdengine_instance *ctx, unsigned size) {
-    if(!size || size > RRDENG_BLOCK_SIZE)
+    if(!size || size > MAX_JOURNAL_TRANSACTION_SIZE)
         fatal("DBENGINE: invalid WAL size requested");
 
     WAL *wal = NULL;
@@ -500,8 +511,9 @@ WAL *wal_get(struct rrdengine_instance *ctx, unsigned size) {
     netdata_spinlock_unlock(&wal_globals.protected.spinlock);
 
     if(unlikely(!wal)) {
+        // all buffers can hold the biggest transaction, only the blocks used are written to disk
         wal = mallocz(sizeof(WAL));
-        wal->buf_size = RRDENG_BLOCK_SIZE;
+        wal->buf_size = MAX_JOURNAL_TRANSACTION_SIZE;
         int ret = posix_memalign((void *)&wal->buf, RRDFILE_ALIGNMENT, wal->buf_size);
         if (unlikely(ret))
             fatal("DBENGINE: posix_memalign:%s", strerror(ret));
@@ -518,7 +530,7 @@ WAL *wal_get(struct rrdengine_instance *ctx, unsigned size) {
     wal->buf_size = buf_size;
     wal->buf = buf;
 
-    memset(wal->buf, 0, wal->buf_size);
+    memset(wal->buf, 0, ALIGN_BYTES_CEILING(size));
 
     wal->transaction_id = transaction_id;
     wal->size = size;
@@ -854,6 +866,34 @@ static void extent_flush_io_callback(uv_fs_t *uv_fs_request) {
     worker_is_idle();
 }
 
+// compress an extent payload with the method and level of the tier
+// returns the compressed size, or 0 on failure
+static int extent_compress(RRDENG_COMPRESSION compression, const char *src, char *dst, int src_size, int dst_capacity) {
+    switch(compression.method) {
+        case RRDENG_COMPRESSION_LZ4HC:
+            return LZ4_compress_HC(src, dst, src_size, dst_capacity, compression.level);
+
+#ifdef NETDATA_WITH_ZSTD
+        case RRDENG_COMPRESSION_ZSTD: {
+            // one context per flushing thread, to avoid allocating it for every extent
+            static __thread ZSTD_CCtx *zstd_cctx = NULL;
+            if(unlikely(!zstd_cctx)) {
+                zstd_cctx = ZSTD_createCCtx();
+                if(unlikely(!zstd_cctx))
+                    return 0;
+            }
+
+            size_t ret = ZSTD_compressCCtx(zstd_cctx, dst, dst_capacity, src, src_size, compression.level);
+            return ZSTD_isError(ret) ? 0 : (int)ret;
+        }
+#endif
+
+        default:
+        case RRDENG_COMPRESSION_LZ4:
+            return LZ4_compress_fast(src, dst, src_size, dst_capacity, compression.level);
+    }
+}
+
 /*
  * Take a page list in a judy array and write them
  */
@@ -867,7 +907,8 @@ static unsigned do_flush_extent(struct rrdengine_instance *ctx, struct page_desc
     struct extent_buffer *eb = NULL;
     void *compressed_buf = NULL;
     Word_t Index;
-    uint8_t compression_algorithm = ctx->global_compress_alg;
+    RRDENG_COMPRESSION compression = ctx->compression;
+    uint8_t compression_algorithm = rrdeng_compression_disk_algorithm(compression.method);
     struct rrdengine_datafile *datafile;
     /* persistent structures */
     struct rrdeng_df_extent_header *header;
@@ -899,6 +940,15 @@ static unsigned do_flush_extent(struct rrdengine_instance *ctx, struct page_desc
             size_bytes = payload_offset + uncompressed_payload_length + sizeof(*trailer);
             break;
 
+#ifdef NETDATA_WITH_ZSTD
+        case RRD_ZSTD:
+            max_compressed_size = (int)ZSTD_compressBound(uncompressed_payload_length);
+            eb = extent_buffer_get(max_compressed_size);
+            compressed_buf = eb->data;
+            size_bytes = payload_offset + MAX(uncompressed_payload_length, (unsigned)max_compressed_size) + sizeof(*trailer);
+            break;
+#endif
+
         default: /* Compress */
             fatal_assert(uncompressed_payload_length < LZ4_MAX_INPUT_SIZE);
             max_compressed_size = LZ4_compressBound(uncompressed_payload_length);
@@ -943,11 +993,24 @@ static unsigned do_flush_extent(struct rrdengine_instance *ctx, struct page_desc
             header->payload_length = uncompressed_payload_length;
             break;
         default: /* Compress */
-            compressed_size = LZ4_compress_default(xt_io_descr->buf + payload_offset, compressed_buf,
-                                               uncompressed_payload_length, max_compressed_size);
+            compressed_size = extent_compress(compression, xt_io_descr->buf + payload_offset, compressed_buf,
+                                              uncompressed_payload_length, max_compressed_size);
+            if(unlikely(compressed_size <= 0)) {
+                // keep the extent uncompressed - it is already in place
+                error_limit_static_global_var(erl, 1, 0);
+                error_limit(&erl, "DBENGINE: %s compression of %"PRIu32" bytes failed, writing the extent uncompressed.",
+                            rrdeng_compression_method_name(compression.method), uncompressed_payload_length);
+
+                extent_buffer_release(eb);
+                header->compression_algorithm = RRD_NO_COMPRESSION;
+                size_bytes = payload_offset + uncompressed_payload_length + sizeof(*trailer);
+                header->payload_length = uncompressed_payload_length;
+                break;
+            }
             ctx->stats.before_compress_bytes += uncompressed_payload_length;
             ctx->stats.after_compress_bytes += compressed_size;
-            debug(D_RRDENGINE, "LZ4 compressed %"PRIu32" bytes to %d bytes.", uncompressed_payload_length, compressed_size);
+            debug(D_RRDENGINE, "%s compressed %"PRIu32" bytes to %d bytes.",
+                  rrdeng_compression_method_name(compression.method), uncompressed_payload_length, compressed_size);
             (void) memcpy(xt_io_descr->buf + payload_offset, compressed_buf, compressed_size);
             extent_buffer_release(eb);
             size_bytes = payload_offset + compressed_size + sizeof(*trailer);
@@ -1281,6 +1344,7 @@ static void cache_flush_tp_worker(struct rrdengine_instance *ctx __maybe_unused,
         return;
 
     worker_is_busy(UV_EVENT_FLUSH_MAIN);
+    rrdeng_page_alignments_flush_expired_pending_pages();
     pgc_flush_pages(main_cache, 0);
 }
 
@@ -1417,7 +1481,7 @@ struct rrdeng_buffer_sizes rrdeng_get_buffer_sizes(void) {
             .opcodes     = __atomic_load_n(&rrdeng_cmd_globals.cache.atomics.allocated, __ATOMIC_RELAXED) * sizeof(struct rrdeng_cmd),
             .handles     = __atomic_load_n(&rrdeng_query_handle_globals.atomics.allocated, __ATOMIC_RELAXED) * sizeof(struct rrdeng_query_handle),
             .descriptors = __atomic_load_n(&page_descriptor_globals.atomics.allocated, __ATOMIC_RELAXED) * sizeof(struct page_descr_with_data),
-            .wal         = __atomic_load_n(&wal_globals.atomics.allocated, __ATOMIC_RELAXED) * (sizeof(WAL) + RRDENG_BLOCK_SIZE),
+            .wal         = __atomic_load_n(&wal_globals.atomics.allocated, __ATOMIC_RELAXED) * (sizeof(WAL) + MAX_JOURNAL_TRANSACTION_SIZE),
             .workers     = __atomic_load_n(&work_request_globals.atomics.allocated, __ATOMIC_RELAXED) * sizeof(struct rrdeng_work),
             .pdc         = pdc_cache_size(),
             .xt_io       = __atomic_load_n(&extent_io_descriptor_globals.atomics.allocated, __ATOMIC_RELAXED) * sizeof(struct extent_io_descriptor),
@@ -1463,14 +1527,19 @@ void timer_cb(uv_timer_t* handle) {
 }
 
 bool rrdeng_dbengine_spawn(struct rrdengine_instance *ctx) {
+    static SPINLOCK spinlock = NETDATA_SPINLOCK_INITIALIZER;
     static bool spawned = false;
 
+    // tiers may be initialized in parallel
+    netdata_spinlock_lock(&spinlock);
+
     if(!spawned) {
         int ret;
 
         ret = uv_loop_init(&rrdeng_main.loop);
         if (ret) {
             error("DBENGINE: uv_loop_init(): %s", uv_strerror(ret));
+            netdata_spinlock_unlock(&spinlock);
             return false;
         }
         rrdeng_main.loop.data = &rrdeng_main;
@@ -1479,6 +1548,7 @@ bool rrdeng_dbengine_spawn(struct rrdengine_instance *ctx) {
         if (ret) {
             error("DBENGINE: uv_async_init(): %s", uv_strerror(ret));
             fatal_assert(0 == uv_loop_close(&rrdeng_main.loop));
+            netdata_spinlock_unlock(&spinlock);
             return false;
         }
         rrdeng_main.async.data = &rrdeng_main;
@@ -1488,6 +1558,7 @@ bool rrdeng_dbengine_spawn(struct rrdengine_instance *ctx) {
             error("DBENGINE: uv_timer_init(): %s", uv_strerror(ret));
             uv_close((uv_handle_t *)&rrdeng_main.async, NULL);
             fatal_assert(0 == uv_loop_close(&rrdeng_main.loop));
+            netdata_spinlock_unlock(&spinlock);
             return false;
         }
         rrdeng_main.timer.data = &rrdeng_main;
@@ -1496,6 +1567,8 @@ bool rrdeng_dbengine_spawn(struct rrdengine_instance *ctx) {
         spawned = true;
     }
 
+    netdata_spinlock_unlock(&spinlock);
+
     ctx->worker_config.now_deleting_files = false;
     ctx->worker_config.migration_to_v2_running = false;
     ctx->worker_config.atomics.extents_currently_being_flushed = 0;
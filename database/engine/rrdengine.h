@@ -8,6 +8,10 @@
 #endif
 #include <fcntl.h>
 #include <lz4.h>
+#include <lz4hc.h>
+#ifdef NETDATA_WITH_ZSTD
+#include <zstd.h>
+#endif
 #include <Judy.h>
 #include <openssl/sha.h>
 #include <openssl/evp.h>
@@ -24,12 +28,43 @@
 #include "pdc.h"
 
 extern unsigned rrdeng_pages_per_extent;
+extern unsigned rrdeng_extent_target_size;
+
+typedef enum __attribute__ ((__packed__)) rrdeng_compression_method {
+    RRDENG_COMPRESSION_NONE = 0,
+    RRDENG_COMPRESSION_LZ4,                 // level is the LZ4 acceleration (1 = LZ4 default)
+    RRDENG_COMPRESSION_LZ4HC,               // level is the LZ4HC level, written as RRD_LZ4 on disk
+    RRDENG_COMPRESSION_ZSTD,                // level is the zstd level, written as RRD_ZSTD on disk
+} RRDENG_COMPRESSION_METHOD;
+
+typedef struct rrdeng_compression {
+    RRDENG_COMPRESSION_METHOD method;
+    int level;
+} RRDENG_COMPRESSION;
+
+extern RRDENG_COMPRESSION rrdeng_tier_compression[RRD_STORAGE_TIERS];
+
+bool rrdeng_compression_set(RRDENG_COMPRESSION *compression, const char *method, int level);
+const char *rrdeng_compression_method_name(RRDENG_COMPRESSION_METHOD method);
+uint8_t rrdeng_compression_disk_algorithm(RRDENG_COMPRESSION_METHOD method);
 
 /* Forward declarations */
 struct rrdengine_instance;
 struct rrdeng_cmd;
 
-#define MAX_PAGES_PER_EXTENT (64) /* TODO: can go higher only when journal supports bigger than 4KiB transactions */
+#define MAX_PAGES_PER_EXTENT (255) /* the number of pages is stored in a uint8_t, on disk */
+
+/* the default pages per extent - agents before variable size journal transactions cannot read larger extents */
+#define RRDENG_DEFAULT_PAGES_PER_EXTENT (64)
+
+/* the largest uncompressed extent payload we write or accept while reading */
+#define MAX_EXTENT_UNCOMPRESSED_SIZE (MAX_PAGES_PER_EXTENT * RRDENG_BLOCK_SIZE)
+
+/* extents are cut when their uncompressed payload reaches this size (configurable) */
+#define RRDENG_EXTENT_TARGET_SIZE (64 * RRDENG_BLOCK_SIZE)
+
+/* journal transactions may span multiple blocks - this is enough to describe MAX_PAGES_PER_EXTENT pages */
+#define MAX_JOURNAL_TRANSACTION_SIZE (4 * RRDENG_BLOCK_SIZE)
 
 #define GET_JOURNAL_DATA(x) __atomic_load_n(&(x)->journal_data, __ATOMIC_ACQUIRE)
 #define GET_JOURNAL_DATA_SIZE(x) __atomic_load_n(&(x)->journal_data_size, __ATOMIC_ACQUIRE)
@@ -101,6 +136,7 @@ typedef enum __attribute__ ((__packed__)) {
     PDC_PAGE_SOURCE_OPEN_CACHE         = (1 << 17),
     PDC_PAGE_SOURCE_JOURNAL_V2         = (1 << 18),
     PDC_PAGE_PRELOADED_PASS4           = (1 << 19),
+    PDC_PAGE_EXTENT_FROM_INFLIGHT      = (1 << 20), // loaded by another query reading the same extent
 
     // datafile acquired
     PDC_PAGE_DATAFILE_ACQUIRED         = (1 << 30),
@@ -187,6 +223,7 @@ struct rrdeng_collect_handle {
     uint32_t page_position;                   // keep track of the current page size, to make sure we don't exceed it
     usec_t page_end_time_ut;
     usec_t update_every_ut;
+    void *spare_data;                         // the data of the next page, allocated before the current page is full
 };
 
 struct rrdeng_query_handle {
@@ -372,7 +409,7 @@ struct rrdengine_instance {
     struct rrdengine_worker_config worker_config;
     struct completion rrdengine_completion;
     bool journal_initialization;
-    uint8_t global_compress_alg;
+    RRDENG_COMPRESSION compression; /* the algorithm and level used for writing extents */
     struct transaction_commit_log commit_log;
     struct rrdengine_datafile_list datafiles;
     RRDHOST *host; /* the legacy host, or NULL for multi-host DB */
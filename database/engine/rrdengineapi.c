@@ -10,6 +10,9 @@ struct rrdengine_instance multidb_ctx_storage_tier4;
 
 #define mrg_metric_ctx(metric) (struct rrdengine_instance *)mrg_metric_section(main_mrg, metric)
 
+// allocate the data of the next page, when the current one has this many points left
+#define RRDENG_SPARE_PAGE_POINTS 1
+
 #if RRD_STORAGE_TIERS != 5
 #error RRD_STORAGE_TIERS is not 5 - you need to add allocations here
 #endif
@@ -27,6 +30,90 @@ size_t tier_page_size[RRD_STORAGE_TIERS] = {4096, 2048, 384, 384, 384};
 #endif
 size_t page_type_size[256] = {sizeof(storage_number), sizeof(storage_number_tier1_t)};
 
+RRDENG_COMPRESSION rrdeng_tier_compression[RRD_STORAGE_TIERS] = {
+        [0 ... RRD_STORAGE_TIERS - 1] = { .method = RRDENG_COMPRESSION_LZ4, .level = 1 },
+};
+
+const char *rrdeng_compression_method_name(RRDENG_COMPRESSION_METHOD method) {
+    switch(method) {
+        case RRDENG_COMPRESSION_NONE:
+            return "none";
+
+        default:
+        case RRDENG_COMPRESSION_LZ4:
+            return "lz4";
+
+        case RRDENG_COMPRESSION_LZ4HC:
+            return "lz4hc";
+
+        case RRDENG_COMPRESSION_ZSTD:
+            return "zstd";
+    }
+}
+
+uint8_t rrdeng_compression_disk_algorithm(RRDENG_COMPRESSION_METHOD method) {
+    switch(method) {
+        case RRDENG_COMPRESSION_NONE:
+            return RRD_NO_COMPRESSION;
+
+#ifdef NETDATA_WITH_ZSTD
+        case RRDENG_COMPRESSION_ZSTD:
+            return RRD_ZSTD;
+#endif
+
+        default:
+        case RRDENG_COMPRESSION_LZ4:
+        case RRDENG_COMPRESSION_LZ4HC:
+            return RRD_LZ4;
+    }
+}
+
+// parse a compression method and level
+// level 0 selects the default level of the method, out of range levels are clamped
+// returns false (and leaves compression untouched) when the method is unknown or not supported
+bool rrdeng_compression_set(RRDENG_COMPRESSION *compression, const char *method, int level) {
+    RRDENG_COMPRESSION c;
+    int min_level, max_level, default_level;
+
+    if(!strcmp(method, "none")) {
+        c.method = RRDENG_COMPRESSION_NONE;
+        min_level = max_level = default_level = 0;
+    }
+    else if(!strcmp(method, "lz4")) {
+        c.method = RRDENG_COMPRESSION_LZ4;
+        min_level = 1;
+        max_level = 65537; // LZ4_ACCELERATION_MAX
+        default_level = 1;
+    }
+    else if(!strcmp(method, "lz4hc")) {
+        c.method = RRDENG_COMPRESSION_LZ4HC;
+        min_level = 1;
+        max_level = LZ4HC_CLEVEL_MAX;
+        default_level = LZ4HC_CLEVEL_DEFAULT;
+    }
+#ifdef NETDATA_WITH_ZSTD
+    else if(!strcmp(method, "zstd")) {
+        c.method = RRDENG_COMPRESSION_ZSTD;
+        min_level = 1;
+        max_level = ZSTD_maxCLevel();
+        default_level = ZSTD_CLEVEL_DEFAULT;
+    }
+#endif
+    else
+        return false;
+
+    if(!level)
+        level = default_level;
+    else if(level < min_level)
+        level = min_level;
+    else if(level > max_level)
+        level = max_level;
+
+    c.level = level;
+    *compression = c;
+    return true;
+}
+
 __attribute__((constructor)) void initialize_multidb_ctx(void) {
     multidb_ctx[0] = &multidb_ctx_storage_tier0;
     multidb_ctx[1] = &multidb_ctx_storage_tier1;
@@ -38,6 +125,7 @@ __attribute__((constructor)) void initialize_multidb_ctx(void) {
 int default_rrdeng_page_fetch_timeout = 3;
 int default_rrdeng_page_fetch_retries = 3;
 int db_engine_journal_check = 0;
+int db_engine_parallel_initialization = 1;
 int default_rrdeng_disk_quota_mb = 256;
 int default_multidb_disk_quota_mb = 256;
 
@@ -50,15 +138,94 @@ int default_rrdeng_page_cache_mb = 32;
 // ----------------------------------------------------------------------------
 // metrics groups
 
+// all the metrics groups, so that the flush worker can find the ones with expired pending pages
+static struct {
+    SPINLOCK spinlock;
+    struct pg_alignment *base;
+} pg_alignment_globals = {
+        .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+        .base = NULL,
+};
+
 static inline void rrdeng_page_alignment_acquire(struct pg_alignment *pa) {
     if(unlikely(!pa)) return;
     __atomic_add_fetch(&pa->refcount, 1, __ATOMIC_SEQ_CST);
 }
 
+// take all the pending pages of the group - the group has to be locked
+static inline size_t rrdeng_page_alignment_take_pending_pages_unsafe(struct pg_alignment *pa, PGC_PAGE **pages) {
+    size_t count = pa->pending_pages;
+    memcpy(pages, pa->pending, count * sizeof(PGC_PAGE *));
+    __atomic_store_n(&pa->pending_pages, 0, __ATOMIC_RELAXED);
+    return count;
+}
+
+// make dirty the pages taken from a group, in one batch
+static void rrdeng_page_alignment_dirty_pages(PGC_PAGE **pages, size_t count) {
+    if(!count)
+        return;
+
+    pgc_pages_hot_to_dirty_and_release(main_cache, pages, count);
+
+    __atomic_add_fetch(&rrdeng_cache_efficiency_stats.collection_pages_batched, count, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&rrdeng_cache_efficiency_stats.collection_batches, 1, __ATOMIC_RELAXED);
+}
+
+// make dirty all the full pages of the group, in one batch
+static void rrdeng_page_alignment_flush_pending_pages(struct pg_alignment *pa) {
+    PGC_PAGE *pages[PG_ALIGNMENT_PENDING_PAGES];
+    size_t count;
+
+    netdata_spinlock_lock(&pa->spinlock);
+    count = rrdeng_page_alignment_take_pending_pages_unsafe(pa, pages);
+    netdata_spinlock_unlock(&pa->spinlock);
+
+    rrdeng_page_alignment_dirty_pages(pages, count);
+}
+
+// a full hot page is queued to its group, instead of being made dirty immediately
+// the group is flushed when all its collectors have filled their pages, when the
+// queue is full, when the next collection iteration starts, or by the flush worker
+// when the group is not collected for PG_ALIGNMENT_PENDING_MAX_ITERATIONS
+static void rrdeng_page_alignment_add_pending_page(struct pg_alignment *pa, PGC_PAGE *page, usec_t page_end_time_ut, usec_t update_every_ut) {
+    if(unlikely(!pa)) {
+        pgc_page_hot_to_dirty_and_release(main_cache, page);
+        return;
+    }
+
+    PGC_PAGE *pages[PG_ALIGNMENT_PENDING_PAGES];
+    size_t count = 0;
+
+    netdata_spinlock_lock(&pa->spinlock);
+
+    if(!pa->pending_pages) {
+        __atomic_store_n(&pa->pending_since_ut, page_end_time_ut, __ATOMIC_RELAXED);
+        pa->pending_expire_ut = now_monotonic_usec() + PG_ALIGNMENT_PENDING_MAX_ITERATIONS * update_every_ut;
+    }
+
+    pa->pending[pa->pending_pages] = page;
+    __atomic_store_n(&pa->pending_pages, pa->pending_pages + 1, __ATOMIC_RELAXED);
+
+    // the chart holds one reference, the rest are the collectors
+    // the pages are taken while locked, so that the next page always finds room in the queue
+    if(pa->pending_pages >= PG_ALIGNMENT_PENDING_PAGES ||
+       pa->pending_pages + 1 >= __atomic_load_n(&pa->refcount, __ATOMIC_RELAXED))
+        count = rrdeng_page_alignment_take_pending_pages_unsafe(pa, pages);
+
+    netdata_spinlock_unlock(&pa->spinlock);
+
+    rrdeng_page_alignment_dirty_pages(pages, count);
+}
+
 static inline bool rrdeng_page_alignment_release(struct pg_alignment *pa) {
     if(unlikely(!pa)) return true;
 
     if(__atomic_sub_fetch(&pa->refcount, 1, __ATOMIC_SEQ_CST) == 0) {
+        netdata_spinlock_lock(&pg_alignment_globals.spinlock);
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(pg_alignment_globals.base, pa, prev, next);
+        netdata_spinlock_unlock(&pg_alignment_globals.spinlock);
+
+        rrdeng_page_alignment_flush_pending_pages(pa);
         freez(pa);
         return true;
     }
@@ -66,10 +233,43 @@ static inline bool rrdeng_page_alignment_release(struct pg_alignment *pa) {
     return false;
 }
 
+// the flush worker calls this, to make dirty the pending pages of the groups
+// that stopped being collected - their next store would never come
+void rrdeng_page_alignments_flush_expired_pending_pages(void) {
+    PGC_PAGE *pages[PG_ALIGNMENT_PENDING_PAGES];
+    usec_t now_ut = now_monotonic_usec();
+
+    // the list lock is taken before the lock of each group, and keeps
+    // the groups from being freed while we are using them
+    netdata_spinlock_lock(&pg_alignment_globals.spinlock);
+
+    for(struct pg_alignment *pa = pg_alignment_globals.base; pa ; pa = pa->next) {
+        if(likely(!__atomic_load_n(&pa->pending_pages, __ATOMIC_RELAXED)))
+            continue;
+
+        size_t count = 0;
+
+        netdata_spinlock_lock(&pa->spinlock);
+        if(pa->pending_pages && pa->pending_expire_ut <= now_ut)
+            count = rrdeng_page_alignment_take_pending_pages_unsafe(pa, pages);
+        netdata_spinlock_unlock(&pa->spinlock);
+
+        rrdeng_page_alignment_dirty_pages(pages, count);
+    }
+
+    netdata_spinlock_unlock(&pg_alignment_globals.spinlock);
+}
+
 // charts call this
 STORAGE_METRICS_GROUP *rrdeng_metrics_group_get(STORAGE_INSTANCE *db_instance __maybe_unused, uuid_t *uuid __maybe_unused) {
     struct pg_alignment *pa = callocz(1, sizeof(struct pg_alignment));
+    netdata_spinlock_init(&pa->spinlock);
     rrdeng_page_alignment_acquire(pa);
+
+    netdata_spinlock_lock(&pg_alignment_globals.spinlock);
+    DOUBLE_LINKED_LIST_APPEND_UNSAFE(pg_alignment_globals.base, pa, prev, next);
+    netdata_spinlock_unlock(&pg_alignment_globals.spinlock);
+
     return (STORAGE_METRICS_GROUP *)pa;
 }
 
@@ -248,7 +448,7 @@ void rrdeng_store_metric_flush_current_page(STORAGE_COLLECT_HANDLE *collection_h
 
     else {
         mrg_metric_set_clean_latest_time_s(main_mrg, handle->metric, pgc_page_end_time_s(handle->page));
-        pgc_page_hot_to_dirty_and_release(main_cache, handle->page);
+        rrdeng_page_alignment_add_pending_page(handle->alignment, handle->page, handle->page_end_time_ut, handle->update_every_ut);
     }
 
     mrg_metric_set_hot_latest_time_s(main_mrg, handle->metric, 0);
@@ -309,6 +509,16 @@ static void *rrdeng_alloc_new_metric_data(struct rrdeng_collect_handle *handle,
     if(handle->options & RRDENG_FIRST_PAGE_ALLOCATED) {
         // any page except the first
         size = tier_page_size[ctx->tier];
+
+        if(likely(handle->spare_data)) {
+            // it has been allocated while the previous page was being filled
+            void *data = handle->spare_data;
+            handle->spare_data = NULL;
+            __atomic_add_fetch(&rrdeng_cache_efficiency_stats.collection_spare_pages_used, 1, __ATOMIC_RELAXED);
+
+            *data_size = size;
+            return data;
+        }
     }
     else {
         // the first page
@@ -341,6 +551,15 @@ static void *rrdeng_alloc_new_metric_data(struct rrdeng_collect_handle *handle,
     return dbengine_page_alloc(ctx, size);
 }
 
+static inline void rrdeng_collection_rollover_latency_add(usec_t dt_ut) {
+    size_t bucket = (dt_ut) ? (size_t)(64 - __builtin_clzll(dt_ut)) : 0;
+
+    if(bucket >= RRDENG_COLLECTION_LATENCY_BUCKETS)
+        bucket = RRDENG_COLLECTION_LATENCY_BUCKETS - 1;
+
+    __atomic_add_fetch(&rrdeng_cache_efficiency_stats.collection_rollover_latency_ut[bucket], 1, __ATOMIC_RELAXED);
+}
+
 static void rrdeng_store_metric_next_internal(STORAGE_COLLECT_HANDLE *collection_handle,
                               usec_t point_in_time_ut,
                               NETDATA_DOUBLE n,
@@ -357,6 +576,11 @@ static void rrdeng_store_metric_next_internal(STORAGE_COLLECT_HANDLE *collection
     void *data;
     size_t data_size;
 
+    // time only the points that create or complete a page
+    usec_t rollover_started_ut = 0;
+    if(unlikely(!handle->page || handle->page_position + 1 >= handle->page_entries_max))
+        rollover_started_ut = now_monotonic_usec();
+
     if(likely(handle->page)) {
         /* Make alignment decisions */
         if (handle->page_position == handle->alignment->page_position) {
@@ -432,6 +656,9 @@ static void rrdeng_store_metric_next_internal(STORAGE_COLLECT_HANDLE *collection
             internal_fatal(handle->page_position > handle->page_entries_max, "DBENGINE: exceeded page max number of points");
             rrdeng_store_metric_flush_current_page(collection_handle);
         }
+        else if(unlikely(!handle->spare_data && handle->page_position + RRDENG_SPARE_PAGE_POINTS >= handle->page_entries_max))
+            // allocate the next page before this one is full
+            handle->spare_data = dbengine_page_alloc(ctx, tier_page_size[ctx->tier]);
     }
 
     if (perfect_page_alignment)
@@ -439,6 +666,9 @@ static void rrdeng_store_metric_next_internal(STORAGE_COLLECT_HANDLE *collection
 
     // update the metric information
     mrg_metric_set_hot_latest_time_s(main_mrg, handle->metric, (time_t) (point_in_time_ut / USEC_PER_SEC));
+
+    if(unlikely(rollover_started_ut))
+        rrdeng_collection_rollover_latency_add(now_monotonic_usec() - rollover_started_ut);
 }
 
 void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
@@ -451,6 +681,12 @@ void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
                               SN_FLAGS flags)
 {
     struct rrdeng_collect_handle *handle = (struct rrdeng_collect_handle *)collection_handle;
+    struct pg_alignment *pa = handle->alignment;
+
+    // a new collection iteration started, make dirty the pages the group filled in the previous one
+    if(unlikely(pa && __atomic_load_n(&pa->pending_pages, __ATOMIC_RELAXED) &&
+                point_in_time_ut > __atomic_load_n(&pa->pending_since_ut, __ATOMIC_RELAXED)))
+        rrdeng_page_alignment_flush_pending_pages(pa);
 
     if(likely(handle->page_end_time_ut + handle->update_every_ut == point_in_time_ut)) {
         // happy path
@@ -510,7 +746,15 @@ int rrdeng_store_metric_finalize(STORAGE_COLLECT_HANDLE *collection_handle) {
     struct rrdeng_collect_handle *handle = (struct rrdeng_collect_handle *)collection_handle;
 
     rrdeng_store_metric_flush_current_page(collection_handle);
+
+    if(handle->alignment)
+        rrdeng_page_alignment_flush_pending_pages(handle->alignment);
+
     rrdeng_page_alignment_release(handle->alignment);
+
+    if(handle->spare_data)
+        dbengine_page_free(handle->spare_data);
+
     mrg_metric_release(main_mrg, handle->metric);
     freez(handle);
 
@@ -883,7 +1127,7 @@ int rrdeng_init(RRDHOST *host, struct rrdengine_instance **ctxp, char *dbfiles_p
     }
     ctx->tier = tier;
     ctx->page_type = tier_page_type[tier];
-    ctx->global_compress_alg = RRD_LZ4;
+    ctx->compression = rrdeng_tier_compression[tier];
     if (page_cache_mb < RRDENG_MIN_PAGE_CACHE_SIZE_MB)
         page_cache_mb = RRDENG_MIN_PAGE_CACHE_SIZE_MB;
     if (disk_space_mb < RRDENG_MIN_DISK_SPACE_MB)
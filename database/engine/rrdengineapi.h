@@ -18,6 +18,7 @@ extern int default_rrdeng_page_fetch_retries;
 extern int default_rrdeng_page_cache_mb;
 extern int db_engine_journal_indexing;
 extern int db_engine_journal_check;
+extern int db_engine_parallel_initialization;
 extern int default_rrdeng_disk_quota_mb;
 extern int default_multidb_disk_quota_mb;
 extern struct rrdengine_instance *multidb_ctx[RRD_STORAGE_TIERS];
@@ -122,12 +123,16 @@ typedef struct rrdengine_size_statistics {
     double average_page_size_bytes;
 } RRDENG_SIZE_STATS;
 
+// log2 histogram of microseconds - bucket N has the samples up to 2^N usecs
+#define RRDENG_COLLECTION_LATENCY_BUCKETS 24
+
 struct rrdeng_cache_efficiency_stats {
     size_t queries;
     size_t queries_planned_with_gaps;
     size_t queries_executed_with_gaps;
     size_t queries_open;
     size_t queries_journal_v2;
+    size_t queries_cancelled_before_prep;
 
     size_t currently_running_queries;
 
@@ -141,6 +146,10 @@ struct rrdeng_cache_efficiency_stats {
     size_t pages_meta_source_open_cache;
     size_t pages_meta_source_journal_v2;
 
+    // journal v2 files in the time-range of the queries
+    size_t journal_v2_files_searched;
+    size_t journal_v2_files_skipped;                    // the metric is not indexed in them
+
     // preloading
     size_t page_next_wait_failed;
     size_t page_next_wait_loaded;
@@ -152,12 +161,14 @@ struct rrdeng_cache_efficiency_stats {
     size_t pages_data_source_main_cache_at_pass4;
     size_t pages_data_source_disk;
     size_t pages_data_source_extent_cache;              // loaded by a cached extent
+    size_t pages_data_source_inflight_extent;           // loaded by another query reading the same extent
 
     // cache hits at different points
     size_t pages_load_ok_loaded_but_cache_hit_while_inserting; // found in cache while inserting it (conflict)
 
     // loading
     size_t pages_load_extent_merged;
+    size_t pages_load_extent_followed;                  // extent page lists that waited for another query reading the same extent
     size_t pages_load_ok_uncompressed;
     size_t pages_load_ok_compressed;
     size_t pages_load_fail_invalid_page_in_extent;
@@ -190,6 +201,12 @@ struct rrdeng_cache_efficiency_stats {
     size_t pages_invalid_size_skipped;
     size_t pages_invalid_update_every_fixed;
     size_t pages_invalid_entries_fixed;
+
+    // collection
+    size_t collection_spare_pages_used;
+    size_t collection_pages_batched;
+    size_t collection_batches;
+    size_t collection_rollover_latency_ut[RRDENG_COLLECTION_LATENCY_BUCKETS];
 };
 
 struct rrdeng_buffer_sizes {
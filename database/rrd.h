@@ -359,6 +359,8 @@ struct rrddim {
     collected_number collected_value;               // the current value, as collected - resets to 0 after being used
     collected_number last_collected_value;          // the last value that was collected, after being processed
 
+    struct rrddim_exporting_tap *exporting_tap;     // the values stored since each exporting instance last read them
+
 #ifdef NETDATA_LOG_COLLECTION_ERRORS
     usec_t rrddim_store_metric_last_ut;             // the timestamp we last called rrddim_store_metric()
     size_t rrddim_store_metric_count;               // the rrddim_store_metric() counter
@@ -378,6 +380,36 @@ struct rrddim {
 #define rrddim_id(rd) string2str((rd)->id)
 #define rrddim_name(rd) string2str((rd) ->name)
 
+// ----------------------------------------------------------------------------
+// exporting tap - when enabled, the exporting engine reads the values stored
+// since its last run from here, instead of querying the database
+
+struct rrddim_exporting_tap_slot {
+    NETDATA_DOUBLE sum;                             // the sum of the values stored since the last read
+    size_t count;                                   // the number of values stored since the last read
+    time_t last_time_s;                             // the timestamp of the last value stored
+};
+
+typedef struct rrddim_exporting_tap {
+    SPINLOCK spinlock;
+    size_t slots;                                   // one slot per exporting connector instance
+    struct rrddim_exporting_tap_slot slot[];
+} RRDDIM_EXPORTING_TAP;
+
+static inline void rrddim_exporting_tap_store(RRDDIM *rd, NETDATA_DOUBLE n, time_t now_s) {
+    RRDDIM_EXPORTING_TAP *tap = __atomic_load_n(&rd->exporting_tap, __ATOMIC_ACQUIRE);
+    if(likely(!tap) || unlikely(!netdata_double_isnumber(n)))
+        return;
+
+    netdata_spinlock_lock(&tap->spinlock);
+    for(size_t i = 0; i < tap->slots ; i++) {
+        tap->slot[i].sum += n;
+        tap->slot[i].count++;
+        tap->slot[i].last_time_s = now_s;
+    }
+    netdata_spinlock_unlock(&tap->spinlock);
+}
+
 // returns the RRDDIM cache filename, or NULL if it does not exist
 const char *rrddim_cache_filename(RRDDIM *rd);
 
@@ -556,6 +588,7 @@ typedef enum __attribute__ ((__packed__)) rrdset_flags {
                                                               // least rrdset_free_obsolete_time seconds ago.
     RRDSET_FLAG_ARCHIVED                         = (1 << 15),
     RRDSET_FLAG_METADATA_UPDATE                  = (1 << 16), // Mark that metadata needs to be stored
+    RRDSET_FLAG_METADATA_QUEUED                  = (1 << 17), // the chart is in the host metadata queue
     RRDSET_FLAG_ANOMALY_DETECTION                = (1 << 18), // flag to identify anomaly detection charts.
     RRDSET_FLAG_INDEXED_ID                       = (1 << 19), // the rrdset is indexed by its id
     RRDSET_FLAG_INDEXED_NAME                     = (1 << 20), // the rrdset is indexed by its name
@@ -1058,6 +1091,8 @@ struct rrdhost {
     DICTIONARY *rrdset_root_index;                  // the host's charts index (by id)
     DICTIONARY *rrdset_root_index_name;             // the host's charts index (by name)
 
+    struct rrdset_metadata_queued *rrdset_metadata_queue; // the charts with metadata pending to be stored (lock-free)
+
     DICTIONARY *rrdfamily_root_index;               // the host's chart families index
     DICTIONARY *rrdvars;                            // the host's chart variables index
                                                     // this includes custom host variables
@@ -1077,6 +1112,31 @@ struct rrdhost {
 };
 extern RRDHOST *localhost;
 
+// ----------------------------------------------------------------------------
+// the queue of charts with metadata pending to be stored in the database
+// charts are referenced by id, so that they can be deleted while queued
+
+struct rrdset_metadata_queued {
+    STRING *id;
+    struct rrdset_metadata_queued *next;
+};
+
+// push a list of queued charts (linked from first to last) to the metadata queue of a host
+// producers push concurrently, while the single consumer detaches the whole queue at once
+static inline void rrdhost_metadata_queue_push(RRDHOST *host, struct rrdset_metadata_queued *first, struct rrdset_metadata_queued *last) {
+    struct rrdset_metadata_queued *head = __atomic_load_n(&host->rrdset_metadata_queue, __ATOMIC_RELAXED);
+
+    do {
+        last->next = head;
+    } while(!__atomic_compare_exchange_n(&host->rrdset_metadata_queue, &head, first, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static inline struct rrdset_metadata_queued *rrdhost_metadata_queue_detach(RRDHOST *host) {
+    return __atomic_exchange_n(&host->rrdset_metadata_queue, NULL, __ATOMIC_ACQUIRE);
+}
+
+void rrdhost_metadata_queue_free(RRDHOST *host);
+
 #define rrdhost_hostname(host) string2str((host)->hostname)
 #define rrdhost_registry_hostname(host) string2str((host)->registry_hostname)
 #define rrdhost_os(host) string2str((host)->os)
@@ -1210,6 +1270,11 @@ time_t rrdset_set_update_every_s(RRDSET *st, time_t update_every_s);
 
 RRDSET *rrdset_find(RRDHOST *host, const char *id);
 #define rrdset_find_localhost(id) rrdset_find(localhost, id)
+RRDSET_ACQUIRED *rrdset_find_and_acquire(RRDHOST *host, const char *id);
+RRDSET *rrdset_acquired_to_rrdset(RRDSET_ACQUIRED *rsa);
+void rrdset_acquired_release(RRDSET_ACQUIRED *rsa);
+void rrdset_metadata_updated(RRDSET *st);
+void rrdset_metadata_queue(RRDSET *st);
 /* This will not return charts that are archived */
 static inline RRDSET *rrdset_find_active_localhost(const char *id)
 {
@@ -1294,6 +1359,7 @@ RRDDIM_ACQUIRED *rrddim_find_and_acquire(RRDSET *st, const char *id);
 RRDDIM *rrddim_acquired_to_rrddim(RRDDIM_ACQUIRED *rda);
 void rrddim_acquired_release(RRDDIM_ACQUIRED *rda);
 RRDDIM *rrddim_find_active(RRDSET *st, const char *id);
+void rrddim_metadata_updated(RRDDIM *rd);
 
 int rrddim_hide(RRDSET *st, const char *id);
 int rrddim_unhide(RRDSET *st, const char *id);
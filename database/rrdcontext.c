@@ -2253,6 +2253,81 @@ DICTIONARY *rrdcontext_all_metrics_to_dict(RRDHOST *host, SIMPLE_PATTERN *contex
     return dict;
 }
 
+// Summarizes the points of a metric in a time-frame, reading each part of it
+// from the highest tier that has it, so that only the most recent part, not
+// yet aggregated by the higher tiers, is read from the lower ones. The tiers
+// keep the min and the max of the points they aggregate, so the min and the
+// max of the summary are exactly the ones of all the collected values.
+// Returns false when there is no data, or there are gaps, in the time-frame.
+bool rrdmetric_acquired_storage_summary(RRDHOST *host, RRDMETRIC_ACQUIRED *rma, time_t after, time_t before,
+                                        STORAGE_PRIORITY priority, STORAGE_POINT *summary, size_t *points_per_tier) {
+    RRDMETRIC *rm = rrdmetric_acquired_value(rma);
+
+    storage_point_unset(*summary);
+    bool gaps = false;
+
+    // the time-frame up to this time has been summarized
+    time_t summarized_s = after;
+
+    for(int tier = (int)storage_tiers - 1; tier >= 0 && summarized_s < before && !gaps ; tier--) {
+        STORAGE_ENGINE *eng = host->db[tier].eng;
+        STORAGE_METRIC_HANDLE *db_metric_handle;
+
+        if(rm->rrddim && rm->rrddim->tiers[tier] && rm->rrddim->tiers[tier]->db_metric_handle)
+            db_metric_handle = eng->api.metric_dup(rm->rrddim->tiers[tier]->db_metric_handle);
+        else
+            db_metric_handle = eng->api.metric_get(host->db[tier].instance, &rm->uuid);
+
+        if(!db_metric_handle)
+            continue;
+
+        time_t first_time_s = eng->api.query_ops.oldest_time_s(db_metric_handle);
+        time_t last_time_s = eng->api.query_ops.latest_time_s(db_metric_handle);
+
+        if(first_time_s && last_time_s && last_time_s > summarized_s) {
+            if(first_time_s > summarized_s + (time_t)(host->db[tier].tier_grouping * host->rrd_update_every)) {
+                // the lower tiers have a shorter retention than this one
+                gaps = true;
+            }
+            else {
+                struct storage_engine_query_handle handle;
+                eng->api.query_ops.init(db_metric_handle, &handle, summarized_s, before, priority);
+
+                while(!eng->api.query_ops.is_finished(&handle)) {
+                    STORAGE_POINT sp = eng->api.query_ops.next_metric(&handle);
+                    points_per_tier[tier]++;
+
+                    if(storage_point_is_unset(sp) || storage_point_is_empty(sp)) {
+                        gaps = true;
+                        break;
+                    }
+
+                    if(storage_point_is_unset(*summary)) {
+                        *summary = sp;
+                    }
+                    else {
+                        if(sp.min < summary->min) summary->min = sp.min;
+                        if(sp.max > summary->max) summary->max = sp.max;
+                        summary->sum += sp.sum;
+                        summary->count += sp.count;
+                        summary->anomaly_count += sp.anomaly_count;
+                        summary->end_time_s = MAX(summary->end_time_s, sp.end_time_s);
+                    }
+
+                    if(sp.end_time_s > summarized_s)
+                        summarized_s = sp.end_time_s;
+                }
+
+                eng->api.query_ops.finalize(&handle);
+            }
+        }
+
+        eng->api.metric_release(db_metric_handle);
+    }
+
+    return !gaps && !storage_point_is_unset(*summary);
+}
+
 // ----------------------------------------------------------------------------
 // query API
 
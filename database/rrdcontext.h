@@ -114,6 +114,8 @@ struct metric_entry {
 };
 
 DICTIONARY *rrdcontext_all_metrics_to_dict(RRDHOST *host, SIMPLE_PATTERN *contexts);
+bool rrdmetric_acquired_storage_summary(RRDHOST *host, RRDMETRIC_ACQUIRED *rma, time_t after, time_t before,
+                                        STORAGE_PRIORITY priority, STORAGE_POINT *summary, size_t *points_per_tier);
 
 // ----------------------------------------------------------------------------
 // public API for queries
@@ -140,10 +142,12 @@ typedef struct query_metric {
         time_t db_last_time_s;          // the latest timestamp available for this tier
         time_t db_update_every_s;       // latest update every for this tier
         long weight;
+        bool aligned;                   // the points of this tier fit exactly in the groups of the query
     } tiers[RRD_STORAGE_TIERS];
 
     struct {
         size_t used;
+        bool aggregated;                // the planner selected an aligned tier, to read its pre-aggregated points
         QUERY_PLAN_ENTRY array[QUERY_PLANS_MAX];
     } plan;
 
@@ -169,6 +173,9 @@ typedef struct query_metric {
 
 #define MAX_QUERY_TARGET_ID_LENGTH 255
 
+// called periodically while a query runs, returns true when the query should stop
+typedef bool (*qt_interrupt_callback_t)(void *data);
+
 typedef struct query_target_request {
     RRDHOST *host;                      // the host to be queried (can be NULL, hosts will be used)
     RRDCONTEXT_ACQUIRED *rca;           // the context to be queried (can be NULL)
@@ -184,7 +191,7 @@ typedef struct query_target_request {
     time_t after;                       // the requested timeframe
     time_t before;                      // the requested timeframe
     size_t points;                      // the requested number of points
-    time_t timeout;                     // the timeout of the query in seconds
+    time_t timeout;                     // the timeout of the query in milliseconds
     uint32_t format;                    // DATASOURCE_FORMAT
     RRDR_OPTIONS options;
     RRDR_GROUPING group_method;
@@ -193,6 +200,8 @@ typedef struct query_target_request {
     size_t tier;
     QUERY_SOURCE query_source;
     STORAGE_PRIORITY priority;
+    qt_interrupt_callback_t interrupt_callback; // e.g. when the client that made the query went away
+    void *interrupt_callback_data;
 } QUERY_TARGET_REQUEST;
 
 typedef struct query_target {
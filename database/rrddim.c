@@ -240,6 +240,9 @@ static void rrddim_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, v
             freez(rd->db);
     }
 
+    freez(rd->exporting_tap);
+    rd->exporting_tap = NULL;
+
     string_freez(rd->id);
     string_freez(rd->name);
 }
@@ -283,10 +286,8 @@ static void rrddim_react_callback(const DICTIONARY_ITEM *item __maybe_unused, vo
     RRDDIM *rd = rrddim;
     RRDSET *st = ctr->st;
 
-    if(ctr->react_action & (RRDDIM_REACT_UPDATED | RRDDIM_REACT_NEW)) {
-        rrddim_flag_set(rd, RRDDIM_FLAG_METADATA_UPDATE);
-        rrdhost_flag_set(rd->rrdset->rrdhost, RRDHOST_FLAG_METADATA_UPDATE);
-    }
+    if(ctr->react_action & (RRDDIM_REACT_UPDATED | RRDDIM_REACT_NEW))
+        rrddim_metadata_updated(rd);
 
     if(ctr->react_action == RRDDIM_REACT_UPDATED) {
         // the chart needs to be updated to the parent
@@ -347,6 +348,12 @@ void rrddim_acquired_release(RRDDIM_ACQUIRED *rda) {
     dictionary_acquired_item_release(rd->rrdset->rrddim_root_index, (const DICTIONARY_ITEM *)rda);
 }
 
+// mark the metadata of the dimension for storing and queue its chart
+void rrddim_metadata_updated(RRDDIM *rd) {
+    rrddim_flag_set(rd, RRDDIM_FLAG_METADATA_UPDATE);
+    rrdset_metadata_queue(rd->rrdset);
+}
+
 // This will not return dimensions that are archived
 RRDDIM *rrddim_find_active(RRDSET *st, const char *id) {
     RRDDIM *rd = rrddim_find(st, id);
@@ -504,8 +511,8 @@ int rrddim_hide(RRDSET *st, const char *id) {
         return 1;
     }
     if (!rrddim_flag_check(rd, RRDDIM_FLAG_META_HIDDEN)) {
-        rrddim_flag_set(rd, RRDDIM_FLAG_META_HIDDEN | RRDDIM_FLAG_METADATA_UPDATE);
-        rrdhost_flag_set(rd->rrdset->rrdhost, RRDHOST_FLAG_METADATA_UPDATE);
+        rrddim_flag_set(rd, RRDDIM_FLAG_META_HIDDEN);
+        rrddim_metadata_updated(rd);
     }
 
     rrddim_option_set(rd, RRDDIM_OPTION_HIDDEN);
@@ -524,8 +531,7 @@ int rrddim_unhide(RRDSET *st, const char *id) {
     }
     if (rrddim_flag_check(rd, RRDDIM_FLAG_META_HIDDEN)) {
         rrddim_flag_clear(rd, RRDDIM_FLAG_META_HIDDEN);
-        rrddim_flag_set(rd, RRDDIM_FLAG_METADATA_UPDATE);
-        rrdhost_flag_set(rd->rrdset->rrdhost, RRDHOST_FLAG_METADATA_UPDATE);
+        rrddim_metadata_updated(rd);
     }
 
     rrddim_option_clear(rd, RRDDIM_OPTION_HIDDEN);
@@ -52,7 +52,8 @@ static DICTIONARY *rrdhost_root_index_hostname = NULL;
 static inline void rrdhost_init() {
     if(unlikely(!rrdhost_root_index)) {
         rrdhost_root_index = dictionary_create(
-            DICT_OPTION_NAME_LINK_DONT_CLONE | DICT_OPTION_VALUE_LINK_DONT_CLONE | DICT_OPTION_DONT_OVERWRITE_VALUE);
+            DICT_OPTION_NAME_LINK_DONT_CLONE | DICT_OPTION_VALUE_LINK_DONT_CLONE | DICT_OPTION_DONT_OVERWRITE_VALUE |
+            DICT_OPTION_INDEX_PARTITIONED);
     }
 
     if(unlikely(!rrdhost_root_index_hostname)) {
@@ -772,9 +773,26 @@ inline int rrdhost_should_be_removed(RRDHOST *host, RRDHOST *protected_host, tim
 // ----------------------------------------------------------------------------
 // RRDHOST global / startup initialization
 
+#ifdef ENABLE_DBENGINE
+struct dbengine_initialization {
+    netdata_thread_t thread;
+    char path[FILENAME_MAX + 1];
+    size_t tier;
+    int page_cache_mb;
+    int disk_space_mb;
+    int ret;
+};
+
+static void *dbengine_tier_init(void *ptr) {
+    struct dbengine_initialization *dbi = ptr;
+    dbi->ret = rrdeng_init(NULL, NULL, dbi->path, dbi->page_cache_mb, dbi->disk_space_mb, dbi->tier);
+    return ptr;
+}
+#endif
+
 void dbengine_init(char *hostname) {
 #ifdef ENABLE_DBENGINE
-    unsigned read_num = (unsigned)config_get_number(CONFIG_SECTION_DB, "dbengine pages per extent", MAX_PAGES_PER_EXTENT);
+    unsigned read_num = (unsigned)config_get_number(CONFIG_SECTION_DB, "dbengine pages per extent", RRDENG_DEFAULT_PAGES_PER_EXTENT);
     if (read_num > 0 && read_num <= MAX_PAGES_PER_EXTENT)
         rrdeng_pages_per_extent = read_num;
     else {
@@ -782,6 +800,14 @@ void dbengine_init(char *hostname) {
         config_set_number(CONFIG_SECTION_DB, "dbengine pages per extent", rrdeng_pages_per_extent);
     }
 
+    read_num = (unsigned)config_get_number(CONFIG_SECTION_DB, "dbengine extent target size KB", RRDENG_EXTENT_TARGET_SIZE / 1024);
+    if (read_num >= RRDENG_BLOCK_SIZE / 1024 && read_num <= MAX_EXTENT_UNCOMPRESSED_SIZE / 1024)
+        rrdeng_extent_target_size = read_num * 1024;
+    else {
+        error("Invalid dbengine extent target size %u KB given. Using %u KB.", read_num, rrdeng_extent_target_size / 1024);
+        config_set_number(CONFIG_SECTION_DB, "dbengine extent target size KB", rrdeng_extent_target_size / 1024);
+    }
+
     storage_tiers = config_get_number(CONFIG_SECTION_DB, "storage tiers", storage_tiers);
     if(storage_tiers < 1) {
         error("At least 1 storage tier is required. Assuming 1.");
@@ -808,11 +834,15 @@ void dbengine_init(char *hostname) {
         config_set_number(CONFIG_SECTION_DB, "dbengine page fetch retries", default_rrdeng_page_fetch_retries);
     }
 
+    struct dbengine_initialization tiers_init[RRD_STORAGE_TIERS] = {};
+
     size_t created_tiers = 0;
-    char dbenginepath[FILENAME_MAX + 1];
+    size_t configured_tiers = 0;
     char dbengineconfig[200 + 1];
     int divisor = 1;
     for(size_t tier = 0; tier < storage_tiers ;tier++) {
+        char *dbenginepath = tiers_init[tier].path;
+
         if(tier == 0)
             snprintfz(dbenginepath, FILENAME_MAX, "%s/dbengine", netdata_configured_cache_dir);
         else
@@ -859,6 +889,23 @@ void dbengine_init(char *hostname) {
             }
         }
 
+        RRDENG_COMPRESSION *compression = &rrdeng_tier_compression[tier];
+        if(tier == 0)
+            snprintfz(dbengineconfig, 200, "dbengine compression");
+        else
+            snprintfz(dbengineconfig, 200, "dbengine tier %zu compression", tier);
+        const char *method = config_get(CONFIG_SECTION_DB, dbengineconfig, rrdeng_compression_method_name(compression->method));
+
+        char dbenginelevelconfig[200 + 1];
+        snprintfz(dbenginelevelconfig, 200, "%s level", dbengineconfig);
+        int level = (int)config_get_number(CONFIG_SECTION_DB, dbenginelevelconfig, 0);
+
+        if(!rrdeng_compression_set(compression, method, level)) {
+            error("DBENGINE on '%s': unknown or unsupported compression '%s' for tier %zu, assuming '%s'",
+                  hostname, method, tier, rrdeng_compression_method_name(compression->method));
+            config_set(CONFIG_SECTION_DB, dbengineconfig, rrdeng_compression_method_name(compression->method));
+        }
+
         storage_tiers_grouping_iterations[tier] = grouping_iterations;
         storage_tiers_backfill[tier] = backfill;
 
@@ -869,16 +916,49 @@ void dbengine_init(char *hostname) {
         }
 
         internal_error(true, "DBENGINE tier %zu grouping iterations is set to %zu", tier, storage_tiers_grouping_iterations[tier]);
-        ret = rrdeng_init(NULL, NULL, dbenginepath, page_cache_mb, disk_space_mb, tier);
-        if(ret != 0) {
+
+        tiers_init[tier].tier = tier;
+        tiers_init[tier].page_cache_mb = page_cache_mb;
+        tiers_init[tier].disk_space_mb = disk_space_mb;
+        configured_tiers++;
+    }
+
+    // load the tiers in parallel - each tier loads its own journal files
+    bool parallel_initialization = db_engine_parallel_initialization && configured_tiers > 1;
+    if(parallel_initialization) {
+        // make sure the machine guid is loaded before the threads need it
+        (void)registry_get_this_machine_guid();
+
+        for(size_t tier = 0; tier < configured_tiers ;tier++) {
+            char tag[NETDATA_THREAD_TAG_MAX + 1];
+            snprintfz(tag, NETDATA_THREAD_TAG_MAX, "DBENGINIT[%zu]", tier);
+            netdata_thread_create(&tiers_init[tier].thread, tag, NETDATA_THREAD_OPTION_JOINABLE,
+                                  dbengine_tier_init, &tiers_init[tier]);
+        }
+
+        for(size_t tier = 0; tier < configured_tiers ;tier++)
+            netdata_thread_join(tiers_init[tier].thread, NULL);
+    }
+
+    for(size_t tier = 0; tier < configured_tiers ;tier++) {
+        if(!parallel_initialization)
+            dbengine_tier_init(&tiers_init[tier]);
+
+        if(tiers_init[tier].ret != 0) {
             error("DBENGINE on '%s': Failed to initialize multi-host database tier %zu on path '%s'",
-                  hostname, tier, dbenginepath);
+                  hostname, tier, tiers_init[tier].path);
             break;
         }
         else
             created_tiers++;
     }
 
+    // the tiers above a failed one are not used
+    for(size_t tier = created_tiers + 1; parallel_initialization && tier < configured_tiers ;tier++) {
+        if(tiers_init[tier].ret == 0)
+            rrdeng_exit(multidb_ctx[tier]);
+    }
+
     if(created_tiers && created_tiers < storage_tiers) {
         error("DBENGINE on '%s': Managed to create %zu tiers instead of %zu. Continuing with %zu available.",
               hostname, created_tiers, storage_tiers, created_tiers);
@@ -1114,6 +1194,7 @@ void rrdhost_free___while_having_rrd_wrlock(RRDHOST *host, bool force) {
 
     // delete all the RRDSETs of the host
     rrdset_index_destroy(host);
+    rrdhost_metadata_queue_free(host);
     rrdcalc_rrdhost_index_destroy(host);
     rrdcalctemplate_index_destroy(host);
 
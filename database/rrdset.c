@@ -392,8 +392,7 @@ static void rrdset_react_callback(const DICTIONARY_ITEM *item __maybe_unused, vo
 #endif
             }
         }
-        rrdset_flag_set(st, RRDSET_FLAG_METADATA_UPDATE);
-        rrdhost_flag_set(st->rrdhost, RRDHOST_FLAG_METADATA_UPDATE);
+        rrdset_metadata_updated(st);
     }
 
     rrdcontext_updated_rrdset(st);
@@ -401,7 +400,7 @@ static void rrdset_react_callback(const DICTIONARY_ITEM *item __maybe_unused, vo
 
 void rrdset_index_init(RRDHOST *host) {
     if(!host->rrdset_root_index) {
-        host->rrdset_root_index = dictionary_create(DICT_OPTION_DONT_OVERWRITE_VALUE);
+        host->rrdset_root_index = dictionary_create(DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_INDEX_PARTITIONED);
 
         dictionary_register_insert_callback(host->rrdset_root_index, rrdset_insert_callback, NULL);
         dictionary_register_conflict_callback(host->rrdset_root_index, rrdset_conflict_callback, NULL);
@@ -457,6 +456,62 @@ inline RRDSET *rrdset_find(RRDHOST *host, const char *id) {
     return(st);
 }
 
+RRDSET_ACQUIRED *rrdset_find_and_acquire(RRDHOST *host, const char *id) {
+    debug(D_RRD_CALLS, "rrdset_find_and_acquire() for host %s, chart %s", rrdhost_hostname(host), id);
+
+    return (RRDSET_ACQUIRED *)dictionary_get_and_acquire_item(host->rrdset_root_index, id);
+}
+
+RRDSET *rrdset_acquired_to_rrdset(RRDSET_ACQUIRED *rsa) {
+    if(unlikely(!rsa))
+        return NULL;
+
+    return (RRDSET *) dictionary_acquired_item_value((const DICTIONARY_ITEM *)rsa);
+}
+
+void rrdset_acquired_release(RRDSET_ACQUIRED *rsa) {
+    if(unlikely(!rsa))
+        return;
+
+    RRDSET *st = rrdset_acquired_to_rrdset(rsa);
+    dictionary_acquired_item_release(st->rrdhost->rrdset_root_index, (const DICTIONARY_ITEM *)rsa);
+}
+
+// ----------------------------------------------------------------------------
+// RRDSET - metadata queue
+
+// mark the metadata of the chart for storing and queue the chart, unless it is already queued
+// the metadata sync thread clears RRDSET_FLAG_METADATA_QUEUED before it stores the chart
+void rrdset_metadata_updated(RRDSET *st) {
+    rrdset_flag_set(st, RRDSET_FLAG_METADATA_UPDATE);
+    rrdset_metadata_queue(st);
+}
+
+// queue the chart, so that the metadata sync thread checks it and its dimensions
+void rrdset_metadata_queue(RRDSET *st) {
+    RRDHOST *host = st->rrdhost;
+
+    if(__atomic_fetch_or(&st->flags, RRDSET_FLAG_METADATA_QUEUED, __ATOMIC_SEQ_CST) & RRDSET_FLAG_METADATA_QUEUED)
+        return;
+
+    struct rrdset_metadata_queued *q = mallocz(sizeof(*q));
+    q->id = string_dup(st->id);
+    rrdhost_metadata_queue_push(host, q, q);
+
+    rrdhost_flag_set(host, RRDHOST_FLAG_METADATA_UPDATE);
+}
+
+void rrdhost_metadata_queue_free(RRDHOST *host) {
+    struct rrdset_metadata_queued *q = rrdhost_metadata_queue_detach(host);
+
+    while(q) {
+        struct rrdset_metadata_queued *next = q->next;
+        string_freez(q->id);
+        freez(q);
+        q = next;
+    }
+}
+
 inline RRDSET *rrdset_find_bytype(RRDHOST *host, const char *type, const char *id) {
     debug(D_RRD_CALLS, "rrdset_find_bytype() for chart '%s.%s' in host '%s'", type, id, rrdhost_hostname(host));
 
@@ -1198,6 +1253,8 @@ void rrddim_store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n,
 
     time_t now_s = (time_t)(point_end_time_ut / USEC_PER_SEC);
 
+    rrddim_exporting_tap_store(rd, n, now_s);
+
     STORAGE_POINT sp = {
         .start_time_s = now_s - rd->update_every,
         .end_time_s = now_s,
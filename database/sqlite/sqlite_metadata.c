@@ -35,6 +35,9 @@
 #define SQL_STORE_DIMENSION "INSERT OR REPLACE INTO dimension (dim_id, chart_id, id, name, multiplier, divisor , algorithm, options) " \
         "VALUES (@dim_id, @chart_id, @id, @name, @multiplier, @divisor, @algorithm, @options);"
 
+#define SQL_STORE_DIMENSION_BATCH "INSERT OR REPLACE INTO dimension (dim_id, chart_id, id, name, multiplier, divisor , algorithm, options) VALUES "
+#define SQL_STORE_DIMENSION_BATCH_ROW "(?, ?, ?, ?, ?, ?, ?, ?)"
+
 #define SELECT_DIMENSION_LIST "SELECT dim_id, rowid FROM dimension WHERE rowid > @row_id"
 
 #define STORE_HOST_INFO "INSERT OR REPLACE INTO host_info (host_id, system_key, system_value, date_created) VALUES "
@@ -56,6 +59,7 @@
 
 #define MAX_METADATA_CLEANUP (500)                  // Maximum metadata write operations (e.g  deletes before retrying)
 #define METADATA_MAX_BATCH_SIZE (512)               // Maximum commands to execute before running the event loop
+#define METADATA_DIMENSION_BATCH_SIZE (64)          // Dimensions stored with a single statement (8 parameters each)
 
 enum metadata_opcode {
     METADATA_DATABASE_NOOP = 0,
@@ -610,6 +614,153 @@ static int sql_store_dimension(
     return 1;
 }
 
+/*
+ * Store dimensions in batches
+ *
+ * Full batches are stored with a single multi-row statement, the remaining dimensions one by one.
+ * The caller should run it inside a transaction.
+ */
+
+struct dimension_batch {
+    size_t used;
+    struct {
+        uuid_t dim_uuid;
+        uuid_t chart_uuid;
+        STRING *id;
+        STRING *name;
+        collected_number multiplier;
+        collected_number divisor;
+        int algorithm;
+        bool hidden;
+    } rows[METADATA_DIMENSION_BATCH_SIZE];
+};
+
+static int sql_store_dimension_full_batch(struct dimension_batch *batch)
+{
+    static __thread sqlite3_stmt *res = NULL;
+    int rc, param = 0;
+
+    if (unlikely(!res)) {
+        BUFFER *sql = buffer_create(sizeof(SQL_STORE_DIMENSION_BATCH) + METADATA_DIMENSION_BATCH_SIZE * sizeof(SQL_STORE_DIMENSION_BATCH_ROW));
+        buffer_strcat(sql, SQL_STORE_DIMENSION_BATCH);
+        for (size_t i = 0; i < METADATA_DIMENSION_BATCH_SIZE; i++) {
+            if (i)
+                buffer_strcat(sql, ",");
+            buffer_strcat(sql, SQL_STORE_DIMENSION_BATCH_ROW);
+        }
+        buffer_strcat(sql, ";");
+
+        rc = prepare_statement(db_meta, buffer_tostring(sql), &res);
+        buffer_free(sql);
+        if (unlikely(rc != SQLITE_OK)) {
+            error_report("Failed to prepare statement to store a batch of dimensions, rc = %d", rc);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < METADATA_DIMENSION_BATCH_SIZE; i++) {
+        rc = sqlite3_bind_blob(res, ++param, &batch->rows[i].dim_uuid, sizeof(uuid_t), SQLITE_STATIC);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+
+        rc = sqlite3_bind_blob(res, ++param, &batch->rows[i].chart_uuid, sizeof(uuid_t), SQLITE_STATIC);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+
+        rc = sqlite3_bind_text(res, ++param, string2str(batch->rows[i].id), -1, SQLITE_STATIC);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+
+        rc = sqlite3_bind_text(res, ++param, string2str(batch->rows[i].name), -1, SQLITE_STATIC);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+
+        rc = sqlite3_bind_int(res, ++param, (int) batch->rows[i].multiplier);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+
+        rc = sqlite3_bind_int(res, ++param, (int) batch->rows[i].divisor);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+
+        rc = sqlite3_bind_int(res, ++param, batch->rows[i].algorithm);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+
+        if (batch->rows[i].hidden)
+            rc = sqlite3_bind_text(res, ++param, "hidden", -1, SQLITE_STATIC);
+        else
+            rc = sqlite3_bind_null(res, ++param);
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+    }
+
+    rc = execute_insert(res);
+    if (unlikely(rc != SQLITE_DONE))
+        error_report("Failed to store a batch of dimensions, rc = %d", rc);
+
+    rc = sqlite3_reset(res);
+    if (unlikely(rc != SQLITE_OK))
+        error_report("Failed to reset statement in store a batch of dimensions, rc = %d", rc);
+    return 0;
+
+bind_fail:
+    error_report("Failed to bind parameter %d to store a batch of dimensions, rc = %d", param, rc);
+    rc = sqlite3_reset(res);
+    if (unlikely(rc != SQLITE_OK))
+        error_report("Failed to reset statement in store a batch of dimensions, rc = %d", rc);
+    return 1;
+}
+
+static void dimension_batch_flush(struct dimension_batch *batch)
+{
+    if (likely(batch->used == METADATA_DIMENSION_BATCH_SIZE && db_meta)) {
+        if (unlikely(sql_store_dimension_full_batch(batch)))
+            error_report("METADATA: Failed to store a batch of %zu dimensions", batch->used);
+    }
+    else {
+        for (size_t i = 0; i < batch->used; i++) {
+            int rc = sql_store_dimension(
+                &batch->rows[i].dim_uuid,
+                &batch->rows[i].chart_uuid,
+                string2str(batch->rows[i].id),
+                string2str(batch->rows[i].name),
+                batch->rows[i].multiplier,
+                batch->rows[i].divisor,
+                batch->rows[i].algorithm,
+                batch->rows[i].hidden);
+
+            if (unlikely(rc))
+                error_report("METADATA: Failed to store dimension %s", string2str(batch->rows[i].id));
+        }
+    }
+
+    for (size_t i = 0; i < batch->used; i++) {
+        string_freez(batch->rows[i].id);
+        string_freez(batch->rows[i].name);
+    }
+    batch->used = 0;
+}
+
+static void dimension_batch_add(
+    struct dimension_batch *batch, uuid_t *dim_uuid, uuid_t *chart_uuid, STRING *id, STRING *name,
+    collected_number multiplier, collected_number divisor, int algorithm, bool hidden)
+{
+    size_t i = batch->used++;
+
+    uuid_copy(batch->rows[i].dim_uuid, *dim_uuid);
+    uuid_copy(batch->rows[i].chart_uuid, *chart_uuid);
+    batch->rows[i].id = string_dup(id);
+    batch->rows[i].name = string_dup(name);
+    batch->rows[i].multiplier = multiplier;
+    batch->rows[i].divisor = divisor;
+    batch->rows[i].algorithm = algorithm;
+    batch->rows[i].hidden = hidden;
+
+    if (batch->used == METADATA_DIMENSION_BATCH_SIZE)
+        dimension_batch_flush(batch);
+}
+
 static bool dimension_can_be_deleted(uuid_t *dim_uuid __maybe_unused)
 {
 #ifdef ENABLE_DBENGINE
@@ -869,22 +1020,52 @@ static void after_metadata_hosts(uv_work_t *req, int status __maybe_unused)
     freez(data);
 }
 
+// Store the charts queued for a host and their dimensions, inside a transaction
 static bool metadata_scan_host(RRDHOST *host, uint32_t max_count) {
-    RRDSET *st;
     int rc;
 
+    struct rrdset_metadata_queued *queued = rrdhost_metadata_queue_detach(host);
+    if (!queued)
+        return false;
+
     bool more_to_do = false;
     uint32_t scan_count = 1;
     BUFFER *work_buffer = buffer_create(1024);
+    struct dimension_batch *batch = mallocz(sizeof(*batch));
+    batch->used = 0;
+
+    if (likely(db_meta))
+        db_execute("BEGIN TRANSACTION;");
 
-    rrdset_foreach_reentrant(st, host) {
+    while (queued) {
         if (scan_count == max_count) {
+            // put the rest back to the queue, for the next run
+            struct rrdset_metadata_queued *last = queued;
+            while (last->next)
+                last = last->next;
+            rrdhost_metadata_queue_push(host, queued, last);
             more_to_do = true;
             break;
         }
+
+        struct rrdset_metadata_queued *next = queued->next;
+        RRDSET_ACQUIRED *rsa = rrdset_find_and_acquire(host, string2str(queued->id));
+        string_freez(queued->id);
+        freez(queued);
+        queued = next;
+
+        // the chart has been deleted since it was queued
+        if (unlikely(!rsa))
+            continue;
+
+        RRDSET *st = rrdset_acquired_to_rrdset(rsa);
+
+        // updates from now on will queue the chart again
+        rrdset_flag_clear(st, RRDSET_FLAG_METADATA_QUEUED);
+        scan_count++;
+
         if(rrdset_flag_check(st, RRDSET_FLAG_METADATA_UPDATE)) {
             rrdset_flag_clear(st, RRDSET_FLAG_METADATA_UPDATE);
-            scan_count++;
 
             check_and_update_chart_labels(st, work_buffer);
 
@@ -919,24 +1100,29 @@ static bool metadata_scan_host(RRDHOST *host, uint32_t max_count) {
                 else
                     rrddim_flag_clear(rd, RRDDIM_FLAG_META_HIDDEN);
 
-                rc = sql_store_dimension(
+                dimension_batch_add(
+                    batch,
                     &rd->metric_uuid,
                     &rd->rrdset->chart_uuid,
-                    string2str(rd->id),
-                    string2str(rd->name),
+                    rd->id,
+                    rd->name,
                     rd->multiplier,
                     rd->divisor,
                     rd->algorithm,
                     rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN));
-
-                if (unlikely(rc))
-                    error_report("METADATA: Failed to store dimension %s", string2str(rd->id));
             }
         }
         rrddim_foreach_done(rd);
+
+        rrdset_acquired_release(rsa);
     }
-    rrdset_foreach_done(st);
 
+    dimension_batch_flush(batch);
+
+    if (likely(db_meta))
+        db_execute("COMMIT TRANSACTION;");
+
+    freez(batch);
     buffer_free(work_buffer);
     return more_to_do;
 }
@@ -956,6 +1142,9 @@ static void start_metadata_hosts(uv_work_t *req __maybe_unused)
     dfe_start_reentrant(rrdhost_root_index, host) {
         if (rrdhost_flag_check(host, RRDHOST_FLAG_ARCHIVED) || !rrdhost_flag_check(host, RRDHOST_FLAG_METADATA_UPDATE))
             continue;
+
+        // anything updated from now on will set the flag again
+        rrdhost_flag_clear(host, RRDHOST_FLAG_METADATA_UPDATE);
         internal_error(true, "METADATA: Scanning host %s", rrdhost_hostname(host));
 
         if (unlikely(rrdhost_flag_check(host, RRDHOST_FLAG_METADATA_LABELS))) {
@@ -1351,6 +1540,204 @@ static void *metadata_unittest_threads(void)
     return 0;
 }
 
+struct thread_unittest_queue {
+    RRDSET *charts;
+    size_t charts_count;
+    size_t updates;
+    size_t thread;
+    size_t threads;
+    unsigned *running;
+};
+
+// every thread updates dimensions of all the charts, so that the threads race to queue the same charts
+static void *unittest_queue_metadata_updates(void *arg) {
+    struct thread_unittest_queue *tq = arg;
+
+    for (size_t i = 0; i < tq->updates; i++) {
+        size_t c = (i + tq->thread) % tq->charts_count;
+        rrdset_metadata_queue(&tq->charts[c]);
+    }
+
+    __atomic_sub_fetch(tq->running, 1, __ATOMIC_RELEASE);
+    return arg;
+}
+
+static int metadata_unittest_queue(size_t dimensions, size_t dimensions_per_chart, int threads_to_create)
+{
+    size_t charts_count = dimensions / dimensions_per_chart;
+
+    fprintf(
+        stderr,
+        "\nChecking the metadata queue with %zu dimension updates on %zu charts from %d threads...\n",
+        dimensions, charts_count, threads_to_create);
+
+    RRDHOST *host = callocz(1, sizeof(RRDHOST));
+    RRDSET *charts = callocz(charts_count, sizeof(RRDSET));
+    char id[RRD_ID_LENGTH_MAX + 1];
+
+    for (size_t c = 0; c < charts_count; c++) {
+        snprintfz(id, RRD_ID_LENGTH_MAX, "unittest.chart%zu", c);
+        charts[c].id = string_strdupz(id);
+        charts[c].rrdhost = host;
+    }
+
+    netdata_thread_t threads[threads_to_create];
+    struct thread_unittest_queue tq[threads_to_create];
+    unsigned running = threads_to_create;
+
+    usec_t started_ut = now_monotonic_usec();
+    for (int i = 0; i < threads_to_create; i++) {
+        tq[i] = (struct thread_unittest_queue) {
+            .charts = charts,
+            .charts_count = charts_count,
+            .updates = dimensions / threads_to_create,
+            .thread = i,
+            .threads = threads_to_create,
+            .running = &running,
+        };
+
+        char buf[100 + 1];
+        snprintf(buf, 100, "metaq%d", i);
+        netdata_thread_create(
+            &threads[i],
+            buf,
+            NETDATA_THREAD_OPTION_DONT_LOG | NETDATA_THREAD_OPTION_JOINABLE,
+            unittest_queue_metadata_updates,
+            &tq[i]);
+    }
+
+    // detach the queue while the threads are pushing to it, like the metadata event loop does
+    size_t queued = 0;
+    bool last_pass = false;
+    do {
+        last_pass = !__atomic_load_n(&running, __ATOMIC_ACQUIRE);
+
+        struct rrdset_metadata_queued *q = rrdhost_metadata_queue_detach(host);
+        while (q) {
+            struct rrdset_metadata_queued *next = q->next;
+            string_freez(q->id);
+            freez(q);
+            queued++;
+            q = next;
+        }
+    } while (!last_pass);
+    usec_t ended_ut = now_monotonic_usec();
+
+    for (int i = 0; i < threads_to_create; i++)
+        netdata_thread_join(threads[i], NULL);
+
+    size_t updated = 0;
+    for (size_t c = 0; c < charts_count; c++) {
+        if (rrdset_flag_check(&charts[c], RRDSET_FLAG_METADATA_QUEUED))
+            updated++;
+        string_freez(charts[c].id);
+    }
+    freez(charts);
+    freez(host);
+
+    fprintf(
+        stderr,
+        "Queued %zu charts out of %zu updated, in %llu usec (%0.2f million dimension updates per second)\n",
+        queued, updated, ended_ut - started_ut,
+        (double)(dimensions / threads_to_create * threads_to_create) / (double)(ended_ut - started_ut));
+
+    if (queued != updated) {
+        fprintf(stderr, "FAILED: every updated chart should have been queued exactly once\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static size_t metadata_unittest_count_dimensions(void)
+{
+    sqlite3_stmt *res = NULL;
+    size_t count = 0;
+
+    if (sqlite3_prepare_v2(db_meta, "SELECT COUNT(*) FROM dimension;", -1, &res, 0) != SQLITE_OK)
+        return 0;
+
+    if (sqlite3_step_monitored(res) == SQLITE_ROW)
+        count = (size_t) sqlite3_column_int64(res, 0);
+
+    sqlite3_finalize(res);
+    return count;
+}
+
+static int metadata_unittest_store(size_t dimensions, size_t dimensions_per_chart)
+{
+    fprintf(stderr, "\nChecking storing %zu dimensions in the metadata database...\n", dimensions);
+
+    if (sql_init_database(DB_CHECK_NONE, 1)) {
+        fprintf(stderr, "FAILED: cannot initialize an in-memory metadata database\n");
+        return 1;
+    }
+
+    uuid_t *dim_uuids = mallocz(dimensions * sizeof(uuid_t));
+    uuid_t chart_uuid;
+    STRING *names[dimensions_per_chart];
+    char id[RRD_ID_LENGTH_MAX + 1];
+
+    for (size_t d = 0; d < dimensions; d++)
+        uuid_generate(dim_uuids[d]);
+
+    for (size_t d = 0; d < dimensions_per_chart; d++) {
+        snprintfz(id, RRD_ID_LENGTH_MAX, "dim%zu", d);
+        names[d] = string_strdupz(id);
+    }
+
+    // one row at a time, every row in its own transaction
+
+    usec_t started_ut = now_monotonic_usec();
+    for (size_t d = 0; d < dimensions; d++) {
+        if (d % dimensions_per_chart == 0)
+            uuid_generate(chart_uuid);
+
+        STRING *name = names[d % dimensions_per_chart];
+        sql_store_dimension(&dim_uuids[d], &chart_uuid, string2str(name), string2str(name), 1, 1, RRD_ALGORITHM_ABSOLUTE, false);
+    }
+    usec_t single_ut = now_monotonic_usec() - started_ut;
+    size_t single_count = metadata_unittest_count_dimensions();
+
+    // in batches, inside a transaction, as metadata_scan_host() does
+
+    struct dimension_batch *batch = mallocz(sizeof(*batch));
+    batch->used = 0;
+
+    started_ut = now_monotonic_usec();
+    db_execute("BEGIN TRANSACTION;");
+    for (size_t d = 0; d < dimensions; d++) {
+        if (d % dimensions_per_chart == 0)
+            uuid_generate(chart_uuid);
+
+        STRING *name = names[d % dimensions_per_chart];
+        dimension_batch_add(batch, &dim_uuids[d], &chart_uuid, name, name, 1, 1, RRD_ALGORITHM_ABSOLUTE, true);
+    }
+    dimension_batch_flush(batch);
+    db_execute("COMMIT TRANSACTION;");
+    usec_t batch_ut = now_monotonic_usec() - started_ut;
+    size_t batch_count = metadata_unittest_count_dimensions();
+
+    fprintf(stderr, "Stored %zu dimensions one by one in %llu usec (%0.0f dimensions per second)\n",
+            single_count, single_ut, (double)dimensions * USEC_PER_SEC / (double)(single_ut ? single_ut : 1));
+    fprintf(stderr, "Stored %zu dimensions in batches of %d in %llu usec (%0.0f dimensions per second)\n",
+            batch_count, METADATA_DIMENSION_BATCH_SIZE, batch_ut, (double)dimensions * USEC_PER_SEC / (double)(batch_ut ? batch_ut : 1));
+
+    freez(batch);
+    freez(dim_uuids);
+    for (size_t d = 0; d < dimensions_per_chart; d++)
+        string_freez(names[d]);
+
+    sql_close_database();
+
+    if (single_count != dimensions || batch_count != dimensions) {
+        fprintf(stderr, "FAILED: expected %zu dimensions in the database\n", dimensions);
+        return 1;
+    }
+
+    return 0;
+}
+
 int metadata_unittest(void)
 {
     metadata_sync_init();
@@ -1361,5 +1748,9 @@ int metadata_unittest(void)
     fprintf(stderr, "Items still in queue %u\n", metasync_worker.queue_size);
     metadata_sync_shutdown();
 
-    return 0;
+    int errors = 0;
+    errors += metadata_unittest_queue(1000000, 10, 4);
+    errors += metadata_unittest_store(1000000, 10);
+
+    return errors;
 }
@@ -70,6 +70,9 @@ void analytics_exporting_connectors(BUFFER *b)
                 buffer_strcat(b, "MongoDB");
 #endif
                 break;
+            case EXPORTING_CONNECTOR_TYPE_MMAP:
+                buffer_strcat(b, "Mmap");
+                break;
             default:
                 buffer_strcat(b, "Unknown");
         }
@@ -110,6 +113,8 @@ static void exporting_clean_engine()
         clean_instance(current_instance);
     }
 
+    exporting_snapshot_free(&engine->snapshot);
+
     freez((void *)engine->config.hostname);
     freez(engine);
 }
@@ -133,6 +138,8 @@ static void exporting_main_cleanup(void *ptr)
 
     engine->exit = 1;
 
+    stop_formatting_threads(engine);
+
     int found = 0;
     usec_t max = 2 * USEC_PER_SEC, step = 50000;
 
@@ -60,6 +60,7 @@ typedef enum exporting_connector_types {
     EXPORTING_CONNECTOR_TYPE_KINESIS,                 // Send message to AWS Kinesis
     EXPORTING_CONNECTOR_TYPE_PUBSUB,                  // Send message to Google Cloud Pub/Sub
     EXPORTING_CONNECTOR_TYPE_MONGODB,                 // Send data to MongoDB collection
+    EXPORTING_CONNECTOR_TYPE_MMAP,                    // Write data to a memory mapped file
     EXPORTING_CONNECTOR_TYPE_NUM                      // Number of exporting connector types
 } EXPORTING_CONNECTOR_TYPE;
 
@@ -152,9 +153,16 @@ struct mongodb_specific_config {
     char *collection;
 };
 
+struct mmap_specific_config {
+    uint32_t rows;
+    mode_t mode;
+};
+
 struct engine_config {
     const char *hostname;
     int update_every;
+    int collection_tap;
+    size_t formatting_threads;
 };
 
 struct stats {
@@ -170,6 +178,8 @@ struct stats {
     collected_number reconnects;
     collected_number transmission_failures;
     collected_number receptions;
+    collected_number formatting_time;
+    collected_number formatting_wait_time;
 
     int initialized;
 
@@ -194,6 +204,10 @@ struct stats {
     RRDSET *st_rusage;
     RRDDIM *rd_user;
     RRDDIM *rd_system;
+
+    RRDSET *st_formatting;
+    RRDDIM *rd_formatting;
+    RRDDIM *rd_formatting_wait;
 };
 
 struct instance {
@@ -204,8 +218,6 @@ struct instance {
 
     int scheduled;
     int disabled;
-    int skip_host;
-    int skip_chart;
 
     BUFFER *labels_buffer;
 
@@ -238,12 +250,55 @@ struct instance {
     volatile sig_atomic_t exited;
 };
 
+struct exporting_snapshot_host {
+    RRDHOST *host;
+    size_t charts_start;
+    size_t charts_end;
+};
+
+struct exporting_snapshot_chart {
+    RRDSET *st;
+    const DICTIONARY_ITEM *item;
+    size_t dimensions_start;
+    size_t dimensions_end;
+};
+
+struct exporting_snapshot_dimension {
+    RRDDIM *rd;
+    const DICTIONARY_ITEM *item;
+};
+
+struct exporting_snapshot {
+    struct exporting_snapshot_host *hosts;
+    size_t hosts_used;
+    size_t hosts_size;
+
+    struct exporting_snapshot_chart *charts;
+    size_t charts_used;
+    size_t charts_size;
+
+    struct exporting_snapshot_dimension *dimensions;
+    size_t dimensions_used;
+    size_t dimensions_size;
+};
+
 struct engine {
     struct engine_config config;
 
     size_t instance_num;
     time_t now;
 
+    struct exporting_snapshot snapshot;
+
+    size_t formatting_threads;
+    uv_thread_t *formatters;
+    uv_mutex_t formatting_mutex;
+    uv_cond_t formatting_cond;
+    uv_cond_t formatting_done_cond;
+    size_t formatting_iteration;
+    size_t formatting_pending;
+    struct instance *formatting_next;
+
     int aws_sdk_initialized;
     int protocol_buffers_initialized;
     int mongoc_initialized;
@@ -279,14 +334,9 @@ exporting_calculate_value_from_stored_data(
     RRDDIM *rd,
     time_t *last_timestamp);
 
-void start_batch_formatting(struct engine *engine);
-void start_host_formatting(struct engine *engine, RRDHOST *host);
-void start_chart_formatting(struct engine *engine, RRDSET *st);
-void metric_formatting(struct engine *engine, RRDDIM *rd);
-void end_chart_formatting(struct engine *engine, RRDSET *st);
-void variables_formatting(struct engine *engine, RRDHOST *host);
-void end_host_formatting(struct engine *engine, RRDHOST *host);
-void end_batch_formatting(struct engine *engine);
+void exporting_snapshot_free(struct exporting_snapshot *snapshot);
+int init_formatting_threads(struct engine *engine);
+void stop_formatting_threads(struct engine *engine);
 int flush_host_labels(struct instance *instance, RRDHOST *host);
 int simple_connector_end_batch(struct instance *instance);
 
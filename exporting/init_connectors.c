@@ -4,6 +4,7 @@
 #include "graphite/graphite.h"
 #include "json/json.h"
 #include "opentsdb/opentsdb.h"
+#include "mmap/mmap.h"
 
 #if ENABLE_PROMETHEUS_REMOTE_WRITE
 #include "prometheus/remote_write/remote_write.h"
@@ -84,6 +85,10 @@ int init_connectors(struct engine *engine)
                     return 1;
 #endif
                 break;
+            case EXPORTING_CONNECTOR_TYPE_MMAP:
+                if (init_mmap_instance(instance) != 0)
+                    return 1;
+                break;
             default:
                 error("EXPORTING: unknown exporting connector type");
                 return 1;
@@ -102,7 +107,7 @@ int init_connectors(struct engine *engine)
         send_statistics("EXPORTING_START", "OK", instance->config.type_name);
     }
 
-    return 0;
+    return init_formatting_threads(engine);
 }
 
 // TODO: use a base64 encoder from a library
@@ -0,0 +1,445 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "mmap.h"
+
+/**
+ * Free the names of a metric when it is deleted from the dictionary
+ *
+ * @param item the dictionary item.
+ * @param value a mmap_metric structure.
+ * @param data unused.
+ */
+static void mmap_metric_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused)
+{
+    struct mmap_metric *m = value;
+
+    string_freez(m->host);
+    string_freez(m->context);
+    string_freez(m->chart);
+    string_freez(m->dimension);
+    string_freez(m->units);
+}
+
+/**
+ * Initialize a mmap connector instance
+ *
+ * @param instance an instance data structure.
+ * @return Returns 0 on success, 1 on failure.
+ */
+int init_mmap_instance(struct instance *instance)
+{
+    instance->worker = mmap_connector_worker;
+
+    instance->start_batch_formatting = start_batch_mmap;
+    instance->start_host_formatting = NULL;
+    instance->start_chart_formatting = NULL;
+    instance->metric_formatting = format_dimension_mmap;
+    instance->end_chart_formatting = NULL;
+    instance->variables_formatting = NULL;
+    instance->end_host_formatting = NULL;
+    instance->end_batch_formatting = format_batch_mmap;
+
+    instance->prepare_header = NULL;
+    instance->check_response = NULL;
+
+    struct mmap_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    if (connector_specific_config->rows < 2)
+        connector_specific_config->rows = 2;
+
+    struct mmap_specific_data *connector_specific_data = callocz(1, sizeof(struct mmap_specific_data));
+    instance->connector_specific_data = (void *)connector_specific_data;
+
+    connector_specific_data->fd = -1;
+    connector_specific_data->metrics =
+        dictionary_create(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE);
+    dictionary_register_delete_callback(connector_specific_data->metrics, mmap_metric_delete_callback, NULL);
+
+    if (uv_mutex_init(&instance->mutex))
+        return 1;
+    if (uv_cond_init(&instance->cond_var))
+        return 1;
+
+    return 0;
+}
+
+/**
+ * Start a batch for the mmap connector
+ *
+ * @param instance an instance data structure.
+ * @return Always returns 0.
+ */
+int start_batch_mmap(struct instance *instance)
+{
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+
+    connector_specific_data->batch++;
+    connector_specific_data->new_metrics = 0;
+    connector_specific_data->batch_metrics = 0;
+
+    return 0;
+}
+
+/**
+ * Keep the value of a dimension for the row of this batch
+ *
+ * @param instance an instance data structure.
+ * @param rd a dimension.
+ * @return Always returns 0.
+ */
+int format_dimension_mmap(struct instance *instance, RRDDIM *rd)
+{
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+    RRDSET *st = rd->rrdset;
+    RRDHOST *host = st->rrdhost;
+
+    NETDATA_DOUBLE value;
+    if (EXPORTING_OPTIONS_DATA_SOURCE(instance->config.options) == EXPORTING_SOURCE_DATA_AS_COLLECTED)
+        value = (NETDATA_DOUBLE)rd->last_collected_value;
+    else {
+        time_t last_t;
+        value = exporting_calculate_value_from_stored_data(instance, rd, &last_t);
+    }
+
+    char key[RRD_ID_LENGTH_MAX * 3 + 3];
+    snprintfz(key, sizeof(key) - 1, "%s/%s/%s", rrdhost_hostname(host), rrdset_id(st), rrddim_id(rd));
+
+    struct mmap_metric *m = dictionary_get(connector_specific_data->metrics, key);
+    if (unlikely(!m)) {
+        bool send_names = instance->config.options & EXPORTING_OPTION_SEND_NAMES;
+
+        struct mmap_metric tmp = {
+            .host = string_strdupz((host == localhost) ? instance->config.hostname : rrdhost_hostname(host)),
+            .context = string_dup(st->context),
+            .chart = string_dup((send_names && st->name) ? st->name : st->id),
+            .dimension = string_dup((send_names && rd->name) ? rd->name : rd->id),
+            .units = string_dup(st->units),
+            .column = MMAP_COLUMN_NONE,
+        };
+
+        m = dictionary_set(connector_specific_data->metrics, key, &tmp, sizeof(tmp));
+        connector_specific_data->new_metrics++;
+    }
+
+    m->batch = connector_specific_data->batch;
+    m->value = value;
+    connector_specific_data->batch_metrics++;
+
+    return 0;
+}
+
+/**
+ * Unmap the file of the connector
+ *
+ * @param connector_specific_data the mmap connector data.
+ * @param obsolete tell the readers that the file has been replaced.
+ */
+static void mmap_close_file(struct mmap_specific_data *connector_specific_data, bool obsolete)
+{
+    if (connector_specific_data->map) {
+        if (obsolete)
+            __atomic_store_n(&connector_specific_data->header->obsolete, 1, __ATOMIC_RELEASE);
+
+        munmap(connector_specific_data->map, connector_specific_data->map_size);
+    }
+
+    if (connector_specific_data->fd != -1)
+        close(connector_specific_data->fd);
+
+    connector_specific_data->map = NULL;
+    connector_specific_data->map_size = 0;
+    connector_specific_data->header = NULL;
+    connector_specific_data->fd = -1;
+}
+
+static inline uint32_t mmap_copy_string(char *strings, uint32_t *offset, STRING *s)
+{
+    uint32_t ret = *offset;
+    size_t len = string_strlen(s);
+
+    memcpy(&strings[ret], string2str(s), len);
+    strings[ret + len] = '\0';
+    *offset += len + 1;
+
+    return ret;
+}
+
+/**
+ * Write a new file for the current set of metrics
+ *
+ * The metrics that have not been exported for a whole ring are dropped. The rows of the
+ * metrics that were in the previous file are copied to the new one, which is then moved
+ * over the previous one.
+ *
+ * @param instance an instance data structure.
+ * @return Returns 0 on success, 1 on failure.
+ */
+static int mmap_create_file(struct instance *instance)
+{
+    struct mmap_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+    uint32_t rows = connector_specific_config->rows;
+
+    size_t metrics = 0, strings_size = 0;
+    struct mmap_metric *m;
+    dfe_start_write(connector_specific_data->metrics, m) {
+        if (connector_specific_data->batch - m->batch >= rows) {
+            dictionary_del(connector_specific_data->metrics, m_dfe.name);
+            continue;
+        }
+
+        metrics++;
+        strings_size += string_strlen(m->host) + string_strlen(m->context) + string_strlen(m->chart) +
+                        string_strlen(m->dimension) + string_strlen(m->units) + 5;
+    }
+    dfe_done(m);
+
+    size_t metrics_offset = sizeof(struct netdata_mmap_header);
+    size_t timestamps_offset = metrics_offset + metrics * sizeof(struct netdata_mmap_metric);
+    size_t values_offset = timestamps_offset + rows * sizeof(int64_t);
+    size_t strings_offset = values_offset + metrics * rows * sizeof(double);
+    size_t file_size = strings_offset + strings_size;
+
+    char filename[FILENAME_MAX + 1];
+    snprintfz(filename, FILENAME_MAX, "%s.tmp", instance->config.destination);
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, connector_specific_config->mode);
+    if (fd == -1) {
+        error("EXPORTING: cannot create file '%s'", filename);
+        return 1;
+    }
+
+    // the mode of open() is filtered by the umask
+    if (fchmod(fd, connector_specific_config->mode) != 0)
+        error("EXPORTING: cannot change the permissions of file '%s'", filename);
+
+    if (ftruncate(fd, (off_t)file_size) != 0) {
+        error("EXPORTING: cannot resize file '%s' to %zu bytes", filename, file_size);
+        close(fd);
+        unlink(filename);
+        return 1;
+    }
+
+    uint8_t *map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        error("EXPORTING: cannot memory map file '%s'", filename);
+        close(fd);
+        unlink(filename);
+        return 1;
+    }
+
+    struct netdata_mmap_header *old_header = connector_specific_data->header;
+    uint8_t *old_map = connector_specific_data->map;
+
+    struct netdata_mmap_header *header = (struct netdata_mmap_header *)map;
+    memcpy(header->magic, NETDATA_MMAP_MAGIC, NETDATA_MMAP_MAGIC_SIZE);
+    header->version = NETDATA_MMAP_VERSION;
+    header->header_size = sizeof(struct netdata_mmap_header);
+    header->sequence = 0;
+    header->obsolete = 0;
+    header->update_every = instance->config.update_every;
+    header->rows_written = old_header ? old_header->rows_written : 0;
+    header->rows = rows;
+    header->metrics = metrics;
+    header->metrics_offset = metrics_offset;
+    header->timestamps_offset = timestamps_offset;
+    header->values_offset = values_offset;
+    header->strings_offset = strings_offset;
+    header->file_size = file_size;
+
+    // the ring has the same size, so the rows are in the same positions
+    int64_t *timestamps = (int64_t *)&map[timestamps_offset];
+    if (old_header)
+        memcpy(timestamps, &old_map[old_header->timestamps_offset], rows * sizeof(int64_t));
+
+    struct netdata_mmap_metric *entries = (struct netdata_mmap_metric *)&map[metrics_offset];
+    double *values = (double *)&map[values_offset];
+    char *strings = (char *)&map[strings_offset];
+    uint32_t column = 0, string_offset = 0;
+
+    dfe_start_read(connector_specific_data->metrics, m) {
+        struct netdata_mmap_metric *entry = &entries[column];
+        entry->host = mmap_copy_string(strings, &string_offset, m->host);
+        entry->context = mmap_copy_string(strings, &string_offset, m->context);
+        entry->chart = mmap_copy_string(strings, &string_offset, m->chart);
+        entry->dimension = mmap_copy_string(strings, &string_offset, m->dimension);
+        entry->units = mmap_copy_string(strings, &string_offset, m->units);
+        entry->reserved = 0;
+
+        double *column_values = &values[(size_t)column * rows];
+        if (old_header && m->column != MMAP_COLUMN_NONE) {
+            double *old_values = (double *)&old_map[old_header->values_offset];
+            memcpy(column_values, &old_values[(size_t)m->column * rows], rows * sizeof(double));
+        } else {
+            for (uint32_t row = 0; row < rows; row++)
+                column_values[row] = NAN;
+        }
+
+        m->column = column++;
+    }
+    dfe_done(m);
+
+    if (rename(filename, instance->config.destination) != 0) {
+        error("EXPORTING: cannot rename file '%s' to '%s'", filename, instance->config.destination);
+        munmap(map, file_size);
+        close(fd);
+        unlink(filename);
+
+        // the columns have been renumbered, so the rows of the previous file cannot be used anymore
+        mmap_close_file(connector_specific_data, true);
+        return 1;
+    }
+
+    mmap_close_file(connector_specific_data, true);
+
+    connector_specific_data->fd = fd;
+    connector_specific_data->map = map;
+    connector_specific_data->map_size = file_size;
+    connector_specific_data->header = header;
+
+    return 0;
+}
+
+/**
+ * Write the row of a batch to the file of the mmap connector
+ *
+ * The file is rewritten when new metrics appear, or when metrics have not been exported
+ * for a whole ring.
+ *
+ * @param instance an instance data structure.
+ * @return Always returns 0. Failures are reported by the worker as lost metrics.
+ */
+int format_batch_mmap(struct instance *instance)
+{
+    struct mmap_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+    uint32_t rows = connector_specific_config->rows;
+    struct mmap_metric *m;
+
+    bool rebuild = !connector_specific_data->map || connector_specific_data->new_metrics;
+    if (!rebuild && connector_specific_data->batch_metrics != connector_specific_data->header->metrics) {
+        dfe_start_read(connector_specific_data->metrics, m) {
+            if (connector_specific_data->batch - m->batch >= rows) {
+                rebuild = true;
+                break;
+            }
+        }
+        dfe_done(m);
+    }
+
+    connector_specific_data->failed = false;
+    if (rebuild && mmap_create_file(instance) != 0) {
+        connector_specific_data->failed = true;
+        return 0;
+    }
+
+    struct netdata_mmap_header *header = connector_specific_data->header;
+    int64_t *timestamps = (int64_t *)&connector_specific_data->map[header->timestamps_offset];
+    double *values = (double *)&connector_specific_data->map[header->values_offset];
+
+    // readers retry when the sequence is odd or changes while they read
+    uint64_t sequence = header->sequence;
+    __atomic_store_n(&header->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint64_t row = header->rows_written % rows;
+    timestamps[row] = instance->before;
+
+    dfe_start_read(connector_specific_data->metrics, m) {
+        values[(size_t)m->column * rows + row] = (m->batch == connector_specific_data->batch) ? m->value : NAN;
+    }
+    dfe_done(m);
+
+    __atomic_store_n(&header->rows_written, header->rows_written + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    instance->stats.buffered_bytes = (collected_number)(sizeof(int64_t) + header->metrics * sizeof(double));
+
+    return 0;
+}
+
+/**
+ * Clean up the mmap connector instance on Netdata exit
+ *
+ * The file is left in place, so that readers can still use the last rows.
+ *
+ * @param instance an instance data structure.
+ */
+void mmap_cleanup(struct instance *instance)
+{
+    info("EXPORTING: cleaning up instance %s ...", instance->config.name);
+
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+
+    mmap_close_file(connector_specific_data, false);
+    dictionary_destroy(connector_specific_data->metrics);
+    freez(connector_specific_data);
+
+    struct mmap_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    freez(connector_specific_config);
+
+    info("EXPORTING: instance %s exited", instance->config.name);
+    instance->exited = 1;
+}
+
+/**
+ * Mmap connector worker
+ *
+ * Runs in a separate thread for every instance. The rows are written to the file while
+ * the batches are formatted, so the worker only reports the statistics of the instance.
+ *
+ * @param instance_p an instance data structure.
+ */
+void mmap_connector_worker(void *instance_p)
+{
+    struct instance *instance = (struct instance *)instance_p;
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+
+    while (!instance->engine->exit) {
+        struct stats *stats = &instance->stats;
+
+        uv_mutex_lock(&instance->mutex);
+        while (!instance->data_is_ready)
+            uv_cond_wait(&instance->cond_var, &instance->mutex);
+        instance->data_is_ready = 0;
+
+        if (unlikely(instance->engine->exit)) {
+            uv_mutex_unlock(&instance->mutex);
+            break;
+        }
+
+        // reset the monitoring chart counters
+        stats->received_bytes =
+        stats->sent_bytes =
+        stats->sent_metrics =
+        stats->lost_metrics =
+        stats->receptions =
+        stats->transmission_successes =
+        stats->transmission_failures =
+        stats->data_lost_events =
+        stats->lost_bytes =
+        stats->reconnects = 0;
+
+        if (unlikely(connector_specific_data->failed)) {
+            stats->transmission_failures++;
+            stats->data_lost_events++;
+            stats->lost_metrics = stats->buffered_metrics;
+        } else {
+            stats->transmission_successes++;
+            stats->sent_metrics = stats->buffered_metrics;
+            stats->sent_bytes = stats->buffered_bytes;
+        }
+
+        send_internal_metrics(instance);
+
+        stats->buffered_metrics = 0;
+        stats->buffered_bytes = 0;
+
+        uv_mutex_unlock(&instance->mutex);
+
+#ifdef UNIT_TESTING
+        return;
+#endif
+    }
+
+    mmap_cleanup(instance);
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_EXPORTING_MMAP_H
+#define NETDATA_EXPORTING_MMAP_H
+
+#include "exporting/exporting_engine.h"
+#include "netdata_mmap.h"
+
+#define MMAP_COLUMN_NONE UINT32_MAX
+
+struct mmap_metric {
+    STRING *host;
+    STRING *context;
+    STRING *chart;
+    STRING *dimension;
+    STRING *units;
+
+    uint32_t column;                    // in the current file, MMAP_COLUMN_NONE when it is not in the file yet
+    size_t batch;                       // the last batch the metric was exported in
+    NETDATA_DOUBLE value;               // the value of the last batch
+};
+
+struct mmap_specific_data {
+    DICTIONARY *metrics;                // struct mmap_metric, by host, chart id and dimension id
+
+    size_t batch;
+    size_t batch_metrics;               // metrics exported in this batch
+    size_t new_metrics;                 // metrics of this batch that are not in the file
+    bool failed;                        // the row of this batch could not be written
+
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    struct netdata_mmap_header *header;
+};
+
+int init_mmap_instance(struct instance *instance);
+
+int start_batch_mmap(struct instance *instance);
+int format_dimension_mmap(struct instance *instance, RRDDIM *rd);
+int format_batch_mmap(struct instance *instance);
+
+void mmap_cleanup(struct instance *instance);
+void mmap_connector_worker(void *instance_p);
+
+#endif //NETDATA_EXPORTING_MMAP_H
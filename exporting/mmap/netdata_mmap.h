@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_MMAP_H
+#define NETDATA_MMAP_H 1
+
+/*
+ * The binary layout of the files written by the mmap exporting connector.
+ *
+ * This header does not depend on any other netdata header, so that it can be
+ * used by the programs reading the files (see netdata_mmap_reader.h).
+ *
+ * A file has a fixed set of metrics and keeps the last `rows` values of each of
+ * them in a ring. All offsets are from the start of the file and all numbers
+ * are in the byte order of the host that wrote the file:
+ *
+ *   struct netdata_mmap_header   header
+ *   struct netdata_mmap_metric   metrics[metrics]
+ *   int64_t                      timestamps[rows]
+ *   double                       values[metrics][rows]   the rows of each metric are contiguous
+ *   char                         strings[]               the names of the metrics, NUL terminated
+ *
+ * Row N is stored at index N % rows of the ring. The newest row is rows_written - 1
+ * and the ring has the last MIN(rows_written, rows) rows. Values that are not
+ * available are NaN.
+ *
+ * The file is updated in place, once every `update_every` seconds. The exporter
+ * makes `sequence` odd before it starts updating the file and even again when it
+ * finishes, so readers can check that the data they read are consistent.
+ *
+ * When the set of exported metrics changes, the exporter writes a new file, moves
+ * it over the old one and sets `obsolete` in the old one, so that readers reopen it.
+ */
+
+#include <stdint.h>
+
+#define NETDATA_MMAP_MAGIC "NDMMAP\0\0"
+#define NETDATA_MMAP_MAGIC_SIZE 8
+#define NETDATA_MMAP_VERSION 1
+
+struct netdata_mmap_header {
+    char magic[NETDATA_MMAP_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t header_size;               // sizeof(struct netdata_mmap_header)
+
+    uint64_t sequence;                  // odd while the exporter updates the file
+    uint32_t obsolete;                  // the file has been replaced by a new one
+    uint32_t update_every;              // seconds between rows
+
+    uint64_t rows_written;              // since the file was created, including the rows of the file it replaced
+    uint32_t rows;                      // the size of the ring
+    uint32_t metrics;
+
+    uint64_t metrics_offset;
+    uint64_t timestamps_offset;
+    uint64_t values_offset;
+    uint64_t strings_offset;
+    uint64_t file_size;
+};
+
+struct netdata_mmap_metric {
+    // offsets of the names in strings
+    uint32_t host;
+    uint32_t context;
+    uint32_t chart;                     // id or name, according to "send names instead of ids"
+    uint32_t dimension;                 // id or name, according to "send names instead of ids"
+    uint32_t units;
+    uint32_t reserved;
+};
+
+#endif //NETDATA_MMAP_H
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "netdata_mmap_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int netdata_mmap_validate(const struct netdata_mmap_header *header, size_t map_size)
+{
+    if (map_size < sizeof(struct netdata_mmap_header) ||
+        memcmp(header->magic, NETDATA_MMAP_MAGIC, NETDATA_MMAP_MAGIC_SIZE) != 0 ||
+        header->version != NETDATA_MMAP_VERSION ||
+        header->header_size < sizeof(struct netdata_mmap_header) ||
+        header->file_size > map_size || !header->rows)
+        return -1;
+
+    uint64_t rows = header->rows, metrics = header->metrics;
+
+    if (header->metrics_offset < header->header_size ||
+        header->timestamps_offset < header->metrics_offset + metrics * sizeof(struct netdata_mmap_metric) ||
+        header->values_offset < header->timestamps_offset + rows * sizeof(int64_t) ||
+        header->strings_offset < header->values_offset + metrics * rows * sizeof(double) ||
+        header->file_size < header->strings_offset)
+        return -1;
+
+    // the last string has to be terminated
+    if (header->file_size > header->strings_offset && ((const char *)header)[header->file_size - 1] != '\0')
+        return -1;
+
+    return 0;
+}
+
+int netdata_mmap_open(NETDATA_MMAP_READER *reader, const char *path)
+{
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct netdata_mmap_header)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    if (netdata_mmap_validate(map, (size_t)st.st_size) != 0) {
+        munmap(map, (size_t)st.st_size);
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    reader->path = strdup(path);
+    if (!reader->path) {
+        munmap(map, (size_t)st.st_size);
+        close(fd);
+        return -1;
+    }
+
+    reader->fd = fd;
+    reader->dev = st.st_dev;
+    reader->ino = st.st_ino;
+    reader->map = map;
+    reader->map_size = (size_t)st.st_size;
+    reader->header = map;
+
+    return 0;
+}
+
+void netdata_mmap_close(NETDATA_MMAP_READER *reader)
+{
+    if (reader->map)
+        munmap((void *)reader->map, reader->map_size);
+
+    if (reader->fd != -1)
+        close(reader->fd);
+
+    free(reader->path);
+
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
+
+int netdata_mmap_refresh(NETDATA_MMAP_READER *reader)
+{
+    struct stat st;
+
+    // the exporter marks the files it replaces, but a restarted exporter replaces the file without marking it
+    if (!__atomic_load_n(&reader->header->obsolete, __ATOMIC_ACQUIRE) &&
+        (stat(reader->path, &st) != 0 || (st.st_dev == reader->dev && st.st_ino == reader->ino)))
+        return 0;
+
+    NETDATA_MMAP_READER new_reader;
+    if (netdata_mmap_open(&new_reader, reader->path) != 0)
+        return -1;
+
+    netdata_mmap_close(reader);
+    *reader = new_reader;
+
+    return 1;
+}
+
+uint32_t netdata_mmap_metrics(const NETDATA_MMAP_READER *reader)
+{
+    return reader->header->metrics;
+}
+
+static inline const char *netdata_mmap_string(const NETDATA_MMAP_READER *reader, uint32_t offset)
+{
+    const struct netdata_mmap_header *header = reader->header;
+
+    if (offset >= header->file_size - header->strings_offset)
+        return "";
+
+    return (const char *)&reader->map[header->strings_offset + offset];
+}
+
+int netdata_mmap_metric_info(const NETDATA_MMAP_READER *reader, uint32_t metric, struct netdata_mmap_metric_info *info)
+{
+    const struct netdata_mmap_header *header = reader->header;
+
+    if (metric >= header->metrics)
+        return -1;
+
+    const struct netdata_mmap_metric *entry =
+        &((const struct netdata_mmap_metric *)&reader->map[header->metrics_offset])[metric];
+
+    info->host = netdata_mmap_string(reader, entry->host);
+    info->context = netdata_mmap_string(reader, entry->context);
+    info->chart = netdata_mmap_string(reader, entry->chart);
+    info->dimension = netdata_mmap_string(reader, entry->dimension);
+    info->units = netdata_mmap_string(reader, entry->units);
+
+    return 0;
+}
+
+int64_t netdata_mmap_find_metric(
+    const NETDATA_MMAP_READER *reader, const char *host, const char *chart, const char *dimension)
+{
+    struct netdata_mmap_metric_info info;
+
+    for (uint32_t metric = 0; metric < reader->header->metrics; metric++) {
+        netdata_mmap_metric_info(reader, metric, &info);
+
+        if ((!host || !strcmp(host, info.host)) && !strcmp(chart, info.chart) && !strcmp(dimension, info.dimension))
+            return metric;
+    }
+
+    return -1;
+}
+
+int netdata_mmap_view_begin(const NETDATA_MMAP_READER *reader, struct netdata_mmap_view *view)
+{
+    const struct netdata_mmap_header *header = reader->header;
+
+    // the exporter updates the file for a very short time, once every update_every seconds,
+    // so a sequence that stays odd means that the exporter stopped in the middle of an update
+    int retries = NETDATA_MMAP_READER_RETRIES;
+    while ((view->sequence = __atomic_load_n(&header->sequence, __ATOMIC_ACQUIRE)) & 1) {
+        if (!--retries) {
+            errno = EAGAIN;
+            return -1;
+        }
+        sched_yield();
+    }
+
+    view->rows_written = __atomic_load_n(&header->rows_written, __ATOMIC_RELAXED);
+    view->rows = header->rows;
+    view->timestamps = (const int64_t *)&reader->map[header->timestamps_offset];
+    view->values = (const double *)&reader->map[header->values_offset];
+
+    return 0;
+}
+
+int netdata_mmap_view_end(const NETDATA_MMAP_READER *reader, const struct netdata_mmap_view *view)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n(&reader->header->sequence, __ATOMIC_RELAXED) != view->sequence)
+        return -1;
+
+    return 0;
+}
+
+ssize_t netdata_mmap_read(
+    const NETDATA_MMAP_READER *reader, uint32_t metric, int64_t *timestamps, double *values, size_t max_rows)
+{
+    if (metric >= reader->header->metrics) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct netdata_mmap_view view;
+    size_t rows;
+    int retries = NETDATA_MMAP_READER_RETRIES;
+
+    do {
+        if (netdata_mmap_view_begin(reader, &view) != 0)
+            return -1;
+
+        rows = view.rows_written < view.rows ? (size_t)view.rows_written : view.rows;
+        if (rows > max_rows)
+            rows = max_rows;
+
+        const double *metric_values = netdata_mmap_view_metric(&view, metric);
+        uint64_t first_row = view.rows_written - rows;
+
+        for (size_t i = 0; i < rows; i++) {
+            size_t slot = (first_row + i) % view.rows;
+
+            if (timestamps)
+                timestamps[i] = view.timestamps[slot];
+            if (values)
+                values[i] = metric_values[slot];
+        }
+
+        if (netdata_mmap_view_end(reader, &view) == 0)
+            return (ssize_t)rows;
+    } while (--retries);
+
+    errno = EAGAIN;
+    return -1;
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_MMAP_READER_H
+#define NETDATA_MMAP_READER_H 1
+
+/*
+ * A small library for reading the files of the mmap exporting connector.
+ *
+ * It depends only on libc and netdata_mmap.h, so that it can be copied to
+ * other projects. All functions return 0 on success and -1 on failure,
+ * unless stated otherwise.
+ */
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "netdata_mmap.h"
+
+// The times a reader waits for the exporter to finish an update, before failing with EAGAIN
+#define NETDATA_MMAP_READER_RETRIES 1000
+
+typedef struct netdata_mmap_reader {
+    char *path;
+    int fd;
+    dev_t dev;
+    ino_t ino;
+
+    const uint8_t *map;
+    size_t map_size;
+    const struct netdata_mmap_header *header;
+} NETDATA_MMAP_READER;
+
+struct netdata_mmap_metric_info {
+    const char *host;
+    const char *context;
+    const char *chart;
+    const char *dimension;
+    const char *units;
+};
+
+// A consistent view of the rows of the file, without copying them.
+struct netdata_mmap_view {
+    uint64_t sequence;
+    uint64_t rows_written;
+    uint32_t rows;
+    const int64_t *timestamps;
+    const double *values;
+};
+
+int netdata_mmap_open(NETDATA_MMAP_READER *reader, const char *path);
+void netdata_mmap_close(NETDATA_MMAP_READER *reader);
+
+// Reopens the file when the exporter has replaced it.
+// Returns 1 when the file has been reopened, so metric numbers and names have to be looked up again.
+int netdata_mmap_refresh(NETDATA_MMAP_READER *reader);
+
+uint32_t netdata_mmap_metrics(const NETDATA_MMAP_READER *reader);
+int netdata_mmap_metric_info(const NETDATA_MMAP_READER *reader, uint32_t metric, struct netdata_mmap_metric_info *info);
+
+// Returns the number of the metric, or -1 when it is not in the file. host may be NULL to match any host.
+int64_t netdata_mmap_find_metric(
+    const NETDATA_MMAP_READER *reader, const char *host, const char *chart, const char *dimension);
+
+// Copies the last max_rows rows of a metric, the oldest first. Returns the number of rows copied, or -1.
+// errno is EAGAIN when the exporter did not finish updating the file, see netdata_mmap_view_begin().
+ssize_t netdata_mmap_read(
+    const NETDATA_MMAP_READER *reader, uint32_t metric, int64_t *timestamps, double *values, size_t max_rows);
+
+// Row N of the view is at index N % rows of the timestamps and of the values of each metric.
+// The data of the view can be used until netdata_mmap_view_end() returns 0. When it returns -1,
+// the exporter has updated the file in the meantime and the view has to be started again.
+// netdata_mmap_view_begin() fails with EAGAIN when the exporter is still updating the file after
+// NETDATA_MMAP_READER_RETRIES retries. Call netdata_mmap_refresh() then, because an exporter that
+// stopped during an update replaces the file when it starts again.
+int netdata_mmap_view_begin(const NETDATA_MMAP_READER *reader, struct netdata_mmap_view *view);
+int netdata_mmap_view_end(const NETDATA_MMAP_READER *reader, const struct netdata_mmap_view *view);
+
+static inline const double *netdata_mmap_view_metric(const struct netdata_mmap_view *view, uint32_t metric)
+{
+    return &view->values[(size_t)metric * view->rows];
+}
+
+#endif //NETDATA_MMAP_READER_H
@@ -55,7 +55,7 @@ int mark_scheduled_instances(struct engine *engine)
 }
 
 /**
- * Calculate the SUM or AVERAGE of a dimension, for any timeframe
+ * Calculate the SUM or AVERAGE of a dimension, querying the database
  *
  * May return NAN if the database does not have any value in the give timeframe.
  *
@@ -64,7 +64,7 @@ int mark_scheduled_instances(struct engine *engine)
  * @param last_timestamp the timestamp that should be reported to the exporting connector instance.
  * @return Returns the value, calculated over the given period.
  */
-NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
+static NETDATA_DOUBLE exporting_query_stored_data(
     struct instance *instance,
     RRDDIM *rd,
     time_t *last_timestamp)
@@ -160,208 +160,506 @@ NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
 }
 
 /**
- * Start batch formatting for every connector instance's buffer
+ * Calculate the SUM or AVERAGE of a dimension, from its collection tap
  *
- * @param engine an engine data structure.
+ * The collection tap accumulates the values stored since the last time the instance read them,
+ * so no database query is needed. The first time a dimension is exported, its tap is created and
+ * the database is queried.
+ *
+ * May return NAN if no values have been stored since the last read.
+ *
+ * @param instance an instance data structure.
+ * @param rd a dimension(metric) in the Netdata database.
+ * @param last_timestamp the timestamp that should be reported to the exporting connector instance.
+ * @return Returns the value, calculated over the values stored since the last read.
  */
-void start_batch_formatting(struct engine *engine)
+static NETDATA_DOUBLE exporting_read_collection_tap(
+    struct instance *instance,
+    RRDDIM *rd,
+    time_t *last_timestamp)
 {
-    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled) {
-            uv_mutex_lock(&instance->mutex);
-            if (instance->start_batch_formatting && instance->start_batch_formatting(instance) != 0) {
-                error("EXPORTING: cannot start batch formatting for %s", instance->config.name);
-                disable_instance(instance);
-            }
-        }
+    RRDDIM_EXPORTING_TAP *tap = __atomic_load_n(&rd->exporting_tap, __ATOMIC_ACQUIRE);
+
+    if (unlikely(!tap)) {
+        size_t slots = instance->engine->instance_num;
+        tap = callocz(1, sizeof(RRDDIM_EXPORTING_TAP) + slots * sizeof(struct rrddim_exporting_tap_slot));
+        netdata_spinlock_init(&tap->spinlock);
+        tap->slots = slots;
+
+        RRDDIM_EXPORTING_TAP *expected = NULL;
+        if (!__atomic_compare_exchange_n(&rd->exporting_tap, &expected, tap, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+            freez(tap);
+
+        return exporting_query_stored_data(instance, rd, last_timestamp);
     }
+
+    netdata_spinlock_lock(&tap->spinlock);
+    struct rrddim_exporting_tap_slot slot = tap->slot[instance->index];
+    tap->slot[instance->index].sum = 0.0;
+    tap->slot[instance->index].count = 0;
+    netdata_spinlock_unlock(&tap->spinlock);
+
+    if (unlikely(!slot.count)) {
+        debug(
+            D_EXPORTING,
+            "EXPORTING: %s.%s.%s: no values stored since the last read",
+            rrdhost_hostname(rd->rrdset->rrdhost),
+            rrdset_id(rd->rrdset),
+            rrddim_id(rd));
+        return NAN;
+    }
+
+    *last_timestamp = slot.last_time_s;
+
+    if (unlikely(EXPORTING_OPTIONS_DATA_SOURCE(instance->config.options) == EXPORTING_SOURCE_DATA_SUM))
+        return slot.sum;
+
+    return slot.sum / (NETDATA_DOUBLE)slot.count;
 }
 
 /**
- * Start host formatting for every connector instance's buffer
+ * Calculate the SUM or AVERAGE of a dimension, for any timeframe
  *
- * @param engine an engine data structure.
- * @param host a data collecting host.
+ * May return NAN if the database does not have any value in the give timeframe.
+ *
+ * @param instance an instance data structure.
+ * @param rd a dimension(metric) in the Netdata database.
+ * @param last_timestamp the timestamp that should be reported to the exporting connector instance.
+ * @return Returns the value, calculated over the given period.
  */
-void start_host_formatting(struct engine *engine, RRDHOST *host)
+NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
+    struct instance *instance,
+    RRDDIM *rd,
+    time_t *last_timestamp)
 {
-    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled) {
-            if (rrdhost_is_exportable(instance, host)) {
-                if (instance->start_host_formatting && instance->start_host_formatting(instance, host) != 0) {
-                    error("EXPORTING: cannot start host formatting for %s", instance->config.name);
-                    disable_instance(instance);
-                }
-            } else {
-                instance->skip_host = 1;
-            }
-        }
-    }
+    // the prometheus web exporter has no engine, and each of its clients asks for a different timeframe
+    if (instance->engine && instance->engine->config.collection_tap)
+        return exporting_read_collection_tap(instance, rd, last_timestamp);
+
+    return exporting_query_stored_data(instance, rd, last_timestamp);
 }
 
 /**
- * Start chart formatting for every connector instance's buffer
+ * Take a snapshot of the hosts, charts and dimensions to export
+ *
+ * The snapshot is shared read-only by all connector instances formatting their buffers in this iteration. Charts and
+ * dimensions are acquired, so that they cannot be freed while they are formatted. Hosts are protected by the rrd
+ * lock, which is held until all instances finish formatting.
  *
  * @param engine an engine data structure.
- * @param st a chart.
  */
-void start_chart_formatting(struct engine *engine, RRDSET *st)
+static void exporting_snapshot_take(struct engine *engine)
 {
-    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled && !instance->skip_host) {
-            if (rrdset_is_exportable(instance, st)) {
-                if (instance->start_chart_formatting && instance->start_chart_formatting(instance, st) != 0) {
-                    error("EXPORTING: cannot start chart formatting for %s", instance->config.name);
-                    disable_instance(instance);
+    struct exporting_snapshot *snapshot = &engine->snapshot;
+
+    snapshot->hosts_used = 0;
+    snapshot->charts_used = 0;
+    snapshot->dimensions_used = 0;
+
+    RRDHOST *host;
+    rrdhost_foreach_read(host) {
+        // allocate the per instance flags here, so that the formatting threads do not race to allocate them
+        if (unlikely(!host->exporting_flags))
+            host->exporting_flags = callocz(engine->instance_num, sizeof(size_t));
+
+        if (unlikely(snapshot->hosts_used == snapshot->hosts_size)) {
+            snapshot->hosts_size = snapshot->hosts_size ? snapshot->hosts_size * 2 : 16;
+            snapshot->hosts = reallocz(snapshot->hosts, snapshot->hosts_size * sizeof(struct exporting_snapshot_host));
+        }
+
+        struct exporting_snapshot_host *h = &snapshot->hosts[snapshot->hosts_used++];
+        h->host = host;
+        h->charts_start = snapshot->charts_used;
+
+        RRDSET *st;
+        rrdset_foreach_read(st, host) {
+            if (unlikely(!st->exporting_flags))
+                st->exporting_flags = callocz(engine->instance_num, sizeof(size_t));
+
+            if (unlikely(snapshot->charts_used == snapshot->charts_size)) {
+                snapshot->charts_size = snapshot->charts_size ? snapshot->charts_size * 2 : 1024;
+                snapshot->charts =
+                    reallocz(snapshot->charts, snapshot->charts_size * sizeof(struct exporting_snapshot_chart));
+            }
+
+            struct exporting_snapshot_chart *c = &snapshot->charts[snapshot->charts_used++];
+            c->st = st;
+            c->item = dictionary_acquired_item_dup(host->rrdset_root_index, st_dfe.item);
+            c->dimensions_start = snapshot->dimensions_used;
+
+            RRDDIM *rd;
+            rrddim_foreach_read(rd, st) {
+                if (unlikely(snapshot->dimensions_used == snapshot->dimensions_size)) {
+                    snapshot->dimensions_size = snapshot->dimensions_size ? snapshot->dimensions_size * 2 : 16384;
+                    snapshot->dimensions = reallocz(
+                        snapshot->dimensions, snapshot->dimensions_size * sizeof(struct exporting_snapshot_dimension));
                 }
-            } else {
-                instance->skip_chart = 1;
+
+                struct exporting_snapshot_dimension *d = &snapshot->dimensions[snapshot->dimensions_used++];
+                d->rd = rd;
+                d->item = dictionary_acquired_item_dup(st->rrddim_root_index, rd_dfe.item);
             }
+            rrddim_foreach_done(rd);
+
+            c->dimensions_end = snapshot->dimensions_used;
         }
+        rrdset_foreach_done(st);
+
+        h->charts_end = snapshot->charts_used;
     }
 }
 
 /**
- * Format metric for every connector instance's buffer
+ * Release the charts and dimensions acquired by a snapshot
+ *
+ * The memory of the snapshot is kept, to be reused in the next iteration.
  *
  * @param engine an engine data structure.
- * @param rd a dimension(metric) in the Netdata database.
  */
-void metric_formatting(struct engine *engine, RRDDIM *rd)
+static void exporting_snapshot_release(struct engine *engine)
 {
-    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled && !instance->skip_host && !instance->skip_chart) {
-            if (instance->metric_formatting && instance->metric_formatting(instance, rd) != 0) {
-                error("EXPORTING: cannot format metric for %s", instance->config.name);
-                disable_instance(instance);
-                continue;
-            }
-            instance->stats.buffered_metrics++;
-        }
+    struct exporting_snapshot *snapshot = &engine->snapshot;
+
+    for (size_t c = 0; c < snapshot->charts_used; c++) {
+        struct exporting_snapshot_chart *chart = &snapshot->charts[c];
+
+        for (size_t d = chart->dimensions_start; d < chart->dimensions_end; d++)
+            dictionary_acquired_item_release(chart->st->rrddim_root_index, snapshot->dimensions[d].item);
+
+        dictionary_acquired_item_release(chart->st->rrdhost->rrdset_root_index, chart->item);
     }
+
+    snapshot->hosts_used = 0;
+    snapshot->charts_used = 0;
+    snapshot->dimensions_used = 0;
 }
 
 /**
- * End chart formatting for every connector instance's buffer
+ * Free the memory of a snapshot
+ *
+ * @param snapshot the snapshot to free.
+ */
+void exporting_snapshot_free(struct exporting_snapshot *snapshot)
+{
+    freez(snapshot->hosts);
+    freez(snapshot->charts);
+    freez(snapshot->dimensions);
+    memset(snapshot, 0, sizeof(struct exporting_snapshot));
+}
+
+/**
+ * Format the buffer of a connector instance
+ *
+ * Walk through the snapshot and fill the buffer of the instance according to its configured rules. When the buffer
+ * is ready, the instance worker is signaled to send it, without waiting for the rest of the instances.
  *
  * @param engine an engine data structure.
- * @param a chart.
+ * @param instance an instance data structure.
  */
-void end_chart_formatting(struct engine *engine, RRDSET *st)
+static void format_instance(struct engine *engine, struct instance *instance)
 {
-    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled && !instance->skip_host && !instance->skip_chart) {
+    struct exporting_snapshot *snapshot = &engine->snapshot;
+    struct stats *stats = &instance->stats;
+
+    // the rrd lock is held here, so we cannot wait for a worker that has taken the buffer again since
+    // wait_for_instances(); the instance is skipped and its next batch covers this interval too
+    if (uv_mutex_trylock(&instance->mutex)) {
+        debug(D_EXPORTING, "EXPORTING: skipping instance %s, because its buffer is busy", instance->config.name);
+        instance->scheduled = 0;
+        return;
+    }
+    usec_t formatting_started_ut = now_monotonic_usec();
+
+    if (instance->start_batch_formatting && instance->start_batch_formatting(instance) != 0) {
+        error("EXPORTING: cannot start batch formatting for %s", instance->config.name);
+        disable_instance(instance);
+        return;
+    }
+
+    for (size_t h = 0; h < snapshot->hosts_used; h++) {
+        RRDHOST *host = snapshot->hosts[h].host;
+
+        if (!rrdhost_is_exportable(instance, host))
+            continue;
+
+        if (instance->start_host_formatting && instance->start_host_formatting(instance, host) != 0) {
+            error("EXPORTING: cannot start host formatting for %s", instance->config.name);
+            disable_instance(instance);
+            return;
+        }
+
+        for (size_t c = snapshot->hosts[h].charts_start; c < snapshot->hosts[h].charts_end; c++) {
+            RRDSET *st = snapshot->charts[c].st;
+
+            if (!rrdset_is_exportable(instance, st))
+                continue;
+
+            if (instance->start_chart_formatting && instance->start_chart_formatting(instance, st) != 0) {
+                error("EXPORTING: cannot start chart formatting for %s", instance->config.name);
+                disable_instance(instance);
+                return;
+            }
+
+            for (size_t d = snapshot->charts[c].dimensions_start; d < snapshot->charts[c].dimensions_end; d++) {
+                if (instance->metric_formatting &&
+                    instance->metric_formatting(instance, snapshot->dimensions[d].rd) != 0) {
+                    error("EXPORTING: cannot format metric for %s", instance->config.name);
+                    disable_instance(instance);
+                    return;
+                }
+                stats->buffered_metrics++;
+            }
+
             if (instance->end_chart_formatting && instance->end_chart_formatting(instance, st) != 0) {
                 error("EXPORTING: cannot end chart formatting for %s", instance->config.name);
                 disable_instance(instance);
-                continue;
+                return;
             }
         }
-        instance->skip_chart = 0;
+
+        if (should_send_variables(instance)) {
+            if (instance->variables_formatting && instance->variables_formatting(instance, host) != 0) {
+                error("EXPORTING: cannot format variables for %s", instance->config.name);
+                disable_instance(instance);
+                return;
+            }
+            // sum all variables as one metrics
+            stats->buffered_metrics++;
+        }
+
+        if (instance->end_host_formatting && instance->end_host_formatting(instance, host) != 0) {
+            error("EXPORTING: cannot end host formatting for %s", instance->config.name);
+            disable_instance(instance);
+            return;
+        }
+    }
+
+    if (instance->end_batch_formatting && instance->end_batch_formatting(instance) != 0) {
+        error("EXPORTING: cannot end batch formatting for %s", instance->config.name);
+        disable_instance(instance);
+        return;
     }
+
+    stats->formatting_time += (collected_number)(now_monotonic_usec() - formatting_started_ut);
+
+    uv_mutex_unlock(&instance->mutex);
+    instance->data_is_ready = 1;
+    uv_cond_signal(&instance->cond_var);
+
+    instance->scheduled = 0;
+    instance->after = instance->before;
 }
 
 /**
- * Format variables for every connector instance's buffer
+ * Pick the next scheduled instance of this iteration
+ *
+ * Should be called with the formatting mutex locked.
  *
  * @param engine an engine data structure.
- * @param host a data collecting host.
-  */
-void variables_formatting(struct engine *engine, RRDHOST *host)
+ * @return Returns the instance to format, or NULL when there are no more instances to format.
+ */
+static struct instance *next_formatting_instance(struct engine *engine)
 {
-    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled && !instance->skip_host && should_send_variables(instance)) {
-            if (instance->variables_formatting && instance->variables_formatting(instance, host) != 0){ 
-                error("EXPORTING: cannot format variables for %s", instance->config.name);
-                disable_instance(instance);
-                continue;
-            }
-            // sum all variables as one metrics
-            instance->stats.buffered_metrics++;
-        }
+    struct instance *instance = engine->formatting_next;
+
+    while (instance && !instance->scheduled)
+        instance = instance->next;
+
+    engine->formatting_next = instance ? instance->next : NULL;
+
+    return instance;
+}
+
+/**
+ * Format instances until all the instances of this iteration have been picked
+ *
+ * Runs on the main exporting thread and on all the formatting threads.
+ *
+ * @param engine an engine data structure.
+ */
+static void format_instances(struct engine *engine)
+{
+    uv_mutex_lock(&engine->formatting_mutex);
+
+    struct instance *instance;
+    while ((instance = next_formatting_instance(engine))) {
+        uv_mutex_unlock(&engine->formatting_mutex);
+
+        format_instance(engine, instance);
+
+        uv_mutex_lock(&engine->formatting_mutex);
+        if (!--engine->formatting_pending)
+            uv_cond_signal(&engine->formatting_done_cond);
     }
+
+    uv_mutex_unlock(&engine->formatting_mutex);
 }
 
 /**
- * End host formatting for every connector instance's buffer
+ * Formatting thread
+ *
+ * Waits for the main exporting thread to take a snapshot and formats the buffers of the scheduled instances.
+ *
+ * @param engine_p an engine data structure.
+ */
+static void formatting_thread(void *engine_p)
+{
+    struct engine *engine = (struct engine *)engine_p;
+    size_t iteration = 0;
+
+    while (1) {
+        uv_mutex_lock(&engine->formatting_mutex);
+        while (!engine->exit && engine->formatting_iteration == iteration)
+            uv_cond_wait(&engine->formatting_cond, &engine->formatting_mutex);
+        iteration = engine->formatting_iteration;
+        uv_mutex_unlock(&engine->formatting_mutex);
+
+        if (unlikely(engine->exit))
+            break;
+
+        format_instances(engine);
+    }
+}
+
+/**
+ * Start the formatting threads
+ *
+ * The main exporting thread formats buffers too, so one thread less than configured is started.
  *
  * @param engine an engine data structure.
- * @param host a data collecting host.
+ * @return Returns 0 on success, 1 on failure.
  */
-void end_host_formatting(struct engine *engine, RRDHOST *host)
+int init_formatting_threads(struct engine *engine)
 {
-    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled && !instance->skip_host) {
-            if (instance->end_host_formatting && instance->end_host_formatting(instance, host) != 0) {
-                error("EXPORTING: cannot end host formatting for %s", instance->config.name);
-                disable_instance(instance);
-                continue;
-            }
+    size_t threads = engine->config.formatting_threads;
+
+    if (!threads) {
+        long cpus = get_system_cpus();
+        threads = MIN(engine->instance_num, (size_t)(cpus > 0 ? cpus : 1));
+    }
+
+    if (threads <= 1)
+        return 0;
+
+    if (uv_mutex_init(&engine->formatting_mutex) || uv_cond_init(&engine->formatting_cond) ||
+        uv_cond_init(&engine->formatting_done_cond)) {
+        error("EXPORTING: cannot initialize the formatting threads synchronization");
+        return 1;
+    }
+
+    engine->formatters = callocz(threads - 1, sizeof(uv_thread_t));
+
+    for (size_t i = 0; i < threads - 1; i++) {
+        int error = uv_thread_create(&engine->formatters[i], formatting_thread, engine);
+        if (error) {
+            error("EXPORTING: cannot create formatting thread. uv_thread_create(): %s", uv_strerror(error));
+            return 1;
         }
-        instance->skip_host = 0;
+        engine->formatting_threads++;
+
+        char threadname[NETDATA_THREAD_NAME_MAX + 1];
+        snprintfz(threadname, NETDATA_THREAD_NAME_MAX, "EXPORTING-FMT%zu", i);
+        uv_thread_set_name_np(engine->formatters[i], threadname);
     }
+
+    info("EXPORTING: formatting buffers with %zu threads", engine->formatting_threads + 1);
+
+    return 0;
+}
+
+/**
+ * Stop the formatting threads
+ *
+ * Should be called after engine->exit is set.
+ *
+ * @param engine an engine data structure.
+ */
+void stop_formatting_threads(struct engine *engine)
+{
+    if (!engine->formatting_threads)
+        return;
+
+    uv_mutex_lock(&engine->formatting_mutex);
+    uv_cond_broadcast(&engine->formatting_cond);
+    uv_mutex_unlock(&engine->formatting_mutex);
+
+    for (size_t i = 0; i < engine->formatting_threads; i++)
+        uv_thread_join(&engine->formatters[i]);
+
+    freez(engine->formatters);
+    engine->formatters = NULL;
+    engine->formatting_threads = 0;
 }
 
 /**
- * End batch formatting for every connector instance's buffer
+ * Wait for the workers of the scheduled instances to release their buffers
+ *
+ * The instance worker holds the mutex while it is using the buffer, so the time we wait for it is the backpressure of
+ * the connector. We wait before taking the rrd lock, so that a slow connector cannot block data collection.
  *
  * @param engine an engine data structure.
  */
-void end_batch_formatting(struct engine *engine)
+static void wait_for_instances(struct engine *engine)
 {
     for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
-        if (instance->scheduled) {
-            if (instance->end_batch_formatting && instance->end_batch_formatting(instance) != 0) {
-                error("EXPORTING: cannot end batch formatting for %s", instance->config.name);
-                disable_instance(instance);
-                continue;
-            }
-            uv_mutex_unlock(&instance->mutex);
-            instance->data_is_ready = 1;
-            uv_cond_signal(&instance->cond_var);
+        if (!instance->scheduled)
+            continue;
 
-            instance->scheduled = 0;
-            instance->after = instance->before;
-        }
+        usec_t wait_started_ut = now_monotonic_usec();
+        uv_mutex_lock(&instance->mutex);
+        instance->stats.formatting_wait_time += (collected_number)(now_monotonic_usec() - wait_started_ut);
+        uv_mutex_unlock(&instance->mutex);
     }
 }
 
 /**
  * Prepare buffers
  *
- * Walk through the Netdata database and fill buffers for every scheduled exporting connector instance according to
- * configured rules.
+ * Take a snapshot of the Netdata database and fill buffers for every scheduled exporting connector instance
+ * according to configured rules. Every instance formats its buffer independently, on the formatting threads.
  *
  * @param engine an engine data structure.
  */
 void prepare_buffers(struct engine *engine)
 {
     netdata_thread_disable_cancelability();
-    start_batch_formatting(engine);
 
-    rrd_rdlock();
-    RRDHOST *host;
-    rrdhost_foreach_read(host) {
-        start_host_formatting(engine, host);
-        RRDSET *st;
-        rrdset_foreach_read(st, host) {
-            start_chart_formatting(engine, st);
+    wait_for_instances(engine);
 
-            RRDDIM *rd;
-            rrddim_foreach_read(rd, st)
-                metric_formatting(engine, rd);
-            rrddim_foreach_done(rd);
+    // hosts are not reference counted, so the rrd lock is held until the formatting of all instances finishes
+    rrd_rdlock();
+    exporting_snapshot_take(engine);
 
-            end_chart_formatting(engine, st);
+    if (!engine->formatting_threads) {
+        for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
+            if (instance->scheduled)
+                format_instance(engine, instance);
         }
-        rrdset_foreach_done(st);
-        variables_formatting(engine, host);
-        end_host_formatting(engine, host);
+    } else {
+        uv_mutex_lock(&engine->formatting_mutex);
+        engine->formatting_pending = 0;
+        for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
+            if (instance->scheduled)
+                engine->formatting_pending++;
+        }
+        engine->formatting_next = engine->instance_root;
+        engine->formatting_iteration++;
+        uv_cond_broadcast(&engine->formatting_cond);
+        uv_mutex_unlock(&engine->formatting_mutex);
+
+        format_instances(engine);
+
+        // the snapshot and the hosts are used by the formatting threads until they finish
+        uv_mutex_lock(&engine->formatting_mutex);
+        while (engine->formatting_pending)
+            uv_cond_wait(&engine->formatting_done_cond, &engine->formatting_mutex);
+        uv_mutex_unlock(&engine->formatting_mutex);
     }
+
+    exporting_snapshot_release(engine);
     rrd_unlock();
-    netdata_thread_enable_cancelability();
 
-    end_batch_formatting(engine);
+    netdata_thread_enable_cancelability();
 }
 
 /**
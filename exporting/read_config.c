@@ -157,8 +157,10 @@ EXPORTING_CONNECTOR_TYPE exporting_select_type(const char *type)
         return EXPORTING_CONNECTOR_TYPE_KINESIS;
     } else if (!strcmp(type, "pubsub") || !strcmp(type, "pubsub:plaintext")) {
         return EXPORTING_CONNECTOR_TYPE_PUBSUB;
-    } else if (!strcmp(type, "mongodb") || !strcmp(type, "mongodb:plaintext"))
+    } else if (!strcmp(type, "mongodb") || !strcmp(type, "mongodb:plaintext")) {
         return EXPORTING_CONNECTOR_TYPE_MONGODB;
+    } else if (!strcmp(type, "mmap"))
+        return EXPORTING_CONNECTOR_TYPE_MMAP;
 
     return EXPORTING_CONNECTOR_TYPE_UNKNOWN;
 }
@@ -306,12 +308,16 @@ struct engine *read_exporting_config()
             strdupz(exporter_get(CONFIG_SECTION_EXPORTING, "hostname", netdata_configured_hostname));
         engine->config.update_every = exporter_get_number(
             CONFIG_SECTION_EXPORTING, EXPORTING_UPDATE_EVERY_OPTION_NAME, EXPORTING_UPDATE_EVERY_DEFAULT);
+        engine->config.collection_tap = exporter_get_boolean(CONFIG_SECTION_EXPORTING, "collection tap", CONFIG_BOOLEAN_NO);
+        engine->config.formatting_threads =
+            (size_t)exporter_get_number(CONFIG_SECTION_EXPORTING, "formatting threads", 0);
     }
 
     while (tmp_ci_list) {
         struct instance *tmp_instance;
         char *instance_name;
         char *default_destination = "localhost";
+        char default_filename[FILENAME_MAX + 1];
 
         info("Instance %s on %s", tmp_ci_list->local_ci.instance_name, tmp_ci_list->local_ci.connector_name);
 
@@ -454,6 +460,22 @@ struct engine *read_exporting_config()
                 instance_name, "collection", ""));
         }
 
+        if (tmp_instance->config.type == EXPORTING_CONNECTOR_TYPE_MMAP) {
+            struct mmap_specific_config *connector_specific_config =
+                callocz(1, sizeof(struct mmap_specific_config));
+
+            snprintfz(
+                default_filename, FILENAME_MAX, "%s/exporting-%s.mmap", netdata_configured_cache_dir, instance_name);
+            default_destination = default_filename;
+
+            tmp_instance->config.connector_specific_config = connector_specific_config;
+
+            connector_specific_config->rows = (uint32_t)exporter_get_number(instance_name, "history", 360);
+
+            char *mode = exporter_get(instance_name, "file mode", "0640");
+            connector_specific_config->mode = (mode_t)strtoul(mode, NULL, 8);
+        }
+
         tmp_instance->config.destination = strdupz(exporter_get(instance_name, "destination", default_destination));
 
         tmp_instance->config.username = strdupz(exporter_get(instance_name, "username", ""));
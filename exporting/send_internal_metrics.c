@@ -121,6 +121,18 @@ void send_internal_metrics(struct instance *instance)
         stats->rd_user   = rrddim_add(stats->st_rusage, "user", NULL, 1, 1000, RRD_ALGORITHM_INCREMENTAL);
         stats->rd_system = rrddim_add(stats->st_rusage, "system", NULL, 1, 1000, RRD_ALGORITHM_INCREMENTAL);
 
+        // ------------------------------------------------------------------------
+
+        snprintf(id, RRD_ID_LENGTH_MAX, "exporting_%s_formatting", instance->config.name);
+        netdata_fix_chart_id(id);
+
+        stats->st_formatting = rrdset_create_localhost(
+            "netdata", id, NULL, buffer_tostring(family), "exporting_formatting", "Netdata Exporting Instance Formatting Time",
+            "milliseconds/s", "exporting", NULL, 130650, instance->config.update_every, RRDSET_TYPE_STACKED);
+
+        stats->rd_formatting      = rrddim_add(stats->st_formatting, "formatting", NULL, 1, 1000, RRD_ALGORITHM_INCREMENTAL);
+        stats->rd_formatting_wait = rrddim_add(stats->st_formatting, "waiting", NULL, 1, 1000, RRD_ALGORITHM_INCREMENTAL);
+
         buffer_free(family);
 
         stats->initialized = 1;
@@ -153,4 +165,8 @@ void send_internal_metrics(struct instance *instance)
     rrddim_set_by_pointer(stats->st_rusage, stats->rd_user,   thread.ru_utime.tv_sec * 1000000ULL + thread.ru_utime.tv_usec);
     rrddim_set_by_pointer(stats->st_rusage, stats->rd_system, thread.ru_stime.tv_sec * 1000000ULL + thread.ru_stime.tv_usec);
     rrdset_done(stats->st_rusage);
+
+    rrddim_set_by_pointer(stats->st_formatting, stats->rd_formatting,      stats->formatting_time);
+    rrddim_set_by_pointer(stats->st_formatting, stats->rd_formatting_wait, stats->formatting_wait_time);
+    rrdset_done(stats->st_formatting);
 }
@@ -2,34 +2,60 @@
 
 #include "test_exporting_engine.h"
 
-void __wrap_uv_thread_create(uv_thread_t thread, void (*worker)(void *arg), void *arg)
+// When set, the libuv doubles call the real functions, so that tests can run threads. CMocka expectations are not
+// thread safe, so the doubles that threads call do not check any while it is set.
+int real_threads = 0;
+
+int __real_uv_thread_create(uv_thread_t *thread, void (*worker)(void *arg), void *arg);
+int __wrap_uv_thread_create(uv_thread_t *thread, void (*worker)(void *arg), void *arg)
 {
+    if (real_threads)
+        return __real_uv_thread_create(thread, worker, arg);
+
     function_called();
 
     check_expected_ptr(thread);
     check_expected_ptr(worker);
     check_expected_ptr(arg);
+
+    return 0;
 }
 
+void __real_uv_mutex_lock(uv_mutex_t *mutex);
 void __wrap_uv_mutex_lock(uv_mutex_t *mutex)
 {
-    (void)mutex;
+    if (real_threads)
+        __real_uv_mutex_lock(mutex);
 }
 
+void __real_uv_mutex_unlock(uv_mutex_t *mutex);
 void __wrap_uv_mutex_unlock(uv_mutex_t *mutex)
 {
-    (void)mutex;
+    if (real_threads)
+        __real_uv_mutex_unlock(mutex);
+}
+
+int __real_uv_mutex_trylock(uv_mutex_t *mutex);
+int __wrap_uv_mutex_trylock(uv_mutex_t *mutex)
+{
+    if (real_threads)
+        return __real_uv_mutex_trylock(mutex);
+
+    return 0;
 }
 
+void __real_uv_cond_signal(uv_cond_t *cond_var);
 void __wrap_uv_cond_signal(uv_cond_t *cond_var)
 {
-    (void)cond_var;
+    if (real_threads)
+        __real_uv_cond_signal(cond_var);
 }
 
+void __real_uv_cond_wait(uv_cond_t *cond_var, uv_mutex_t *mutex);
 void __wrap_uv_cond_wait(uv_cond_t *cond_var, uv_mutex_t *mutex)
 {
-    (void)cond_var;
-    (void)mutex;
+    if (real_threads)
+        __real_uv_cond_wait(cond_var, mutex);
 }
 
 ssize_t __wrap_recv(int sockfd, void *buf, size_t len, int flags)
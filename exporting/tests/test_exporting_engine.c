@@ -10,6 +10,7 @@ netdata_rwlock_t rrd_rwlock;
 struct config netdata_config;
 char *netdata_configured_user_config_dir = ".";
 char *netdata_configured_stock_config_dir = ".";
+char *netdata_configured_cache_dir = ".";
 char *netdata_configured_hostname = "test_global_host";
 bool global_statistics_enabled = true;
 
@@ -337,6 +338,71 @@ static void test_exporting_calculate_value_from_stored_data(void **state)
     assert_float_equal(__real_exporting_calculate_value_from_stored_data(instance, rd, &timestamp), 36, 0.1);
 }
 
+static void test_exporting_calculate_value_from_collection_tap(void **state)
+{
+    struct engine *engine = *state;
+    struct instance *instance = engine->instance_root;
+
+    RRDSET *st;
+    rrdset_foreach_read(st, localhost);
+        break;
+    rrdset_foreach_done(st);
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st);
+        break;
+    rrddim_foreach_done(rd);
+
+    time_t timestamp;
+
+    engine->config.collection_tap = 1;
+    instance->after = 3;
+    instance->before = 10;
+
+    // the first time, the tap is created and the database is queried
+    expect_function_call(__mock_rrddim_query_oldest_time);
+    will_return(__mock_rrddim_query_oldest_time, 1);
+
+    expect_function_call(__mock_rrddim_query_latest_time);
+    will_return(__mock_rrddim_query_latest_time, 2);
+
+    expect_function_call(__mock_rrddim_query_init);
+    expect_value(__mock_rrddim_query_init, start_time, 1);
+    expect_value(__mock_rrddim_query_init, end_time, 2);
+
+    expect_function_call(__mock_rrddim_query_is_finished);
+    will_return(__mock_rrddim_query_is_finished, 0);
+    expect_function_call(__mock_rrddim_query_next_metric);
+
+    expect_function_call(__mock_rrddim_query_is_finished);
+    will_return(__mock_rrddim_query_is_finished, 0);
+    expect_function_call(__mock_rrddim_query_next_metric);
+
+    expect_function_call(__mock_rrddim_query_is_finished);
+    will_return(__mock_rrddim_query_is_finished, 1);
+
+    expect_function_call(__mock_rrddim_query_finalize);
+
+    assert_float_equal(__real_exporting_calculate_value_from_stored_data(instance, rd, &timestamp), 36, 0.1);
+    assert_ptr_not_equal(rd->exporting_tap, NULL);
+
+    // then, only the values stored since the last read are used, without any queries
+    assert_true(isnan(__real_exporting_calculate_value_from_stored_data(instance, rd, &timestamp)));
+
+    rrddim_exporting_tap_store(rd, 10, 4);
+    rrddim_exporting_tap_store(rd, NAN, 5);
+    rrddim_exporting_tap_store(rd, 20, 6);
+
+    assert_float_equal(__real_exporting_calculate_value_from_stored_data(instance, rd, &timestamp), 15, 0.1);
+    assert_int_equal(timestamp, 6);
+
+    assert_true(isnan(__real_exporting_calculate_value_from_stored_data(instance, rd, &timestamp)));
+
+    freez(rd->exporting_tap);
+    rd->exporting_tap = NULL;
+    engine->config.collection_tap = 0;
+}
+
 static void test_prepare_buffers(void **state)
 {
     struct engine *engine = *state;
@@ -421,6 +487,92 @@ static void test_prepare_buffers(void **state)
     assert_int_equal(instance->after, 2);
 }
 
+static void format_scheduled_instances(struct engine *engine)
+{
+    for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
+        BUFFER *buffer = instance->buffer;
+        instance->scheduled = 1;
+        buffer_flush(buffer);
+    }
+
+    __real_prepare_buffers(engine);
+}
+
+static void test_prepare_buffers_in_parallel(void **state)
+{
+    struct engine *engine = *state;
+
+    // an instance of every plaintext connector, formatting its buffer from the same snapshot
+    int (*init_instance[])(struct instance *instance) = {
+        init_json_instance, init_opentsdb_telnet_instance, init_opentsdb_http_instance };
+    EXPORTING_CONNECTOR_TYPE types[] = {
+        EXPORTING_CONNECTOR_TYPE_JSON, EXPORTING_CONNECTOR_TYPE_OPENTSDB, EXPORTING_CONNECTOR_TYPE_OPENTSDB_HTTP };
+    const size_t instances_num = 4;
+
+    struct instance *instances[instances_num];
+    instances[0] = engine->instance_root;
+    instances[0]->config.options |= EXPORTING_OPTION_SEND_CONFIGURED_LABELS;
+
+    for (size_t i = 1; i < instances_num; i++) {
+        struct instance *instance = calloc(1, sizeof(struct instance));
+        instance->engine = engine;
+        instance->index = i;
+        instance->config = instances[0]->config;
+        instance->config.type = types[i - 1];
+        assert_int_equal(init_instance[i - 1](instance), 0);
+
+        instances[i - 1]->next = instance;
+        instances[i] = instance;
+    }
+    engine->instance_num = instances_num;
+
+    // keep the formatted metrics in the buffers of the instances
+    for (size_t i = 0; i < instances_num; i++)
+        instances[i]->end_batch_formatting = NULL;
+
+    real_threads = 1;
+
+    // the buffers formatted by the exporting thread alone, one instance after the other
+    format_scheduled_instances(engine);
+
+    BUFFER *expected[instances_num];
+    for (size_t i = 0; i < instances_num; i++) {
+        BUFFER *buffer = instances[i]->buffer;
+        assert_int_not_equal(buffer_strlen(buffer), 0);
+        expected[i] = buffer_create(0);
+        buffer_strcat(expected[i], buffer_tostring(buffer));
+    }
+
+    engine->config.formatting_threads = instances_num;
+    expect_function_call(__wrap_info_int);
+    assert_int_equal(init_formatting_threads(engine), 0);
+    assert_int_equal(engine->formatting_threads, instances_num - 1);
+
+    for (size_t iteration = 0; iteration < 1000; iteration++) {
+        format_scheduled_instances(engine);
+
+        for (size_t i = 0; i < instances_num; i++) {
+            BUFFER *buffer = instances[i]->buffer;
+            assert_int_equal(instances[i]->scheduled, 0);
+            assert_string_equal(buffer_tostring(buffer), buffer_tostring(expected[i]));
+        }
+    }
+
+    engine->exit = 1;
+    stop_formatting_threads(engine);
+    real_threads = 0;
+
+    for (size_t i = 0; i < instances_num; i++)
+        buffer_free(expected[i]);
+
+    for (size_t i = 1; i < instances_num; i++) {
+        buffer_free(instances[i]->labels_buffer);
+        buffer_free(instances[i]->buffer);
+        free(instances[i]);
+    }
+    instances[0]->next = NULL;
+}
+
 static void test_exporting_name_copy(void **state)
 {
     (void)state;
@@ -904,6 +1056,8 @@ static void test_send_internal_metrics(void **state)
     stats->st_ops->counter_done = 1;
     stats->st_rusage = calloc(1, sizeof(RRDSET));
     stats->st_rusage->counter_done = 1;
+    stats->st_formatting = calloc(1, sizeof(RRDSET));
+    stats->st_formatting->counter_done = 1;
 
     // ------------------------------------------------------------------------
 
@@ -1003,6 +1157,30 @@ static void test_send_internal_metrics(void **state)
 
     // ------------------------------------------------------------------------
 
+    expect_function_call(rrdset_create_custom);
+    expect_value(rrdset_create_custom, host, localhost);
+    expect_string(rrdset_create_custom, type, "netdata");
+    expect_string(rrdset_create_custom, id, "exporting_test_instance_formatting");
+    expect_value(rrdset_create_custom, name, NULL);
+    expect_string(rrdset_create_custom, family, "exporting_test_instance");
+    expect_string(rrdset_create_custom, context, "exporting_formatting");
+    expect_string(rrdset_create_custom, units, "milliseconds/s");
+    expect_string(rrdset_create_custom, plugin, "exporting");
+    expect_value(rrdset_create_custom, module, NULL);
+    expect_value(rrdset_create_custom, priority, 130650);
+    expect_value(rrdset_create_custom, update_every, 2);
+    expect_value(rrdset_create_custom, chart_type, RRDSET_TYPE_STACKED);
+    will_return(rrdset_create_custom, stats->st_formatting);
+
+    expect_function_calls(rrddim_add_custom, 2);
+    expect_value_count(rrddim_add_custom, st, stats->st_formatting, 2);
+    expect_value_count(rrddim_add_custom, name, NULL, 2);
+    expect_value_count(rrddim_add_custom, multiplier, 1, 2);
+    expect_value_count(rrddim_add_custom, divisor, 1000, 2);
+    expect_value_count(rrddim_add_custom, algorithm, RRD_ALGORITHM_INCREMENTAL, 2);
+
+    // ------------------------------------------------------------------------
+
     expect_function_call(rrdset_next_usec);
     expect_value(rrdset_next_usec, st, stats->st_metrics);
 
@@ -1047,12 +1225,24 @@ static void test_send_internal_metrics(void **state)
 
     // ------------------------------------------------------------------------
 
+    expect_function_call(rrdset_next_usec);
+    expect_value(rrdset_next_usec, st, stats->st_formatting);
+
+    expect_function_calls(rrddim_set_by_pointer, 2);
+    expect_value_count(rrddim_set_by_pointer, st, stats->st_formatting, 2);
+
+    expect_function_call(rrdset_done);
+    expect_value(rrdset_done, st, stats->st_formatting);
+
+    // ------------------------------------------------------------------------
+
     __real_send_internal_metrics(instance);
 
     free(stats->st_metrics);
     free(stats->st_bytes);
     free(stats->st_ops);
     free(stats->st_rusage);
+    free(stats->st_formatting);
     free((void *)instance->config.name);
     free(instance);
 }
@@ -1195,6 +1385,229 @@ static void rrd_stats_api_v1_charts_allmetrics_prometheus(void **state)
     buffer_free(buffer);
 }
 
+static void test_init_mmap_instance(void **state)
+{
+    struct engine *engine = *state;
+    struct instance *instance = engine->instance_root;
+
+    struct mmap_specific_config *connector_specific_config = callocz(1, sizeof(struct mmap_specific_config));
+    instance->config.connector_specific_config = connector_specific_config;
+    connector_specific_config->rows = 1;
+    connector_specific_config->mode = 0600;
+
+    assert_int_equal(init_mmap_instance(instance), 0);
+    assert_int_equal(connector_specific_config->rows, 2);
+
+    assert_ptr_equal(instance->worker, mmap_connector_worker);
+    assert_ptr_equal(instance->start_batch_formatting, start_batch_mmap);
+    assert_ptr_equal(instance->metric_formatting, format_dimension_mmap);
+    assert_ptr_equal(instance->end_batch_formatting, format_batch_mmap);
+
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+    assert_ptr_not_equal(connector_specific_data->metrics, NULL);
+    assert_int_equal(connector_specific_data->fd, -1);
+    assert_ptr_equal(connector_specific_data->map, NULL);
+
+    dictionary_destroy(connector_specific_data->metrics);
+    freez(connector_specific_data);
+    freez(connector_specific_config);
+}
+
+static void test_format_batch_mmap(void **state)
+{
+    struct engine *engine = *state;
+    struct instance *instance = engine->instance_root;
+
+    free((void *)instance->config.destination);
+    instance->config.destination = strdupz("test_exporting.mmap");
+
+    struct mmap_specific_config *connector_specific_config = callocz(1, sizeof(struct mmap_specific_config));
+    instance->config.connector_specific_config = connector_specific_config;
+    connector_specific_config->rows = 3;
+    connector_specific_config->mode = 0600;
+
+    assert_int_equal(init_mmap_instance(instance), 0);
+
+    RRDSET *st;
+    rrdset_foreach_read(st, localhost);
+        break;
+    rrdset_foreach_done(st);
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st);
+        break;
+    rrddim_foreach_done(rd);
+
+    for (int batch = 0; batch < 4; batch++) {
+        rd->last_collected_value = batch;
+        instance->before = 15051 + batch;
+
+        assert_int_equal(start_batch_mmap(instance), 0);
+        assert_int_equal(format_dimension_mmap(instance, rd), 0);
+        assert_int_equal(format_batch_mmap(instance), 0);
+    }
+
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+    assert_false(connector_specific_data->failed);
+
+    struct netdata_mmap_header *header = connector_specific_data->header;
+    assert_memory_equal(header->magic, NETDATA_MMAP_MAGIC, NETDATA_MMAP_MAGIC_SIZE);
+    assert_int_equal(header->version, NETDATA_MMAP_VERSION);
+    assert_int_equal(header->sequence, 8);
+    assert_int_equal(header->obsolete, 0);
+    assert_int_equal(header->rows_written, 4);
+    assert_int_equal(header->rows, 3);
+    assert_int_equal(header->metrics, 1);
+
+    uint8_t *map = connector_specific_data->map;
+    struct netdata_mmap_metric *metric = (struct netdata_mmap_metric *)&map[header->metrics_offset];
+    const char *strings = (const char *)&map[header->strings_offset];
+    assert_string_equal(&strings[metric->host], "test-host");
+    assert_string_equal(&strings[metric->chart], "chart_name");
+    assert_string_equal(&strings[metric->dimension], "dimension_name");
+
+    // the last row has replaced the first one in the ring
+    int64_t *timestamps = (int64_t *)&map[header->timestamps_offset];
+    double *values = (double *)&map[header->values_offset];
+    assert_int_equal(timestamps[0], 15054);
+    assert_int_equal(timestamps[1], 15052);
+    assert_int_equal(timestamps[2], 15053);
+    assert_true(values[0] == 3);
+    assert_true(values[1] == 1);
+    assert_true(values[2] == 2);
+
+    struct stat statbuf;
+    assert_int_equal(stat("test_exporting.mmap", &statbuf), 0);
+    assert_int_equal(statbuf.st_mode & 0777, 0600);
+    assert_int_equal(statbuf.st_size, header->file_size);
+
+    munmap(connector_specific_data->map, connector_specific_data->map_size);
+    close(connector_specific_data->fd);
+    unlink("test_exporting.mmap");
+
+    dictionary_destroy(connector_specific_data->metrics);
+    freez(connector_specific_data);
+    freez(connector_specific_config);
+}
+
+static void test_read_mmap(void **state)
+{
+    struct engine *engine = *state;
+    struct instance *instance = engine->instance_root;
+
+    free((void *)instance->config.destination);
+    instance->config.destination = strdupz("test_exporting.mmap");
+
+    struct mmap_specific_config *connector_specific_config = callocz(1, sizeof(struct mmap_specific_config));
+    instance->config.connector_specific_config = connector_specific_config;
+    connector_specific_config->rows = 3;
+    connector_specific_config->mode = 0600;
+
+    assert_int_equal(init_mmap_instance(instance), 0);
+
+    RRDSET *st;
+    rrdset_foreach_read(st, localhost);
+        break;
+    rrdset_foreach_done(st);
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st);
+        break;
+    rrddim_foreach_done(rd);
+
+    RRDDIM rd2 = *rd;
+    rd2.id = string_strdupz("dimension_2");
+    rd2.name = string_dup(rd2.id);
+
+    int64_t timestamps[3];
+    double values[3];
+
+    // the first batch creates the file
+    rd->last_collected_value = 1;
+    instance->before = 15051;
+    assert_int_equal(start_batch_mmap(instance), 0);
+    assert_int_equal(format_dimension_mmap(instance, rd), 0);
+    assert_int_equal(format_batch_mmap(instance), 0);
+
+    NETDATA_MMAP_READER reader;
+    assert_int_equal(netdata_mmap_open(&reader, "test_exporting.mmap"), 0);
+    assert_int_equal(netdata_mmap_metrics(&reader), 1);
+    assert_int_equal(netdata_mmap_find_metric(&reader, NULL, "chart_name", "dimension_name"), 0);
+    assert_int_equal(netdata_mmap_read(&reader, 0, timestamps, values, 3), 1);
+    assert_int_equal(timestamps[0], 15051);
+    assert_true(values[0] == 1);
+
+    // a new metric rebuilds the file, keeping the rows of the first one
+    rd->last_collected_value = 2;
+    rd2.last_collected_value = 20;
+    instance->before = 15052;
+    assert_int_equal(start_batch_mmap(instance), 0);
+    assert_int_equal(format_dimension_mmap(instance, rd), 0);
+    assert_int_equal(format_dimension_mmap(instance, &rd2), 0);
+    assert_int_equal(format_batch_mmap(instance), 0);
+
+    assert_int_equal(netdata_mmap_refresh(&reader), 1);
+    assert_int_equal(netdata_mmap_metrics(&reader), 2);
+
+    int64_t metric = netdata_mmap_find_metric(&reader, "test-host", "chart_name", "dimension_name");
+    assert_true(metric >= 0);
+    assert_int_equal(netdata_mmap_read(&reader, metric, timestamps, values, 3), 2);
+    assert_int_equal(timestamps[0], 15051);
+    assert_int_equal(timestamps[1], 15052);
+    assert_true(values[0] == 1);
+    assert_true(values[1] == 2);
+
+    metric = netdata_mmap_find_metric(&reader, NULL, "chart_name", "dimension_2");
+    assert_true(metric >= 0);
+    assert_int_equal(netdata_mmap_read(&reader, metric, timestamps, values, 3), 2);
+    assert_true(isnan(values[0]));
+    assert_true(values[1] == 20);
+
+    // the first metric is dropped when it has not been exported for a whole ring
+    for (int batch = 3; batch <= 5; batch++) {
+        rd2.last_collected_value = batch * 10;
+        instance->before = 15050 + batch;
+        assert_int_equal(start_batch_mmap(instance), 0);
+        assert_int_equal(format_dimension_mmap(instance, &rd2), 0);
+        assert_int_equal(format_batch_mmap(instance), 0);
+
+        assert_int_equal(netdata_mmap_refresh(&reader), batch == 5 ? 1 : 0);
+    }
+
+    assert_int_equal(netdata_mmap_metrics(&reader), 1);
+    assert_int_equal(netdata_mmap_find_metric(&reader, NULL, "chart_name", "dimension_name"), -1);
+    metric = netdata_mmap_find_metric(&reader, NULL, "chart_name", "dimension_2");
+    assert_int_equal(metric, 0);
+    assert_int_equal(netdata_mmap_read(&reader, metric, timestamps, values, 3), 3);
+    assert_int_equal(timestamps[0], 15053);
+    assert_int_equal(timestamps[2], 15055);
+    assert_true(values[0] == 30);
+    assert_true(values[2] == 50);
+
+    // readers give up while the exporter is in the middle of an update
+    struct mmap_specific_data *connector_specific_data = instance->connector_specific_data;
+    connector_specific_data->header->sequence++;
+    errno = 0;
+    assert_int_equal(netdata_mmap_read(&reader, metric, timestamps, values, 3), -1);
+    assert_int_equal(errno, EAGAIN);
+    connector_specific_data->header->sequence++;
+    assert_int_equal(netdata_mmap_read(&reader, metric, timestamps, values, 1), 1);
+    assert_int_equal(timestamps[0], 15055);
+
+    netdata_mmap_close(&reader);
+
+    string_freez(rd2.id);
+    string_freez(rd2.name);
+
+    munmap(connector_specific_data->map, connector_specific_data->map_size);
+    close(connector_specific_data->fd);
+    unlink("test_exporting.mmap");
+
+    dictionary_destroy(connector_specific_data->metrics);
+    freez(connector_specific_data);
+    freez(connector_specific_config);
+}
+
 #if ENABLE_PROMETHEUS_REMOTE_WRITE
 static void test_init_prometheus_remote_write_instance(void **state)
 {
@@ -1943,7 +2356,11 @@ int main(void)
             test_false_rrdset_is_exportable, setup_initialized_engine, teardown_initialized_engine),
         cmocka_unit_test_setup_teardown(
             test_exporting_calculate_value_from_stored_data, setup_initialized_engine, teardown_initialized_engine),
+        cmocka_unit_test_setup_teardown(
+            test_exporting_calculate_value_from_collection_tap, setup_initialized_engine, teardown_initialized_engine),
         cmocka_unit_test_setup_teardown(test_prepare_buffers, setup_initialized_engine, teardown_initialized_engine),
+        cmocka_unit_test_setup_teardown(
+            test_prepare_buffers_in_parallel, setup_initialized_engine, teardown_initialized_engine),
         cmocka_unit_test(test_exporting_name_copy),
         cmocka_unit_test_setup_teardown(
             test_format_dimension_collected_graphite_plaintext, setup_initialized_engine, teardown_initialized_engine),
@@ -2010,6 +2427,14 @@ int main(void)
 
     test_res += cmocka_run_group_tests_name("prometheus_web_api", prometheus_web_api_tests, NULL, NULL);
 
+    const struct CMUnitTest mmap_tests[] = {
+        cmocka_unit_test_setup_teardown(test_init_mmap_instance, setup_configured_engine, teardown_configured_engine),
+        cmocka_unit_test_setup_teardown(test_format_batch_mmap, setup_initialized_engine, teardown_initialized_engine),
+        cmocka_unit_test_setup_teardown(test_read_mmap, setup_initialized_engine, teardown_initialized_engine),
+    };
+
+    test_res += cmocka_run_group_tests_name("mmap_exporting_connector", mmap_tests, NULL, NULL);
+
 #if ENABLE_PROMETHEUS_REMOTE_WRITE
     const struct CMUnitTest prometheus_remote_write_tests[] = {
         cmocka_unit_test_setup_teardown(
@@ -10,6 +10,8 @@
 #include "exporting/graphite/graphite.h"
 #include "exporting/json/json.h"
 #include "exporting/opentsdb/opentsdb.h"
+#include "exporting/mmap/mmap.h"
+#include "exporting/mmap/netdata_mmap_reader.h"
 
 #if ENABLE_PROMETHEUS_REMOTE_WRITE
 #include "exporting/prometheus/remote_write/remote_write.h"
@@ -65,9 +67,12 @@ void __mock_rrddim_query_finalize(struct rrddim_query_handle *handle);
 // -----------------------------------------------------------------------
 // wraps for system functions
 
-void __wrap_uv_thread_create(uv_thread_t thread, void (*worker)(void *arg), void *arg);
+extern int real_threads;
+
+int __wrap_uv_thread_create(uv_thread_t *thread, void (*worker)(void *arg), void *arg);
 void __wrap_uv_mutex_lock(uv_mutex_t *mutex);
 void __wrap_uv_mutex_unlock(uv_mutex_t *mutex);
+int __wrap_uv_mutex_trylock(uv_mutex_t *mutex);
 void __wrap_uv_cond_signal(uv_cond_t *cond_var);
 void __wrap_uv_cond_wait(uv_cond_t *cond_var, uv_mutex_t *mutex);
 ssize_t __wrap_recv(int sockfd, void *buf, size_t len, int flags);
@@ -33,6 +33,52 @@ typedef struct arrayalloc_page {
     struct arrayalloc_page *next; // the next page on the list
 } ARAL_PAGE;
 
+// ----------------------------------------------------------------------------
+// per thread magazines
+//
+// When an ARAL has magazine_elements, each thread keeps a stack of free
+// elements for it (a magazine). Allocations and frees are served by the
+// magazine without touching the ARAL spinlock. An empty magazine is refilled
+// with half its size under a single lock, and a full magazine returns half
+// its elements under a single lock.
+//
+// Elements are interchangeable, so an element allocated by one thread can be
+// freed by another; it just ends up in the magazine of the freeing thread.
+// When a thread exits, its magazines are returned to their ARALs.
+
+#define ARAL_MAX_MAGAZINE_SLOTS 64
+
+typedef struct aral_magazine {
+    ARAL *ar;                           // NULL when the ARAL has been destroyed
+    void *elements;                     // the free elements, linked via their first pointer
+    size_t count;
+
+    struct {
+        size_t hits;
+        size_t stores;
+        size_t refills;
+        size_t flushes;
+    } stats;                            // updated only by the owner thread
+
+    struct aral_magazine *prev, *next;  // the list of magazines of the ARAL
+} ARAL_MAGAZINE;
+
+static struct {
+    SPINLOCK spinlock;                  // protects the list of ARALs, the slots and the lists of magazines
+    ARAL *arals;
+    uint64_t slots;
+    pthread_key_t key;
+    bool key_created;
+} aral_globals = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .arals = NULL,
+    .slots = 0,
+    .key_created = false,
+};
+
+static __thread ARAL_MAGAZINE *aral_thread_magazines[ARAL_MAX_MAGAZINE_SLOTS] = { NULL };
+static __thread bool aral_thread_key_set = false;
+
 #define ARAL_NATURAL_ALIGNMENT  (sizeof(uintptr_t) * 2)
 static inline size_t natural_alignment(size_t size, size_t alignment) {
     if(unlikely(size % alignment))
@@ -65,6 +111,8 @@ static void arrayalloc_delete_leftover_files(const char *path, const char *requi
     closedir(dir);
 }
 
+static void arrayalloc_thread_exit(void *ptr);
+
 // ----------------------------------------------------------------------------
 // arrayalloc_init()
 
@@ -120,6 +168,34 @@ static void arrayalloc_init(ARAL *ar) {
         ar->internal.pages = NULL;
         ar->internal.allocation_multiplier = 1;
         ar->internal.file_number = 0;
+        ar->internal.magazines = NULL;
+        ar->internal.magazine_slot = -1;
+
+        netdata_spinlock_lock(&aral_globals.spinlock);
+
+        if(ar->magazine_elements && !ar->internal.lockless) {
+            if(ar->magazine_elements < 2)
+                ar->magazine_elements = 2;
+
+            if(!aral_globals.key_created && pthread_key_create(&aral_globals.key, arrayalloc_thread_exit) == 0)
+                aral_globals.key_created = true;
+
+            for(int slot = 0; aral_globals.key_created && slot < ARAL_MAX_MAGAZINE_SLOTS ;slot++) {
+                if(!(aral_globals.slots & (1ULL << slot))) {
+                    aral_globals.slots |= (1ULL << slot);
+                    ar->internal.magazine_slot = slot;
+                    break;
+                }
+            }
+
+            if(ar->internal.magazine_slot == -1)
+                error("ARRAYALLOC: no magazine slots available for '%s', it will be used without per thread magazines",
+                      ar->filename ? ar->filename : "unnamed");
+        }
+
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(aral_globals.arals, ar, internal.prev, internal.next);
+
+        netdata_spinlock_unlock(&aral_globals.spinlock);
 
         if(ar->internal.mmap) {
             char directory_name[FILENAME_MAX + 1];
@@ -231,6 +307,9 @@ static void arrayalloc_add_page(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_P
     // link the new page at the front of the list of pages
     DOUBLE_LINKED_LIST_PREPEND_UNSAFE(ar->internal.pages, page, prev, next);
 
+    __atomic_add_fetch(&ar->internal.stats.pages, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ar->internal.stats.allocated_bytes, page->size, __ATOMIC_RELAXED);
+
     arrayalloc_free_validate_internal_check(ar, fr);
 }
 
@@ -244,13 +323,14 @@ static void arrayalloc_unlock(ARAL *ar) {
         netdata_spinlock_unlock(&ar->internal.spinlock);
 }
 
-ARAL *arrayalloc_create(size_t element_size, size_t elements, const char *filename, char **cache_dir, bool mmap, bool lockless) {
+ARAL *arrayalloc_create(size_t element_size, size_t elements, const char *filename, char **cache_dir, bool mmap, bool lockless, size_t magazine_elements) {
     ARAL *ar = callocz(1, sizeof(ARAL));
     ar->requested_element_size = element_size;
     ar->initial_elements = elements;
     ar->filename = filename;
     ar->cache_dir = cache_dir;
     ar->use_mmap = mmap;
+    ar->magazine_elements = magazine_elements;
     ar->internal.lockless = lockless;
     return ar;
 }
@@ -259,6 +339,9 @@ void arrayalloc_del_page(ARAL *ar, ARAL_PAGE *page TRACE_ALLOCATIONS_FUNCTION_DE
 
     DOUBLE_LINKED_LIST_REMOVE_UNSAFE(ar->internal.pages, page, prev, next);
 
+    __atomic_sub_fetch(&ar->internal.stats.pages, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&ar->internal.stats.allocated_bytes, page->size, __ATOMIC_RELAXED);
+
     // free it
     if (ar->internal.mmap) {
         netdata_munmap(page->data, page->size);
@@ -280,6 +363,25 @@ void arrayalloc_del_page(ARAL *ar, ARAL_PAGE *page TRACE_ALLOCATIONS_FUNCTION_DE
 }
 
 void arrayalloc_destroy_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    if(ar->internal.initialized) {
+        netdata_spinlock_lock(&aral_globals.spinlock);
+
+        // the magazines of the threads now belong to the threads,
+        // they will free them without touching their elements
+        while(ar->internal.magazines) {
+            ARAL_MAGAZINE *m = ar->internal.magazines;
+            DOUBLE_LINKED_LIST_REMOVE_UNSAFE(ar->internal.magazines, m, prev, next);
+            __atomic_store_n(&m->ar, NULL, __ATOMIC_RELEASE);
+        }
+
+        if(ar->internal.magazine_slot != -1)
+            aral_globals.slots &= ~(1ULL << ar->internal.magazine_slot);
+
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(aral_globals.arals, ar, internal.prev, internal.next);
+
+        netdata_spinlock_unlock(&aral_globals.spinlock);
+    }
+
     arrayalloc_lock(ar);
 
     while(ar->internal.pages)
@@ -289,13 +391,8 @@ void arrayalloc_destroy_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_
     freez(ar);
 }
 
-void *arrayalloc_mallocz_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
-
-    if(unlikely(!ar->internal.initialized))
-        arrayalloc_init(ar);
-
-    arrayalloc_lock(ar);
-
+// get an element from the pages - the ARAL has to be locked
+static void *arrayalloc_pool_get_unsafe(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
     if(unlikely(!ar->internal.pages || !ar->internal.pages->free_list)) {
 #ifdef NETDATA_ARRAYALLOC_INTERNAL_CHECKS
             internal_fatal(find_page_with_free_slots_internal_check(ar) != NULL,
@@ -349,15 +446,12 @@ void *arrayalloc_mallocz_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION
     ARAL_PAGE **page_ptr = (ARAL_PAGE **)&data[ar->internal.page_ptr_offset];
     *page_ptr = page;
 
-    arrayalloc_unlock(ar);
+    ar->internal.stats.used_elements++;
     return (void *)found_fr;
 }
 
-void arrayalloc_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
-
-    if(unlikely(!ptr)) return;
-    arrayalloc_lock(ar);
-
+// return an element to its page - the ARAL has to be locked
+static void arrayalloc_pool_put_unsafe(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
     // get the page pointer
     ARAL_PAGE *page;
     {
@@ -412,12 +506,405 @@ void arrayalloc_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DE
         DOUBLE_LINKED_LIST_PREPEND_UNSAFE(ar->internal.pages, page, prev, next);
     }
 
+    ar->internal.stats.used_elements--;
+}
+
+// ----------------------------------------------------------------------------
+// magazines
+
+static void arrayalloc_magazine_refill(ARAL *ar, ARAL_MAGAZINE *m TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    size_t elements = ar->magazine_elements / 2;
+
+    arrayalloc_lock(ar);
+
+    for(size_t i = 0; i < elements ;i++) {
+        void *ptr = arrayalloc_pool_get_unsafe(ar TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+        *(void **)ptr = m->elements;
+        m->elements = ptr;
+    }
+
+    arrayalloc_unlock(ar);
+
+    m->count += elements;
+    __atomic_store_n(&m->stats.refills, m->stats.refills + 1, __ATOMIC_RELAXED);
+}
+
+// return elements of a magazine to the pages - the ARAL has to be locked
+static void arrayalloc_magazine_flush_unsafe(ARAL *ar, ARAL_MAGAZINE *m, size_t elements TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    if(elements > m->count)
+        elements = m->count;
+
+    for(size_t i = 0; i < elements ;i++) {
+        void *ptr = m->elements;
+        m->elements = *(void **)ptr;
+        arrayalloc_pool_put_unsafe(ar, ptr TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    }
+
+    m->count -= elements;
+    __atomic_store_n(&m->stats.flushes, m->stats.flushes + 1, __ATOMIC_RELAXED);
+}
+
+static void arrayalloc_magazine_flush(ARAL *ar, ARAL_MAGAZINE *m, size_t elements TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    arrayalloc_lock(ar);
+    arrayalloc_magazine_flush_unsafe(ar, m, elements TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    arrayalloc_unlock(ar);
+}
+
+// add the counters of a magazine that goes away to its ARAL - the ARAL has to be locked, so that it is not destroyed
+static void arrayalloc_magazine_stats_to_aral(ARAL *ar, ARAL_MAGAZINE *m) {
+    __atomic_add_fetch(&ar->internal.stats.magazine_hits, m->stats.hits, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ar->internal.stats.magazine_stores, m->stats.stores, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ar->internal.stats.refills, m->stats.refills, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ar->internal.stats.flushes, m->stats.flushes, __ATOMIC_RELAXED);
+}
+
+static void arrayalloc_thread_exit(void *ptr __maybe_unused) {
+#ifdef NETDATA_TRACE_ALLOCATIONS
+    const char *file = __FILE__, *function = __FUNCTION__;
+    size_t line = __LINE__;
+#endif
+
+    for(int slot = 0; slot < ARAL_MAX_MAGAZINE_SLOTS ;slot++) {
+        ARAL_MAGAZINE *m = aral_thread_magazines[slot];
+        if(!m) continue;
+
+        aral_thread_magazines[slot] = NULL;
+
+        netdata_spinlock_lock(&aral_globals.spinlock);
+
+        ARAL *ar = __atomic_load_n(&m->ar, __ATOMIC_ACQUIRE);
+        if(ar) {
+            DOUBLE_LINKED_LIST_REMOVE_UNSAFE(ar->internal.magazines, m, prev, next);
+
+            // arrayalloc_destroy_internal() needs the lock of the ARAL to free it,
+            // so holding it keeps the ARAL alive after we release the global spinlock
+            arrayalloc_lock(ar);
+        }
+
+        netdata_spinlock_unlock(&aral_globals.spinlock);
+
+        if(ar) {
+            // return everything to the ARAL
+            arrayalloc_magazine_flush_unsafe(ar, m, m->count TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+            arrayalloc_magazine_stats_to_aral(ar, m);
+            arrayalloc_unlock(ar);
+        }
+
+        freez(m);
+    }
+
+    aral_thread_key_set = false;
+}
+
+static inline ARAL_MAGAZINE *arrayalloc_thread_magazine(ARAL *ar) {
+    int slot = ar->internal.magazine_slot;
+    if(unlikely(slot < 0))
+        return NULL;
+
+    ARAL_MAGAZINE *m = aral_thread_magazines[slot];
+    if(likely(m && __atomic_load_n(&m->ar, __ATOMIC_RELAXED) == ar))
+        return m;
+
+    if(m) {
+        // the ARAL that was using this slot has been destroyed
+        freez(m);
+        aral_thread_magazines[slot] = NULL;
+    }
+
+    if(unlikely(!aral_thread_key_set)) {
+        // to get our magazines back when the thread exits
+        pthread_setspecific(aral_globals.key, aral_thread_magazines);
+        aral_thread_key_set = true;
+    }
+
+    m = callocz(1, sizeof(ARAL_MAGAZINE));
+    m->ar = ar;
+
+    netdata_spinlock_lock(&aral_globals.spinlock);
+    DOUBLE_LINKED_LIST_APPEND_UNSAFE(ar->internal.magazines, m, prev, next);
+    netdata_spinlock_unlock(&aral_globals.spinlock);
+
+    aral_thread_magazines[slot] = m;
+    return m;
+}
+
+// ----------------------------------------------------------------------------
+// the public API
+
+void *arrayalloc_mallocz_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    if(unlikely(!ar->internal.initialized))
+        arrayalloc_init(ar);
+
+    ARAL_MAGAZINE *m = arrayalloc_thread_magazine(ar);
+    if(m) {
+        if(unlikely(!m->count))
+            arrayalloc_magazine_refill(ar, m TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+
+        void *ptr = m->elements;
+        m->elements = *(void **)ptr;
+        m->count--;
+        __atomic_store_n(&m->stats.hits, m->stats.hits + 1, __ATOMIC_RELAXED);
+        return ptr;
+    }
+
+    arrayalloc_lock(ar);
+    void *ptr = arrayalloc_pool_get_unsafe(ar TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    ar->internal.stats.allocations++;
+    arrayalloc_unlock(ar);
+
+    return ptr;
+}
+
+void arrayalloc_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    if(unlikely(!ptr)) return;
+
+    ARAL_MAGAZINE *m = arrayalloc_thread_magazine(ar);
+    if(m) {
+        *(void **)ptr = m->elements;
+        m->elements = ptr;
+        m->count++;
+        __atomic_store_n(&m->stats.stores, m->stats.stores + 1, __ATOMIC_RELAXED);
+
+        if(unlikely(m->count >= ar->magazine_elements))
+            arrayalloc_magazine_flush(ar, m, ar->magazine_elements / 2 TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+
+        return;
+    }
+
+    arrayalloc_lock(ar);
+    arrayalloc_pool_put_unsafe(ar, ptr TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    ar->internal.stats.frees++;
     arrayalloc_unlock(ar);
 }
 
+// ----------------------------------------------------------------------------
+// statistics
+
+// add the statistics of an ARAL to stats - aral_globals.spinlock has to be locked
+static void arrayalloc_add_statistics_unsafe(ARAL *ar, struct aral_statistics *stats) {
+    size_t hits = __atomic_load_n(&ar->internal.stats.magazine_hits, __ATOMIC_RELAXED);
+    size_t stores = __atomic_load_n(&ar->internal.stats.magazine_stores, __ATOMIC_RELAXED);
+
+    stats->refills += __atomic_load_n(&ar->internal.stats.refills, __ATOMIC_RELAXED);
+    stats->flushes += __atomic_load_n(&ar->internal.stats.flushes, __ATOMIC_RELAXED);
+
+    // the magazines are updated by their threads without locks,
+    // so these are approximations, good enough for statistics
+    size_t cached = 0;
+    for(ARAL_MAGAZINE *m = ar->internal.magazines; m ; m = m->next) {
+        stats->magazines++;
+        cached += __atomic_load_n(&m->count, __ATOMIC_RELAXED);
+        hits += __atomic_load_n(&m->stats.hits, __ATOMIC_RELAXED);
+        stores += __atomic_load_n(&m->stats.stores, __ATOMIC_RELAXED);
+        stats->refills += __atomic_load_n(&m->stats.refills, __ATOMIC_RELAXED);
+        stats->flushes += __atomic_load_n(&m->stats.flushes, __ATOMIC_RELAXED);
+    }
+
+    size_t used = __atomic_load_n(&ar->internal.stats.used_elements, __ATOMIC_RELAXED);
+    stats->used_bytes += used * ar->internal.element_size;
+    stats->cached_bytes += cached * ar->internal.element_size;
+
+    stats->magazine_hits += hits;
+    stats->magazine_stores += stores;
+    stats->allocations += __atomic_load_n(&ar->internal.stats.allocations, __ATOMIC_RELAXED) + hits;
+    stats->frees += __atomic_load_n(&ar->internal.stats.frees, __ATOMIC_RELAXED) + stores;
+    stats->pages += __atomic_load_n(&ar->internal.stats.pages, __ATOMIC_RELAXED);
+    stats->allocated_bytes += __atomic_load_n(&ar->internal.stats.allocated_bytes, __ATOMIC_RELAXED);
+    stats->used_elements += used;
+    stats->cached_elements += cached;
+}
+
+void arrayalloc_get_statistics(ARAL *ar, struct aral_statistics *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    netdata_spinlock_lock(&aral_globals.spinlock);
+    arrayalloc_add_statistics_unsafe(ar, stats);
+    netdata_spinlock_unlock(&aral_globals.spinlock);
+}
+
+// call the callback for all the named ARALs, summing the ones that have the same name
+void arrayalloc_foreach_statistics(void (*cb)(const char *name, struct aral_statistics *stats, void *data), void *data) {
+    const char *names[ARAL_MAX_MAGAZINE_SLOTS];
+    struct aral_statistics stats[ARAL_MAX_MAGAZINE_SLOTS];
+    size_t used = 0;
+
+    memset(stats, 0, sizeof(stats));
+
+    netdata_spinlock_lock(&aral_globals.spinlock);
+
+    for(ARAL *ar = aral_globals.arals; ar ; ar = ar->internal.next) {
+        if(!ar->filename) continue;
+
+        size_t i;
+        for(i = 0; i < used ;i++)
+            if(!strcmp(names[i], ar->filename)) break;
+
+        if(i == used) {
+            if(used == ARAL_MAX_MAGAZINE_SLOTS) continue;
+            names[used++] = ar->filename;
+        }
+
+        arrayalloc_add_statistics_unsafe(ar, &stats[i]);
+    }
+
+    netdata_spinlock_unlock(&aral_globals.spinlock);
+
+    for(size_t i = 0; i < used ;i++)
+        cb(names[i], &stats[i], data);
+}
+
+// ----------------------------------------------------------------------------
+// unittest and benchmark
+
+struct aral_unittest_thread {
+    ARAL *ar;
+    size_t id;
+    size_t elements;
+    void **pointers;
+    bool *stop;
+    size_t ops;
+    size_t errors;
+};
+
+#define ARAL_UNITTEST_BATCH 128
+
+static void *aral_unittest_benchmark_thread(void *arg) {
+    struct aral_unittest_thread *t = arg;
+    uint64_t *pointers[ARAL_UNITTEST_BATCH];
+
+    while(!__atomic_load_n(t->stop, __ATOMIC_RELAXED)) {
+        for(size_t i = 0; i < ARAL_UNITTEST_BATCH ;i++) {
+            pointers[i] = arrayalloc_mallocz(t->ar);
+            pointers[i][0] = t->id;
+            pointers[i][1] = i;
+        }
+
+        for(size_t i = 0; i < ARAL_UNITTEST_BATCH ;i++) {
+            if(pointers[i][0] != t->id || pointers[i][1] != i)
+                t->errors++;
+
+            arrayalloc_freez(t->ar, pointers[i]);
+        }
+
+        t->ops += ARAL_UNITTEST_BATCH * 2;
+    }
+
+    return NULL;
+}
+
+static void *aral_unittest_allocate_thread(void *arg) {
+    struct aral_unittest_thread *t = arg;
+
+    for(size_t i = 0; i < t->elements ;i++)
+        t->pointers[i] = arrayalloc_mallocz(t->ar);
+
+    return NULL;
+}
+
+static void *aral_unittest_free_thread(void *arg) {
+    struct aral_unittest_thread *t = arg;
+
+    for(size_t i = 0; i < t->elements ;i++)
+        arrayalloc_freez(t->ar, t->pointers[i]);
+
+    return NULL;
+}
+
+static void aral_unittest_run_thread(void *(*start_routine)(void *), struct aral_unittest_thread *t) {
+    netdata_thread_t thread;
+    netdata_thread_create(&thread, "ARAL_TEST", NETDATA_THREAD_OPTION_DONT_LOG | NETDATA_THREAD_OPTION_JOINABLE, start_routine, t);
+    netdata_thread_join(thread, NULL);
+}
+
+// elements allocated by one thread and freed by another
+static int aral_unittest_cross_thread_frees(size_t elements) {
+    ARAL *ar = arrayalloc_create(sizeof(uint64_t) * 2, 10, "test-aral-cross", NULL, false, false, ARAL_DEFAULT_MAGAZINE_ELEMENTS);
+    void **pointers = mallocz(elements * sizeof(void *));
+
+    struct aral_unittest_thread t = {
+        .ar = ar,
+        .elements = elements,
+        .pointers = pointers,
+    };
+
+    aral_unittest_run_thread(aral_unittest_allocate_thread, &t);
+    aral_unittest_run_thread(aral_unittest_free_thread, &t);
+
+    struct aral_statistics stats;
+    arrayalloc_get_statistics(ar, &stats);
+
+    int errors = 0;
+    if(ar->internal.pages || stats.used_elements || stats.magazines) {
+        fprintf(stderr, "ARAL cross thread frees: leftovers detected (pages %zu, used elements %zu, magazines %zu)\n",
+                stats.pages, stats.used_elements, stats.magazines);
+        errors++;
+    }
+
+    if(stats.allocations != elements || stats.frees != elements) {
+        fprintf(stderr, "ARAL cross thread frees: expected %zu allocations and frees, got %zu allocations and %zu frees\n",
+                elements, stats.allocations, stats.frees);
+        errors++;
+    }
+
+    freez(pointers);
+    arrayalloc_destroy(ar);
+    return errors;
+}
+
+static int aral_unittest_benchmark(size_t threads, size_t magazine_elements, usec_t duration_ut) {
+    ARAL *ar = arrayalloc_create(sizeof(uint64_t) * 2, 1024, "test-aral-benchmark", NULL, false, false, magazine_elements);
+
+    bool stop = false;
+    struct aral_unittest_thread t[threads];
+    netdata_thread_t thread[threads];
+
+    for(size_t i = 0; i < threads ;i++) {
+        t[i] = (struct aral_unittest_thread) {
+            .ar = ar,
+            .id = i,
+            .stop = &stop,
+        };
+
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "ARAL_BENCH%zu", i);
+        netdata_thread_create(&thread[i], tag, NETDATA_THREAD_OPTION_DONT_LOG | NETDATA_THREAD_OPTION_JOINABLE, aral_unittest_benchmark_thread, &t[i]);
+    }
+
+    usec_t started_ut = now_monotonic_usec();
+    sleep_usec(duration_ut);
+    __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+
+    size_t ops = 0, errors = 0;
+    for(size_t i = 0; i < threads ;i++) {
+        netdata_thread_join(thread[i], NULL);
+        ops += t[i].ops;
+        errors += t[i].errors;
+    }
+    usec_t ended_ut = now_monotonic_usec();
+
+    struct aral_statistics stats;
+    arrayalloc_get_statistics(ar, &stats);
+
+    fprintf(stderr, "ARAL: %2zu threads, %s: %10.2f Mops/s (%zu ops, %zu refills, %zu flushes)\n",
+            threads, magazine_elements ? "   magazines" : "no magazines",
+            (double)ops / (double)(ended_ut - started_ut),
+            ops, stats.refills, stats.flushes);
+
+    if(errors)
+        fprintf(stderr, "ARAL: %zu elements were given to more than one thread\n", errors);
+
+    if(ar->internal.pages || stats.used_elements) {
+        fprintf(stderr, "ARAL: benchmark leftovers detected (pages %zu, used elements %zu)\n", stats.pages, stats.used_elements);
+        errors++;
+    }
+
+    arrayalloc_destroy(ar);
+    return (int)errors;
+}
+
 int aral_unittest(size_t elements) {
     char *cache_dir = "/tmp/";
-    ARAL *ar = arrayalloc_create(20, 10, "test-aral", &cache_dir, false, false);
+    ARAL *ar = arrayalloc_create(20, 10, "test-aral", &cache_dir, false, false, 0);
 
     void *pointers[elements];
 
@@ -497,5 +984,17 @@ int aral_unittest(size_t elements) {
         return 1;
     }
 
-    return 0;
+    arrayalloc_destroy(ar);
+
+    if(aral_unittest_cross_thread_frees(elements))
+        return 1;
+
+    int errors = 0;
+    fprintf(stderr, "\nARAL multi-threaded allocation throughput:\n");
+    for(size_t threads = 1; threads <= 8 ; threads *= 2) {
+        errors += aral_unittest_benchmark(threads, 0, USEC_PER_SEC / 2);
+        errors += aral_unittest_benchmark(threads, ARAL_DEFAULT_MAGAZINE_ELEMENTS, USEC_PER_SEC / 2);
+    }
+
+    return errors ? 1 : 0;
 }
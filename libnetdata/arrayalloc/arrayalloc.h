@@ -4,18 +4,36 @@
 
 #include "../libnetdata.h"
 
+struct aral_statistics {
+    size_t allocations;                 // elements given to callers
+    size_t frees;                       // elements returned by callers
+    size_t magazine_hits;               // allocations served by a thread magazine
+    size_t magazine_stores;             // frees kept in a thread magazine
+    size_t refills;                     // magazines refilled from the shared pool
+    size_t flushes;                     // magazines that returned elements to the shared pool
+    size_t magazines;                   // the number of thread magazines
+    size_t cached_elements;             // the free elements kept in thread magazines
+    size_t pages;                       // the number of pages allocated
+    size_t allocated_bytes;             // the size of all the pages allocated
+    size_t used_elements;               // the elements given to callers or kept in magazines
+    size_t used_bytes;                  // the size of used_elements
+    size_t cached_bytes;                // the size of cached_elements
+};
+
 typedef struct arrayalloc {
     size_t requested_element_size;
     size_t initial_elements;
-    const char *filename;
+    const char *filename;               // also the name of the ARAL in statistics
     char **cache_dir;
     bool use_mmap;
+    size_t magazine_elements;           // the size of the per thread magazines, 0 to disable them
 
     // private members - do not touch
     struct {
         bool mmap;
         bool lockless;
         bool initialized;
+        int magazine_slot;
         size_t element_size;
         size_t page_ptr_offset;
         size_t file_number;
@@ -24,10 +42,17 @@ typedef struct arrayalloc {
         size_t max_alloc_size;
         SPINLOCK spinlock;
         struct arrayalloc_page *pages;
+        struct aral_magazine *magazines;
+        struct aral_statistics stats;
+        struct arrayalloc *prev, *next;
     } internal;
 } ARAL;
 
-ARAL *arrayalloc_create(size_t element_size, size_t elements, const char *filename, char **cache_dir, bool mmap, bool lockless);
+#define ARAL_DEFAULT_MAGAZINE_ELEMENTS 64
+
+ARAL *arrayalloc_create(size_t element_size, size_t elements, const char *filename, char **cache_dir, bool mmap, bool lockless, size_t magazine_elements);
+void arrayalloc_get_statistics(ARAL *ar, struct aral_statistics *stats);
+void arrayalloc_foreach_statistics(void (*cb)(const char *name, struct aral_statistics *stats, void *data), void *data);
 int aral_unittest(size_t elements);
 
 #ifdef NETDATA_TRACE_ALLOCATIONS
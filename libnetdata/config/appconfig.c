@@ -89,6 +89,8 @@ int is_valid_connector(char *type, int check_reserved)
         return rc;
     } else if (!strcmp(type, "mongodb") || !strcmp(type, "mongodb:plaintext")) {
         return rc;
+    } else if (!strcmp(type, "mmap")) {
+        return rc;
     }
 
     return 0;
@@ -21,6 +21,7 @@ typedef enum __attribute__ ((__packed__)) {
 #define is_dictionary_single_threaded(dict) ((dict)->options & DICT_OPTION_SINGLE_THREADED)
 #define is_view_dictionary(dict) ((dict)->master)
 #define is_master_dictionary(dict) (!is_view_dictionary(dict))
+#define is_dictionary_index_partitioned(dict) ((dict)->options & DICT_OPTION_INDEX_PARTITIONED)
 
 typedef enum __attribute__ ((__packed__)) item_options {
     ITEM_OPTION_NONE            = 0,
@@ -132,6 +133,42 @@ struct dictionary_stats dictionary_stats_category_other = {
     .name = "other",
 };
 
+/*
+ * The partitioned index (DICT_OPTION_INDEX_PARTITIONED).
+ */
+
+#define DICT_INDEX_PARTITIONS_BITS 4
+#define DICT_INDEX_PARTITIONS (1 << DICT_INDEX_PARTITIONS_BITS)
+#define DICT_INDEX_PARTITION_INITIAL_BUCKETS 16
+#define DICT_INDEX_PARTITION_MAX_LOAD 2 // nodes per bucket, before the partition grows
+#define DICT_INDEX_CACHE_LINE_SIZE 64
+
+typedef struct dictionary_index_node {
+    uint32_t hash;                          // the hash of the key
+    DICTIONARY_ITEM *item;                  // the item (NULL while it is being created)
+    struct dictionary_index_node *next;     // the next node of the bucket chain
+} DICTIONARY_INDEX_NODE;
+
+struct dictionary_index_table {
+    size_t size;                            // the number of buckets (always a power of 2)
+    DICTIONARY_INDEX_NODE *buckets[];
+};
+
+// The readers counters are modified by every search, so they are padded to a cache line of their own,
+// away from the fields every search reads and from the fields the writers modify.
+struct dictionary_index_partition {
+    size_t seq;                             // odd while the partition is being resized
+    size_t epoch;                           // selects the readers counter new readers will use
+    struct dictionary_index_table *table;   // the current hash table of this partition
+    uint8_t padding1[DICT_INDEX_CACHE_LINE_SIZE - 2 * sizeof(size_t) - sizeof(struct dictionary_index_table *)];
+
+    size_t readers[2];                      // the readers currently searching this partition
+    uint8_t padding2[DICT_INDEX_CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+
+    netdata_mutex_t mutex;                  // serializes the writers of this partition
+    size_t entries;                         // the nodes in this partition
+};
+
 struct dictionary {
 #ifdef NETDATA_INTERNAL_CHECKS
     const char *creation_function;
@@ -146,6 +183,7 @@ struct dictionary {
     struct {                            // support for multiple indexing engines
         Pvoid_t JudyHSArray;            // the hash table
         netdata_rwlock_t rwlock;        // protect the index
+        struct dictionary_index_partition *partitions; // the partitioned index, when DICT_OPTION_INDEX_PARTITIONED is set
     } index;
 
     struct {
@@ -184,7 +222,7 @@ static void garbage_collect_pending_deletes(DICTIONARY *dict);
 static inline void item_linked_list_remove(DICTIONARY *dict, DICTIONARY_ITEM *item);
 static size_t dict_item_free_with_hooks(DICTIONARY *dict, DICTIONARY_ITEM *item);
 static inline const char *item_get_name(const DICTIONARY_ITEM *item);
-static inline int hashtable_delete_unsafe(DICTIONARY *dict, const char *name, size_t name_len, void *item);
+static inline int hashtable_delete_unsafe(DICTIONARY *dict, const char *name, size_t name_len, uint32_t hash, void *item);
 static void item_release(DICTIONARY *dict, DICTIONARY_ITEM *item);
 static bool dict_item_set_deleted(DICTIONARY *dict, DICTIONARY_ITEM *item);
 
@@ -752,6 +790,27 @@ static inline void dictionary_index_wrlock_unlock(DICTIONARY *dict) {
     netdata_rwlock_unlock(&dict->index.rwlock);
 }
 
+// lock the part of the index the key with this hash belongs to
+// (the whole index, unless the index is partitioned)
+
+static inline struct dictionary_index_partition *dictionary_index_partition(DICTIONARY *dict, uint32_t hash) {
+    return &dict->index.partitions[hash >> (32 - DICT_INDEX_PARTITIONS_BITS)];
+}
+
+static inline void dictionary_index_key_wrlock(DICTIONARY *dict, uint32_t hash) {
+    if(is_dictionary_index_partitioned(dict))
+        netdata_mutex_lock(&dictionary_index_partition(dict, hash)->mutex);
+    else
+        dictionary_index_lock_wrlock(dict);
+}
+
+static inline void dictionary_index_key_wrlock_unlock(DICTIONARY *dict, uint32_t hash) {
+    if(is_dictionary_index_partitioned(dict))
+        netdata_mutex_unlock(&dictionary_index_partition(dict, hash)->mutex);
+    else
+        dictionary_index_wrlock_unlock(dict);
+}
+
 // ----------------------------------------------------------------------------
 // items garbage collector
 
@@ -964,7 +1023,7 @@ static int item_check_and_acquire_advanced(DICTIONARY *dict, DICTIONARY_ITEM *it
 
             if (having_index_lock) {
                 // delete it from the hashtable
-                if(hashtable_delete_unsafe(dict, item_get_name(item), item->key_len, item) == 0)
+                if(hashtable_delete_unsafe(dict, item_get_name(item), item->key_len, 0, item) == 0)
                     error("DICTIONARY: INTERNAL ERROR VIEW: tried to delete item with name '%s', name_len %u that is not in the index", item_get_name(item), (KEY_LEN_TYPE)(item->key_len - 1));
                 else
                     pointer_del(dict, item);
@@ -1063,15 +1122,282 @@ static inline bool item_shared_release_and_check_if_it_can_be_freed(DICTIONARY *
 }
 
 
+// ----------------------------------------------------------------------------
+// partitioned index operations
+//
+// Each partition is a chained hash table. Writers are serialized per partition
+// with its mutex. Readers do not lock: they register themselves on one of the
+// two readers counters of the partition, walk the bucket chain and acquire the
+// item they found using its reference counter.
+// Writers that unlink a node wait for all the readers that may still see it
+// (a grace period), before freeing anything.
+// Growing a partition moves nodes between chains, so a reader that did not find
+// anything while the sequence number of the partition changed, searches again.
+
+static ARAL dict_index_nodes_aral = {
+        .filename = "dictionary_index_nodes",
+        .cache_dir = NULL,
+        .use_mmap = false,
+        .initial_elements = 65536 / sizeof(DICTIONARY_INDEX_NODE),
+        .requested_element_size = sizeof(DICTIONARY_INDEX_NODE),
+        .magazine_elements = ARAL_DEFAULT_MAGAZINE_ELEMENTS,
+};
+
+static inline uint32_t dictionary_index_hash(DICTIONARY *dict, const char *name, size_t name_len) {
+    if(!is_dictionary_index_partitioned(dict))
+        return 0;
+
+    const unsigned char *s = (const unsigned char *)name, *end = s + name_len;
+    uint32_t hval = 0x811c9dc5;
+    while(s < end) {
+        hval ^= (uint32_t)*s++;
+        hval *= 16777619;
+    }
+
+    // the partition is selected by the high bits and the bucket by the low bits
+    return murmur32(hval);
+}
+
+static inline size_t index_partition_table_size(size_t buckets) {
+    return sizeof(struct dictionary_index_table) + buckets * sizeof(DICTIONARY_INDEX_NODE *);
+}
+
+static inline size_t index_partition_reader_enter(struct dictionary_index_partition *p) {
+    netdata_thread_disable_cancelability();
+
+    // a stale epoch is fine, writers flip it twice and wait for both counters
+    size_t epoch = __atomic_load_n(&p->epoch, __ATOMIC_RELAXED) & 1;
+
+    // the only full barrier of a search: the counter has to be visible to the writers
+    // before we load anything from the partition, and it pairs with their epoch flip
+    __atomic_add_fetch(&p->readers[epoch], 1, __ATOMIC_SEQ_CST);
+    return epoch;
+}
+
+static inline void index_partition_reader_exit(struct dictionary_index_partition *p, size_t epoch) {
+    // our loads from the partition have to complete before writers see us leaving
+    __atomic_sub_fetch(&p->readers[epoch], 1, __ATOMIC_RELEASE);
+
+    netdata_thread_enable_cancelability();
+}
+
+// wait for all readers that may have seen the partition before this call
+// the caller must have the partition mutex, and must not be a reader itself
+static void index_partition_wait_for_readers(struct dictionary_index_partition *p) {
+    static const struct timespec ns = { .tv_sec = 0, .tv_nsec = 1 };
+
+    // readers that entered just before a flip may still use the previous counter,
+    // so we flip twice, waiting each time for the counter we switched away from
+    // (this is the slow path of deletions and resizes, so it stays sequentially consistent)
+    for(size_t flips = 0; flips < 2 ; flips++) {
+        size_t old = __atomic_fetch_add(&p->epoch, 1, __ATOMIC_SEQ_CST) & 1;
+
+        for(int i = 1; __atomic_load_n(&p->readers[old], __ATOMIC_SEQ_CST) ; i++) {
+            if(unlikely(i == 8)) {
+                i = 0;
+                nanosleep(&ns, NULL);
+            }
+        }
+    }
+}
+
+static inline bool index_node_matches(DICTIONARY_INDEX_NODE *node, uint32_t hash, const char *name, size_t name_len) {
+    if(node->hash != hash)
+        return false;
+
+    DICTIONARY_ITEM *item = __atomic_load_n(&node->item, __ATOMIC_ACQUIRE);
+    return item && item->key_len == name_len && memcmp(item_get_name(item), name, name_len) == 0;
+}
+
+static inline DICTIONARY_INDEX_NODE *index_partition_search(struct dictionary_index_table *t, uint32_t hash, const char *name, size_t name_len) {
+    DICTIONARY_INDEX_NODE *node = __atomic_load_n(&t->buckets[hash & (t->size - 1)], __ATOMIC_ACQUIRE);
+
+    while(node && !index_node_matches(node, hash, name, name_len))
+        node = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+
+    return node;
+}
+
+static void index_partition_grow_unsafe(DICTIONARY *dict, struct dictionary_index_partition *p) {
+    struct dictionary_index_table *old = p->table;
+    size_t old_size = old->size, size = old_size * 2;
+
+    struct dictionary_index_table *t = callocz(1, index_partition_table_size(size));
+    t->size = size;
+
+    // readers that miss while the sequence number changes, will search again
+    __atomic_add_fetch(&p->seq, 1, __ATOMIC_SEQ_CST);
+
+    for(size_t b = 0; b < old_size ; b++) {
+        DICTIONARY_INDEX_NODE *node = old->buckets[b], *next;
+        for(; node ; node = next) {
+            next = node->next;
+
+            // the new table is not visible to readers yet,
+            // but the node may be walked through the old one
+            DICTIONARY_INDEX_NODE **head = &t->buckets[node->hash & (size - 1)];
+            __atomic_store_n(&node->next, *head, __ATOMIC_RELEASE);
+            *head = node;
+        }
+    }
+
+    __atomic_store_n(&p->table, t, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&p->seq, 1, __ATOMIC_SEQ_CST);
+
+    index_partition_wait_for_readers(p);
+    freez(old);
+
+    DICTIONARY_STATS_PLUS_MEMORY(dict, 0, index_partition_table_size(size) - index_partition_table_size(old_size), 0);
+}
+
+static void **index_partition_insert_unsafe(DICTIONARY *dict, const char *name, size_t name_len, uint32_t hash) {
+    struct dictionary_index_partition *p = dictionary_index_partition(dict, hash);
+
+    DICTIONARY_INDEX_NODE *node = index_partition_search(p->table, hash, name, name_len);
+    if(node)
+        return (void **)&node->item;
+
+    if(unlikely(p->entries >= p->table->size * DICT_INDEX_PARTITION_MAX_LOAD))
+        index_partition_grow_unsafe(dict, p);
+
+    node = arrayalloc_mallocz(&dict_index_nodes_aral);
+    node->hash = hash;
+    node->item = NULL;
+
+    // the caller will set the item - until then, readers will skip this node
+    DICTIONARY_INDEX_NODE **head = &p->table->buckets[hash & (p->table->size - 1)];
+    node->next = *head;
+    __atomic_store_n(head, node, __ATOMIC_RELEASE);
+    p->entries++;
+
+    DICTIONARY_STATS_PLUS_MEMORY(dict, 0, sizeof(DICTIONARY_INDEX_NODE), 0);
+    return (void **)&node->item;
+}
+
+static int index_partition_delete_unsafe(DICTIONARY *dict, const char *name, size_t name_len, uint32_t hash) {
+    struct dictionary_index_partition *p = dictionary_index_partition(dict, hash);
+    struct dictionary_index_table *t = p->table;
+
+    DICTIONARY_INDEX_NODE **pptr = &t->buckets[hash & (t->size - 1)], *node;
+    while((node = *pptr) && !index_node_matches(node, hash, name, name_len))
+        pptr = &node->next;
+
+    if(!node)
+        return 0;
+
+    // readers walking through this node will continue to its next
+    __atomic_store_n(pptr, node->next, __ATOMIC_RELEASE);
+    p->entries--;
+
+    // the readers that found this node, may still be using it and its item
+    index_partition_wait_for_readers(p);
+    arrayalloc_freez(&dict_index_nodes_aral, node);
+
+    DICTIONARY_STATS_MINUS_MEMORY(dict, 0, sizeof(DICTIONARY_INDEX_NODE), 0);
+    return 1;
+}
+
+static DICTIONARY_ITEM *index_partition_get_and_acquire(DICTIONARY *dict, const char *name, size_t name_len, uint32_t hash) {
+    static const struct timespec ns = { .tv_sec = 0, .tv_nsec = 1 };
+    struct dictionary_index_partition *p = dictionary_index_partition(dict, hash);
+
+    size_t epoch = index_partition_reader_enter(p);
+
+    DICTIONARY_STATS_SEARCHES_PLUS1(dict);
+
+    DICTIONARY_INDEX_NODE *node;
+    for(int i = 1; ; i++) {
+        size_t seq = __atomic_load_n(&p->seq, __ATOMIC_ACQUIRE);
+        node = index_partition_search(__atomic_load_n(&p->table, __ATOMIC_ACQUIRE), hash, name, name_len);
+
+        if(node || (!(seq & 1) && seq == __atomic_load_n(&p->seq, __ATOMIC_ACQUIRE)))
+            break;
+
+        // the partition was resized while we were searching it
+        if(unlikely(i == 8)) {
+            i = 0;
+            nanosleep(&ns, NULL);
+        }
+    }
+
+    DICTIONARY_ITEM *item = node ? __atomic_load_n(&node->item, __ATOMIC_ACQUIRE) : NULL;
+    if(unlikely(item && !item_check_and_acquire(dict, item))) {
+        item = NULL;
+        DICTIONARY_STATS_SEARCH_IGNORES_PLUS1(dict);
+    }
+
+    index_partition_reader_exit(p, epoch);
+
+    return item;
+}
+
+static size_t index_partitions_init(DICTIONARY *dict) {
+    BUILD_BUG_ON(offsetof(struct dictionary_index_partition, readers) < DICT_INDEX_CACHE_LINE_SIZE ||
+                 offsetof(struct dictionary_index_partition, mutex) - offsetof(struct dictionary_index_partition, readers) < DICT_INDEX_CACHE_LINE_SIZE);
+
+    dict->index.partitions = callocz(DICT_INDEX_PARTITIONS, sizeof(struct dictionary_index_partition));
+
+    for(size_t i = 0; i < DICT_INDEX_PARTITIONS ; i++) {
+        struct dictionary_index_partition *p = &dict->index.partitions[i];
+        netdata_mutex_init(&p->mutex);
+        p->table = callocz(1, index_partition_table_size(DICT_INDEX_PARTITION_INITIAL_BUCKETS));
+        p->table->size = DICT_INDEX_PARTITION_INITIAL_BUCKETS;
+    }
+
+    return DICT_INDEX_PARTITIONS * (sizeof(struct dictionary_index_partition) + index_partition_table_size(DICT_INDEX_PARTITION_INITIAL_BUCKETS));
+}
+
+static size_t index_partitions_destroy(DICTIONARY *dict) {
+    if(unlikely(!dict->index.partitions)) return 0;
+
+    size_t bytes = DICT_INDEX_PARTITIONS * sizeof(struct dictionary_index_partition);
+
+    for(size_t i = 0; i < DICT_INDEX_PARTITIONS ; i++) {
+        struct dictionary_index_partition *p = &dict->index.partitions[i];
+
+        netdata_mutex_lock(&p->mutex);
+        index_partition_wait_for_readers(p);
+
+        struct dictionary_index_table *t = p->table;
+        for(size_t b = 0; b < t->size ; b++) {
+            DICTIONARY_INDEX_NODE *node = t->buckets[b], *next;
+            for(; node ; node = next) {
+                next = node->next;
+                arrayalloc_freez(&dict_index_nodes_aral, node);
+                bytes += sizeof(DICTIONARY_INDEX_NODE);
+            }
+        }
+        bytes += index_partition_table_size(t->size);
+        freez(t);
+        p->table = NULL;
+
+        netdata_mutex_unlock(&p->mutex);
+        netdata_mutex_destroy(&p->mutex);
+    }
+
+    freez(dict->index.partitions);
+    dict->index.partitions = NULL;
+
+    DICTIONARY_STATS_MINUS_MEMORY(dict, 0, bytes, 0);
+    return bytes;
+}
+
 // ----------------------------------------------------------------------------
 // hash table operations
 
 static size_t hashtable_init_unsafe(DICTIONARY *dict) {
     dict->index.JudyHSArray = NULL;
+
+    if(is_dictionary_index_partitioned(dict))
+        return index_partitions_init(dict);
+
     return 0;
 }
 
 static size_t hashtable_destroy_unsafe(DICTIONARY *dict) {
+    if(is_dictionary_index_partitioned(dict))
+        return index_partitions_destroy(dict);
+
     if(unlikely(!dict->index.JudyHSArray)) return 0;
 
     pointer_destroy_index(dict);
@@ -1089,7 +1415,10 @@ static size_t hashtable_destroy_unsafe(DICTIONARY *dict) {
     return (size_t)ret;
 }
 
-static inline void **hashtable_insert_unsafe(DICTIONARY *dict, const char *name, size_t name_len) {
+static inline void **hashtable_insert_unsafe(DICTIONARY *dict, const char *name, size_t name_len, uint32_t hash) {
+    if(is_dictionary_index_partitioned(dict))
+        return index_partition_insert_unsafe(dict, name, name_len, hash);
+
     JError_t J_Error;
     Pvoid_t *Rc = JudyHSIns(&dict->index.JudyHSArray, (void *)name, name_len, &J_Error);
     if (unlikely(Rc == PJERR)) {
@@ -1107,8 +1436,11 @@ static inline void **hashtable_insert_unsafe(DICTIONARY *dict, const char *name,
     return Rc;
 }
 
-static inline int hashtable_delete_unsafe(DICTIONARY *dict, const char *name, size_t name_len, void *item) {
+static inline int hashtable_delete_unsafe(DICTIONARY *dict, const char *name, size_t name_len, uint32_t hash, void *item) {
     (void)item;
+    if(is_dictionary_index_partitioned(dict))
+        return index_partition_delete_unsafe(dict, name, name_len, hash);
+
     if(unlikely(!dict->index.JudyHSArray)) return 0;
 
     JError_t J_Error;
@@ -1132,7 +1464,14 @@ static inline int hashtable_delete_unsafe(DICTIONARY *dict, const char *name, si
     }
 }
 
-static inline DICTIONARY_ITEM *hashtable_get_unsafe(DICTIONARY *dict, const char *name, size_t name_len) {
+static inline DICTIONARY_ITEM *hashtable_get_unsafe(DICTIONARY *dict, const char *name, size_t name_len, uint32_t hash) {
+    if(is_dictionary_index_partitioned(dict)) {
+        DICTIONARY_STATS_SEARCHES_PLUS1(dict);
+
+        DICTIONARY_INDEX_NODE *node = index_partition_search(dictionary_index_partition(dict, hash)->table, hash, name, name_len);
+        return node ? node->item : NULL;
+    }
+
     if(unlikely(!dict->index.JudyHSArray)) return NULL;
 
     DICTIONARY_STATS_SEARCHES_PLUS1(dict);
@@ -1235,19 +1574,21 @@ static inline size_t item_get_name_len(const DICTIONARY_ITEM *item) {
 }
 
 static ARAL dict_items_aral = {
-        .filename = NULL,
+        .filename = "dictionary_items",
         .cache_dir = NULL,
         .use_mmap = false,
         .initial_elements = 65536 / sizeof(DICTIONARY_ITEM),
         .requested_element_size = sizeof(DICTIONARY_ITEM),
+        .magazine_elements = ARAL_DEFAULT_MAGAZINE_ELEMENTS,
 };
 
 static ARAL dict_shared_items_aral = {
-        .filename = NULL,
+        .filename = "dictionary_shared_items",
         .cache_dir = NULL,
         .use_mmap = false,
         .initial_elements = 65536 / sizeof(DICTIONARY_ITEM_SHARED),
         .requested_element_size = sizeof(DICTIONARY_ITEM_SHARED),
+        .magazine_elements = ARAL_DEFAULT_MAGAZINE_ELEMENTS,
 };
 
 static DICTIONARY_ITEM *dict_item_create(DICTIONARY *dict __maybe_unused, size_t *allocated_bytes, DICTIONARY_ITEM *master_item) {
@@ -1545,21 +1886,22 @@ static bool dict_item_del(DICTIONARY *dict, const char *name, ssize_t name_len)
     // item that was deleted, so we have to find it before we delete it,
     // since we need to release our structures too.
 
-    dictionary_index_lock_wrlock(dict);
+    uint32_t hash = dictionary_index_hash(dict, name, name_len);
+    dictionary_index_key_wrlock(dict, hash);
 
     int ret;
-    DICTIONARY_ITEM *item = hashtable_get_unsafe(dict, name, name_len);
+    DICTIONARY_ITEM *item = hashtable_get_unsafe(dict, name, name_len, hash);
     if(unlikely(!item)) {
-        dictionary_index_wrlock_unlock(dict);
+        dictionary_index_key_wrlock_unlock(dict, hash);
         ret = false;
     }
     else {
-        if(hashtable_delete_unsafe(dict, name, name_len, item) == 0)
+        if(hashtable_delete_unsafe(dict, name, name_len, hash, item) == 0)
             error("DICTIONARY: INTERNAL ERROR: tried to delete item with name '%s', name_len %zd that is not in the index", name, name_len - 1);
         else
             pointer_del(dict, item);
 
-        dictionary_index_wrlock_unlock(dict);
+        dictionary_index_key_wrlock_unlock(dict, hash);
 
         dict_item_free_or_mark_deleted(dict, item);
         ret = true;
@@ -1601,19 +1943,21 @@ static DICTIONARY_ITEM *dict_item_add_or_reset_value_and_acquire(DICTIONARY *dic
     // But the caller has the option to do this on his/her own.
     // So, let's do the fastest here and let the caller decide the flow of calls.
 
-    dictionary_index_lock_wrlock(dict);
+    uint32_t hash = dictionary_index_hash(dict, name, name_len);
+    dictionary_index_key_wrlock(dict, hash);
 
     bool added_or_updated = false;
     size_t spins = 0;
     DICTIONARY_ITEM *item = NULL;
     do {
-        DICTIONARY_ITEM **item_pptr = (DICTIONARY_ITEM **)hashtable_insert_unsafe(dict, name, name_len);
+        DICTIONARY_ITEM **item_pptr = (DICTIONARY_ITEM **)hashtable_insert_unsafe(dict, name, name_len, hash);
         if (likely(*item_pptr == NULL)) {
             // a new item added to the index
 
             // create the dictionary item
-            item = *item_pptr =
-                dict_item_create_with_hooks(dict, name, name_len, value, value_len, constructor_data, master_item);
+            // (lockless readers of a partitioned index may see it as soon as it is stored)
+            item = dict_item_create_with_hooks(dict, name, name_len, value, value_len, constructor_data, master_item);
+            __atomic_store_n(item_pptr, item, __ATOMIC_RELEASE);
 
             pointer_add(dict, item);
 
@@ -1622,7 +1966,7 @@ static DICTIONARY_ITEM *dict_item_add_or_reset_value_and_acquire(DICTIONARY *dic
 
             // unlock the index lock, before we add it to the linked list
             // DON'T DO IT THE OTHER WAY AROUND - DO NOT CROSS THE LOCKS!
-            dictionary_index_wrlock_unlock(dict);
+            dictionary_index_key_wrlock_unlock(dict, hash);
 
             item_linked_list_add(dict, item);
 
@@ -1673,7 +2017,7 @@ static DICTIONARY_ITEM *dict_item_add_or_reset_value_and_acquire(DICTIONARY *dic
                 }
             }
 
-            dictionary_index_wrlock_unlock(dict);
+            dictionary_index_key_wrlock_unlock(dict, hash);
         }
     } while(!item);
 
@@ -1709,9 +2053,12 @@ static DICTIONARY_ITEM *dict_item_find_and_acquire(DICTIONARY *dict, const char
 
     debug(D_DICTIONARY, "GET dictionary entry with name '%s'.", name);
 
+    if(is_dictionary_index_partitioned(dict))
+        return index_partition_get_and_acquire(dict, name, name_len, dictionary_index_hash(dict, name, name_len));
+
     dictionary_index_lock_rdlock(dict);
 
-    DICTIONARY_ITEM *item = hashtable_get_unsafe(dict, name, name_len);
+    DICTIONARY_ITEM *item = hashtable_get_unsafe(dict, name, name_len, 0);
     if(unlikely(item && !item_check_and_acquire(dict, item))) {
         item = NULL;
         DICTIONARY_STATS_SEARCH_IGNORES_PLUS1(dict);
@@ -1961,6 +2308,10 @@ static bool api_is_name_good_with_trace(DICTIONARY *dict __maybe_unused, const c
 static DICTIONARY *dictionary_create_internal(DICT_OPTIONS options, struct dictionary_stats *stats) {
     cleanup_destroyed_dictionaries();
 
+    // a partitioned index is only useful to dictionaries used by many threads
+    if(options & DICT_OPTION_SINGLE_THREADED)
+        options &= ~DICT_OPTION_INDEX_PARTITIONED;
+
     DICTIONARY *dict = callocz(1, sizeof(DICTIONARY));
     dict->options = options;
     dict->stats = stats;
@@ -2002,7 +2353,8 @@ DICTIONARY *dictionary_create_view_with_trace(DICTIONARY *master, const char *fu
 DICTIONARY *dictionary_create_view(DICTIONARY *master) {
 #endif
 
-    DICTIONARY *dict = dictionary_create_internal(master->options, master->stats);
+    // views delete items from their index while traversing, so they always use JudyHS
+    DICTIONARY *dict = dictionary_create_internal(master->options & ~DICT_OPTION_INDEX_PARTITIONED, master->stats);
     dict->master = master;
 
     dictionary_hooks_allocate(master);
@@ -3153,7 +3505,7 @@ static void *unittest_dict_thread(void *arg) {
     return arg;
 }
 
-static int dictionary_unittest_threads() {
+static int dictionary_unittest_threads(DICT_OPTIONS options) {
 
     struct thread_unittest tu = {
         .join = 0,
@@ -3162,14 +3514,15 @@ static int dictionary_unittest_threads() {
     };
 
     // threads testing of dictionary
-    tu.dict = dictionary_create(DICT_OPTION_DONT_OVERWRITE_VALUE);
+    tu.dict = dictionary_create(DICT_OPTION_DONT_OVERWRITE_VALUE | options);
     time_t seconds_to_run = 5;
     int threads_to_create = 2;
     fprintf(
         stderr,
-        "\nChecking dictionary concurrency with %d threads for %lld seconds...\n",
+        "\nChecking dictionary concurrency with %d threads for %lld seconds%s...\n",
         threads_to_create,
-        (long long)seconds_to_run);
+        (long long)seconds_to_run,
+        (options & DICT_OPTION_INDEX_PARTITIONED) ? " (partitioned index)" : "");
 
     netdata_thread_t threads[threads_to_create];
     tu.join = 0;
@@ -3224,6 +3577,107 @@ static int dictionary_unittest_threads() {
     return 0;
 }
 
+struct thread_partitioned_unittest {
+    int join;
+    DICTIONARY *dict;
+    size_t stable_items;
+    size_t searches;
+    size_t errors;
+};
+
+static void *unittest_dict_partitioned_reader_thread(void *arg) {
+    struct thread_partitioned_unittest *tp = arg;
+    char buf[100 + 1];
+    size_t searches = 0, errors = 0;
+
+    while(!__atomic_load_n(&tp->join, __ATOMIC_RELAXED)) {
+        for(size_t i = 0; i < tp->stable_items ; i++, searches++) {
+            snprintfz(buf, 100, "stable item %zu", i);
+
+            // the stable items are never deleted, so they must always be found
+            size_t *value = dictionary_get(tp->dict, buf);
+            if(!value || *value != i)
+                errors++;
+        }
+    }
+
+    __atomic_add_fetch(&tp->searches, searches, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&tp->errors, errors, __ATOMIC_RELAXED);
+    return arg;
+}
+
+static void *unittest_dict_partitioned_writer_thread(void *arg) {
+    struct thread_partitioned_unittest *tp = arg;
+    char buf[100 + 1];
+
+    while(!__atomic_load_n(&tp->join, __ATOMIC_RELAXED)) {
+        // grow the partitions while the readers are searching them
+        for(size_t i = 0; i < 20000 ; i++) {
+            snprintfz(buf, 100, "volatile item %zu", i);
+            dictionary_set(tp->dict, buf, &i, sizeof(i));
+        }
+
+        for(size_t i = 0; i < 20000 ; i++) {
+            snprintfz(buf, 100, "volatile item %zu", i);
+            dictionary_del(tp->dict, buf);
+        }
+    }
+
+    return arg;
+}
+
+static int dictionary_unittest_partitioned_threads() {
+    struct thread_partitioned_unittest tp = {
+        .join = 0,
+        .dict = NULL,
+        .stable_items = 1000,
+    };
+
+    tp.dict = dictionary_create(DICT_OPTION_INDEX_PARTITIONED);
+
+    char buf[100 + 1];
+    for(size_t i = 0; i < tp.stable_items ; i++) {
+        snprintfz(buf, 100, "stable item %zu", i);
+        dictionary_set(tp.dict, buf, &i, sizeof(i));
+    }
+
+    time_t seconds_to_run = 3;
+    int readers = 2, writers = 2;
+    fprintf(stderr,
+            "\nChecking partitioned index lockless searches with %d readers and %d writers for %lld seconds...\n",
+            readers, writers, (long long)seconds_to_run);
+
+    netdata_thread_t threads[readers + writers];
+    for (int i = 0; i < readers + writers; i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "dictpart%d", i);
+        netdata_thread_create(
+            &threads[i],
+            tag,
+            NETDATA_THREAD_OPTION_DONT_LOG | NETDATA_THREAD_OPTION_JOINABLE,
+            (i < readers) ? unittest_dict_partitioned_reader_thread : unittest_dict_partitioned_writer_thread,
+            &tp);
+    }
+    sleep_usec(seconds_to_run * USEC_PER_SEC);
+
+    __atomic_store_n(&tp.join, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < readers + writers; i++) {
+        void *retval;
+        netdata_thread_join(threads[i], &retval);
+    }
+
+    size_t entries = dictionary_entries(tp.dict);
+    if(entries != tp.stable_items)
+        tp.errors++;
+
+    fprintf(stderr,
+            "searches %zu, inserts %zu, deletes %zu, entries %zu, errors %zu\n",
+            tp.searches, tp.dict->stats->ops.inserts, tp.dict->stats->ops.deletes, entries, tp.errors);
+
+    dictionary_destroy(tp.dict);
+    return (int)tp.errors;
+}
+
 struct thread_view_unittest {
     int join;
     DICTIONARY *master;
@@ -3506,6 +3960,16 @@ int dictionary_unittest(size_t entries) {
     dict = dictionary_create(DICT_OPTION_NONE);
     dictionary_unittest_clone(dict, names, values, entries, &errors);
 
+    fprintf(stderr, "\nCreating dictionary multi threaded, clone, partitioned index, %zu items\n", entries);
+    dict = dictionary_create(DICT_OPTION_INDEX_PARTITIONED);
+    dictionary_unittest_clone(dict, names, values, entries, &errors);
+
+    fprintf(stderr, "\nCreating dictionary multi threaded, non-clone, add-in-front, partitioned index, %zu items\n", entries);
+    dict = dictionary_create(
+        DICT_OPTION_NAME_LINK_DONT_CLONE | DICT_OPTION_VALUE_LINK_DONT_CLONE | DICT_OPTION_ADD_IN_FRONT |
+        DICT_OPTION_INDEX_PARTITIONED);
+    dictionary_unittest_nonclone(dict, names, values, entries, &errors);
+
     fprintf(stderr, "\nCreating dictionary single threaded, non-clone, add-in-front options, %zu items\n", entries);
     dict = dictionary_create(
         DICT_OPTION_SINGLE_THREADED | DICT_OPTION_NAME_LINK_DONT_CLONE | DICT_OPTION_VALUE_LINK_DONT_CLONE |
@@ -3636,7 +4100,9 @@ int dictionary_unittest(size_t entries) {
     dictionary_unittest_free_char_pp(values, entries);
 
     errors += dictionary_unittest_views();
-    errors += dictionary_unittest_threads();
+    errors += dictionary_unittest_threads(DICT_OPTION_NONE);
+    errors += dictionary_unittest_threads(DICT_OPTION_INDEX_PARTITIONED);
+    errors += dictionary_unittest_partitioned_threads();
     errors += dictionary_unittest_view_threads();
 
     fprintf(stderr, "\n%zu errors found\n", errors);
@@ -53,6 +53,7 @@ typedef enum dictionary_options {
     DICT_OPTION_NAME_LINK_DONT_CLONE    = (1 << 2), // don't copy the name, just point to the one provided (default: copy)
     DICT_OPTION_DONT_OVERWRITE_VALUE    = (1 << 3), // don't overwrite values of dictionary items (default: overwrite)
     DICT_OPTION_ADD_IN_FRONT            = (1 << 4), // add dictionary items at the front of the linked list (default: at the end)
+    DICT_OPTION_INDEX_PARTITIONED       = (1 << 5), // partition the index and search it without locks (default: one JudyHS with a rwlock)
 } DICT_OPTIONS;
 
 struct dictionary_stats {
@@ -488,6 +488,446 @@ static inline void log_unlock() {
     netdata_mutex_unlock(&log_mutex);
 }
 
+// ----------------------------------------------------------------------------
+// asynchronous logging
+//
+// When enabled, the daemon threads do not write their logs to the log files.
+// They format each line in a thread local buffer and append it to a ring
+// buffer that belongs to the thread (single producer, single consumer),
+// without taking any locks. A dedicated logger thread drains all the rings,
+// batches the lines per log file and writes them with a few write() calls.
+//
+// The memory is bounded: when the ring of a thread is full, the line is
+// dropped and accounted in the dropped messages counter, which is also
+// reported in the error log by the logger thread.
+//
+// fatal() and the exit path flush everything synchronously.
+
+int log_async_enabled = 1;
+size_t log_async_buffer_size = LOG_ASYNC_DEFAULT_BUFFER_SIZE;
+
+#define LOG_ASYNC_MAX_LINE       8192
+#define LOG_ASYNC_BATCH_SIZE     (64 * 1024)
+#define LOG_ASYNC_MIN_SLEEP_UT   (5 * USEC_PER_MS)
+#define LOG_ASYNC_MAX_SLEEP_UT   (100 * USEC_PER_MS)
+#define LOG_ASYNC_RECORD_WRAP    UINT32_MAX
+#define LOG_ASYNC_ALIGN(x)       (((x) + 7) & ~((size_t)7))
+
+typedef enum {
+    LOG_ASYNC_ERROR = 0,
+    LOG_ASYNC_ACCESS,
+    LOG_ASYNC_HEALTH,
+
+    // terminator
+    LOG_ASYNC_MAX,
+} LOG_ASYNC_TYPE;
+
+struct log_async_record {
+    uint32_t len;                       // the length of the line following the header
+    uint16_t syslog_offset;             // where the message starts in the line, for syslog
+    uint8_t type;                       // LOG_ASYNC_TYPE
+    int8_t priority;                    // the syslog priority, or -1 to not send it to syslog
+};
+
+struct log_async_ring {
+    size_t head;                        // updated only by the producer
+    size_t tail;                        // updated only by the consumer
+    bool abandoned;                     // the thread exited
+
+    char *data;
+    struct log_async_ring *prev, *next;
+};
+
+static struct {
+    bool running;                       // the logger thread is running
+    size_t size;                        // the size of each ring, a power of 2
+
+    SPINLOCK spinlock;                  // protects the list of rings - taken only to add or remove a ring
+    struct log_async_ring *rings;
+
+    netdata_mutex_t drain_mutex;        // only one drainer at a time (the logger thread, fatal() or exit)
+
+    bool wakeup_pending;                // a ring is more than half full, the logger thread should run now
+    netdata_mutex_t wakeup_mutex;
+    pthread_cond_t wakeup_cond;
+    pthread_key_t key;
+    netdata_thread_t thread;
+
+    struct {
+        char data[LOG_ASYNC_BATCH_SIZE];
+        size_t len;
+    } batches[LOG_ASYNC_MAX];
+
+    size_t dropped_reported;
+
+    struct {
+        size_t queued;
+        size_t written;
+        size_t dropped;
+        size_t writes;
+    } atomic;
+} log_async = {
+    .running = false,
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .rings = NULL,
+    .drain_mutex = NETDATA_MUTEX_INITIALIZER,
+    .wakeup_pending = false,
+    .wakeup_mutex = NETDATA_MUTEX_INITIALIZER,
+    .wakeup_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static bool log_async_active = false;
+static __thread struct log_async_ring *log_async_thread_ring = NULL;
+static __thread bool log_async_is_drainer = false;
+static __thread char log_async_line[LOG_ASYNC_MAX_LINE];
+
+static inline bool log_async_is_active(void) {
+    return __atomic_load_n(&log_async_active, __ATOMIC_ACQUIRE);
+}
+
+static inline size_t log_async_vsnprintf(char *dst, size_t size, size_t used, const char *fmt, va_list args) {
+    if(used + 1 >= size)
+        return used;
+
+    int ret = vsnprintf(&dst[used], size - used, fmt, args);
+    if(ret < 0)
+        return used;
+
+    used += (size_t)ret;
+    return (used >= size) ? size - 1 : used;
+}
+
+static inline size_t log_async_snprintf(char *dst, size_t size, size_t used, const char *fmt, ...) PRINTFLIKE(4, 5);
+static inline size_t log_async_snprintf(char *dst, size_t size, size_t used, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    used = log_async_vsnprintf(dst, size, used, fmt, args);
+    va_end(args);
+    return used;
+}
+
+static void log_async_wakeup(void) {
+    if(__atomic_exchange_n(&log_async.wakeup_pending, true, __ATOMIC_ACQ_REL))
+        return;
+
+    netdata_mutex_lock(&log_async.wakeup_mutex);
+    pthread_cond_signal(&log_async.wakeup_cond);
+    netdata_mutex_unlock(&log_async.wakeup_mutex);
+}
+
+static void log_async_wait(usec_t timeout_ut) {
+    netdata_mutex_lock(&log_async.wakeup_mutex);
+
+    if(!__atomic_load_n(&log_async.wakeup_pending, __ATOMIC_ACQUIRE)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        usec_t ut = (usec_t)ts.tv_nsec / NSEC_PER_USEC + timeout_ut;
+        ts.tv_sec += (time_t)(ut / USEC_PER_SEC);
+        ts.tv_nsec = (long)((ut % USEC_PER_SEC) * NSEC_PER_USEC);
+        pthread_cond_timedwait(&log_async.wakeup_cond, &log_async.wakeup_mutex, &ts);
+    }
+
+    __atomic_store_n(&log_async.wakeup_pending, false, __ATOMIC_RELEASE);
+    netdata_mutex_unlock(&log_async.wakeup_mutex);
+}
+
+static size_t log_async_line_header(char *s, const char *prefix, const char *file __maybe_unused, const char *function __maybe_unused, const unsigned long line __maybe_unused) {
+    char date[LOG_DATE_LENGTH];
+    log_date(date, LOG_DATE_LENGTH, now_realtime_sec());
+
+#ifdef NETDATA_INTERNAL_CHECKS
+    return log_async_snprintf(s, LOG_ASYNC_MAX_LINE, 0, "%s: %s %-5.5s : %s : (%04lu@%-20.20s:%-15.15s): ", date, program_name, prefix, netdata_thread_tag(), line, file, function);
+#else
+    return log_async_snprintf(s, LOG_ASYNC_MAX_LINE, 0, "%s: %s %-5.5s : %s : ", date, program_name, prefix, netdata_thread_tag());
+#endif
+}
+
+static void log_async_thread_exit(void *ptr) {
+    struct log_async_ring *ring = ptr;
+
+    if(log_async_thread_ring == ring)
+        log_async_thread_ring = NULL;
+
+    // the logger thread will free it, after draining it
+    __atomic_store_n(&ring->abandoned, true, __ATOMIC_RELEASE);
+}
+
+static struct log_async_ring *log_async_get_thread_ring(void) {
+    if(likely(log_async_thread_ring))
+        return log_async_thread_ring;
+
+    struct log_async_ring *ring = callocz(1, sizeof(struct log_async_ring));
+    ring->data = mallocz(log_async.size);
+
+    netdata_spinlock_lock(&log_async.spinlock);
+    DOUBLE_LINKED_LIST_PREPEND_UNSAFE(log_async.rings, ring, prev, next);
+    netdata_spinlock_unlock(&log_async.spinlock);
+
+    pthread_setspecific(log_async.key, ring);
+    log_async_thread_ring = ring;
+    return ring;
+}
+
+// append a line (without the trailing newline) to the ring of the calling thread
+static void log_async_enqueue(LOG_ASYNC_TYPE type, int priority, const char *line, size_t len, size_t syslog_offset) {
+    struct log_async_ring *ring = log_async_get_thread_ring();
+    size_t size = log_async.size;
+
+    if(unlikely(len + 1 > size / 4))
+        len = size / 4 - 1;
+
+    size_t need = LOG_ASYNC_ALIGN(sizeof(struct log_async_record) + len + 1);
+    size_t head = ring->head;
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t pos = head & (size - 1);
+    size_t to_end = size - pos;
+    size_t total = (to_end < need) ? to_end + need : need;
+
+    if(unlikely(size - (head - tail) < total)) {
+        __atomic_add_fetch(&log_async.atomic.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    struct log_async_record *rec;
+
+    if(unlikely(to_end < need)) {
+        // the record does not fit at the end of the ring, skip to its beginning
+        rec = (struct log_async_record *)&ring->data[pos];
+        rec->len = LOG_ASYNC_RECORD_WRAP;
+        head += to_end;
+        pos = 0;
+    }
+
+    rec = (struct log_async_record *)&ring->data[pos];
+    rec->len = (uint32_t)(len + 1);
+    rec->syslog_offset = (uint16_t)((syslog_offset < len) ? syslog_offset : len);
+    rec->type = (uint8_t)type;
+    rec->priority = (int8_t)priority;
+
+    char *s = (char *)&rec[1];
+    memcpy(s, line, len);
+    s[len] = '\n';
+
+    __atomic_store_n(&ring->head, head + need, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&log_async.atomic.queued, 1, __ATOMIC_RELAXED);
+
+    // do not wait for the logger thread to wake up by itself
+    if(unlikely(head + need - tail > size / 2))
+        log_async_wakeup();
+}
+
+static int log_async_fd(LOG_ASYNC_TYPE type) {
+    switch(type) {
+        case LOG_ASYNC_ACCESS:
+            return stdaccess ? stdaccess_fd : -1;
+
+        case LOG_ASYNC_HEALTH:
+            return stdhealth ? stdhealth_fd : -1;
+
+        default:
+            return STDERR_FILENO;
+    }
+}
+
+static void log_async_write_batch(LOG_ASYNC_TYPE type) {
+    char *s = log_async.batches[type].data;
+    size_t len = log_async.batches[type].len;
+    int fd = log_async_fd(type);
+
+    while(len && fd != -1) {
+        ssize_t ret = write(fd, s, len);
+        if(ret < 0) {
+            if(errno == EINTR || errno == EAGAIN)
+                continue;
+
+            break;
+        }
+
+        s += ret;
+        len -= (size_t)ret;
+        __atomic_add_fetch(&log_async.atomic.writes, 1, __ATOMIC_RELAXED);
+    }
+
+    log_async.batches[type].len = 0;
+}
+
+static void log_async_batch_append(LOG_ASYNC_TYPE type, const char *s, size_t len) {
+    if(log_async.batches[type].len + len > LOG_ASYNC_BATCH_SIZE)
+        log_async_write_batch(type);
+
+    memcpy(&log_async.batches[type].data[log_async.batches[type].len], s, len);
+    log_async.batches[type].len += len;
+}
+
+static size_t log_async_drain_ring(struct log_async_ring *ring) {
+    size_t size = log_async.size;
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t tail = ring->tail;
+    size_t lines = 0;
+
+    while(tail != head) {
+        size_t pos = tail & (size - 1);
+        struct log_async_record *rec = (struct log_async_record *)&ring->data[pos];
+
+        if(rec->len == LOG_ASYNC_RECORD_WRAP) {
+            tail += size - pos;
+            continue;
+        }
+
+        const char *s = (const char *)&rec[1];
+        log_async_batch_append(rec->type, s, rec->len);
+
+        if(rec->priority >= 0)
+            syslog(rec->priority, "%.*s", (int)(rec->len - 1 - rec->syslog_offset), &s[rec->syslog_offset]);
+
+        tail += LOG_ASYNC_ALIGN(sizeof(struct log_async_record) + rec->len);
+        lines++;
+    }
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    return lines;
+}
+
+// drain all the rings and write everything to the log files
+// returns the number of lines written
+static size_t log_async_drain(void) {
+    size_t lines = 0;
+
+    // fatal() while draining, from the drainer itself
+    if(log_async_is_drainer)
+        return 0;
+
+    netdata_mutex_lock(&log_async.drain_mutex);
+    log_async_is_drainer = true;
+
+    netdata_spinlock_lock(&log_async.spinlock);
+    struct log_async_ring *ring = log_async.rings;
+    netdata_spinlock_unlock(&log_async.spinlock);
+
+    // new rings are always prepended, so walking the list
+    // from the head we got does not need the spinlock
+    while(ring) {
+        struct log_async_ring *next = ring->next;
+        bool abandoned = __atomic_load_n(&ring->abandoned, __ATOMIC_ACQUIRE);
+
+        lines += log_async_drain_ring(ring);
+
+        if(abandoned) {
+            netdata_spinlock_lock(&log_async.spinlock);
+            DOUBLE_LINKED_LIST_REMOVE_UNSAFE(log_async.rings, ring, prev, next);
+            netdata_spinlock_unlock(&log_async.spinlock);
+
+            freez(ring->data);
+            freez(ring);
+        }
+
+        ring = next;
+    }
+
+    size_t dropped = __atomic_load_n(&log_async.atomic.dropped, __ATOMIC_RELAXED);
+    if(unlikely(dropped != log_async.dropped_reported)) {
+        char date[LOG_DATE_LENGTH];
+        log_date(date, LOG_DATE_LENGTH, now_realtime_sec());
+
+        char buf[512];
+        size_t len = (size_t)snprintfz(buf, sizeof(buf) - 1,
+                                       "%s: %s ERROR : LOGGER : dropped %zu log messages, because the log buffers of the threads were full\n",
+                                       date, program_name, dropped - log_async.dropped_reported);
+        log_async_batch_append(LOG_ASYNC_ERROR, buf, len);
+        log_async.dropped_reported = dropped;
+    }
+
+    for(size_t type = 0; type < LOG_ASYNC_MAX ;type++)
+        log_async_write_batch(type);
+
+    __atomic_add_fetch(&log_async.atomic.written, lines, __ATOMIC_RELAXED);
+
+    log_async_is_drainer = false;
+    netdata_mutex_unlock(&log_async.drain_mutex);
+
+    return lines;
+}
+
+static void *log_async_thread(void *ptr __maybe_unused) {
+    usec_t sleep_ut = LOG_ASYNC_MIN_SLEEP_UT;
+
+    while(__atomic_load_n(&log_async.running, __ATOMIC_ACQUIRE)) {
+        log_async_wait(sleep_ut);
+
+        if(log_async_drain())
+            sleep_ut = LOG_ASYNC_MIN_SLEEP_UT;
+        else if(sleep_ut < LOG_ASYNC_MAX_SLEEP_UT)
+            sleep_ut *= 2;
+    }
+
+    return NULL;
+}
+
+static void log_async_atfork_child(void) {
+    // the logger thread does not exist in the child
+    log_async_active = false;
+    log_async.running = false;
+}
+
+void log_async_start(void) {
+    if(!log_async_enabled || log_async_active)
+        return;
+
+    size_t size = 4096;
+    while(size < log_async_buffer_size && size < 16 * 1024 * 1024)
+        size <<= 1;
+    log_async.size = size;
+
+    if(pthread_key_create(&log_async.key, log_async_thread_exit) != 0) {
+        error("LOG: cannot create the thread key for asynchronous logging, logging synchronously");
+        return;
+    }
+
+    pthread_atfork(NULL, NULL, log_async_atfork_child);
+
+    fflush(stderr);
+    if(stdaccess) fflush(stdaccess);
+    if(stdhealth) fflush(stdhealth);
+
+    __atomic_store_n(&log_async.running, true, __ATOMIC_RELEASE);
+    if(netdata_thread_create(&log_async.thread, "LOGGER", NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG, log_async_thread, NULL) != 0) {
+        __atomic_store_n(&log_async.running, false, __ATOMIC_RELEASE);
+        error("LOG: cannot start the logger thread, logging synchronously");
+        return;
+    }
+
+    __atomic_store_n(&log_async_active, true, __ATOMIC_RELEASE);
+    info("LOG: asynchronous logging enabled, with %zu bytes of log buffer per thread", size);
+}
+
+// write synchronously everything queued so far
+void log_async_flush(void) {
+    if(!log_async.size)
+        return;
+
+    log_async_drain();
+}
+
+// switch to synchronous logging and flush everything queued
+void log_async_stop(void) {
+    if(!__atomic_exchange_n(&log_async_active, false, __ATOMIC_ACQ_REL))
+        return;
+
+    if(__atomic_exchange_n(&log_async.running, false, __ATOMIC_ACQ_REL)) {
+        log_async_wakeup();
+        netdata_thread_join(log_async.thread, NULL);
+    }
+
+    log_async_drain();
+}
+
+void log_async_statistics(size_t *queued, size_t *written, size_t *dropped, size_t *writes) {
+    *queued = __atomic_load_n(&log_async.atomic.queued, __ATOMIC_RELAXED);
+    *written = __atomic_load_n(&log_async.atomic.written, __ATOMIC_RELAXED);
+    *dropped = __atomic_load_n(&log_async.atomic.dropped, __ATOMIC_RELAXED);
+    *writes = __atomic_load_n(&log_async.atomic.writes, __ATOMIC_RELAXED);
+}
+
 static FILE *open_log_file(int fd, FILE *fp, const char *filename, int *enabled_syslog, int is_stdaccess, int *fd_ptr) {
     int f, devnull = 0;
 
@@ -770,6 +1210,21 @@ void info_int( const char *file __maybe_unused, const char *function __maybe_unu
         return;
     }
 
+    if(log_async_is_active()) {
+        log_unlock();
+
+        char *s = log_async_line;
+        size_t len = log_async_line_header(s, "INFO", file, function, line);
+        size_t offset = len;
+
+        va_start( args, fmt );
+        len = log_async_vsnprintf(s, LOG_ASYNC_MAX_LINE, len, fmt, args);
+        va_end( args );
+
+        log_async_enqueue(LOG_ASYNC_ERROR, error_log_syslog ? LOG_INFO : -1, s, len, offset);
+        return;
+    }
+
     if(error_log_syslog) {
         va_start( args, fmt );
         vsyslog(LOG_INFO,  fmt, args );
@@ -842,6 +1297,37 @@ void error_limit_int(ERROR_LIMIT *erl, const char *prefix, const char *file __ma
         return;
     }
 
+    if(log_async_is_active()) {
+        size_t count = erl->count;
+        time_t last_logged = erl->last_logged;
+        erl->last_logged = now;
+        erl->count = 0;
+        log_unlock();
+
+        char *s = log_async_line;
+        size_t len = log_async_line_header(s, prefix, file, function, line);
+        size_t offset = len;
+
+        va_start( args, fmt );
+        len = log_async_vsnprintf(s, LOG_ASYNC_MAX_LINE, len, fmt, args);
+        va_end( args );
+
+        if(count > 1)
+            len = log_async_snprintf(s, LOG_ASYNC_MAX_LINE, len, " (similar messages repeated %zu times in the last %llu secs)", count, (unsigned long long)(last_logged ? now - last_logged : 0));
+
+        if(erl->sleep_ut)
+            len = log_async_snprintf(s, LOG_ASYNC_MAX_LINE, len, " (sleeping for %llu microseconds every time this happens)", erl->sleep_ut);
+
+        if(__errno) {
+            char buf[1024];
+            len = log_async_snprintf(s, LOG_ASYNC_MAX_LINE, len, " (errno %d, %s)", __errno, strerror_result(strerror_r(__errno, buf, 1023), buf));
+            errno = 0;
+        }
+
+        log_async_enqueue(LOG_ASYNC_ERROR, error_log_syslog ? LOG_ERR : -1, s, len, offset);
+        return;
+    }
+
     if(error_log_syslog) {
         va_start( args, fmt );
         vsyslog(LOG_ERR,  fmt, args );
@@ -894,6 +1380,27 @@ void error_int(const char *prefix, const char *file __maybe_unused, const char *
         return;
     }
 
+    if(log_async_is_active()) {
+        log_unlock();
+
+        char *s = log_async_line;
+        size_t len = log_async_line_header(s, prefix, file, function, line);
+        size_t offset = len;
+
+        va_start( args, fmt );
+        len = log_async_vsnprintf(s, LOG_ASYNC_MAX_LINE, len, fmt, args);
+        va_end( args );
+
+        if(__errno) {
+            char buf[1024];
+            len = log_async_snprintf(s, LOG_ASYNC_MAX_LINE, len, " (errno %d, %s)", __errno, strerror_result(strerror_r(__errno, buf, 1023), buf));
+            errno = 0;
+        }
+
+        log_async_enqueue(LOG_ASYNC_ERROR, error_log_syslog ? LOG_ERR : -1, s, len, offset);
+        return;
+    }
+
     if(error_log_syslog) {
         va_start( args, fmt );
         vsyslog(LOG_ERR,  fmt, args );
@@ -963,6 +1470,9 @@ void fatal_int( const char *file, const char *function, const unsigned long line
         }
     }
 
+    // write everything queued before the fatal message
+    log_async_flush();
+
     char date[LOG_DATE_LENGTH];
     log_date(date, LOG_DATE_LENGTH, now_realtime_sec());
 
@@ -1006,6 +1516,22 @@ void fatal_int( const char *file, const char *function, const unsigned long line
 void log_access( const char *fmt, ... ) {
     va_list args;
 
+    if(log_async_is_active()) {
+        char date[LOG_DATE_LENGTH];
+        log_date(date, LOG_DATE_LENGTH, now_realtime_sec());
+
+        char *s = log_async_line;
+        size_t len = log_async_snprintf(s, LOG_ASYNC_MAX_LINE, 0, "%s: ", date);
+        size_t offset = len;
+
+        va_start( args, fmt );
+        len = log_async_vsnprintf(s, LOG_ASYNC_MAX_LINE, len, fmt, args);
+        va_end( args );
+
+        log_async_enqueue(LOG_ASYNC_ACCESS, access_log_syslog ? LOG_INFO : -1, s, len, offset);
+        return;
+    }
+
     if(access_log_syslog) {
         va_start( args, fmt );
         vsyslog(LOG_INFO,  fmt, args );
@@ -1038,6 +1564,22 @@ void log_access( const char *fmt, ... ) {
 void log_health( const char *fmt, ... ) {
     va_list args;
 
+    if(log_async_is_active()) {
+        char date[LOG_DATE_LENGTH];
+        log_date(date, LOG_DATE_LENGTH, now_realtime_sec());
+
+        char *s = log_async_line;
+        size_t len = log_async_snprintf(s, LOG_ASYNC_MAX_LINE, 0, "%s: ", date);
+        size_t offset = len;
+
+        va_start( args, fmt );
+        len = log_async_vsnprintf(s, LOG_ASYNC_MAX_LINE, len, fmt, args);
+        va_end( args );
+
+        log_async_enqueue(LOG_ASYNC_HEALTH, health_log_syslog ? LOG_INFO : -1, s, len, offset);
+        return;
+    }
+
     if(health_log_syslog) {
         va_start( args, fmt );
         vsyslog(LOG_INFO,  fmt, args );
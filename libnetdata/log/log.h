@@ -86,6 +86,15 @@ int error_log_limit(int reset);
 void open_all_log_files();
 void reopen_all_log_files();
 
+#define LOG_ASYNC_DEFAULT_BUFFER_SIZE (64 * 1024)
+extern int log_async_enabled;
+extern size_t log_async_buffer_size;
+
+void log_async_start(void);
+void log_async_flush(void);
+void log_async_stop(void);
+void log_async_statistics(size_t *queued, size_t *written, size_t *dropped, size_t *writes);
+
 #define LOG_DATE_LENGTH 26
 void log_date(char *buffer, size_t len, time_t now);
 
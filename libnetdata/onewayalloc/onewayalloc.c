@@ -14,6 +14,53 @@ typedef struct owa_page {
     struct owa_page *last;     // the last page on the list - we currently allocate on this
 } OWA_PAGE;
 
+// ----------------------------------------------------------------------------
+// per thread page cache
+//
+// Queries create and destroy an OWA each time they run. To avoid allocating
+// and releasing (usually mmap()ing and munmap()ing) the same memory again and
+// again, the pages of destroyed OWAs are kept in a per thread cache, by size
+// class (natural page size * 2^class), and are reused by the next OWAs of the
+// same thread. The cache is bounded per thread and it is freed when the
+// thread exits.
+
+#define OWA_CACHE_SIZE_CLASSES 12                           // up to 8MiB pages, for 4KiB natural pages
+#define OWA_CACHE_MAX_SIZE_PER_THREAD (8 * 1024 * 1024)
+
+static size_t OWA_NATURAL_PAGE_SIZE = 0;
+
+static pthread_key_t owa_cache_key;
+static pthread_once_t owa_cache_key_once = PTHREAD_ONCE_INIT;
+
+static __thread struct {
+    bool key_set;
+    size_t cached_size;                                     // the bytes kept in the cache
+    size_t last_owa_size;                                   // the total size of the last OWA destroyed
+    struct owa_page *pages[OWA_CACHE_SIZE_CLASSES];
+    struct onewayalloc_thread_statistics stats;
+} owa_cache = { 0 };
+
+static void onewayalloc_thread_cache_free(void *ptr __maybe_unused) {
+    onewayalloc_thread_cache_cleanup();
+}
+
+static void onewayalloc_thread_cache_key_create(void) {
+    if(pthread_key_create(&owa_cache_key, onewayalloc_thread_cache_free) != 0)
+        error("ONEWAYALLOC: cannot create the thread key to free the thread cache on thread exit");
+}
+
+static inline int onewayalloc_size_class(size_t size) {
+    int c = 0;
+    size_t class_size = OWA_NATURAL_PAGE_SIZE;
+
+    while(class_size < size && c < OWA_CACHE_SIZE_CLASSES) {
+        class_size <<= 1;
+        c++;
+    }
+
+    return (c < OWA_CACHE_SIZE_CLASSES) ? c : -1;
+}
+
 // allocations need to be aligned to CPU register width
 // https://en.wikipedia.org/wiki/Data_structure_alignment
 static inline size_t natural_alignment(size_t size) {
@@ -28,8 +75,6 @@ static inline size_t natural_alignment(size_t size) {
 // any number of times, for any amount of memory.
 
 static OWA_PAGE *onewayalloc_create_internal(OWA_PAGE *head, size_t size_hint) {
-    static size_t OWA_NATURAL_PAGE_SIZE = 0;
-
     if(unlikely(!OWA_NATURAL_PAGE_SIZE)) {
         long int page_size = sysconf(_SC_PAGE_SIZE);
         if (unlikely(page_size == -1))
@@ -53,13 +98,36 @@ static OWA_PAGE *onewayalloc_create_internal(OWA_PAGE *head, size_t size_hint) {
         size_t optimal_size = head->stats_pages_size / 2;
         if(optimal_size > size) size = optimal_size;
     }
+    else if(owa_cache.last_owa_size > size && onewayalloc_size_class(owa_cache.last_owa_size) != -1) {
+        // the previous query of this thread needed that much,
+        // so start with a page that can fit it
+        size = owa_cache.last_owa_size;
+    }
 
     // Make sure our allocations are always a multiple of the hardware page size
     if(size % OWA_NATURAL_PAGE_SIZE) size = size + OWA_NATURAL_PAGE_SIZE - (size % OWA_NATURAL_PAGE_SIZE);
 
-    // OWA_PAGE *page = (OWA_PAGE *)netdata_mmap(NULL, size, MAP_ANONYMOUS|MAP_PRIVATE, 0);
-    // if(unlikely(!page)) fatal("Cannot allocate onewayalloc buffer of size %zu", size);
-    OWA_PAGE *page = (OWA_PAGE *)mallocz(size);
+    OWA_PAGE *page = NULL;
+
+    // round it up to its size class, to reuse it
+    int c = onewayalloc_size_class(size);
+    if(c != -1) {
+        size = OWA_NATURAL_PAGE_SIZE << c;
+
+        if(owa_cache.pages[c]) {
+            page = owa_cache.pages[c];
+            owa_cache.pages[c] = page->next;
+            owa_cache.cached_size -= size;
+            owa_cache.stats.pages_reused++;
+        }
+    }
+
+    if(!page) {
+        // OWA_PAGE *page = (OWA_PAGE *)netdata_mmap(NULL, size, MAP_ANONYMOUS|MAP_PRIVATE, 0);
+        // if(unlikely(!page)) fatal("Cannot allocate onewayalloc buffer of size %zu", size);
+        page = (OWA_PAGE *)mallocz(size);
+        owa_cache.stats.pages_allocated++;
+    }
 
     page->size = size;
     page->offset = natural_alignment(sizeof(OWA_PAGE));
@@ -86,6 +154,7 @@ static OWA_PAGE *onewayalloc_create_internal(OWA_PAGE *head, size_t size_hint) {
 }
 
 ONEWAYALLOC *onewayalloc_create(size_t size_hint) {
+    owa_cache.stats.arenas++;
     return (ONEWAYALLOC *)onewayalloc_create_internal(NULL, size_hint);
 }
 
@@ -96,6 +165,7 @@ void *onewayalloc_mallocz(ONEWAYALLOC *owa, size_t size) {
     // update stats
     head->stats_mallocs_made++;
     head->stats_mallocs_size += size;
+    owa_cache.stats.allocations++;
 
     // make sure the size is aligned
     size = natural_alignment(size);
@@ -183,11 +253,50 @@ void onewayalloc_destroy(ONEWAYALLOC *owa) {
     //     head->stats_mallocs_made, head->stats_mallocs_size,
     //     head->stats_pages, head->stats_pages_size);
 
+    owa_cache.last_owa_size = head->stats_pages_size;
+
+    if(unlikely(!owa_cache.key_set)) {
+        pthread_once(&owa_cache_key_once, onewayalloc_thread_cache_key_create);
+        pthread_setspecific(owa_cache_key, &owa_cache);
+        owa_cache.key_set = true;
+    }
+
     OWA_PAGE *page = head;
     while(page) {
         OWA_PAGE *p = page;
         page = page->next;
+
+        int c = onewayalloc_size_class(p->size);
+        if(c != -1 && p->size == (OWA_NATURAL_PAGE_SIZE << c) && owa_cache.cached_size + p->size <= OWA_CACHE_MAX_SIZE_PER_THREAD) {
+            // keep it for the next OWA of this thread
+            p->next = owa_cache.pages[c];
+            owa_cache.pages[c] = p;
+            owa_cache.cached_size += p->size;
+            continue;
+        }
+
         // munmap(p, p->size);
         freez(p);
     }
 }
+
+// free all the pages cached by the calling thread
+void onewayalloc_thread_cache_cleanup(void) {
+    for(int c = 0; c < OWA_CACHE_SIZE_CLASSES ;c++) {
+        while(owa_cache.pages[c]) {
+            OWA_PAGE *p = owa_cache.pages[c];
+            owa_cache.pages[c] = p->next;
+            freez(p);
+        }
+    }
+
+    owa_cache.cached_size = 0;
+    owa_cache.last_owa_size = 0;
+    owa_cache.key_set = false;
+}
+
+// the statistics of the calling thread - all counters are cumulative
+void onewayalloc_thread_statistics(struct onewayalloc_thread_statistics *stats) {
+    *stats = owa_cache.stats;
+    stats->cached_bytes = owa_cache.cached_size;
+}
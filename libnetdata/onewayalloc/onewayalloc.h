@@ -16,4 +16,15 @@ void onewayalloc_freez(ONEWAYALLOC *owa, const void *ptr);
 
 void *onewayalloc_doublesize(ONEWAYALLOC *owa, const void *src, size_t oldsize);
 
+struct onewayalloc_thread_statistics {
+    size_t arenas;                  // the OWAs created
+    size_t allocations;             // the onewayalloc_mallocz() calls
+    size_t pages_allocated;         // the pages allocated from the system
+    size_t pages_reused;            // the pages served by the thread cache
+    size_t cached_bytes;            // the bytes kept in the thread cache
+};
+
+void onewayalloc_thread_statistics(struct onewayalloc_thread_statistics *stats);
+void onewayalloc_thread_cache_cleanup(void);
+
 #endif // ONEWAYALLOC_H
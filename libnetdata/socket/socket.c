@@ -81,6 +81,52 @@ int sock_enlarge_out(int fd) {
     return ret;
 }
 
+// returns true when the peer of a socket has gone away, or the socket has failed,
+// without consuming any data the peer has sent.
+// A peer that has only closed its sending side (FIN) is gone only when eof_is_close
+// is true - HTTP/1.0 tools and nc -N shutdown their side and still wait for the response.
+bool sock_peer_has_closed(int fd, bool eof_is_close) {
+    if(fd < 0)
+        return false;
+
+    struct pollfd pfd = {
+        .fd = fd,
+#ifdef POLLRDHUP
+        .events = eof_is_close ? (POLLIN | POLLRDHUP) : 0,
+#else
+        .events = eof_is_close ? POLLIN : 0,
+#endif
+        .revents = 0,
+    };
+
+    if(poll(&pfd, 1, 0) <= 0)
+        return false;
+
+    if(pfd.revents & (POLLERR | POLLHUP | POLLNVAL))
+        return true;
+
+    if(!eof_is_close)
+        return false;
+
+#ifdef POLLRDHUP
+    if(pfd.revents & POLLRDHUP)
+        return true;
+#endif
+
+    if(pfd.revents & POLLIN) {
+        // the peer may have sent more requests (pipelining), or the end of its stream
+        char c;
+        ssize_t rc = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        if(rc == 0)
+            return true;
+
+        if(rc == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return true;
+    }
+
+    return false;
+}
+
 
 // --------------------------------------------------------------------------------------------------------------------
 
@@ -518,8 +564,6 @@ static inline int bind_to_this(LISTEN_SOCKETS *sockets, const char *definition,
 }
 
 int listen_sockets_setup(LISTEN_SOCKETS *sockets) {
-    listen_sockets_init(sockets);
-
     sockets->backlog = (int) appconfig_get_number(sockets->config, sockets->config_section, "listen backlog", sockets->backlog);
 
     long long int old_port = sockets->default_port;
@@ -532,9 +576,16 @@ int listen_sockets_setup(LISTEN_SOCKETS *sockets) {
 
     debug(D_OPTIONS, "LISTENER: Default listen port set to %d.", sockets->default_port);
 
-    char *s = appconfig_get(sockets->config, sockets->config_section, "bind to", sockets->default_bind_to);
+    return listen_sockets_setup_bind_to(sockets, appconfig_get(sockets->config, sockets->config_section, "bind to", sockets->default_bind_to));
+}
+
+// open the sockets of the bind to string given, using the default port and backlog already set in sockets
+int listen_sockets_setup_bind_to(LISTEN_SOCKETS *sockets, const char *bind_to) {
+    listen_sockets_init(sockets);
+
+    const char *s = bind_to;
     while(*s) {
-        char *e = s;
+        const char *e = s;
 
         // skip separators, moving both s(tart) and e(nd)
         while(isspace(*e) || *e == ',') s = ++e;
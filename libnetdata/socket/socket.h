@@ -55,6 +55,7 @@ typedef struct listen_sockets {
 char *strdup_client_description(int family, const char *protocol, const char *ip, uint16_t port);
 
 int listen_sockets_setup(LISTEN_SOCKETS *sockets);
+int listen_sockets_setup_bind_to(LISTEN_SOCKETS *sockets, const char *bind_to);
 void listen_sockets_close(LISTEN_SOCKETS *sockets);
 
 void foreach_entry_in_connection_string(const char *destination, bool (*callback)(char *entry, void *data), void *data);
@@ -80,6 +81,7 @@ int sock_setreuse(int fd, int reuse);
 int sock_setreuse_port(int fd, int reuse);
 int sock_enlarge_in(int fd);
 int sock_enlarge_out(int fd);
+bool sock_peer_has_closed(int fd, bool eof_is_close);
 
 int connection_allowed(int fd, char *client_ip, char *client_host, size_t hostsize,
                               SIMPLE_PATTERN *access_list, const char *patname, int allow_dns);
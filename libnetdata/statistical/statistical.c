@@ -145,6 +145,127 @@ NETDATA_DOUBLE median(const NETDATA_DOUBLE *series, size_t entries) {
     return avg;
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+// selection of order statistics
+//
+// Moves the values at the given ranks to the positions a full sort would put them,
+// with all the smaller values before them and all the bigger values after them.
+// Several ranks are found together: every partitioning step continues only on the
+// sides that still have ranks in them, so the cost is O(n) for a few ranks.
+// Large ranges pick their pivot by selecting it first in a small range around
+// the rank (Floyd-Rivest), the rest use the median of 3. Like introselect, the
+// partitioning depth is limited and the ranges going deeper are sorted.
+// The values must be numbers, like the ones the query engine groups.
+
+#define SELECT_SERIES_SORT_BELOW 16
+#define SELECT_SERIES_SAMPLE_ABOVE 600
+
+static inline void select_series_swap(NETDATA_DOUBLE *a, NETDATA_DOUBLE *b) {
+    NETDATA_DOUBLE t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static inline NETDATA_DOUBLE select_series_median_of_3(NETDATA_DOUBLE a, NETDATA_DOUBLE b, NETDATA_DOUBLE c) {
+    if(a < b) {
+        if(b < c) return b;
+        return (a < c) ? c : a;
+    }
+
+    if(a < c) return a;
+    return (b < c) ? c : b;
+}
+
+static void select_series_range(NETDATA_DOUBLE *series, size_t left, size_t right, const size_t *ranks, size_t ranks_count, size_t depth) {
+    while(ranks_count) {
+        size_t entries = right - left + 1;
+
+        if(entries <= SELECT_SERIES_SORT_BELOW) {
+            // insertion sort
+            for(size_t i = left + 1; i <= right ; i++) {
+                NETDATA_DOUBLE v = series[i];
+                size_t j = i;
+                for(; j > left && series[j - 1] > v ; j--)
+                    series[j] = series[j - 1];
+                series[j] = v;
+            }
+            return;
+        }
+
+        if(unlikely(!depth)) {
+            sort_series(&series[left], entries);
+            return;
+        }
+        depth--;
+
+        size_t k = ranks[ranks_count / 2];
+        NETDATA_DOUBLE pivot;
+
+        if(entries > SELECT_SERIES_SAMPLE_ABOVE) {
+            double n = (double)entries;
+            double i = (double)(k - left + 1);
+            double z = log(n);
+            double s = 0.5 * exp(2.0 * z / 3.0);
+            double sd = 0.5 * sqrt(z * s * (n - s) / n) * ((i < n / 2.0) ? -1.0 : 1.0);
+
+            double sample_left = (double)k - i * s / n + sd;
+            double sample_right = (double)k + (n - i) * s / n + sd;
+
+            size_t from = (sample_left > (double)left) ? (size_t)sample_left : left;
+            size_t to = (sample_right < (double)right) ? (size_t)sample_right : right;
+            if(from > k) from = k;
+            if(to < k) to = k;
+
+            select_series_range(series, from, to, &k, 1, depth);
+            pivot = series[k];
+        }
+        else
+            pivot = select_series_median_of_3(series[left], series[left + entries / 2], series[right]);
+
+        // 3-way partitioning: [left, lt) < pivot, [lt, gt] == pivot, (gt, right] > pivot
+        // the pivot is one of the values, so gt never goes below lt
+        size_t lt = left, i = left, gt = right;
+        while(i <= gt) {
+            if(series[i] < pivot)
+                select_series_swap(&series[lt++], &series[i++]);
+            else if(series[i] > pivot)
+                select_series_swap(&series[i], &series[gt--]);
+            else
+                i++;
+        }
+
+        size_t below = 0;
+        while(below < ranks_count && ranks[below] < lt)
+            below++;
+
+        size_t above = below;
+        while(above < ranks_count && ranks[above] <= gt)
+            above++;
+
+        if(below)
+            select_series_range(series, left, lt - 1, ranks, below, depth);
+
+        ranks += above;
+        ranks_count -= above;
+        left = gt + 1;
+    }
+}
+
+void select_series(NETDATA_DOUBLE *series, size_t entries, const size_t *ranks, size_t ranks_count) {
+    // the ranks have to be sorted, ignore the ones out of the series
+    while(ranks_count && ranks[ranks_count - 1] >= entries)
+        ranks_count--;
+
+    if(unlikely(entries < 2 || !ranks_count))
+        return;
+
+    size_t depth = 0;
+    for(size_t n = entries; n ; n >>= 1)
+        depth += 2;
+
+    select_series_range(series, 0, entries - 1, ranks, ranks_count, depth);
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 NETDATA_DOUBLE moving_median(const NETDATA_DOUBLE *series, size_t entries, size_t period) {
@@ -458,3 +579,564 @@ NETDATA_DOUBLE holtwinters(const NETDATA_DOUBLE *series, size_t entries,
 
     return value;
 }
+
+// --------------------------------------------------------------------------------------------------------------------
+// mergeable quantile sketch (DDSketch)
+//
+// Values are mapped to logarithmic buckets, so that every value in a bucket is
+// within the configured relative error of the bucket's representative value.
+// Inserting is O(1), memory is bounded by max_buckets per sign, and sketches
+// with the same relative error can be merged by adding their buckets.
+// When a store needs more than max_buckets, its lowest buckets are collapsed,
+// so the accuracy of the upper quantiles is always preserved.
+
+#define QUANTILE_SKETCH_MIN_INDEXABLE 1e-9
+#define QUANTILE_SKETCH_INITIAL_BUCKETS 64
+
+static inline int32_t quantile_sketch_index(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE value) {
+    return (int32_t)ceil(log((double)value) / qs->gamma_ln);
+}
+
+static inline NETDATA_DOUBLE quantile_sketch_value(const QUANTILE_SKETCH *qs, int32_t index) {
+    // the bucket covers (gamma^(index - 1), gamma^index]
+    // this is the value with the same relative distance from both ends
+    double gamma = exp(qs->gamma_ln);
+    return (NETDATA_DOUBLE)(2.0 * exp((double)index * qs->gamma_ln) / (1.0 + gamma));
+}
+
+static void quantile_sketch_store_add(struct quantile_sketch_store *s, int32_t index, NETDATA_DOUBLE weight, uint32_t max_buckets) {
+    if(unlikely(!s->counts)) {
+        s->size = (max_buckets < QUANTILE_SKETCH_INITIAL_BUCKETS) ? max_buckets : QUANTILE_SKETCH_INITIAL_BUCKETS;
+        s->offset = index - (int32_t)(s->size / 2);
+        s->counts = callocz(s->size, sizeof(NETDATA_DOUBLE));
+    }
+
+    if(unlikely(index < s->offset || index >= s->offset + (int32_t)s->size)) {
+        int64_t low  = (index < s->offset) ? index : s->offset;
+        int64_t high = (index >= s->offset + (int32_t)s->size) ? index : s->offset + (int64_t)s->size - 1;
+
+        // the range we need, limited to max_buckets by collapsing the lowest buckets
+        if(high - low + 1 > (int64_t)max_buckets)
+            low = high - max_buckets + 1;
+
+        uint32_t size = s->size;
+        while(size < high - low + 1)
+            size *= 2;
+        if(size > max_buckets)
+            size = max_buckets;
+
+        // leave the free buckets at the side we are growing to
+        int32_t offset = (int32_t)((index < s->offset) ? high - size + 1 : low);
+
+        NETDATA_DOUBLE *counts = callocz(size, sizeof(NETDATA_DOUBLE));
+        for(uint32_t i = 0; i < s->size ; i++) {
+            if(!s->counts[i]) continue;
+
+            int64_t k = (int64_t)s->offset + i - offset;
+            if(k < 0) k = 0;
+            counts[k] += s->counts[i];
+        }
+
+        freez(s->counts);
+        s->counts = counts;
+        s->offset = offset;
+        s->size = size;
+
+        if(index < s->offset)
+            index = s->offset;
+    }
+
+    s->counts[index - s->offset] += weight;
+}
+
+void quantile_sketch_init(QUANTILE_SKETCH *qs, NETDATA_DOUBLE relative_error, size_t max_buckets) {
+    if(isless(relative_error, 0.0001)) relative_error = 0.0001;
+    if(isgreater(relative_error, 0.5)) relative_error = 0.5;
+    if(max_buckets < 16) max_buckets = 16;
+
+    memset(qs, 0, sizeof(*qs));
+    qs->gamma_ln = log((1.0 + (double)relative_error) / (1.0 - (double)relative_error));
+    qs->max_buckets = (uint32_t)max_buckets;
+    qs->min = NAN;
+    qs->max = NAN;
+}
+
+void quantile_sketch_reset(QUANTILE_SKETCH *qs) {
+    // keep the allocated buckets, to be reused
+    if(qs->positive.counts)
+        memset(qs->positive.counts, 0, qs->positive.size * sizeof(NETDATA_DOUBLE));
+
+    if(qs->negative.counts)
+        memset(qs->negative.counts, 0, qs->negative.size * sizeof(NETDATA_DOUBLE));
+
+    qs->zero = 0;
+    qs->count = 0;
+    qs->sum = 0;
+    qs->mean = 0;
+    qs->m2 = 0;
+    qs->min = NAN;
+    qs->max = NAN;
+}
+
+void quantile_sketch_free(QUANTILE_SKETCH *qs) {
+    freez(qs->positive.counts);
+    freez(qs->negative.counts);
+    memset(&qs->positive, 0, sizeof(qs->positive));
+    memset(&qs->negative, 0, sizeof(qs->negative));
+    quantile_sketch_reset(qs);
+}
+
+void quantile_sketch_add(QUANTILE_SKETCH *qs, NETDATA_DOUBLE value, NETDATA_DOUBLE weight) {
+    if(unlikely(!netdata_double_isnumber(value) || !isgreater(weight, 0.0)))
+        return;
+
+    if(isgreater(value, QUANTILE_SKETCH_MIN_INDEXABLE))
+        quantile_sketch_store_add(&qs->positive, quantile_sketch_index(qs, value), weight, qs->max_buckets);
+    else if(isless(value, -QUANTILE_SKETCH_MIN_INDEXABLE))
+        quantile_sketch_store_add(&qs->negative, quantile_sketch_index(qs, -value), weight, qs->max_buckets);
+    else
+        qs->zero += weight;
+
+    if(unlikely(qs->count == 0)) {
+        qs->min = value;
+        qs->max = value;
+    }
+    else {
+        if(isless(value, qs->min)) qs->min = value;
+        if(isgreater(value, qs->max)) qs->max = value;
+    }
+
+    qs->count += weight;
+    qs->sum += value * weight;
+
+    NETDATA_DOUBLE delta = value - qs->mean;
+    qs->mean += delta * weight / qs->count;
+    qs->m2 += weight * delta * (value - qs->mean);
+}
+
+static void quantile_sketch_merge_store(QUANTILE_SKETCH *dst, struct quantile_sketch_store *d, const QUANTILE_SKETCH *src, const struct quantile_sketch_store *s) {
+    bool same_mapping = (dst->gamma_ln == src->gamma_ln);
+
+    for(uint32_t i = 0; i < s->size ; i++) {
+        if(!s->counts[i]) continue;
+
+        int32_t index = s->offset + (int32_t)i;
+        if(!same_mapping)
+            index = quantile_sketch_index(dst, quantile_sketch_value(src, index));
+
+        quantile_sketch_store_add(d, index, s->counts[i], dst->max_buckets);
+    }
+}
+
+void quantile_sketch_merge(QUANTILE_SKETCH *dst, const QUANTILE_SKETCH *src) {
+    if(!src->count)
+        return;
+
+    quantile_sketch_merge_store(dst, &dst->positive, src, &src->positive);
+    quantile_sketch_merge_store(dst, &dst->negative, src, &src->negative);
+    dst->zero += src->zero;
+
+    if(!dst->count) {
+        dst->min = src->min;
+        dst->max = src->max;
+        dst->mean = src->mean;
+        dst->m2 = src->m2;
+    }
+    else {
+        if(isless(src->min, dst->min)) dst->min = src->min;
+        if(isgreater(src->max, dst->max)) dst->max = src->max;
+
+        NETDATA_DOUBLE count = dst->count + src->count;
+        NETDATA_DOUBLE delta = src->mean - dst->mean;
+        dst->m2 += src->m2 + delta * delta * dst->count * src->count / count;
+        dst->mean += delta * src->count / count;
+    }
+
+    dst->count += src->count;
+    dst->sum += src->sum;
+}
+
+NETDATA_DOUBLE quantile_sketch_quantile(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE quantile) {
+    if(unlikely(!isgreater(qs->count, 0.0)))
+        return NAN;
+
+    if(isless(quantile, 0.0)) quantile = 0.0;
+    if(isgreater(quantile, 1.0)) quantile = 1.0;
+
+    NETDATA_DOUBLE rank = quantile * (qs->count - 1);
+    NETDATA_DOUBLE seen = 0, value = qs->max;
+    bool found = false;
+
+    // the most negative values first
+    for(int64_t i = (int64_t)qs->negative.size - 1; i >= 0 && !found ; i--) {
+        seen += qs->negative.counts[i];
+        if(isgreater(seen, rank)) {
+            value = -quantile_sketch_value(qs, qs->negative.offset + (int32_t)i);
+            found = true;
+        }
+    }
+
+    if(!found) {
+        seen += qs->zero;
+        if(isgreater(seen, rank)) {
+            value = 0;
+            found = true;
+        }
+    }
+
+    for(uint32_t i = 0; i < qs->positive.size && !found ; i++) {
+        seen += qs->positive.counts[i];
+        if(isgreater(seen, rank)) {
+            value = quantile_sketch_value(qs, qs->positive.offset + (int32_t)i);
+            found = true;
+        }
+    }
+
+    // the representative value of a bucket may be outside the values we have seen
+    if(isless(value, qs->min)) value = qs->min;
+    if(isgreater(value, qs->max)) value = qs->max;
+
+    return value;
+}
+
+// the buckets in ascending order of their values: negative, zero, positive
+static inline NETDATA_DOUBLE quantile_sketch_bucket(const QUANTILE_SKETCH *qs, size_t pos, NETDATA_DOUBLE *weight) {
+    if(pos < qs->negative.size) {
+        size_t i = qs->negative.size - 1 - pos;
+        *weight = qs->negative.counts[i];
+        return -quantile_sketch_value(qs, qs->negative.offset + (int32_t)i);
+    }
+    pos -= qs->negative.size;
+
+    if(!pos) {
+        *weight = qs->zero;
+        return 0;
+    }
+    pos--;
+
+    *weight = qs->positive.counts[pos];
+    return quantile_sketch_value(qs, qs->positive.offset + (int32_t)pos);
+}
+
+NETDATA_DOUBLE quantile_sketch_mean_between(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE from_quantile, NETDATA_DOUBLE to_quantile) {
+    if(unlikely(!isgreater(qs->count, 0.0)))
+        return NAN;
+
+    if(isless(from_quantile, 0.0)) from_quantile = 0.0;
+    if(isgreater(to_quantile, 1.0)) to_quantile = 1.0;
+
+    if(!isless(from_quantile, to_quantile))
+        return quantile_sketch_quantile(qs, from_quantile);
+
+    NETDATA_DOUBLE from_rank = from_quantile * qs->count;
+    NETDATA_DOUBLE to_rank = to_quantile * qs->count;
+    NETDATA_DOUBLE seen = 0, sum = 0, used = 0;
+
+    size_t buckets = qs->negative.size + 1 + qs->positive.size;
+    for(size_t pos = 0; pos < buckets && isless(seen, to_rank) ; pos++) {
+        NETDATA_DOUBLE weight;
+        NETDATA_DOUBLE value = quantile_sketch_bucket(qs, pos, &weight);
+        if(!weight) continue;
+
+        // the part of the bucket within the ranks
+        NETDATA_DOUBLE low = isgreater(seen, from_rank) ? seen : from_rank;
+        NETDATA_DOUBLE high = isless(seen + weight, to_rank) ? seen + weight : to_rank;
+        seen += weight;
+
+        if(!isgreater(high, low)) continue;
+
+        if(isless(value, qs->min)) value = qs->min;
+        if(isgreater(value, qs->max)) value = qs->max;
+
+        sum += value * (high - low);
+        used += high - low;
+    }
+
+    return isgreater(used, 0.0) ? sum / used : NAN;
+}
+
+NETDATA_DOUBLE quantile_sketch_rank(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE value) {
+    if(unlikely(!isgreater(qs->count, 0.0)))
+        return NAN;
+
+    NETDATA_DOUBLE seen = 0;
+
+    size_t buckets = qs->negative.size + 1 + qs->positive.size;
+    for(size_t pos = 0; pos < buckets ; pos++) {
+        NETDATA_DOUBLE weight;
+        if(!isless(quantile_sketch_bucket(qs, pos, &weight), value))
+            break;
+
+        seen += weight;
+    }
+
+    return seen / qs->count;
+}
+
+NETDATA_DOUBLE quantile_sketch_standard_deviation(const QUANTILE_SKETCH *qs) {
+    if(unlikely(!isgreater(qs->count, 0.0)))
+        return NAN;
+
+    // population standard deviation, like standard_deviation()
+    return sqrtndd(qs->m2 / qs->count);
+}
+
+size_t quantile_sketch_memory(const QUANTILE_SKETCH *qs) {
+    return sizeof(QUANTILE_SKETCH) + (qs->positive.size + qs->negative.size) * sizeof(NETDATA_DOUBLE);
+}
+
+static size_t quantile_sketch_unittest_check(const char *label, const QUANTILE_SKETCH *qs, NETDATA_DOUBLE *sorted, size_t entries, NETDATA_DOUBLE relative_error, NETDATA_DOUBLE from_quantile) {
+    size_t errors = 0;
+
+    for(NETDATA_DOUBLE q = from_quantile; !isgreater(q, 1.0) ; q += 0.01) {
+        NETDATA_DOUBLE expected = sorted[(size_t)floor(q * (entries - 1))];
+        NETDATA_DOUBLE found = quantile_sketch_quantile(qs, q);
+
+        if(isgreater(fabsndd(found - expected), fabsndd(expected) * relative_error + QUANTILE_SKETCH_MIN_INDEXABLE)) {
+            fprintf(stderr, "QUANTILE SKETCH: %s: quantile %0.2f, expected " NETDATA_DOUBLE_FORMAT ", found " NETDATA_DOUBLE_FORMAT "\n",
+                    label, (double)q, expected, found);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+int quantile_sketch_unittest(void) {
+    const size_t entries = 100000;
+    const NETDATA_DOUBLE relative_error = 0.01;
+    size_t errors = 0;
+
+    fprintf(stderr, "\nTesting quantile sketches with %zu values...\n", entries);
+
+    NETDATA_DOUBLE *values = mallocz(entries * sizeof(NETDATA_DOUBLE));
+    unsigned int seed = 1;
+    for(size_t i = 0; i < entries ; i++) {
+        // a long tailed distribution, with some negative values and some zeros
+        NETDATA_DOUBLE v = (NETDATA_DOUBLE)exp(((double)rand_r(&seed) / RAND_MAX) * 12.0 - 2.0);
+        if(i % 10 == 0) v = -v;
+        if(i % 100 == 0) v = 0;
+        values[i] = v;
+    }
+
+    // the second half has every value twice
+    for(size_t i = entries / 2; i + 1 < entries ; i += 2)
+        values[i + 1] = values[i];
+
+    // one sketch with all the values, and two merged halves,
+    // the second half added with weights instead of repeated values
+    QUANTILE_SKETCH reference, half1, half2;
+    quantile_sketch_init(&reference, relative_error, QUANTILE_SKETCH_DEFAULT_MAX_BUCKETS);
+    quantile_sketch_init(&half1, relative_error, QUANTILE_SKETCH_DEFAULT_MAX_BUCKETS);
+    quantile_sketch_init(&half2, relative_error, QUANTILE_SKETCH_DEFAULT_MAX_BUCKETS);
+
+    for(size_t i = 0; i < entries ; i++) {
+        quantile_sketch_add(&reference, values[i], 1);
+
+        if(i < entries / 2)
+            quantile_sketch_add(&half1, values[i], 1);
+        else if((i - entries / 2) % 2 == 0)
+            quantile_sketch_add(&half2, values[i], 2);
+    }
+
+    quantile_sketch_merge(&half1, &half2);
+
+    sort_series(values, entries);
+
+    errors += quantile_sketch_unittest_check("merged", &half1, values, entries, relative_error, 0.0);
+    errors += quantile_sketch_unittest_check("reference", &reference, values, entries, relative_error, 0.0);
+
+    if(half1.count != (NETDATA_DOUBLE)entries || half1.min != values[0] || half1.max != values[entries - 1]) {
+        fprintf(stderr, "QUANTILE SKETCH: merged count, min or max are wrong\n");
+        errors++;
+    }
+
+    NETDATA_DOUBLE stddev = standard_deviation(values, entries);
+    if(isgreater(fabsndd(quantile_sketch_standard_deviation(&half1) - stddev), stddev * 1e-6)) {
+        fprintf(stderr, "QUANTILE SKETCH: standard deviation expected " NETDATA_DOUBLE_FORMAT ", found " NETDATA_DOUBLE_FORMAT "\n",
+                stddev, quantile_sketch_standard_deviation(&half1));
+        errors++;
+    }
+
+    // the mean of the biggest 10% of the values, like the percentile groupings of queries
+    size_t top = entries / 10;
+    NETDATA_DOUBLE top_mean = 0;
+    for(size_t i = entries - top; i < entries ; i++)
+        top_mean += values[i];
+    top_mean /= (NETDATA_DOUBLE)top;
+
+    NETDATA_DOUBLE found_mean = quantile_sketch_mean_between(&half1, 0.90, 1.0);
+    if(isgreater(fabsndd(found_mean - top_mean), fabsndd(top_mean) * relative_error)) {
+        fprintf(stderr, "QUANTILE SKETCH: mean of the top 10%% expected " NETDATA_DOUBLE_FORMAT ", found " NETDATA_DOUBLE_FORMAT "\n",
+                top_mean, found_mean);
+        errors++;
+    }
+
+    // bounded memory: with few buckets, only the lower quantiles lose accuracy
+    QUANTILE_SKETCH bounded;
+    quantile_sketch_init(&bounded, relative_error, 256);
+    for(size_t i = 0; i < entries ; i++)
+        quantile_sketch_add(&bounded, values[i], 1);
+
+    if(bounded.positive.size > 256 || bounded.negative.size > 256) {
+        fprintf(stderr, "QUANTILE SKETCH: bounded sketch has %u positive and %u negative buckets\n",
+                bounded.positive.size, bounded.negative.size);
+        errors++;
+    }
+    errors += quantile_sketch_unittest_check("bounded", &bounded, values, entries, relative_error, 0.90);
+
+    fprintf(stderr, "quantile sketch memory: %zu bytes full, %zu bytes bounded, %zu bytes for the raw values\n",
+            quantile_sketch_memory(&reference), quantile_sketch_memory(&bounded), entries * sizeof(NETDATA_DOUBLE));
+
+    quantile_sketch_free(&half1);
+    quantile_sketch_free(&half2);
+    quantile_sketch_free(&reference);
+    quantile_sketch_free(&bounded);
+    freez(values);
+
+    fprintf(stderr, "quantile sketches: %zu errors\n", errors);
+    return errors ? 1 : 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// HyperLogLog cardinality estimator
+//
+// The first 'precision' bits of the 64-bit hash of each value select a register,
+// and the register keeps the max position of the first set bit of the rest of the hash.
+// The harmonic mean of the registers estimates the number of distinct values,
+// with a standard error of 1.04 / sqrt(2^precision).
+
+static inline uint64_t hyperloglog_hash(const void *data, size_t len) {
+    const unsigned char *s = data, *end = s + len;
+    uint64_t hval = 0xcbf29ce484222325ULL;
+    while(s < end) {
+        hval ^= (uint64_t)*s++;
+        hval *= 0x100000001b3ULL;
+    }
+
+    // FNV-1a does not mix the high bits enough, which select the register
+    return murmur64(hval);
+}
+
+void hyperloglog_init(HYPERLOGLOG *hll, uint8_t precision) {
+    if(precision < HYPERLOGLOG_MIN_PRECISION) precision = HYPERLOGLOG_MIN_PRECISION;
+    if(precision > HYPERLOGLOG_MAX_PRECISION) precision = HYPERLOGLOG_MAX_PRECISION;
+
+    hll->precision = precision;
+    hll->registers_count = 1U << precision;
+    hll->registers = callocz(hll->registers_count, sizeof(uint8_t));
+}
+
+void hyperloglog_reset(HYPERLOGLOG *hll) {
+    memset(hll->registers, 0, hll->registers_count * sizeof(uint8_t));
+}
+
+void hyperloglog_free(HYPERLOGLOG *hll) {
+    freez(hll->registers);
+    hll->registers = NULL;
+    hll->registers_count = 0;
+}
+
+void hyperloglog_add(HYPERLOGLOG *hll, const void *data, size_t len) {
+    uint64_t hash = hyperloglog_hash(data, len);
+
+    uint32_t index = (uint32_t)(hash >> (64 - hll->precision));
+
+    // the remaining bits, with a guard bit, so that the count is bounded
+    uint64_t rest = (hash << hll->precision) | (1ULL << (hll->precision - 1));
+    uint8_t rank = (uint8_t)(__builtin_clzll(rest) + 1);
+
+    // the registers may be updated by multiple threads
+    uint8_t current = __atomic_load_n(&hll->registers[index], __ATOMIC_RELAXED);
+    while(rank > current &&
+          !__atomic_compare_exchange_n(&hll->registers[index], &current, rank, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void hyperloglog_merge(HYPERLOGLOG *dst, const HYPERLOGLOG *src) {
+    if(unlikely(dst->precision != src->precision)) {
+        error("HYPERLOGLOG: cannot merge sketches with different precision (%u and %u)", dst->precision, src->precision);
+        return;
+    }
+
+    for(uint32_t i = 0; i < dst->registers_count ; i++)
+        if(src->registers[i] > dst->registers[i])
+            dst->registers[i] = src->registers[i];
+}
+
+NETDATA_DOUBLE hyperloglog_estimate(const HYPERLOGLOG *hll) {
+    double m = (double)hll->registers_count;
+
+    double alpha;
+    switch(hll->registers_count) {
+        case 16: alpha = 0.673; break;
+        case 32: alpha = 0.697; break;
+        case 64: alpha = 0.709; break;
+        default: alpha = 0.7213 / (1.0 + 1.079 / m); break;
+    }
+
+    double sum = 0.0;
+    uint32_t zeros = 0;
+    for(uint32_t i = 0; i < hll->registers_count ; i++) {
+        sum += ldexp(1.0, -(int)hll->registers[i]);
+        if(!hll->registers[i])
+            zeros++;
+    }
+
+    double estimate = alpha * m * m / sum;
+
+    // small cardinalities are estimated better by counting the empty registers
+    if(estimate <= 2.5 * m && zeros)
+        estimate = m * log(m / (double)zeros);
+
+    return (NETDATA_DOUBLE)estimate;
+}
+
+NETDATA_DOUBLE hyperloglog_relative_error(uint8_t precision) {
+    return (NETDATA_DOUBLE)(1.04 / sqrt((double)(1U << precision)));
+}
+
+size_t hyperloglog_memory(const HYPERLOGLOG *hll) {
+    return sizeof(HYPERLOGLOG) + hll->registers_count * sizeof(uint8_t);
+}
+
+int hyperloglog_unittest(void) {
+    size_t errors = 0;
+    size_t cardinalities[] = { 10, 1000, 100000, 1000000 };
+    char buf[100 + 1];
+
+    fprintf(stderr, "\nTesting HyperLogLog with precision %d (standard error %0.2f%%)...\n",
+            HYPERLOGLOG_DEFAULT_PRECISION, (double)hyperloglog_relative_error(HYPERLOGLOG_DEFAULT_PRECISION) * 100.0);
+
+    HYPERLOGLOG hll, half;
+    hyperloglog_init(&hll, HYPERLOGLOG_DEFAULT_PRECISION);
+    hyperloglog_init(&half, HYPERLOGLOG_DEFAULT_PRECISION);
+
+    for(size_t c = 0; c < sizeof(cardinalities) / sizeof(cardinalities[0]) ; c++) {
+        hyperloglog_reset(&hll);
+        hyperloglog_reset(&half);
+
+        // every value is added twice, half of them to another sketch that is merged
+        for(size_t i = 0; i < cardinalities[c] ; i++) {
+            size_t len = snprintfz(buf, 100, "user-%zu", i);
+            hyperloglog_add(&hll, buf, len);
+            hyperloglog_add((i % 2) ? &half : &hll, buf, len);
+        }
+        hyperloglog_merge(&hll, &half);
+
+        NETDATA_DOUBLE estimate = hyperloglog_estimate(&hll);
+        NETDATA_DOUBLE error = fabsndd(estimate - (NETDATA_DOUBLE)cardinalities[c]) / (NETDATA_DOUBLE)cardinalities[c];
+
+        // allow 4 standard errors
+        bool ok = !isgreater(error, hyperloglog_relative_error(hll.precision) * 4);
+        if(!ok) errors++;
+
+        fprintf(stderr, "HyperLogLog: %zu distinct values, estimated " NETDATA_DOUBLE_FORMAT " (error %0.3f%%) %s\n",
+                cardinalities[c], estimate, (double)error * 100.0, ok ? "OK" : "FAILED");
+    }
+
+    hyperloglog_free(&hll);
+    hyperloglog_free(&half);
+
+    return errors ? 1 : 0;
+}
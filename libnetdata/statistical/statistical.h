@@ -30,5 +30,69 @@ NETDATA_DOUBLE sum(const NETDATA_DOUBLE *series, size_t entries);
 NETDATA_DOUBLE median_on_sorted_series(const NETDATA_DOUBLE *series, size_t entries);
 NETDATA_DOUBLE *copy_series(const NETDATA_DOUBLE *series, size_t entries);
 void sort_series(NETDATA_DOUBLE *series, size_t entries);
+void select_series(NETDATA_DOUBLE *series, size_t entries, const size_t *ranks, size_t ranks_count);
+
+// --------------------------------------------------------------------------------------------------------------------
+// mergeable quantile sketch (DDSketch), with bounded relative error and bounded memory
+
+#define QUANTILE_SKETCH_DEFAULT_RELATIVE_ERROR 0.01
+#define QUANTILE_SKETCH_DEFAULT_MAX_BUCKETS 2048
+
+struct quantile_sketch_store {
+    int32_t offset;                 // the bucket index of counts[0]
+    uint32_t size;                  // the allocated buckets
+    NETDATA_DOUBLE *counts;         // the weight of each bucket
+};
+
+typedef struct quantile_sketch {
+    double gamma_ln;                // log(gamma), gamma = (1 + relative error) / (1 - relative error)
+    uint32_t max_buckets;           // the max buckets of each store, the lowest buckets are collapsed above it
+
+    struct quantile_sketch_store positive;
+    struct quantile_sketch_store negative;
+    NETDATA_DOUBLE zero;            // the weight of values too close to zero to be indexed
+
+    NETDATA_DOUBLE count;           // the total weight added
+    NETDATA_DOUBLE sum;
+    NETDATA_DOUBLE min;
+    NETDATA_DOUBLE max;
+    NETDATA_DOUBLE mean;            // running weighted mean and
+    NETDATA_DOUBLE m2;              // sum of squared differences from it, for the standard deviation
+} QUANTILE_SKETCH;
+
+void quantile_sketch_init(QUANTILE_SKETCH *qs, NETDATA_DOUBLE relative_error, size_t max_buckets);
+void quantile_sketch_reset(QUANTILE_SKETCH *qs);
+void quantile_sketch_free(QUANTILE_SKETCH *qs);
+void quantile_sketch_add(QUANTILE_SKETCH *qs, NETDATA_DOUBLE value, NETDATA_DOUBLE weight);
+void quantile_sketch_merge(QUANTILE_SKETCH *dst, const QUANTILE_SKETCH *src);
+NETDATA_DOUBLE quantile_sketch_quantile(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE quantile);
+NETDATA_DOUBLE quantile_sketch_mean_between(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE from_quantile, NETDATA_DOUBLE to_quantile);
+NETDATA_DOUBLE quantile_sketch_rank(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE value);
+NETDATA_DOUBLE quantile_sketch_standard_deviation(const QUANTILE_SKETCH *qs);
+size_t quantile_sketch_memory(const QUANTILE_SKETCH *qs);
+int quantile_sketch_unittest(void);
+
+// --------------------------------------------------------------------------------------------------------------------
+// HyperLogLog cardinality estimator, with fixed memory of 2^precision bytes
+
+#define HYPERLOGLOG_MIN_PRECISION 4
+#define HYPERLOGLOG_MAX_PRECISION 18
+#define HYPERLOGLOG_DEFAULT_PRECISION 14
+
+typedef struct hyperloglog {
+    uint8_t precision;              // the bits of the hash used to select a register
+    uint32_t registers_count;       // 2^precision
+    uint8_t *registers;             // the max leading zeros + 1 seen at each register
+} HYPERLOGLOG;
+
+void hyperloglog_init(HYPERLOGLOG *hll, uint8_t precision);
+void hyperloglog_reset(HYPERLOGLOG *hll);
+void hyperloglog_free(HYPERLOGLOG *hll);
+void hyperloglog_add(HYPERLOGLOG *hll, const void *data, size_t len);
+void hyperloglog_merge(HYPERLOGLOG *dst, const HYPERLOGLOG *src);
+NETDATA_DOUBLE hyperloglog_estimate(const HYPERLOGLOG *hll);
+NETDATA_DOUBLE hyperloglog_relative_error(uint8_t precision);
+size_t hyperloglog_memory(const HYPERLOGLOG *hll);
+int hyperloglog_unittest(void);
 
 #endif //NETDATA_STATISTICAL_H
@@ -476,6 +476,7 @@ void ml::updateTrainingStatisticsChart(RRDHOST *RH, const TrainingStats &TS) {
         static thread_local RRDDIM *NotEnoughCollectedValues = nullptr;
         static thread_local RRDDIM *NullAcquiredDimension = nullptr;
         static thread_local RRDDIM *ChartUnderReplication = nullptr;
+        static thread_local RRDDIM *Loaded = nullptr;
 
         if (!RS) {
             std::stringstream IdSS, NameSS;
@@ -505,6 +506,7 @@ void ml::updateTrainingStatisticsChart(RRDHOST *RH, const TrainingStats &TS) {
             NotEnoughCollectedValues = rrddim_add(RS, "not-enough-values", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
             NullAcquiredDimension = rrddim_add(RS, "null-acquired-dimensions", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
             ChartUnderReplication = rrddim_add(RS, "chart-under-replication", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            Loaded = rrddim_add(RS, "loaded", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
         }
 
         rrddim_set_by_pointer(RS, Ok, TS.TrainingResultOk);
@@ -512,6 +514,46 @@ void ml::updateTrainingStatisticsChart(RRDHOST *RH, const TrainingStats &TS) {
         rrddim_set_by_pointer(RS, NotEnoughCollectedValues, TS.TrainingResultNotEnoughCollectedValues);
         rrddim_set_by_pointer(RS, NullAcquiredDimension, TS.TrainingResultNullAcquiredDimension);
         rrddim_set_by_pointer(RS, ChartUnderReplication, TS.TrainingResultChartUnderReplication);
+        rrddim_set_by_pointer(RS, Loaded, TS.NumDimensionsLoaded);
+
+        rrdset_done(RS);
+    }
+
+    /*
+     * training throughput
+    */
+    {
+        static thread_local RRDSET *RS = nullptr;
+
+        static thread_local RRDDIM *Trained = nullptr;
+
+        if (!RS) {
+            std::stringstream IdSS, NameSS;
+
+            IdSS << "training_throughput_on_" << localhost->machine_guid;
+            NameSS << "training_throughput_on_" << rrdhost_hostname(localhost);
+
+            RS = rrdset_create(
+                    RH,
+                    "netdata", // type
+                IdSS.str().c_str(), // id
+                NameSS.str().c_str(), // name
+                NETDATA_ML_CHART_FAMILY, // family
+                "netdata.training_throughput", // ctx
+                "Training throughput", // title
+                "dimensions/s", // units
+                NETDATA_ML_PLUGIN, // plugin
+                NETDATA_ML_MODULE_TRAINING, // module
+                NETDATA_ML_CHART_PRIO_TRAINING_THROUGHPUT, // priority
+                RH->rrd_update_every, // update_every
+                RRDSET_TYPE_LINE// chart_type
+            );
+            rrdset_flag_set(RS, RRDSET_FLAG_ANOMALY_DETECTION);
+
+            Trained = rrddim_add(RS, "trained", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+        }
+
+        rrddim_set_by_pointer(RS, Trained, TS.TrainingThroughput);
 
         rrdset_done(RS);
     }
@@ -32,6 +32,7 @@ void Config::readMLConfig(void) {
     unsigned MinTrainSamples = config_get_number(ConfigSectionML, "minimum num samples to train", 1 * 900);
     unsigned TrainEvery = config_get_number(ConfigSectionML, "train every", 1 * 3600);
     unsigned NumModelsToUse = config_get_number(ConfigSectionML, "number of models per dimension", 1);
+    time_t DeleteModelsOlderThan = config_get_number(ConfigSectionML, "delete models older than", 7 * 24 * 3600);
 
     unsigned DiffN = config_get_number(ConfigSectionML, "num samples to diff", 1);
     unsigned SmoothN = config_get_number(ConfigSectionML, "num samples to smooth", 3);
@@ -54,6 +55,7 @@ void Config::readMLConfig(void) {
     MinTrainSamples = clamp<unsigned>(MinTrainSamples, 1 * 900, 6 * 3600);
     TrainEvery = clamp<unsigned>(TrainEvery, 1 * 3600, 6 * 3600);
     NumModelsToUse = clamp<unsigned>(NumModelsToUse, 1, 7 * 24);
+    DeleteModelsOlderThan = clamp<time_t>(DeleteModelsOlderThan, 1 * 24 * 3600, 30 * 24 * 3600);
 
     DiffN = clamp(DiffN, 0u, 1u);
     SmoothN = clamp(SmoothN, 0u, 5u);
@@ -88,6 +90,7 @@ void Config::readMLConfig(void) {
     Cfg.MinTrainSamples = MinTrainSamples;
     Cfg.TrainEvery = TrainEvery;
     Cfg.NumModelsToUse = NumModelsToUse;
+    Cfg.DeleteModelsOlderThan = DeleteModelsOlderThan;
 
     Cfg.DiffN = DiffN;
     Cfg.SmoothN = SmoothN;
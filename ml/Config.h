@@ -16,6 +16,7 @@ class Config {
     unsigned TrainEvery;
 
     unsigned NumModelsToUse;
+    time_t DeleteModelsOlderThan;
 
     unsigned DBEngineAnomalyRateEvery;
 
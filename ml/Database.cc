@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "Database.h"
+
+using namespace ml;
+
+/*
+ * Models database shared by all hosts. It stays null when the database
+ * cannot be opened, in which case models live only in memory.
+ */
+Database *ml::DB = nullptr;
+
+// The version of the schema of the models table. The models saved with
+// an older schema are dropped when the database is opened.
+#define ML_DATABASE_VERSION 1
+
+static const char *DatabaseConfig[] = {
+    "PRAGMA journal_mode=WAL;",
+    "PRAGMA synchronous=NORMAL;",
+    "CREATE TABLE IF NOT EXISTS models (host_id BLOB NOT NULL, dim_id BLOB NOT NULL, "
+    "after INT NOT NULL, before INT NOT NULL, min_dist REAL NOT NULL, max_dist REAL NOT NULL, "
+    "feature_size INT NOT NULL, diff_n INT NOT NULL, smooth_n INT NOT NULL, centers BLOB NOT NULL, "
+    "PRIMARY KEY (dim_id, after)) WITHOUT ROWID;",
+    "CREATE INDEX IF NOT EXISTS models_before ON models (before);",
+    "CREATE INDEX IF NOT EXISTS models_host_id ON models (host_id);",
+    nullptr
+};
+
+static const char *SQL_INSERT_MODEL =
+    "INSERT OR REPLACE INTO models (host_id, dim_id, after, before, min_dist, max_dist, feature_size, diff_n, smooth_n, centers) "
+    "VALUES (@host_id, @dim_id, @after, @before, @min_dist, @max_dist, @feature_size, @diff_n, @smooth_n, @centers);";
+
+static const char *SQL_TRIM_MODELS =
+    "DELETE FROM models WHERE dim_id = @dim_id AND after < @after;";
+
+static const char *SQL_LOAD_HOST_MODELS =
+    "SELECT dim_id, after, before, min_dist, max_dist, centers FROM models "
+    "WHERE host_id = @host_id AND feature_size = @feature_size AND diff_n = @diff_n AND smooth_n = @smooth_n "
+    "ORDER BY dim_id, after DESC;";
+
+static const char *SQL_REMOVE_MODELS_BEFORE =
+    "DELETE FROM models WHERE before < @before;";
+
+static int databaseVersion(sqlite3 *Conn) {
+    sqlite3_stmt *Stmt = nullptr;
+    int Version = -1;
+
+    if (sqlite3_prepare_v2(Conn, "PRAGMA user_version;", -1, &Stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(Stmt) == SQLITE_ROW)
+        Version = sqlite3_column_int(Stmt, 0);
+
+    sqlite3_finalize(Stmt);
+    return Version;
+}
+
+bool Database::open(const char *Path) {
+    int RC = sqlite3_open_v2(Path, &Conn, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, nullptr);
+    if (RC != SQLITE_OK) {
+        error("Failed to open ML models database at %s, due to \"%s\"", Path, sqlite3_errstr(RC));
+        close();
+        return false;
+    }
+
+    int Version = databaseVersion(Conn);
+    if (Version < 0) {
+        error("Failed to read the version of ML models database at %s, due to \"%s\"", Path, sqlite3_errmsg(Conn));
+        close();
+        return false;
+    }
+
+    if (Version < ML_DATABASE_VERSION &&
+        sqlite3_exec(Conn, "DROP TABLE IF EXISTS models;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        error("Failed to drop the ML models of version %d, due to \"%s\"", Version, sqlite3_errmsg(Conn));
+        close();
+        return false;
+    }
+
+    for (const char **Cmd = DatabaseConfig; *Cmd; Cmd++) {
+        char *ErrMsg = nullptr;
+
+        RC = sqlite3_exec(Conn, *Cmd, nullptr, nullptr, &ErrMsg);
+        if (RC != SQLITE_OK) {
+            error("Failed to execute \"%s\" on ML models database, due to \"%s\"", *Cmd, ErrMsg);
+            sqlite3_free(ErrMsg);
+            close();
+            return false;
+        }
+    }
+
+    char SetVersion[64];
+    snprintfz(SetVersion, sizeof(SetVersion) - 1, "PRAGMA user_version=%d;", ML_DATABASE_VERSION);
+    if (sqlite3_exec(Conn, SetVersion, nullptr, nullptr, nullptr) != SQLITE_OK) {
+        error("Failed to set the version of ML models database, due to \"%s\"", sqlite3_errmsg(Conn));
+        close();
+        return false;
+    }
+
+    if (sqlite3_prepare_v2(Conn, SQL_INSERT_MODEL, -1, &InsertStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(Conn, SQL_TRIM_MODELS, -1, &TrimStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(Conn, SQL_LOAD_HOST_MODELS, -1, &LoadStmt, nullptr) != SQLITE_OK) {
+        error("Failed to prepare the statements of ML models database, due to \"%s\"", sqlite3_errmsg(Conn));
+        close();
+        return false;
+    }
+
+    info("ML models database %s initialized", Path);
+    return true;
+}
+
+void Database::close() {
+    sqlite3_finalize(InsertStmt);
+    sqlite3_finalize(TrimStmt);
+    sqlite3_finalize(LoadStmt);
+    InsertStmt = TrimStmt = LoadStmt = nullptr;
+
+    if (Conn) {
+        sqlite3_close_v2(Conn);
+        Conn = nullptr;
+    }
+}
+
+bool Database::saveModel(uuid_t *HostId, uuid_t *DimId, const KMeans &KM,
+                         unsigned DiffN, unsigned SmoothN, time_t OldestAfterT) {
+    const std::vector<CalculatedNumber> &CCs = KM.clusterCenters();
+    if (CCs.empty())
+        return false;
+
+    std::lock_guard<Mutex> L(M);
+
+    int RC = sqlite3_bind_blob(InsertStmt, 1, HostId, sizeof(*HostId), SQLITE_STATIC);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_blob(InsertStmt, 2, DimId, sizeof(*DimId), SQLITE_STATIC);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int64(InsertStmt, 3, KM.afterT());
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int64(InsertStmt, 4, KM.beforeT());
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_double(InsertStmt, 5, KM.minDist());
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_double(InsertStmt, 6, KM.maxDist());
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int(InsertStmt, 7, (int) KM.featureSize());
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int(InsertStmt, 8, (int) DiffN);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int(InsertStmt, 9, (int) SmoothN);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_blob(InsertStmt, 10, CCs.data(), (int) (CCs.size() * sizeof(CalculatedNumber)), SQLITE_STATIC);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_step(InsertStmt);
+
+    sqlite3_reset(InsertStmt);
+    sqlite3_clear_bindings(InsertStmt);
+
+    if (RC != SQLITE_DONE) {
+        error("Failed to save ML model, due to \"%s\"", sqlite3_errmsg(Conn));
+        return false;
+    }
+
+    RC = sqlite3_bind_blob(TrimStmt, 1, DimId, sizeof(*DimId), SQLITE_STATIC);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int64(TrimStmt, 2, OldestAfterT);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_step(TrimStmt);
+
+    sqlite3_reset(TrimStmt);
+    sqlite3_clear_bindings(TrimStmt);
+
+    return RC == SQLITE_DONE;
+}
+
+bool Database::loadHostModels(uuid_t *HostId, unsigned DiffN, unsigned SmoothN, unsigned LagN,
+                              size_t MaxModels, HostModels &Models) {
+    std::lock_guard<Mutex> L(M);
+
+    int RC = sqlite3_bind_blob(LoadStmt, 1, HostId, sizeof(*HostId), SQLITE_STATIC);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int(LoadStmt, 2, (int) (LagN + 1));
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int(LoadStmt, 3, (int) DiffN);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_bind_int(LoadStmt, 4, (int) SmoothN);
+
+    while (RC == SQLITE_OK || RC == SQLITE_ROW) {
+        RC = sqlite3_step(LoadStmt);
+        if (RC != SQLITE_ROW)
+            break;
+
+        const uuid_t *DimId = static_cast<const uuid_t *>(sqlite3_column_blob(LoadStmt, 0));
+        if (!DimId || sqlite3_column_bytes(LoadStmt, 0) != sizeof(uuid_t))
+            continue;
+
+        // The models of each dimension are returned the most recent one first
+        std::vector<KMeans> *DimModels = &Models[dimensionKey(DimId)];
+        if (DimModels->size() >= MaxModels)
+            continue;
+
+        const CalculatedNumber *CCs = static_cast<const CalculatedNumber *>(sqlite3_column_blob(LoadStmt, 5));
+        size_t NumValues = sqlite3_column_bytes(LoadStmt, 5) / sizeof(CalculatedNumber);
+
+        KMeans KM;
+        if (!CCs || !KM.restore(CCs, NumValues, LagN + 1,
+                                sqlite3_column_double(LoadStmt, 3), sqlite3_column_double(LoadStmt, 4)))
+            continue;
+
+        KM.setTrainingWindow(sqlite3_column_int64(LoadStmt, 1), sqlite3_column_int64(LoadStmt, 2));
+        DimModels->push_back(std::move(KM));
+    }
+
+    sqlite3_reset(LoadStmt);
+    sqlite3_clear_bindings(LoadStmt);
+
+    for (auto It = Models.begin(); It != Models.end(); ) {
+        if (It->second.empty()) {
+            It = Models.erase(It);
+            continue;
+        }
+
+        std::reverse(It->second.begin(), It->second.end());
+        ++It;
+    }
+
+    if (RC != SQLITE_DONE) {
+        error("Failed to load ML models, due to \"%s\"", sqlite3_errmsg(Conn));
+        return false;
+    }
+
+    return true;
+}
+
+void Database::removeModelsBefore(time_t BeforeT) {
+    sqlite3_stmt *Stmt = nullptr;
+
+    std::lock_guard<Mutex> L(M);
+
+    if (sqlite3_prepare_v2(Conn, SQL_REMOVE_MODELS_BEFORE, -1, &Stmt, nullptr) != SQLITE_OK) {
+        error("Failed to prepare the removal of old ML models, due to \"%s\"", sqlite3_errmsg(Conn));
+        return;
+    }
+
+    int RC = sqlite3_bind_int64(Stmt, 1, BeforeT);
+    if (RC == SQLITE_OK)
+        RC = sqlite3_step(Stmt);
+
+    if (RC != SQLITE_DONE)
+        error("Failed to remove old ML models, due to \"%s\"", sqlite3_errmsg(Conn));
+    else
+        info("Removed %d ML models trained before %ld", sqlite3_changes(Conn), (long) BeforeT);
+
+    sqlite3_finalize(Stmt);
+}
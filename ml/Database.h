@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ML_DATABASE_H
+#define ML_DATABASE_H
+
+#include "Mutex.h"
+#include "KMeans.h"
+
+#include "ml-private.h"
+#include "database/sqlite/sqlite3.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace ml {
+
+/*
+ * Keeps the trained models of the dimensions in a SQLite database, keyed
+ * by the UUID of each dimension, so that anomaly detection can resume
+ * right after a restart instead of waiting for new models to be trained.
+ */
+class Database {
+public:
+    // The saved models of a host, by the UUID of their dimension, the oldest one first
+    using HostModels = std::unordered_map<std::string, std::vector<KMeans>>;
+
+    static std::string dimensionKey(const uuid_t *DimId) {
+        return std::string(reinterpret_cast<const char *>(*DimId), sizeof(uuid_t));
+    }
+
+    Database() : Conn(nullptr), InsertStmt(nullptr), TrimStmt(nullptr), LoadStmt(nullptr) {}
+
+    bool open(const char *Path);
+    void close();
+
+    ~Database() {
+        close();
+    }
+
+    // Saves a model of a dimension, trained on features preprocessed with
+    // DiffN and SmoothN, and deletes the saved models of the dimension that
+    // were trained before OldestAfterT.
+    bool saveModel(uuid_t *HostId, uuid_t *DimId, const KMeans &KM,
+                   unsigned DiffN, unsigned SmoothN, time_t OldestAfterT);
+
+    // Loads, with a single query, up to MaxModels of the most recent models
+    // of each dimension of a host. Models with features that were not
+    // preprocessed with DiffN, SmoothN and LagN are skipped.
+    bool loadHostModels(uuid_t *HostId, unsigned DiffN, unsigned SmoothN, unsigned LagN,
+                        size_t MaxModels, HostModels &Models);
+
+    // Deletes the models that were trained with values older than BeforeT.
+    void removeModelsBefore(time_t BeforeT);
+
+private:
+    sqlite3 *Conn;
+
+    sqlite3_stmt *InsertStmt;
+    sqlite3_stmt *TrimStmt;
+    sqlite3_stmt *LoadStmt;
+
+    // Training threads save models while new hosts load them
+    Mutex M;
+};
+
+extern Database *DB;
+
+} // namespace ml
+
+#endif /* ML_DATABASE_H */
@@ -4,6 +4,7 @@
 #include "Dimension.h"
 #include "Query.h"
 #include "Host.h"
+#include "Database.h"
 
 using namespace ml;
 
@@ -143,6 +144,21 @@ std::pair<CalculatedNumber *, TrainingResponse> Dimension::getCalculatedNumbers(
     return { CNs, TrainingResp };
 }
 
+void Dimension::restoreModels(std::vector<KMeans> &&SavedModels) {
+    if (MLS != MachineLearningStatus::Enabled || SavedModels.empty())
+        return;
+
+    std::lock_guard<Mutex> L(M);
+
+    Models = std::move(SavedModels);
+
+    // The models will be updated in the background, on the next
+    // scheduled training of the dimension.
+    MT = MetricType::Constant;
+    TS = TrainingStatus::Trained;
+    LastTrainingTime = Models.back().beforeT();
+}
+
 TrainingResult Dimension::trainModel(const TrainingRequest &TrainingReq) {
     auto P = getCalculatedNumbers(TrainingReq);
     CalculatedNumber *CNs = P.first;
@@ -176,28 +192,38 @@ TrainingResult Dimension::trainModel(const TrainingRequest &TrainingReq) {
 
     SamplesBuffer SB = SamplesBuffer(CNs, N, 1, Cfg.DiffN, Cfg.SmoothN, Cfg.LagN,
                                      SamplingRatio, Cfg.RandomNums);
-    std::vector<DSample> Samples;
+    std::vector<CalculatedNumber> Samples;
     SB.preprocess(Samples);
 
+    size_t FeatureSize = Cfg.LagN + 1;
+
     KMeans KM;
-    KM.train(Samples, Cfg.MaxKMeansIters);
+    KM.train(Samples.data(), Samples.size() / FeatureSize, FeatureSize, Cfg.MaxKMeansIters);
+    KM.setTrainingWindow(TrainingResp.DbAfterT, TrainingResp.DbBeforeT);
 
+    time_t OldestAfterT;
     {
         std::lock_guard<Mutex> L(M);
 
+        // Copy the model, we save it below without holding the lock
         if (Models.size() < Cfg.NumModelsToUse) {
-            Models.push_back(std::move(KM));
+            Models.push_back(KM);
         } else {
             std::rotate(std::begin(Models), std::begin(Models) + 1, std::end(Models));
-            Models[Models.size() - 1] = std::move(KM);
+            Models[Models.size() - 1] = KM;
         }
 
+        OldestAfterT = Models.front().afterT();
+
         MT = MetricType::Constant;
         TS = TrainingStatus::Trained;
         TR = TrainingResp;
         LastTrainingTime = rrddim_last_entry_s(RD);
     }
 
+    if (DB)
+        DB->saveModel(&RD->rrdset->rrdhost->host_uuid, &RD->metric_uuid, KM, Cfg.DiffN, Cfg.SmoothN, OldestAfterT);
+
     delete[] CNs;
     return TrainingResp.Result;
 }
@@ -240,32 +266,18 @@ bool Dimension::predict(time_t CurrT, CalculatedNumber Value, bool Exists) {
 
     // Don't treat values that don't exist as anomalous
     if (!Exists) {
-        CNs.clear();
+        FB.reset();
         return false;
     }
 
     // Save the value and return if we don't have enough values for a sample
-    unsigned N = Cfg.DiffN + Cfg.SmoothN + Cfg.LagN;
-    if (CNs.size() < N) {
-        CNs.push_back(Value);
-        return false;
-    }
-
-    // Push the value and check if it's different from the last one
     bool SameValue = true;
-    std::rotate(std::begin(CNs), std::begin(CNs) + 1, std::end(CNs));
-    if (CNs[N - 1] != Value)
-        SameValue = false;
-    CNs[N - 1] = Value;
+    if (!FB.add(Value, SameValue))
+        return false;
 
     // Create the sample
-    CalculatedNumber TmpCNs[N * (Cfg.LagN + 1)];
-    memset(TmpCNs, 0, N * (Cfg.LagN + 1) * sizeof(CalculatedNumber));
-    std::memcpy(TmpCNs, CNs.data(), N * sizeof(CalculatedNumber));
-    SamplesBuffer SB = SamplesBuffer(TmpCNs, N, 1,
-                                     Cfg.DiffN, Cfg.SmoothN, Cfg.LagN,
-                                     1.0, Cfg.RandomNums);
-    SB.preprocess(Feature);
+    CalculatedNumber Feature[MaxFeatureSize];
+    size_t FeatureSize = FB.feature(Feature);
 
     /*
      * Lock to predict and possibly schedule the dimension for training
@@ -292,6 +304,9 @@ bool Dimension::predict(time_t CurrT, CalculatedNumber Value, bool Exists) {
             break;
     }
 
+    if (!FeatureSize)
+        return false;
+
     /*
      * Use the KMeans models to check if the value is anomalous
     */
@@ -302,8 +317,8 @@ bool Dimension::predict(time_t CurrT, CalculatedNumber Value, bool Exists) {
     for (const auto &KM : Models) {
         ModelsConsulted++;
 
-        double AnomalyScore = KM.anomalyScore(Feature);
-        if (AnomalyScore == std::numeric_limits<CalculatedNumber>::quiet_NaN())
+        double AnomalyScore = KM.anomalyScore(Feature, FeatureSize);
+        if (std::isnan(AnomalyScore))
             continue;
 
         if (AnomalyScore < (100 * Cfg.DimensionAnomalyScoreThreshold)) {
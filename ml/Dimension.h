@@ -7,6 +7,7 @@
 #include "Stats.h"
 #include "Query.h"
 #include "Config.h"
+#include "FeatureBuffer.h"
 
 #include "ml-private.h"
 
@@ -121,7 +122,8 @@ class Dimension {
         MT(MetricType::Constant),
         TS(TrainingStatus::Untrained),
         TR(),
-        LastTrainingTime(0)
+        LastTrainingTime(0),
+        FB(Cfg.DiffN, Cfg.SmoothN, Cfg.LagN)
     {
         if (simple_pattern_matches(Cfg.SP_ChartsToSkip, rrdset_name(RD->rrdset)))
             MLS = MachineLearningStatus::DisabledDueToExcludedChart;
@@ -155,6 +157,9 @@ class Dimension {
 
     TrainingResult trainModel(const TrainingRequest &TR);
 
+    // Uses the models that were saved for this dimension before a restart
+    void restoreModels(std::vector<KMeans> &&SavedModels);
+
     void scheduleForTraining(time_t CurrT);
 
     bool predict(time_t CurrT, CalculatedNumber Value, bool Exists);
@@ -187,8 +192,7 @@ class Dimension {
 
     MachineLearningStatus MLS;
 
-    std::vector<CalculatedNumber> CNs;
-    DSample Feature;
+    FeatureBuffer FB;
     std::vector<KMeans> Models;
     Mutex M;
 };
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef FEATURE_BUFFER_H
+#define FEATURE_BUFFER_H
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "SamplesBuffer.h"
+
+// Limits of the diff/smooth/lag settings, as clamped by Config::readMLConfig()
+constexpr size_t MaxDiffN = 1;
+constexpr size_t MaxSmoothN = 5;
+constexpr size_t MaxLagN = 5;
+
+constexpr size_t MaxFeatureWindow = MaxDiffN + MaxSmoothN + MaxLagN;
+constexpr size_t MaxFeatureSize = MaxLagN + 1;
+
+// Builds the feature vector of the newest value of Window (oldest value first,
+// DiffN + SmoothN + LagN values). The result is the same as the last sample
+// of SamplesBuffer::preprocess() on the same values.
+static inline __attribute__((always_inline)) size_t
+buildFeature(const CalculatedNumber *Window, CalculatedNumber *Feature,
+             size_t DiffN, size_t SmoothN, size_t LagN) {
+    size_t N = DiffN + SmoothN + LagN;
+
+    CalculatedNumber Diffed[MaxFeatureWindow];
+    for (size_t Idx = DiffN; Idx != N; Idx++)
+        Diffed[Idx] = DiffN ? Window[Idx] - Window[Idx - DiffN] : Window[Idx];
+
+    CalculatedNumber Factor = (CalculatedNumber) 1 / SmoothN;
+    for (size_t Lag = 0; Lag != LagN + 1; Lag++) {
+        size_t Last = N - 1 - Lag;
+
+        CalculatedNumber Sum = 0.0;
+        for (size_t Idx = 0; Idx != SmoothN; Idx++)
+            Sum += Diffed[Last - Idx];
+
+        Feature[Lag] = std::abs(Sum * Factor);
+    }
+
+    return LagN + 1;
+}
+
+// Same as buildFeature(), with the window sizes known at compile time,
+// so that the compiler can unroll and vectorize the loops.
+template<size_t DiffN, size_t SmoothN, size_t LagN>
+static inline size_t buildFeature(const CalculatedNumber *Window, CalculatedNumber *Feature) {
+    static_assert(DiffN <= MaxDiffN && SmoothN <= MaxSmoothN && LagN <= MaxLagN, "invalid feature window");
+    static_assert(SmoothN != 0, "smoothing is required to build a feature");
+
+    return buildFeature(Window, Feature, DiffN, SmoothN, LagN);
+}
+
+/*
+ * Keeps the last DiffN + SmoothN + LagN values of a dimension in a ring
+ * buffer and builds the feature vector of the newest one, without
+ * allocating memory.
+ */
+class FeatureBuffer {
+public:
+    FeatureBuffer(size_t DiffN, size_t SmoothN, size_t LagN) :
+        DiffN(DiffN), SmoothN(SmoothN), LagN(LagN),
+        WindowSize(DiffN + SmoothN + LagN), Head(0), Size(0) {
+        assert(DiffN <= MaxDiffN && SmoothN <= MaxSmoothN && LagN <= MaxLagN);
+        assert(WindowSize != 0);
+    }
+
+    void reset() {
+        Head = 0;
+        Size = 0;
+    }
+
+    // Adds a value to the buffer. Returns false while the buffer is being
+    // filled, otherwise it replaces the oldest value, sets SameValue and
+    // returns true.
+    bool add(CalculatedNumber Value, bool &SameValue) {
+        if (Size < WindowSize) {
+            Values[Size++] = Value;
+            return false;
+        }
+
+        size_t Newest = (Head ? Head : WindowSize) - 1;
+        SameValue = (Values[Newest] == Value);
+
+        Values[Head] = Value;
+        if (++Head == WindowSize)
+            Head = 0;
+
+        return true;
+    }
+
+    // Writes the feature vector of the newest value to Feature, which
+    // must have room for MaxFeatureSize values. Returns the size of the
+    // feature vector, or 0 when one cannot be built.
+    size_t feature(CalculatedNumber *Feature) const {
+        if (Size != WindowSize || SmoothN == 0)
+            return 0;
+
+        // Oldest value first
+        CalculatedNumber Window[MaxFeatureWindow];
+        std::memcpy(Window, &Values[Head], (WindowSize - Head) * sizeof(CalculatedNumber));
+        std::memcpy(&Window[WindowSize - Head], Values, Head * sizeof(CalculatedNumber));
+
+        // The default "num samples to diff/smooth/lag" settings
+        if (DiffN == 1 && SmoothN == 3 && LagN == 5)
+            return buildFeature<1, 3, 5>(Window, Feature);
+
+        return buildFeature(Window, Feature, DiffN, SmoothN, LagN);
+    }
+
+private:
+    uint8_t DiffN;
+    uint8_t SmoothN;
+    uint8_t LagN;
+    uint8_t WindowSize;
+
+    // Index of the oldest value, once the buffer is full
+    uint8_t Head;
+    uint8_t Size;
+
+    CalculatedNumber Values[MaxFeatureWindow];
+};
+
+#endif /* FEATURE_BUFFER_H */
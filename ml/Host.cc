@@ -115,14 +115,20 @@ void Host::detectOnce() {
         TS.AllottedUT = 0;
         TS.ConsumedUT = 0;
         TS.RemainingUT = 0;
+        TS.TrainedUT = 0;
 
         TS.TrainingResultOk = 0;
         TS.TrainingResultInvalidQueryTimeRange = 0;
         TS.TrainingResultNotEnoughCollectedValues = 0;
         TS.TrainingResultNullAcquiredDimension = 0;
         TS.TrainingResultChartUnderReplication = 0;
+
+        TS.NumDimensionsLoaded = 0;
     }
 
+    if (TSCopy.TrainedUT)
+        TSCopy.TrainingThroughput = (TSCopy.TrainingResultOk * USEC_PER_SEC) / TSCopy.TrainedUT;
+
     // Calc the avg values
     if (TSCopy.NumPoppedItems) {
         TSCopy.QueueSize /= TSCopy.NumPoppedItems;
@@ -206,6 +212,47 @@ void Host::scheduleForTraining(TrainingRequest TR) {
     TrainingQueue.push(TR);
 }
 
+void Host::loadSavedModels() {
+    if (!DB)
+        return;
+
+    Database::HostModels Models;
+    if (!DB->loadHostModels(&RH->host_uuid, Cfg.DiffN, Cfg.SmoothN, Cfg.LagN, Cfg.NumModelsToUse, Models))
+        return;
+
+    info("Loaded the saved ML models of %zu dimensions of host %s", Models.size(), rrdhost_hostname(RH));
+
+    std::lock_guard<Mutex> L(SavedModelsMutex);
+    SavedModels = std::move(Models);
+
+    // Dimensions that have not been created within a training period,
+    // will train new models anyway
+    SavedModelsExpireT = now_realtime_sec() + Cfg.TrainEvery * RH->rrd_update_every;
+}
+
+void Host::attachSavedModels(Dimension *D) {
+    std::vector<KMeans> Models;
+
+    {
+        std::lock_guard<Mutex> L(SavedModelsMutex);
+
+        if (SavedModels.empty())
+            return;
+
+        auto It = SavedModels.find(Database::dimensionKey(&D->getRD()->metric_uuid));
+        if (It == SavedModels.end())
+            return;
+
+        Models = std::move(It->second);
+        SavedModels.erase(It);
+    }
+
+    D->restoreModels(std::move(Models));
+
+    std::lock_guard<Mutex> L(M);
+    TS.NumDimensionsLoaded += 1;
+}
+
 #define WORKER_JOB_TRAINING_FIND 0
 #define WORKER_JOB_TRAINING_TRAIN 1
 #define WORKER_JOB_TRAINING_STATS 2
@@ -219,6 +266,12 @@ void Host::train() {
     service_register(SERVICE_THREAD_TYPE_NETDATA, NULL, (force_quit_t )ml_cancel_anomaly_detection_threads, RH, true);
 
     while (service_running(SERVICE_ML_TRAINING)) {
+        if (SavedModelsExpireT && now_realtime_sec() > SavedModelsExpireT) {
+            std::lock_guard<Mutex> L(SavedModelsMutex);
+            SavedModels.clear();
+            SavedModelsExpireT = 0;
+        }
+
         auto P = TrainingQueue.pop();
         TrainingRequest TrainingReq = P.first;
         size_t Size = P.second;
@@ -266,6 +319,7 @@ void Host::train() {
             switch (TrainingRes) {
                 case TrainingResult::Ok:
                     TS.TrainingResultOk += 1;
+                    TS.TrainedUT += ConsumedUT;
                     break;
                 case TrainingResult::InvalidQueryTimeRange:
                     TS.TrainingResultInvalidQueryTimeRange += 1;
@@ -8,6 +8,7 @@
 #include "Dimension.h"
 #include "Chart.h"
 #include "Queue.h"
+#include "Database.h"
 
 #include "ml-private.h"
 #include "json/single_include/nlohmann/json.hpp"
@@ -28,7 +29,8 @@ friend void *detect_main(void *);
         HostAnomalyRate(0.0),
         ThreadsRunning(false),
         ThreadsCancelled(false),
-        ThreadsJoined(false)
+        ThreadsJoined(false),
+        SavedModelsExpireT(0)
         {}
 
     void addChart(Chart *C);
@@ -44,6 +46,12 @@ friend void *detect_main(void *);
     void scheduleForTraining(TrainingRequest TR);
     void train();
 
+    // Loads the saved models of all the dimensions of the host, with one query
+    void loadSavedModels();
+
+    // Gives its saved models to a new dimension
+    void attachSavedModels(Dimension *D);
+
     void detect();
     void detectOnce();
 
@@ -58,6 +66,11 @@ friend void *detect_main(void *);
 
     Queue<TrainingRequest> TrainingQueue;
 
+    // The saved models no dimension has claimed yet, freed after SavedModelsExpireT
+    Mutex SavedModelsMutex;
+    Database::HostModels SavedModels;
+    time_t SavedModelsExpireT;
+
     Mutex M;
     std::unordered_map<RRDSET *, Chart *> Charts;
 
@@ -1,21 +1,219 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "KMeans.h"
+#include "FeatureBuffer.h"
 #include <dlib/clustering.h>
 
-void KMeans::train(const std::vector<DSample> &Samples, size_t MaxIterations) {
+#include <random>
+
+/*
+ * Distance kernels. N is the feature size, when it is known at compile
+ * time, so that the compiler can unroll and vectorize the loops. Otherwise
+ * N is 0 and the kernels use the runtime feature size FS.
+ */
+template<size_t N>
+static inline CalculatedNumber squaredDistance(const CalculatedNumber *A, const CalculatedNumber *B, size_t FS) {
+    const size_t Len = N ? N : FS;
+
+    CalculatedNumber Sum = 0.0;
+    for (size_t Idx = 0; Idx != Len; Idx++) {
+        CalculatedNumber Diff = A[Idx] - B[Idx];
+        Sum += Diff * Diff;
+    }
+
+    return Sum;
+}
+
+// Sum of the euclidean distances of Feature from each cluster center
+template<size_t N>
+static inline CalculatedNumber sumOfDistances(const CalculatedNumber *CCs, size_t NumCCs,
+                                              const CalculatedNumber *Feature, size_t FS) {
+    const size_t Len = N ? N : FS;
+
+    CalculatedNumber Sum = 0.0;
+    for (size_t CC = 0; CC != NumCCs; CC++, CCs += Len)
+        Sum += std::sqrt(squaredDistance<N>(CCs, Feature, FS));
+
+    return Sum;
+}
+
+/*
+ * k-means++ seeding, followed by Lloyd's iterations. The min/max mean
+ * distances of the samples from the centers are computed while assigning
+ * the samples to the clusters: when no assignment changes, the centers do
+ * not move, so the last iteration already has the distances we need.
+ */
+template<size_t N>
+static void kmeans(const CalculatedNumber *Samples, size_t NumSamples, size_t FS,
+                   size_t NumClusters, size_t MaxIterations, std::vector<CalculatedNumber> &CCs,
+                   CalculatedNumber &MinDist, CalculatedNumber &MaxDist) {
+    const size_t Len = N ? N : FS;
+
+    CCs.resize(NumClusters * Len);
+
+    /*
+     * Seeding, with a fixed seed so that models are reproducible
+     */
+
+    std::minstd_rand Gen(NumSamples);
+    std::vector<CalculatedNumber> MinSquaredDist(NumSamples, std::numeric_limits<CalculatedNumber>::max());
+
+    size_t Picked = Gen() % NumSamples;
+    std::memcpy(&CCs[0], &Samples[Picked * Len], Len * sizeof(CalculatedNumber));
+
+    for (size_t CC = 1; CC != NumClusters; CC++) {
+        const CalculatedNumber *LastCC = &CCs[(CC - 1) * Len];
+
+        CalculatedNumber Total = 0.0;
+        for (size_t Idx = 0; Idx != NumSamples; Idx++) {
+            CalculatedNumber D = squaredDistance<N>(&Samples[Idx * Len], LastCC, FS);
+            if (D < MinSquaredDist[Idx])
+                MinSquaredDist[Idx] = D;
+
+            Total += MinSquaredDist[Idx];
+        }
+
+        // Pick a sample with probability proportional to its squared
+        // distance from the nearest center picked so far
+        Picked = 0;
+        if (Total > 0.0) {
+            CalculatedNumber Target = std::uniform_real_distribution<CalculatedNumber>(0.0, Total)(Gen);
+
+            for (Picked = 0; Picked != NumSamples - 1; Picked++) {
+                Target -= MinSquaredDist[Picked];
+                if (Target < 0.0)
+                    break;
+            }
+        }
+
+        std::memcpy(&CCs[CC * Len], &Samples[Picked * Len], Len * sizeof(CalculatedNumber));
+    }
+
+    /*
+     * Lloyd's iterations
+     */
+
+    std::vector<uint32_t> Assignments(NumSamples, NumClusters);
+    std::vector<CalculatedNumber> Sums(NumClusters * Len);
+    std::vector<size_t> Counts(NumClusters);
+
+    for (size_t Iteration = 0; Iteration != MaxIterations; Iteration++) {
+        std::fill(Sums.begin(), Sums.end(), 0.0);
+        std::fill(Counts.begin(), Counts.end(), 0);
+
+        CalculatedNumber IterMinDist = std::numeric_limits<CalculatedNumber>::max();
+        CalculatedNumber IterMaxDist = std::numeric_limits<CalculatedNumber>::min();
+        bool Changed = false;
+
+        for (size_t Idx = 0; Idx != NumSamples; Idx++) {
+            const CalculatedNumber *S = &Samples[Idx * Len];
+
+            uint32_t Nearest = 0;
+            CalculatedNumber NearestDist = std::numeric_limits<CalculatedNumber>::max();
+            CalculatedNumber MeanDist = 0.0;
+
+            for (size_t CC = 0; CC != NumClusters; CC++) {
+                CalculatedNumber D = squaredDistance<N>(S, &CCs[CC * Len], FS);
+
+                MeanDist += std::sqrt(D);
+                if (D < NearestDist) {
+                    NearestDist = D;
+                    Nearest = CC;
+                }
+            }
+
+            MeanDist /= NumClusters;
+            if (MeanDist < IterMinDist)
+                IterMinDist = MeanDist;
+            if (MeanDist > IterMaxDist)
+                IterMaxDist = MeanDist;
+
+            if (Assignments[Idx] != Nearest) {
+                Assignments[Idx] = Nearest;
+                Changed = true;
+            }
+
+            Counts[Nearest]++;
+            CalculatedNumber *Sum = &Sums[Nearest * Len];
+            for (size_t FIdx = 0; FIdx != Len; FIdx++)
+                Sum[FIdx] += S[FIdx];
+        }
+
+        if (!Changed) {
+            MinDist = IterMinDist;
+            MaxDist = IterMaxDist;
+            return;
+        }
+
+        // Move the centers to the mean of their samples. Clusters that
+        // ended up without samples keep their center.
+        for (size_t CC = 0; CC != NumClusters; CC++) {
+            if (!Counts[CC])
+                continue;
+
+            for (size_t FIdx = 0; FIdx != Len; FIdx++)
+                CCs[CC * Len + FIdx] = Sums[CC * Len + FIdx] / Counts[CC];
+        }
+    }
+
+    // Did not converge, we need a pass with the final centers
+    MinDist = std::numeric_limits<CalculatedNumber>::max();
+    MaxDist = std::numeric_limits<CalculatedNumber>::min();
+
+    for (size_t Idx = 0; Idx != NumSamples; Idx++) {
+        CalculatedNumber MeanDist = sumOfDistances<N>(CCs.data(), NumClusters, &Samples[Idx * Len], FS);
+        MeanDist /= NumClusters;
+
+        if (MeanDist < MinDist)
+            MinDist = MeanDist;
+        if (MeanDist > MaxDist)
+            MaxDist = MeanDist;
+    }
+}
+
+// fixed-size kernels for all the feature sizes the configuration allows
+static_assert(MaxFeatureSize == 6, "add a kernel for the new maximum feature size");
+
+void KMeans::train(const CalculatedNumber *Samples, size_t NumSamples, size_t FeatureSize, size_t MaxIterations) {
     MinDist = std::numeric_limits<CalculatedNumber>::max();
     MaxDist = std::numeric_limits<CalculatedNumber>::min();
 
     ClusterCenters.clear();
+    this->FeatureSize = 0;
+
+    if (!FeatureSize || NumSamples < NumClusters)
+        return;
 
-    dlib::pick_initial_centers(NumClusters, ClusterCenters, Samples);
-    dlib::find_clusters_using_kmeans(Samples, ClusterCenters, MaxIterations);
+    switch (FeatureSize) {
+        case 1: kmeans<1>(Samples, NumSamples, 1, NumClusters, MaxIterations, ClusterCenters, MinDist, MaxDist); break;
+        case 2: kmeans<2>(Samples, NumSamples, 2, NumClusters, MaxIterations, ClusterCenters, MinDist, MaxDist); break;
+        case 3: kmeans<3>(Samples, NumSamples, 3, NumClusters, MaxIterations, ClusterCenters, MinDist, MaxDist); break;
+        case 4: kmeans<4>(Samples, NumSamples, 4, NumClusters, MaxIterations, ClusterCenters, MinDist, MaxDist); break;
+        case 5: kmeans<5>(Samples, NumSamples, 5, NumClusters, MaxIterations, ClusterCenters, MinDist, MaxDist); break;
+        case 6: kmeans<6>(Samples, NumSamples, 6, NumClusters, MaxIterations, ClusterCenters, MinDist, MaxDist); break;
+        default:
+            kmeans<0>(Samples, NumSamples, FeatureSize, NumClusters, MaxIterations, ClusterCenters, MinDist, MaxDist);
+            break;
+    }
+
+    this->FeatureSize = FeatureSize;
+}
+
+void KMeans::trainWithDlib(const std::vector<DSample> &Samples, size_t MaxIterations) {
+    MinDist = std::numeric_limits<CalculatedNumber>::max();
+    MaxDist = std::numeric_limits<CalculatedNumber>::min();
+
+    ClusterCenters.clear();
+    FeatureSize = 0;
+
+    std::vector<DSample> CCs;
+    dlib::pick_initial_centers(NumClusters, CCs, Samples);
+    dlib::find_clusters_using_kmeans(Samples, CCs, MaxIterations);
 
     for (const auto &S : Samples) {
         CalculatedNumber MeanDist = 0.0;
 
-        for (const auto &KMCenter : ClusterCenters)
+        for (const auto &KMCenter : CCs)
             MeanDist += dlib::length(KMCenter - S);
 
         MeanDist /= NumClusters;
@@ -26,12 +224,35 @@ void KMeans::train(const std::vector<DSample> &Samples, size_t MaxIterations) {
         if (MeanDist > MaxDist)
             MaxDist = MeanDist;
     }
+
+    if (!CCs.empty())
+        FeatureSize = CCs[0].size();
+
+    ClusterCenters.reserve(CCs.size() * FeatureSize);
+    for (const auto &CC : CCs) {
+        for (long Idx = 0; Idx != CC.size(); Idx++)
+            ClusterCenters.push_back(CC(Idx));
+    }
 }
 
-CalculatedNumber KMeans::anomalyScore(const DSample &Sample) const {
-    CalculatedNumber MeanDist = 0.0;
-    for (const auto &CC: ClusterCenters)
-        MeanDist += dlib::length(CC - Sample);
+CalculatedNumber KMeans::anomalyScore(const CalculatedNumber *Feature, size_t N) const {
+    if (N != FeatureSize)
+        return std::numeric_limits<CalculatedNumber>::quiet_NaN();
+
+    size_t NumCCs = N ? ClusterCenters.size() / N : 0;
+    CalculatedNumber MeanDist;
+
+    switch (N) {
+        case 1: MeanDist = sumOfDistances<1>(ClusterCenters.data(), NumCCs, Feature, 1); break;
+        case 2: MeanDist = sumOfDistances<2>(ClusterCenters.data(), NumCCs, Feature, 2); break;
+        case 3: MeanDist = sumOfDistances<3>(ClusterCenters.data(), NumCCs, Feature, 3); break;
+        case 4: MeanDist = sumOfDistances<4>(ClusterCenters.data(), NumCCs, Feature, 4); break;
+        case 5: MeanDist = sumOfDistances<5>(ClusterCenters.data(), NumCCs, Feature, 5); break;
+        case 6: MeanDist = sumOfDistances<6>(ClusterCenters.data(), NumCCs, Feature, 6); break;
+        default:
+            MeanDist = sumOfDistances<0>(ClusterCenters.data(), NumCCs, Feature, N);
+            break;
+    }
 
     MeanDist /= NumClusters;
 
@@ -41,3 +262,18 @@ CalculatedNumber KMeans::anomalyScore(const DSample &Sample) const {
     CalculatedNumber AnomalyScore = 100.0 * std::abs((MeanDist - MinDist) / (MaxDist - MinDist));
     return (AnomalyScore > 100.0) ? 100.0 : AnomalyScore;
 }
+
+bool KMeans::restore(const CalculatedNumber *CCs, size_t NumValues, size_t FeatureSize,
+                     CalculatedNumber MinDist, CalculatedNumber MaxDist) {
+    if (!FeatureSize || FeatureSize > MaxFeatureSize)
+        return false;
+
+    if (NumValues != NumClusters * FeatureSize)
+        return false;
+
+    ClusterCenters.assign(CCs, CCs + NumValues);
+    this->FeatureSize = FeatureSize;
+    this->MinDist = MinDist;
+    this->MaxDist = MaxDist;
+    return true;
+}
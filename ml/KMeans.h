@@ -18,12 +18,47 @@ class KMeans {
         MaxDist = std::numeric_limits<CalculatedNumber>::min();
     };
 
-    void train(const std::vector<DSample> &Samples, size_t MaxIterations);
-    CalculatedNumber anomalyScore(const DSample &Sample) const;
+    // Trains the model with NumSamples samples of FeatureSize values each,
+    // stored one after the other in a contiguous array.
+    void train(const CalculatedNumber *Samples, size_t NumSamples, size_t FeatureSize, size_t MaxIterations);
+
+    // Trains the model with dlib's k-means. It is slower than train() and
+    // it is used only to check the models that train() generates.
+    void trainWithDlib(const std::vector<DSample> &Samples, size_t MaxIterations);
+
+    // Allocation-free scoring of a feature vector with N values. Returns NaN
+    // when N is not the feature size of the model, so callers must check it.
+    CalculatedNumber anomalyScore(const CalculatedNumber *Feature, size_t N) const;
+
+    // Restores a model from the values of a saved one. Returns false
+    // when the values do not describe a model with NumClusters centers.
+    bool restore(const CalculatedNumber *CCs, size_t NumValues, size_t FeatureSize,
+                 CalculatedNumber MinDist, CalculatedNumber MaxDist);
+
+    const std::vector<CalculatedNumber> &clusterCenters() const { return ClusterCenters; }
+    size_t featureSize() const { return FeatureSize; }
+    CalculatedNumber minDist() const { return MinDist; }
+    CalculatedNumber maxDist() const { return MaxDist; }
+
+    // Time range of the values the model was trained with
+    void setTrainingWindow(time_t AfterT, time_t BeforeT) {
+        this->AfterT = AfterT;
+        this->BeforeT = BeforeT;
+    }
+
+    time_t afterT() const { return AfterT; }
+    time_t beforeT() const { return BeforeT; }
 
     void toJson(nlohmann::json &J) const {
+        std::vector<std::vector<CalculatedNumber>> CCs;
+
+        if (FeatureSize) {
+            for (size_t Idx = 0; Idx != ClusterCenters.size(); Idx += FeatureSize)
+                CCs.emplace_back(ClusterCenters.begin() + Idx, ClusterCenters.begin() + Idx + FeatureSize);
+        }
+
         J = nlohmann::json{
-            {"CCs", ClusterCenters},
+            {"CCs", CCs},
             {"MinDist", MinDist},
             {"MaxDist", MaxDist}
         };
@@ -32,10 +67,15 @@ class KMeans {
 private:
     size_t NumClusters;
 
-    std::vector<DSample> ClusterCenters;
+    // The cluster centers, one after the other, FeatureSize values each
+    std::vector<CalculatedNumber> ClusterCenters;
+    size_t FeatureSize = 0;
 
     CalculatedNumber MinDist;
     CalculatedNumber MaxDist;
+
+    time_t AfterT = 0;
+    time_t BeforeT = 0;
 };
 
 #endif /* KMEANS_H */
@@ -100,31 +100,44 @@ void SamplesBuffer::lagSamples() {
     }
 }
 
-void SamplesBuffer::preprocess(std::vector<DSample> &Samples) {
+/*
+ * Diffs, smooths and lags the samples of the buffer. Returns the number of
+ * preprocessed samples, found at the end of the buffer, or 0 when there
+ * are not enough samples.
+ */
+size_t SamplesBuffer::preprocessInPlace() {
     assert(Preprocessed == false);
 
     size_t OutN = NumSamples;
 
     // Diff
     if (DiffN >= OutN)
-        return;
+        return 0;
     OutN -= DiffN;
     diffSamples();
 
     // Smooth
     if (SmoothN == 0 || SmoothN > OutN)
-        return;
+        return 0;
     OutN -= (SmoothN - 1);
     smoothSamples();
 
     // Lag
     if (LagN >= OutN)
-        return;
+        return 0;
     OutN -= LagN;
     lagSamples();
 
-    Samples.reserve(OutN);
     Preprocessed = true;
+    return OutN;
+}
+
+void SamplesBuffer::preprocess(std::vector<DSample> &Samples) {
+    size_t OutN = preprocessInPlace();
+    if (!OutN)
+        return;
+
+    Samples.reserve(OutN);
 
     uint32_t MaxMT = std::numeric_limits<uint32_t>::max();
     uint32_t CutOff = static_cast<double>(MaxMT) * SamplingRatio;
@@ -144,29 +157,31 @@ void SamplesBuffer::preprocess(std::vector<DSample> &Samples) {
 }
 
 void SamplesBuffer::preprocess(DSample &Feature) {
-    assert(Preprocessed == false);
+    size_t OutN = preprocessInPlace();
+    if (!OutN)
+        return;
 
-    size_t OutN = NumSamples;
+    uint32_t MaxMT = std::numeric_limits<uint32_t>::max();
+    uint32_t CutOff = static_cast<double>(MaxMT) * SamplingRatio;
 
-    // Diff
-    if (DiffN >= OutN)
-        return;
-    OutN -= DiffN;
-    diffSamples();
+    for (size_t Idx = NumSamples - OutN; Idx != NumSamples; Idx++) {
+        if (RandNums[Idx] > CutOff)
+            continue;
 
-    // Smooth
-    if (SmoothN == 0 || SmoothN > OutN)
-        return;
-    OutN -= (SmoothN - 1);
-    smoothSamples();
+        Feature.set_size(NumDimsPerSample * (LagN + 1));
 
-    // Lag
-    if (LagN >= OutN)
+        const Sample PS = getPreprocessedSample(Idx);
+        PS.initDSample(Feature);
+    }
+}
+
+void SamplesBuffer::preprocess(std::vector<CalculatedNumber> &Samples) {
+    size_t OutN = preprocessInPlace();
+    if (!OutN)
         return;
-    OutN -= LagN;
-    lagSamples();
 
-    Preprocessed = true;
+    size_t FeatureSize = NumDimsPerSample * (LagN + 1);
+    Samples.reserve(OutN * FeatureSize);
 
     uint32_t MaxMT = std::numeric_limits<uint32_t>::max();
     uint32_t CutOff = static_cast<double>(MaxMT) * SamplingRatio;
@@ -175,9 +190,10 @@ void SamplesBuffer::preprocess(DSample &Feature) {
         if (RandNums[Idx] > CutOff)
             continue;
 
-        Feature.set_size(NumDimsPerSample * (LagN + 1));
+        size_t Offset = Samples.size();
+        Samples.resize(Offset + FeatureSize);
 
         const Sample PS = getPreprocessedSample(Idx);
-        PS.initDSample(Feature);
+        PS.initFeature(&Samples[Offset]);
     }
 }
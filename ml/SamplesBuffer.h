@@ -25,6 +25,12 @@ class Sample {
         }
     }
 
+    void initFeature(CalculatedNumber *Feature) const {
+        for (size_t Idx = 0; Idx != NumDims; Idx++) {
+            Feature[Idx] = std::abs(CNs[Idx]);
+        }
+    }
+
     void add(const Sample &RHS) const {
         assert(NumDims == RHS.NumDims);
 
@@ -92,6 +98,9 @@ class SamplesBuffer {
 
     void preprocess(std::vector<DSample> &Samples);
     void preprocess(DSample &Feature);
+
+    // Preprocessed samples, one after the other, in a contiguous array
+    void preprocess(std::vector<CalculatedNumber> &Samples);
     std::vector<Sample> getPreprocessedSamples() const;
 
     size_t capacity() const { return NumSamples; }
@@ -126,6 +135,7 @@ class SamplesBuffer {
     void diffSamples();
     void smoothSamples();
     void lagSamples();
+    size_t preprocessInPlace();
 
 private:
     CalculatedNumber *CNs;
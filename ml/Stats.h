@@ -34,11 +34,20 @@ struct TrainingStats {
     usec_t ConsumedUT;
     usec_t RemainingUT;
 
+    // Time consumed by the trainings that generated a model, and the
+    // dimensions per second a busy training thread would train
+    usec_t TrainedUT;
+    size_t TrainingThroughput;
+
     size_t TrainingResultOk;
     size_t TrainingResultInvalidQueryTimeRange;
     size_t TrainingResultNotEnoughCollectedValues;
     size_t TrainingResultNullAcquiredDimension;
     size_t TrainingResultChartUnderReplication;
+
+    // Dimensions that got their saved models when they were created,
+    // these are not training requests, so they are not averaged
+    size_t NumDimensionsLoaded;
 };
 
 } // namespace ml
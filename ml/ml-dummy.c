@@ -15,6 +15,8 @@ bool ml_enabled(RRDHOST *RH) {
 
 void ml_init(void) {}
 
+void ml_fini(void) {}
+
 void ml_host_new(RRDHOST *RH) {
     UNUSED(RH);
 }
@@ -82,4 +84,9 @@ bool ml_streaming_enabled() {
     return false;
 }
 
+int ml_unittest(void) {
+    fprintf(stderr, "ML is not available in this build\n");
+    return 0;
+}
+
 #endif
@@ -4,6 +4,7 @@
 #include "Dimension.h"
 #include "Chart.h"
 #include "Host.h"
+#include "Database.h"
 
 #include <random>
 
@@ -44,6 +45,25 @@ void ml_init(void) {
     Cfg.RandomNums.reserve(Cfg.MaxTrainSamples);
     for (size_t Idx = 0; Idx != Cfg.MaxTrainSamples; Idx++)
         Cfg.RandomNums.push_back(Gen());
+
+    // Open the database of the trained models, so that dimensions can
+    // start with the models they had before the agent was restarted.
+    char Path[FILENAME_MAX + 1];
+    snprintfz(Path, FILENAME_MAX, "%s/ml.db", netdata_configured_cache_dir);
+
+    DB = new Database();
+    if (DB->open(Path)) {
+        DB->removeModelsBefore(now_realtime_sec() - Cfg.DeleteModelsOlderThan);
+    } else {
+        delete DB;
+        DB = nullptr;
+    }
+}
+
+void ml_fini(void) {
+    // Called after the training threads of all hosts have stopped
+    delete DB;
+    DB = nullptr;
 }
 
 void ml_host_new(RRDHOST *RH) {
@@ -51,6 +71,7 @@ void ml_host_new(RRDHOST *RH) {
         return;
 
     Host *H = new Host(RH);
+    H->loadSavedModels();
     RH->ml_host = reinterpret_cast<ml_host_t *>(H);
 }
 
@@ -92,6 +113,10 @@ void ml_dimension_new(RRDDIM *RD) {
         return;
 
     Dimension *D = new Dimension(RD);
+
+    Host *H = reinterpret_cast<Host *>(RD->rrdset->rrdhost->ml_host);
+    H->attachSavedModels(D);
+
     RD->ml_dimension = reinterpret_cast<ml_dimension_t *>(D);
     C->addDimension(D);
 }
@@ -199,4 +224,234 @@ bool ml_streaming_enabled() {
     return Cfg.StreamADCharts;
 }
 
-#include "ml-private.h"
+// Largest relative difference between the cluster centers of two models,
+// regardless of the order the centers were found in.
+static CalculatedNumber centersDifference(const KMeans &A, const KMeans &B) {
+    const std::vector<CalculatedNumber> &ACCs = A.clusterCenters();
+    const std::vector<CalculatedNumber> &BCCs = B.clusterCenters();
+
+    if (!A.featureSize() || A.featureSize() != B.featureSize() || ACCs.size() != BCCs.size())
+        return std::numeric_limits<CalculatedNumber>::max();
+
+    size_t FeatureSize = A.featureSize();
+    size_t NumCCs = ACCs.size() / FeatureSize;
+
+    CalculatedNumber Diff = 0.0;
+    for (size_t ACC = 0; ACC != NumCCs; ACC++) {
+        CalculatedNumber NearestDiff = std::numeric_limits<CalculatedNumber>::max();
+
+        for (size_t BCC = 0; BCC != NumCCs; BCC++) {
+            CalculatedNumber CCDiff = 0.0;
+
+            for (size_t Idx = 0; Idx != FeatureSize; Idx++) {
+                CalculatedNumber AV = ACCs[ACC * FeatureSize + Idx];
+                CalculatedNumber BV = BCCs[BCC * FeatureSize + Idx];
+                CCDiff = std::max(CCDiff, std::abs(AV - BV) / std::max(1.0, std::abs(BV)));
+            }
+
+            NearestDiff = std::min(NearestDiff, CCDiff);
+        }
+
+        Diff = std::max(Diff, NearestDiff);
+    }
+
+    return Diff;
+}
+
+/*
+ * Checks the features of the prediction path against the ones used for
+ * training and the k-means models against dlib's, and measures the
+ * trainings and predictions per second of a single core.
+ */
+int ml_unittest(void) {
+    const size_t DiffN = 1, SmoothN = 3, LagN = 5;
+    const size_t WindowSize = DiffN + SmoothN + LagN;
+    const size_t FeatureSize = LagN + 1;
+    const size_t NumValues = 3600;
+
+    std::mt19937 Gen(42);
+    std::normal_distribution<CalculatedNumber> Dist(100.0, 10.0);
+
+    // Noise with periodic level shifts, so that there are two clusters
+    std::vector<CalculatedNumber> Values(NumValues);
+    for (size_t Idx = 0; Idx != NumValues; Idx++)
+        Values[Idx] = Dist(Gen) + ((Idx % 300) < 30 ? 200.0 : 0.0);
+
+    // Preprocess the values, just like Dimension::trainModel() does
+    std::vector<uint32_t> RandNums(NumValues, 0);
+    std::vector<CalculatedNumber> CNs(NumValues * (LagN + 1), 0.0);
+
+    std::memcpy(CNs.data(), Values.data(), NumValues * sizeof(CalculatedNumber));
+    std::vector<CalculatedNumber> Samples;
+    SamplesBuffer(CNs.data(), NumValues, 1, DiffN, SmoothN, LagN, 1.0, RandNums).preprocess(Samples);
+    size_t NumSamples = Samples.size() / FeatureSize;
+
+    std::memcpy(CNs.data(), Values.data(), NumValues * sizeof(CalculatedNumber));
+    std::vector<DSample> DSamples;
+    SamplesBuffer(CNs.data(), NumValues, 1, DiffN, SmoothN, LagN, 1.0, RandNums).preprocess(DSamples);
+
+    // The features of the ring buffer must match the training samples
+    FeatureBuffer FB(DiffN, SmoothN, LagN);
+    size_t Errors = 0;
+
+    for (size_t Idx = 0; Idx != NumValues; Idx++) {
+        bool SameValue = true;
+        if (!FB.add(Values[Idx], SameValue))
+            continue;
+
+        CalculatedNumber Feature[MaxFeatureSize];
+        size_t N = FB.feature(Feature);
+
+        const CalculatedNumber *S = &Samples[(Idx - (WindowSize - 1)) * FeatureSize];
+        const DSample &DS = DSamples[Idx - (WindowSize - 1)];
+        if (N != FeatureSize || static_cast<long>(N) != DS.size()) {
+            Errors++;
+            continue;
+        }
+
+        for (size_t FIdx = 0; FIdx != N; FIdx++) {
+            if (std::abs(Feature[FIdx] - S[FIdx]) > 1e-9 * std::max(1.0, std::abs(S[FIdx])))
+                Errors++;
+            if (S[FIdx] != DS(FIdx))
+                Errors++;
+        }
+    }
+
+    fprintf(stderr, "ML: %zu samples, %zu features not matching the training samples\n", NumSamples, Errors);
+    if (Errors)
+        return 1;
+
+    // The models must match the ones of dlib
+    KMeans KM, DlibKM;
+    KM.train(Samples.data(), NumSamples, FeatureSize, 1000);
+    DlibKM.trainWithDlib(DSamples, 1000);
+
+    CalculatedNumber CCsDiff = centersDifference(KM, DlibKM);
+    CalculatedNumber MinDistDiff = std::abs(KM.minDist() - DlibKM.minDist()) / std::max(1.0, DlibKM.minDist());
+    CalculatedNumber MaxDistDiff = std::abs(KM.maxDist() - DlibKM.maxDist()) / std::max(1.0, DlibKM.maxDist());
+
+    fprintf(stderr, "ML: k-means vs dlib, relative difference of centers %g, min distance %g, max distance %g\n",
+            CCsDiff, MinDistDiff, MaxDistDiff);
+    if (CCsDiff > 1e-3 || MinDistDiff > 1e-3 || MaxDistDiff > 1e-3)
+        return 1;
+
+    // A feature of another size cannot be scored by the model
+    if (!std::isnan(KM.anomalyScore(Samples.data(), FeatureSize - 1))) {
+        fprintf(stderr, "ML: a feature of %zu values was scored by a model of %zu values\n", FeatureSize - 1, FeatureSize);
+        return 1;
+    }
+
+    // The models saved in the database must be restored as they were trained
+    char DBPath[] = "/tmp/netdata-ml-unittest-XXXXXX";
+    int FD = mkstemp(DBPath);
+    if (FD == -1) {
+        fprintf(stderr, "ML: cannot create a temporary models database\n");
+        return 1;
+    }
+    close(FD);
+
+    size_t RestoreErrors = 0;
+    {
+        Database TestDB;
+        if (!TestDB.open(DBPath))
+            RestoreErrors++;
+
+        uuid_t HostId, OtherHostId, DimId, OtherDimId;
+        uuid_generate(HostId);
+        uuid_generate(OtherHostId);
+        uuid_generate(DimId);
+        uuid_generate(OtherDimId);
+
+        // Two models of a dimension, one of the same dimension with different
+        // smoothing, and one of another host
+        KMeans OldKM = DlibKM, NewKM = KM;
+        OldKM.setTrainingWindow(1000, 2000);
+        NewKM.setTrainingWindow(2000, 3000);
+
+        if (!TestDB.saveModel(&HostId, &DimId, OldKM, DiffN, SmoothN, 0) ||
+            !TestDB.saveModel(&HostId, &DimId, NewKM, DiffN, SmoothN, 0) ||
+            !TestDB.saveModel(&HostId, &OtherDimId, NewKM, DiffN, SmoothN + 1, 0) ||
+            !TestDB.saveModel(&OtherHostId, &OtherDimId, NewKM, DiffN, SmoothN, 0))
+            RestoreErrors++;
+
+        Database::HostModels Models;
+        if (!TestDB.loadHostModels(&HostId, DiffN, SmoothN, LagN, 2, Models) || Models.size() != 1)
+            RestoreErrors++;
+
+        const std::vector<KMeans> &DimModels = Models[Database::dimensionKey(&DimId)];
+        if (DimModels.size() != 2 || DimModels[0].afterT() != 1000 || DimModels[1].beforeT() != 3000)
+            RestoreErrors++;
+
+        for (size_t Idx = 0; Idx != DimModels.size() && Idx != 2; Idx++) {
+            const KMeans &Saved = Idx ? NewKM : OldKM;
+            const KMeans &Restored = DimModels[Idx];
+
+            if (Restored.clusterCenters() != Saved.clusterCenters() || Restored.featureSize() != FeatureSize ||
+                Restored.minDist() != Saved.minDist() || Restored.maxDist() != Saved.maxDist())
+                RestoreErrors++;
+
+            const CalculatedNumber *Feature = &Samples[(NumSamples / 2) * FeatureSize];
+            if (Restored.anomalyScore(Feature, FeatureSize) != Saved.anomalyScore(Feature, FeatureSize))
+                RestoreErrors++;
+        }
+
+        // Keeping only the most recent model
+        Models.clear();
+        if (!TestDB.loadHostModels(&HostId, DiffN, SmoothN, LagN, 1, Models) ||
+            Models[Database::dimensionKey(&DimId)].size() != 1 ||
+            Models[Database::dimensionKey(&DimId)][0].afterT() != 2000)
+            RestoreErrors++;
+    }
+
+    unlink(DBPath);
+    for (const char *Suffix : { "-wal", "-shm" }) {
+        std::string Path = std::string(DBPath) + Suffix;
+        unlink(Path.c_str());
+    }
+
+    fprintf(stderr, "ML: %zu errors restoring the models saved in the database\n", RestoreErrors);
+    if (RestoreErrors)
+        return 1;
+
+    // Trainings per second of a single core
+    const size_t NumTrainings = 100;
+
+    usec_t Started = now_monotonic_usec();
+    for (size_t Idx = 0; Idx != NumTrainings; Idx++)
+        KM.train(Samples.data(), NumSamples, FeatureSize, 1000);
+    double Secs = (double) (now_monotonic_usec() - Started) / USEC_PER_SEC;
+
+    Started = now_monotonic_usec();
+    for (size_t Idx = 0; Idx != NumTrainings; Idx++)
+        DlibKM.trainWithDlib(DSamples, 1000);
+    double DlibSecs = (double) (now_monotonic_usec() - Started) / USEC_PER_SEC;
+
+    fprintf(stderr, "ML: %zu trainings of %zu samples, k-means %0.0f dimensions/sec/core, dlib %0.0f dimensions/sec/core\n",
+            NumTrainings, NumSamples, NumTrainings / Secs, NumTrainings / DlibSecs);
+
+    // Predictions per second of a single core
+    const size_t NumPredictions = 10 * 1000 * 1000;
+    size_t NumAnomalous = 0;
+
+    FB.reset();
+    Started = now_monotonic_usec();
+
+    for (size_t Idx = 0; Idx != NumPredictions; Idx++) {
+        bool SameValue = true;
+        if (!FB.add(Values[Idx % NumValues], SameValue))
+            continue;
+
+        CalculatedNumber Feature[MaxFeatureSize];
+        size_t N = FB.feature(Feature);
+
+        if (KM.anomalyScore(Feature, N) >= 99.0)
+            NumAnomalous++;
+    }
+
+    Secs = (double) (now_monotonic_usec() - Started) / USEC_PER_SEC;
+
+    fprintf(stderr, "ML: %zu predictions in %0.3f secs, %0.0f predictions/sec/core (%zu anomalous)\n",
+            NumPredictions, Secs, NumPredictions / Secs, NumAnomalous);
+
+    return 0;
+}
@@ -19,6 +19,7 @@ bool ml_capable();
 bool ml_enabled(RRDHOST *RH);
 
 void ml_init(void);
+void ml_fini(void);
 
 void ml_host_new(RRDHOST *RH);
 void ml_host_delete(RRDHOST *RH);
@@ -44,6 +45,8 @@ bool ml_is_anomalous(RRDDIM *RD, time_t curr_t, double value, bool exists);
 
 bool ml_streaming_enabled();
 
+int ml_unittest(void);
+
 #ifdef __cplusplus
 };
 #endif
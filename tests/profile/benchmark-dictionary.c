@@ -3,7 +3,13 @@
  * 1. build netdata (as normally)
  * 2. cd tests/profile/
  * 3. compile with:
- *    gcc -O3 -Wall -Wextra -I ../../src/ -I ../../ -o benchmark-dictionary benchmark-dictionary.c ../../src/dictionary.o ../../src/log.o ../../src/avl.o ../../src/common.o -pthread
+ *    make benchmark-dictionary
+ *
+ * Usage: benchmark-dictionary [entries] [seconds per multi-threaded scenario]
+ *
+ * The first part measures single threaded inserts, searches, resets and deletes.
+ * The second part runs multiple readers and writers concurrently on the same
+ * dictionary, once with the default index and once with a partitioned index.
  *
  */
 
@@ -16,23 +22,34 @@ struct myvalue {
 
 void netdata_cleanup_and_exit(int ret) { exit(ret); }
 
-int main(int argc, char **argv) {
-	if(argc || argv) {;}
+static struct dictionary_stats stats = {
+	.name = "benchmark",
+};
 
-//	DICTIONARY *dict = dictionary_create(DICT_OPTION_SINGLE_THREADED|DICT_OPTION_WITH_STATISTICS);
-	DICTIONARY *dict = dictionary_create(DICT_OPTION_STATS);
+static void stats_reset(void) {
+	memset(&stats.ops, 0, sizeof(stats.ops));
+	memset(&stats.spin_locks, 0, sizeof(stats.spin_locks));
+}
+
+static void stats_print(void) {
+	fprintf(stderr, " > Dictionary: %zu inserts, %zu deletes, %zu searches, %zu resets, %zu search ignores\n\n",
+			stats.ops.inserts, stats.ops.deletes, stats.ops.searches, stats.ops.resets, stats.spin_locks.search_spins);
+}
+
+static void single_threaded(DICT_OPTIONS options, int max) {
+	DICTIONARY *dict = dictionary_create_advanced(options, &stats);
 	if(!dict) fatal("Cannot create dictionary.");
 
 	struct rusage start, end;
 	unsigned long long dt;
 	char buf[100 + 1];
 	struct myvalue value, *v;
-	int i, max = 30000000, max2;
+	int i, max2;
 
 	// ------------------------------------------------------------------------
 
 	getrusage(RUSAGE_SELF, &start);
-	dict->stats->inserts = dict->stats->deletes = dict->stats->searches = 0ULL;
+	stats_reset();
 	fprintf(stderr, "Inserting %d entries in the dictionary\n", max);
 	for(i = 0; i < max; i++) {
 		value.i = i;
@@ -42,13 +59,14 @@ int main(int argc, char **argv) {
 	}
 	getrusage(RUSAGE_SELF, &end);
 	dt = (end.ru_utime.tv_sec * 1000000ULL + end.ru_utime.tv_usec) - (start.ru_utime.tv_sec * 1000000ULL + start.ru_utime.tv_usec);
-	fprintf(stderr, "Added %d entries in %llu nanoseconds: %llu inserts per second\n", max, dt, max * 1000000ULL / dt);
-	fprintf(stderr, " > Dictionary: %llu inserts, %llu deletes, %llu searches\n\n", dict->stats->inserts, dict->stats->deletes, dict->stats->searches);
+	if(!dt) dt = 1;
+	fprintf(stderr, "Added %d entries in %llu microseconds: %llu inserts per second\n", max, dt, max * 1000000ULL / dt);
+	stats_print();
 
 	// ------------------------------------------------------------------------
 
 	getrusage(RUSAGE_SELF, &start);
-	dict->stats->inserts = dict->stats->deletes = dict->stats->searches = 0ULL;
+	stats_reset();
 	fprintf(stderr, "Retrieving %d entries from the dictionary\n", max);
 	for(i = 0; i < max; i++) {
 		value.i = i;
@@ -62,13 +80,14 @@ int main(int argc, char **argv) {
 	}
 	getrusage(RUSAGE_SELF, &end);
 	dt = (end.ru_utime.tv_sec * 1000000ULL + end.ru_utime.tv_usec) - (start.ru_utime.tv_sec * 1000000ULL + start.ru_utime.tv_usec);
-	fprintf(stderr, "Read %d entries in %llu nanoseconds: %llu searches per second\n", max, dt, max * 1000000ULL / dt);
-	fprintf(stderr, " > Dictionary: %llu inserts, %llu deletes, %llu searches\n\n", dict->stats->inserts, dict->stats->deletes, dict->stats->searches);
+	if(!dt) dt = 1;
+	fprintf(stderr, "Read %d entries in %llu microseconds: %llu searches per second\n", max, dt, max * 1000000ULL / dt);
+	stats_print();
 
 	// ------------------------------------------------------------------------
 
 	getrusage(RUSAGE_SELF, &start);
-	dict->stats->inserts = dict->stats->deletes = dict->stats->searches = 0ULL;
+	stats_reset();
 	fprintf(stderr, "Resetting %d entries in the dictionary\n", max);
 	for(i = 0; i < max; i++) {
 		value.i = i;
@@ -78,13 +97,14 @@ int main(int argc, char **argv) {
 	}
 	getrusage(RUSAGE_SELF, &end);
 	dt = (end.ru_utime.tv_sec * 1000000ULL + end.ru_utime.tv_usec) - (start.ru_utime.tv_sec * 1000000ULL + start.ru_utime.tv_usec);
-	fprintf(stderr, "Reset %d entries in %llu nanoseconds: %llu resets per second\n", max, dt, max * 1000000ULL / dt);
-	fprintf(stderr, " > Dictionary: %llu inserts, %llu deletes, %llu searches\n\n", dict->stats->inserts, dict->stats->deletes, dict->stats->searches);
+	if(!dt) dt = 1;
+	fprintf(stderr, "Reset %d entries in %llu microseconds: %llu resets per second\n", max, dt, max * 1000000ULL / dt);
+	stats_print();
 
 	// ------------------------------------------------------------------------
 
 	getrusage(RUSAGE_SELF, &start);
-	dict->stats->inserts = dict->stats->deletes = dict->stats->searches = 0ULL;
+	stats_reset();
 	fprintf(stderr, "Searching  %d non-existing entries in the dictionary\n", max);
 	max2 = max * 2;
 	for(i = max; i < max2; i++) {
@@ -97,13 +117,14 @@ int main(int argc, char **argv) {
 	}
 	getrusage(RUSAGE_SELF, &end);
 	dt = (end.ru_utime.tv_sec * 1000000ULL + end.ru_utime.tv_usec) - (start.ru_utime.tv_sec * 1000000ULL + start.ru_utime.tv_usec);
-	fprintf(stderr, "Searched %d non-existing entries in %llu nanoseconds: %llu not found searches per second\n", max, dt, max * 1000000ULL / dt);
-	fprintf(stderr, " > Dictionary: %llu inserts, %llu deletes, %llu searches\n\n", dict->stats->inserts, dict->stats->deletes, dict->stats->searches);
+	if(!dt) dt = 1;
+	fprintf(stderr, "Searched %d non-existing entries in %llu microseconds: %llu not found searches per second\n", max, dt, max * 1000000ULL / dt);
+	stats_print();
 
 	// ------------------------------------------------------------------------
 
 	getrusage(RUSAGE_SELF, &start);
-	dict->stats->inserts = dict->stats->deletes = dict->stats->searches = 0ULL;
+	stats_reset();
 	fprintf(stderr, "Deleting %d entries from the dictionary\n", max);
 	for(i = 0; i < max; i++) {
 		value.i = i;
@@ -113,18 +134,157 @@ int main(int argc, char **argv) {
 	}
 	getrusage(RUSAGE_SELF, &end);
 	dt = (end.ru_utime.tv_sec * 1000000ULL + end.ru_utime.tv_usec) - (start.ru_utime.tv_sec * 1000000ULL + start.ru_utime.tv_usec);
-	fprintf(stderr, "Deleted %d entries in %llu nanoseconds: %llu deletes per second\n", max, dt, max * 1000000ULL / dt);
-	fprintf(stderr, " > Dictionary: %llu inserts, %llu deletes, %llu searches\n\n", dict->stats->inserts, dict->stats->deletes, dict->stats->searches);
+	if(!dt) dt = 1;
+	fprintf(stderr, "Deleted %d entries in %llu microseconds: %llu deletes per second\n", max, dt, max * 1000000ULL / dt);
+	stats_print();
 
 	// ------------------------------------------------------------------------
 
 	getrusage(RUSAGE_SELF, &start);
-	dict->stats->inserts = dict->stats->deletes = dict->stats->searches = 0ULL;
+	stats_reset();
 	fprintf(stderr, "Destroying dictionary\n");
 	dictionary_destroy(dict);
 	getrusage(RUSAGE_SELF, &end);
 	dt = (end.ru_utime.tv_sec * 1000000ULL + end.ru_utime.tv_usec) - (start.ru_utime.tv_sec * 1000000ULL + start.ru_utime.tv_usec);
-	fprintf(stderr, "Destroyed in %llu nanoseconds\n", dt);
+	fprintf(stderr, "Destroyed in %llu microseconds\n\n", dt);
+}
+
+// ----------------------------------------------------------------------------
+// multiple readers and writers on the same dictionary
+
+struct mt_benchmark {
+	DICTIONARY *dict;
+	int entries;			// the entries readers search for (they always exist)
+	int stop;
+	size_t reads;
+	size_t writes;
+	size_t errors;
+};
+
+static void *mt_reader(void *ptr) {
+	struct mt_benchmark *mt = ptr;
+	char buf[100 + 1];
+	size_t reads = 0, errors = 0;
+	unsigned int seed = (unsigned int)gettid();
+
+	while(!__atomic_load_n(&mt->stop, __ATOMIC_RELAXED)) {
+		for(int j = 0; j < 1000 ; j++, reads++) {
+			int i = rand_r(&seed) % mt->entries;
+			snprintf(buf, 100, "%d", i);
+
+			const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(mt->dict, buf);
+			if(!item) {
+				errors++;
+				continue;
+			}
+
+			struct myvalue *v = dictionary_acquired_item_value(item);
+			if(v->i != i)
+				errors++;
+
+			dictionary_acquired_item_release(mt->dict, item);
+		}
+	}
+
+	__atomic_add_fetch(&mt->reads, reads, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&mt->errors, errors, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static void *mt_writer(void *ptr) {
+	struct mt_benchmark *mt = ptr;
+	char buf[100 + 1];
+	struct myvalue value;
+	size_t writes = 0;
+	int base = mt->entries + (gettid() % 1000) * 1000000;
+
+	// writers insert and delete their own entries, so that the readers
+	// always find the entries they search for
+	while(!__atomic_load_n(&mt->stop, __ATOMIC_RELAXED)) {
+		for(int i = 0; i < 1000 ; i++, writes++) {
+			value.i = base + i;
+			snprintf(buf, 100, "%d", base + i);
+			dictionary_set(mt->dict, buf, &value, sizeof(struct myvalue));
+		}
+
+		for(int i = 0; i < 1000 ; i++, writes++) {
+			snprintf(buf, 100, "%d", base + i);
+			dictionary_del(mt->dict, buf);
+		}
+	}
+
+	__atomic_add_fetch(&mt->writes, writes, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static void multi_threaded(DICT_OPTIONS options, const char *index, int entries, int readers, int writers, int seconds) {
+	struct mt_benchmark mt = {
+		.entries = entries,
+	};
+
+	mt.dict = dictionary_create_advanced(options, &stats);
+
+	struct myvalue value;
+	char buf[100 + 1];
+	for(int i = 0; i < entries; i++) {
+		value.i = i;
+		snprintf(buf, 100, "%d", i);
+		dictionary_set(mt.dict, buf, &value, sizeof(struct myvalue));
+	}
+
+	pthread_t threads[readers + writers];
+	usec_t started = now_monotonic_usec();
+
+	for(int t = 0; t < readers + writers ; t++)
+		pthread_create(&threads[t], NULL, (t < readers) ? mt_reader : mt_writer, &mt);
+
+	sleep((unsigned int)seconds);
+	__atomic_store_n(&mt.stop, 1, __ATOMIC_RELAXED);
+
+	for(int t = 0; t < readers + writers ; t++)
+		pthread_join(threads[t], NULL);
+
+	usec_t dt = now_monotonic_usec() - started;
+
+	fprintf(stderr, "%-12s index, %2d readers, %2d writers: %10llu searches/s, %10llu writes/s, %zu errors\n",
+			index, readers, writers,
+			(unsigned long long)(mt.reads * USEC_PER_SEC / dt),
+			(unsigned long long)(mt.writes * USEC_PER_SEC / dt),
+			mt.errors);
+
+	dictionary_destroy(mt.dict);
+}
+
+int main(int argc, char **argv) {
+	int max = 3000000, seconds = 2;
+
+	if(argc > 1) max = str2i(argv[1]);
+	if(argc > 2) seconds = str2i(argv[2]);
+	if(max < 1000) max = 1000;
+	if(seconds < 1) seconds = 1;
+
+	fprintf(stderr, "Single threaded, default index\n\n");
+	single_threaded(DICT_OPTION_NONE, max);
+
+	fprintf(stderr, "Single threaded, partitioned index\n\n");
+	single_threaded(DICT_OPTION_INDEX_PARTITIONED, max);
+
+	int scenarios[][2] = {
+		// readers, writers
+		{ 1, 0 },
+		{ 4, 0 },
+		{ 8, 0 },
+		{ 4, 1 },
+		{ 8, 2 },
+		{ 8, 8 },
+		{ 0, 4 },
+	};
+
+	fprintf(stderr, "Multiple readers and writers on a dictionary of %d entries, %d seconds each\n\n", max / 10, seconds);
+	for(size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]) ; s++) {
+		multi_threaded(DICT_OPTION_NONE, "default", max / 10, scenarios[s][0], scenarios[s][1], seconds);
+		multi_threaded(DICT_OPTION_INDEX_PARTITIONED, "partitioned", max / 10, scenarios[s][0], scenarios[s][1], seconds);
+	}
 
 	return 0;
 }
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ * 1. build netdata (as normally)
+ * 2. cd tests/profile/
+ * 3. compile with:
+ *    make benchmark-statsd-sets
+ *
+ * Usage: benchmark-statsd-sets [hyperloglog precision]
+ *
+ * Compares the two ways statsd sets can count unique values:
+ * a dictionary of all the values (exact), and a HyperLogLog sketch (estimated).
+ * Each value is received twice, as it would happen with a real set.
+ *
+ */
+
+#include "config.h"
+#include "libnetdata/libnetdata.h"
+
+void netdata_cleanup_and_exit(int ret) { exit(ret); }
+
+static struct dictionary_stats stats = {
+	.name = "benchmark",
+};
+
+static unsigned long long rusage_dt(struct rusage *start, struct rusage *end) {
+	unsigned long long dt = (end->ru_utime.tv_sec * 1000000ULL + end->ru_utime.tv_usec) - (start->ru_utime.tv_sec * 1000000ULL + start->ru_utime.tv_usec);
+	return dt ? dt : 1;
+}
+
+static void set_value_insert_callback(const DICTIONARY_ITEM *item, void *value, void *data) {
+	(void)item;
+	(void)value;
+	size_t *unique = data;
+	(*unique)++;
+}
+
+// the same as statsd does with sets, when hyperloglog is not enabled
+static void benchmark_dictionary(size_t distinct) {
+	struct rusage start, end;
+	char buf[100 + 1];
+	size_t unique = 0;
+
+	memset(&stats.memory, 0, sizeof(stats.memory));
+
+	getrusage(RUSAGE_SELF, &start);
+	DICTIONARY *dict = dictionary_create_advanced(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE, &stats);
+	dictionary_register_insert_callback(dict, set_value_insert_callback, &unique);
+	for(size_t r = 0; r < 2 ; r++) {
+		for(size_t i = 0; i < distinct; i++) {
+			snprintfz(buf, 100, "user-%zu", i);
+			dictionary_set(dict, buf, NULL, 0);
+		}
+	}
+	getrusage(RUSAGE_SELF, &end);
+
+	// this does not include the memory of the index itself
+	size_t memory = (size_t)(stats.memory.dict + stats.memory.indexed + stats.memory.values);
+	unsigned long long dt = rusage_dt(&start, &end);
+
+	fprintf(stderr, "%-12s %8zu distinct: %10zu unique (error %6.3f%%), %12zu bytes, %10llu usec, %10llu values/s\n",
+			"dictionary", distinct, unique, 0.0, memory, dt, distinct * 2 * 1000000ULL / dt);
+
+	dictionary_destroy(dict);
+}
+
+static void benchmark_hyperloglog(size_t distinct, uint8_t precision) {
+	struct rusage start, end;
+	char buf[100 + 1];
+	HYPERLOGLOG hll;
+
+	getrusage(RUSAGE_SELF, &start);
+	hyperloglog_init(&hll, precision);
+	for(size_t r = 0; r < 2 ; r++) {
+		for(size_t i = 0; i < distinct; i++) {
+			size_t len = snprintfz(buf, 100, "user-%zu", i);
+			hyperloglog_add(&hll, buf, len);
+		}
+	}
+	size_t unique = (size_t)roundndd(hyperloglog_estimate(&hll));
+	getrusage(RUSAGE_SELF, &end);
+
+	unsigned long long dt = rusage_dt(&start, &end);
+	double error = fabs((double)unique - (double)distinct) * 100.0 / (double)distinct;
+
+	fprintf(stderr, "%-12s %8zu distinct: %10zu unique (error %6.3f%%), %12zu bytes, %10llu usec, %10llu values/s\n",
+			"hyperloglog", distinct, unique, error, hyperloglog_memory(&hll), dt, distinct * 2 * 1000000ULL / dt);
+
+	hyperloglog_free(&hll);
+}
+
+int main(int argc, char **argv) {
+	int precision = HYPERLOGLOG_DEFAULT_PRECISION;
+
+	if(argc > 1) precision = str2i(argv[1]);
+	if(precision < HYPERLOGLOG_MIN_PRECISION) precision = HYPERLOGLOG_MIN_PRECISION;
+	if(precision > HYPERLOGLOG_MAX_PRECISION) precision = HYPERLOGLOG_MAX_PRECISION;
+
+	fprintf(stderr, "HyperLogLog precision %d: %u bytes per set, standard error %0.2f%%\n\n",
+			precision, 1U << precision, (double)hyperloglog_relative_error((uint8_t)precision) * 100.0);
+
+	size_t distinct[] = { 1000, 100000, 1000000 };
+	for(size_t d = 0; d < sizeof(distinct) / sizeof(distinct[0]) ; d++) {
+		benchmark_dictionary(distinct[d]);
+		benchmark_hyperloglog(distinct[d], (uint8_t)precision);
+		fprintf(stderr, "\n");
+	}
+
+	return 0;
+}
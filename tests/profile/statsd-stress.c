@@ -1,4 +1,15 @@
 /* SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ * Usage: statsd-stress THREADS METRICS IP PORT [TYPES]
+ *
+ * TYPES is a comma separated list of statsd metric types to send (default: g,c,m,ms,h,s).
+ *
+ * To measure how netdata scales with its statsd collector threads, run it with
+ * [statsd].collector threads = 1, 2, 4, 8, 16 and compare the netdata.statsd_packets
+ * chart, using at least as many THREADS here, so that packets are spread across all
+ * the SO_REUSEPORT sockets of netdata. Use TYPES g,c,m to measure the thread local
+ * aggregation only.
+ */
 #include <stdlib.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -60,7 +71,8 @@ static void *report_thread(void *__data) {
 	return NULL;
 }
 
-char *types[] = {"g", "c", "m", "ms", "h", "s", NULL};
+char *default_types[] = {"g", "c", "m", "ms", "h", "s", NULL};
+char **types = default_types;
 // char *types[] = {"g", "c", "C", "h", "ms", NULL}; // brubeck compatible
 
 static void *spam_thread(void *__data) {
@@ -104,11 +116,22 @@ static void *spam_thread(void *__data) {
 
 int main(int argc, char *argv[])
 {
-	if (argc != 5) {
-		fprintf(stderr, "Usage: '%s THREADS METRICS IP PORT'\n", argv[0]);
+	if (argc != 5 && argc != 6) {
+		fprintf(stderr, "Usage: '%s THREADS METRICS IP PORT [TYPES]'\n", argv[0]);
 		exit(-1);
 	}
 
+	if (argc == 6) {
+		size_t n = 1;
+		for (char *c = argv[5]; *c; c++)
+			if (*c == ',') n++;
+
+		types = calloc(n + 1, sizeof(char *));
+		n = 0;
+		for (char *t = strtok(argv[5], ","); t; t = strtok(NULL, ","))
+			types[n++] = t;
+	}
+
 	run_threads = atoi(argv[1]);
 	metrics = atoi(argv[2]);
 	char *ip = argv[3];
@@ -59,6 +59,8 @@ void rrdr_show_plan(RRDR *r, BUFFER *wb, const char *kq, const char *sq __maybe_
         }
         buffer_strcat(wb, "\n\t\t\t],");
 
+        buffer_sprintf(wb, "\n\t\t\t%saggregated%s: %s,", kq, kq, qm->plan.aggregated ? "true" : "false");
+
         buffer_sprintf(wb, "\n\t\t\t%stiers%s: [", kq, kq);
         for(size_t tier = 0; tier < storage_tiers ;tier++) {
             if(tier)
@@ -68,7 +70,8 @@ void rrdr_show_plan(RRDR *r, BUFFER *wb, const char *kq, const char *sq __maybe_
             buffer_sprintf(wb, "\n\t\t\t\t\t%stier%s: %zu,", kq, kq, tier);
             buffer_sprintf(wb, "\n\t\t\t\t\t%sdb_first_time%s: %ld,", kq, kq, qm->tiers[tier].db_first_time_s);
             buffer_sprintf(wb, "\n\t\t\t\t\t%sdb_last_time%s: %ld,", kq, kq, qm->tiers[tier].db_last_time_s);
-            buffer_sprintf(wb, "\n\t\t\t\t\t%sweight%s: %ld", kq, kq, qm->tiers[tier].weight);
+            buffer_sprintf(wb, "\n\t\t\t\t\t%sweight%s: %ld,", kq, kq, qm->tiers[tier].weight);
+            buffer_sprintf(wb, "\n\t\t\t\t\t%saligned%s: %s", kq, kq, qm->tiers[tier].aligned ? "true" : "false");
             buffer_strcat(wb, "\n\t\t\t\t}");
         }
         buffer_strcat(wb, "\n\t\t\t]");
@@ -11,6 +11,7 @@ struct grouping_median {
     NETDATA_DOUBLE percent;
 
     NETDATA_DOUBLE *series;
+    QUANTILE_SKETCH *sketch;    // when set, the values are added to it, instead of the series
 };
 
 void grouping_create_median_internal(RRDR *r, const char *options, NETDATA_DOUBLE def) {
@@ -18,17 +19,30 @@ void grouping_create_median_internal(RRDR *r, const char *options, NETDATA_DOUBL
     if(entries < 10) entries = 10;
 
     struct grouping_median *g = (struct grouping_median *)onewayalloc_callocz(r->internal.owa, 1, sizeof(struct grouping_median));
-    g->series = onewayalloc_mallocz(r->internal.owa, entries * sizeof(NETDATA_DOUBLE));
-    g->series_size = (size_t)entries;
 
     g->percent = def;
     if(options && *options) {
-        g->percent = str2ndd(options, NULL);
+        char *end = NULL;
+        g->percent = str2ndd(options, &end);
+
+        // "sketch", optionally after the percentage, approximates the median
+        // of huge groups, without keeping all their values
+        if(strstr(end, "sketch")) {
+            if(end == options) g->percent = def;
+            g->sketch = mallocz(sizeof(QUANTILE_SKETCH));
+            quantile_sketch_init(g->sketch, QUANTILE_SKETCH_DEFAULT_RELATIVE_ERROR, QUANTILE_SKETCH_DEFAULT_MAX_BUCKETS);
+        }
+
         if(!netdata_double_isnumber(g->percent)) g->percent = 0.0;
         if(g->percent < 0.0) g->percent = 0.0;
         if(g->percent > 50.0) g->percent = 50.0;
     }
 
+    if(!g->sketch) {
+        g->series = onewayalloc_mallocz(r->internal.owa, entries * sizeof(NETDATA_DOUBLE));
+        g->series_size = (size_t)entries;
+    }
+
     g->percent = g->percent / 100.0;
     r->internal.grouping_data = g;
 }
@@ -66,11 +80,21 @@ void grouping_create_trimmed_median25(RRDR *r, const char *options) {
 void grouping_reset_median(RRDR *r) {
     struct grouping_median *g = (struct grouping_median *)r->internal.grouping_data;
     g->next_pos = 0;
+
+    if(g->sketch)
+        quantile_sketch_reset(g->sketch);
 }
 
 void grouping_free_median(RRDR *r) {
     struct grouping_median *g = (struct grouping_median *)r->internal.grouping_data;
-    if(g) onewayalloc_freez(r->internal.owa, g->series);
+    if(g) {
+        onewayalloc_freez(r->internal.owa, g->series);
+
+        if(g->sketch) {
+            quantile_sketch_free(g->sketch);
+            freez(g->sketch);
+        }
+    }
 
     onewayalloc_freez(r->internal.owa, r->internal.grouping_data);
     r->internal.grouping_data = NULL;
@@ -79,6 +103,11 @@ void grouping_free_median(RRDR *r) {
 void grouping_add_median(RRDR *r, NETDATA_DOUBLE value) {
     struct grouping_median *g = (struct grouping_median *)r->internal.grouping_data;
 
+    if(unlikely(g->sketch)) {
+        quantile_sketch_add(g->sketch, value, 1);
+        return;
+    }
+
     if(unlikely(g->next_pos >= g->series_size)) {
         g->series = onewayalloc_doublesize( r->internal.owa, g->series, g->series_size * sizeof(NETDATA_DOUBLE));
         g->series_size *= 2;
@@ -87,44 +116,96 @@ void grouping_add_median(RRDR *r, NETDATA_DOUBLE value) {
     g->series[g->next_pos++] = value;
 }
 
+static NETDATA_DOUBLE grouping_flush_median_sketch(struct grouping_median *g) {
+    QUANTILE_SKETCH *qs = g->sketch;
+    NETDATA_DOUBLE quantile = 0.5;
+
+    if(g->percent > 0.0) {
+        NETDATA_DOUBLE delta = (qs->max - qs->min) * g->percent;
+
+        // the middle of the ranks of the values between wanted_min and wanted_max
+        NETDATA_DOUBLE low = quantile_sketch_rank(qs, qs->min + delta);
+        NETDATA_DOUBLE high = quantile_sketch_rank(qs, qs->max - delta);
+        quantile = (low + high) / 2.0;
+    }
+
+    NETDATA_DOUBLE value = quantile_sketch_quantile(qs, quantile);
+
+    quantile_sketch_reset(qs);
+    return value;
+}
+
 NETDATA_DOUBLE grouping_flush_median(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct grouping_median *g = (struct grouping_median *)r->internal.grouping_data;
 
-    size_t available_slots = g->next_pos;
+    size_t available_slots = g->sketch ? (size_t)g->sketch->count : g->next_pos;
     NETDATA_DOUBLE value;
 
     if(unlikely(!available_slots)) {
         value = 0.0;
         *rrdr_value_options_ptr |= RRDR_VALUE_EMPTY;
     }
+    else if(g->sketch) {
+        value = grouping_flush_median_sketch(g);
+    }
     else if(available_slots == 1) {
         value = g->series[0];
     }
     else {
-        sort_series(g->series, available_slots);
-
+        // the slots the values would have, if the series was sorted
         size_t start_slot = 0;
         size_t end_slot = available_slots - 1;
 
         if(g->percent > 0.0) {
             NETDATA_DOUBLE min = g->series[0];
-            NETDATA_DOUBLE max = g->series[available_slots - 1];
+            NETDATA_DOUBLE max = g->series[0];
+            for(size_t i = 1; i < available_slots ; i++) {
+                if(g->series[i] < min) min = g->series[i];
+                if(g->series[i] > max) max = g->series[i];
+            }
+
             NETDATA_DOUBLE delta = (max - min) * g->percent;
 
             NETDATA_DOUBLE wanted_min = min + delta;
             NETDATA_DOUBLE wanted_max = max - delta;
 
-            for (start_slot = 0; start_slot < available_slots; start_slot++)
-                if (g->series[start_slot] >= wanted_min) break;
+            // the first slot >= wanted_min is after all the smaller values,
+            // the last slot <= wanted_max is before all the bigger values
+            size_t below_min = 0, up_to_max = 0;
+            for(size_t i = 0; i < available_slots ; i++) {
+                if(g->series[i] < wanted_min) below_min++;
+                if(g->series[i] <= wanted_max) up_to_max++;
+            }
 
-            for (end_slot = available_slots - 1; end_slot > start_slot; end_slot--)
-                if (g->series[end_slot] <= wanted_max) break;
+            start_slot = below_min;
+            end_slot = (up_to_max > start_slot + 1) ? up_to_max - 1 : start_slot;
         }
 
-        if(start_slot == end_slot)
-            value = g->series[start_slot];
-        else
-            value = median_on_sorted_series(&g->series[start_slot], end_slot - start_slot + 1);
+        if(unlikely(start_slot >= available_slots))
+            value = NAN;
+        else {
+            // select only the slots median_on_sorted_series() reads
+            size_t entries = end_slot - start_slot + 1;
+            size_t ranks[2], ranks_count = 0;
+
+            if(entries <= 2) {
+                ranks[ranks_count++] = start_slot;
+                ranks[ranks_count++] = end_slot;
+            }
+            else if(entries % 2 == 0) {
+                ranks[ranks_count++] = start_slot + entries / 2;
+                ranks[ranks_count++] = start_slot + entries / 2 + 1;
+            }
+            else
+                ranks[ranks_count++] = start_slot + entries / 2;
+
+            select_series(g->series, available_slots, ranks, ranks_count);
+
+            if(start_slot == end_slot)
+                value = g->series[start_slot];
+            else
+                value = median_on_sorted_series(&g->series[start_slot], entries);
+        }
     }
 
     if(unlikely(!netdata_double_isnumber(value))) {
@@ -11,6 +11,7 @@ struct grouping_percentile {
     NETDATA_DOUBLE percent;
 
     NETDATA_DOUBLE *series;
+    QUANTILE_SKETCH *sketch;    // when set, the values are added to it, instead of the series
 };
 
 static void grouping_create_percentile_internal(RRDR *r, const char *options, NETDATA_DOUBLE def) {
@@ -18,17 +19,30 @@ static void grouping_create_percentile_internal(RRDR *r, const char *options, NE
     if(entries < 10) entries = 10;
 
     struct grouping_percentile *g = (struct grouping_percentile *)onewayalloc_callocz(r->internal.owa, 1, sizeof(struct grouping_percentile));
-    g->series = onewayalloc_mallocz(r->internal.owa, entries * sizeof(NETDATA_DOUBLE));
-    g->series_size = (size_t)entries;
 
     g->percent = def;
     if(options && *options) {
-        g->percent = str2ndd(options, NULL);
+        char *end = NULL;
+        g->percent = str2ndd(options, &end);
+
+        // "sketch", optionally after the percentage, approximates the percentile
+        // of huge groups, without keeping all their values
+        if(strstr(end, "sketch")) {
+            if(end == options) g->percent = def;
+            g->sketch = mallocz(sizeof(QUANTILE_SKETCH));
+            quantile_sketch_init(g->sketch, QUANTILE_SKETCH_DEFAULT_RELATIVE_ERROR, QUANTILE_SKETCH_DEFAULT_MAX_BUCKETS);
+        }
+
         if(!netdata_double_isnumber(g->percent)) g->percent = 0.0;
         if(g->percent < 0.0) g->percent = 0.0;
         if(g->percent > 100.0) g->percent = 100.0;
     }
 
+    if(!g->sketch) {
+        g->series = onewayalloc_mallocz(r->internal.owa, entries * sizeof(NETDATA_DOUBLE));
+        g->series_size = (size_t)entries;
+    }
+
     g->percent = g->percent / 100.0;
     r->internal.grouping_data = g;
 }
@@ -66,11 +80,21 @@ void grouping_create_percentile99(RRDR *r, const char *options) {
 void grouping_reset_percentile(RRDR *r) {
     struct grouping_percentile *g = (struct grouping_percentile *)r->internal.grouping_data;
     g->next_pos = 0;
+
+    if(g->sketch)
+        quantile_sketch_reset(g->sketch);
 }
 
 void grouping_free_percentile(RRDR *r) {
     struct grouping_percentile *g = (struct grouping_percentile *)r->internal.grouping_data;
-    if(g) onewayalloc_freez(r->internal.owa, g->series);
+    if(g) {
+        onewayalloc_freez(r->internal.owa, g->series);
+
+        if(g->sketch) {
+            quantile_sketch_free(g->sketch);
+            freez(g->sketch);
+        }
+    }
 
     onewayalloc_freez(r->internal.owa, r->internal.grouping_data);
     r->internal.grouping_data = NULL;
@@ -79,6 +103,11 @@ void grouping_free_percentile(RRDR *r) {
 void grouping_add_percentile(RRDR *r, NETDATA_DOUBLE value) {
     struct grouping_percentile *g = (struct grouping_percentile *)r->internal.grouping_data;
 
+    if(unlikely(g->sketch)) {
+        quantile_sketch_add(g->sketch, value, 1);
+        return;
+    }
+
     if(unlikely(g->next_pos >= g->series_size)) {
         g->series = onewayalloc_doublesize( r->internal.owa, g->series, g->series_size * sizeof(NETDATA_DOUBLE));
         g->series_size *= 2;
@@ -87,24 +116,44 @@ void grouping_add_percentile(RRDR *r, NETDATA_DOUBLE value) {
     g->series[g->next_pos++] = value;
 }
 
+static NETDATA_DOUBLE grouping_flush_percentile_sketch(struct grouping_percentile *g) {
+    QUANTILE_SKETCH *qs = g->sketch;
+    NETDATA_DOUBLE value;
+
+    if(qs->min == qs->max)
+        value = qs->min;
+    else if(qs->min >= 0.0)
+        value = quantile_sketch_mean_between(qs, 0.0, g->percent);
+    else
+        value = quantile_sketch_mean_between(qs, 1.0 - g->percent, 1.0);
+
+    quantile_sketch_reset(qs);
+    return value;
+}
+
 NETDATA_DOUBLE grouping_flush_percentile(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct grouping_percentile *g = (struct grouping_percentile *)r->internal.grouping_data;
 
     NETDATA_DOUBLE value;
-    size_t available_slots = g->next_pos;
+    size_t available_slots = g->sketch ? (size_t)g->sketch->count : g->next_pos;
 
     if(unlikely(!available_slots)) {
         value = 0.0;
         *rrdr_value_options_ptr |= RRDR_VALUE_EMPTY;
     }
+    else if(g->sketch) {
+        value = grouping_flush_percentile_sketch(g);
+    }
     else if(available_slots == 1) {
         value = g->series[0];
     }
     else {
-        sort_series(g->series, available_slots);
-
         NETDATA_DOUBLE min = g->series[0];
-        NETDATA_DOUBLE max = g->series[available_slots - 1];
+        NETDATA_DOUBLE max = g->series[0];
+        for(size_t i = 1; i < available_slots ; i++) {
+            if(g->series[i] < min) min = g->series[i];
+            if(g->series[i] > max) max = g->series[i];
+        }
 
         if (min != max) {
             size_t slots_to_use = (size_t)((NETDATA_DOUBLE)available_slots * g->percent);
@@ -139,6 +188,20 @@ NETDATA_DOUBLE grouping_flush_percentile(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_o
                 step = -1;
             }
 
+            // instead of sorting the series, select the last and the interpolation slots,
+            // which also moves all the slots we sum to the same side of them
+            size_t ranks[2], ranks_count = 0;
+            if(step > 0) {
+                ranks[ranks_count++] = (size_t)last_slot;
+                ranks[ranks_count++] = (size_t)interpolation_slot;
+            }
+            else {
+                if(interpolation_slot >= 0)
+                    ranks[ranks_count++] = (size_t)interpolation_slot;
+                ranks[ranks_count++] = (size_t)last_slot;
+            }
+            select_series(g->series, available_slots, ranks, ranks_count);
+
             value = 0.0;
             for(int slot = start_slot; slot != stop_slot ; slot += step)
                 value += g->series[slot];
@@ -1060,8 +1060,59 @@ static int compare_query_plan_entries_on_start_time(const void *a, const void *b
     return (p1->after < p2->after)?-1:1;
 }
 
-static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before_wanted, size_t points_wanted) {
+// the grouping methods that give the same result, when they are given the
+// min, max, sum or average of many points, instead of the points themselves
+static bool query_grouping_is_aggregatable(RRDR_GROUPING group_method) {
+    switch(group_method) {
+        case RRDR_GROUPING_AVERAGE:
+        case RRDR_GROUPING_MIN:
+        case RRDR_GROUPING_MAX:
+        case RRDR_GROUPING_SUM:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Find the highest tier whose points end exactly at the end of the groups of the query,
+// so that every group is made of whole tier points. For aggregatable grouping methods,
+// reading this tier gives the same groups as reading any lower tier, with fewer points.
+// The tier should not start later than the selected one, since only higher tiers can
+// fill the beginning of a query, while lower tiers can always fill the end of it.
+static size_t query_plan_aggregated_tier(QUERY_ENGINE_OPS *ops, size_t selected_tier, time_t after_wanted, time_t before_wanted) {
     QUERY_METRIC *qm = ops->qm;
+    time_t first_group_end_time = after_wanted + ops->view_update_every - ops->query_granularity;
+    size_t aggregated_tier = selected_tier;
+
+    for(size_t tier = 0; tier < storage_tiers ; tier++) {
+        time_t update_every_s = qm->tiers[tier].db_update_every_s;
+
+        qm->tiers[tier].aligned = query_metric_is_valid_tier(qm, tier) &&
+                                  ops->view_update_every % update_every_s == 0 &&
+                                  first_group_end_time % update_every_s == 0;
+
+        if(!qm->tiers[tier].aligned || tier <= selected_tier)
+            continue;
+
+        if(qm->tiers[tier].db_last_time_s < after_wanted || qm->tiers[tier].db_first_time_s > before_wanted)
+            continue;
+
+        if(qm->tiers[tier].db_first_time_s > MAX(after_wanted, qm->tiers[selected_tier].db_first_time_s))
+            continue;
+
+        aggregated_tier = tier;
+    }
+
+    return aggregated_tier;
+}
+
+static bool query_plan_tiers(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before_wanted, size_t points_wanted) {
+    QUERY_METRIC *qm = ops->qm;
+
+    qm->plan.aggregated = false;
+    for(size_t tier = 0; tier < storage_tiers ; tier++)
+        qm->tiers[tier].aligned = false;
 
     // put our selected tier as the first plan
     size_t selected_tier;
@@ -1083,6 +1134,15 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
         if(qm->tiers[selected_tier].db_first_time_s > before_wanted ||
            qm->tiers[selected_tier].db_last_time_s < after_wanted)
             return false;
+
+        // prefer a higher tier, when its points can be used as whole groups
+        if(query_grouping_is_aggregatable(ops->r->internal.qt->window.group_method)) {
+            size_t aggregated_tier = query_plan_aggregated_tier(ops, selected_tier, after_wanted, before_wanted);
+            if(aggregated_tier != selected_tier) {
+                selected_tier = aggregated_tier;
+                qm->plan.aggregated = true;
+            }
+        }
     }
 
     qm->plan.used = 1;
@@ -1090,13 +1150,27 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
     qm->plan.array[0].after = (qm->tiers[selected_tier].db_first_time_s < after_wanted) ? after_wanted : qm->tiers[selected_tier].db_first_time_s;
     qm->plan.array[0].before = (qm->tiers[selected_tier].db_last_time_s > before_wanted) ? before_wanted : qm->tiers[selected_tier].db_last_time_s;
 
+    // the time our selected tier has to start, to cover the beginning of the query
+    time_t selected_tier_wanted_first_time_s = after_wanted;
+
+    // the storage engine gives points relative to the time the query starts,
+    // so start the aggregated tier at the end of its first point in the query
+    if(qm->plan.aggregated) {
+        time_t first_group_end_time = after_wanted + ops->view_update_every - ops->query_granularity;
+        if(qm->plan.array[0].after < first_group_end_time && first_group_end_time <= qm->plan.array[0].before)
+            qm->plan.array[0].after = first_group_end_time;
+
+        // its first point covers the whole first group
+        selected_tier_wanted_first_time_s = first_group_end_time;
+    }
+
     if(!(ops->r->internal.query_options & RRDR_OPTION_SELECTED_TIER)) {
         // the selected tier
         time_t selected_tier_first_time_s = qm->plan.array[0].after;
         time_t selected_tier_last_time_s = qm->plan.array[0].before;
 
         // check if our selected tier can start the query
-        if (selected_tier_first_time_s > after_wanted) {
+        if (selected_tier_first_time_s > selected_tier_wanted_first_time_s) {
             // we need some help from other tiers
             for (size_t tr = (int)selected_tier + 1; tr < storage_tiers; tr++) {
                 if(!query_metric_is_valid_tier(qm, tr))
@@ -1179,6 +1253,13 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
     }
 #endif
 
+    return true;
+}
+
+static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before_wanted, size_t points_wanted) {
+    if(!query_plan_tiers(ops, after_wanted, before_wanted, points_wanted))
+        return false;
+
     query_planer_initialize_plans(ops);
     query_planer_activate_plan(ops, 0, 0);
 
@@ -1243,6 +1324,49 @@ static QUERY_ENGINE_OPS *rrd2rrdr_query_prep(RRDR *r, size_t dim_id_in_rrdr) {
     return ops;
 }
 
+// ----------------------------------------------------------------------------
+// query interruption
+
+// how often to call the interrupt callback of a query
+#define QUERY_INTERRUPT_CALLBACK_EVERY_UT (10 * USEC_PER_MS)
+
+// how many db points to read between checks, while querying a dimension
+#define QUERY_INTERRUPT_CHECK_EVERY_POINTS 1024
+
+// Check if the query should stop, because it exceeded its timeout, or because its
+// interrupt callback says so (e.g. the client went away). Once it is interrupted,
+// the query is marked as cancelled and this keeps returning true.
+static bool rrd2rrdr_query_interrupted(RRDR *r) {
+    if(unlikely(r->result_options & RRDR_RESULT_OPTION_CANCEL))
+        return true;
+
+    QUERY_TARGET *qt = r->internal.qt;
+    if(likely(!qt->request.timeout && !qt->request.interrupt_callback))
+        return false;
+
+    usec_t now_ut = now_monotonic_usec();
+    usec_t runtime_ut = now_ut - r->internal.started_ut;
+
+    if(qt->request.timeout && runtime_ut > (usec_t)qt->request.timeout * USEC_PER_MS) {
+        log_access("QUERY CANCELED RUNTIME EXCEEDED %0.2f ms (LIMIT %lld ms)",
+                   (NETDATA_DOUBLE)runtime_ut / USEC_PER_MS, (long long)qt->request.timeout);
+        r->internal.timed_out = true;
+    }
+    else if(qt->request.interrupt_callback && now_ut >= r->internal.next_interrupt_check_ut) {
+        r->internal.next_interrupt_check_ut = now_ut + QUERY_INTERRUPT_CALLBACK_EVERY_UT;
+
+        if(!qt->request.interrupt_callback(qt->request.interrupt_callback_data))
+            return false;
+
+        log_access("QUERY INTERRUPTED AFTER %0.2f ms", (NETDATA_DOUBLE)runtime_ut / USEC_PER_MS);
+    }
+    else
+        return false;
+
+    r->result_options |= RRDR_RESULT_OPTION_CANCEL;
+    return true;
+}
+
 static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_OPS *ops) {
     QUERY_TARGET *qt = r->internal.qt;
     QUERY_METRIC *qm = &qt->query.array[dim_id_in_rrdr]; (void)qm;
@@ -1272,6 +1396,7 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
     time_t now_end_time   = after_wanted + ops->view_update_every - ops->query_granularity;
 
     size_t db_points_read_since_plan_switch = 0; (void)db_points_read_since_plan_switch;
+    size_t next_interrupt_check_points = QUERY_INTERRUPT_CHECK_EVERY_POINTS;
 
     // The main loop, based on the query granularity we need
     for( ; points_added < points_wanted ; now_start_time = now_end_time, now_end_time += ops->view_update_every) {
@@ -1312,6 +1437,14 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
                 ops->db_points_read_per_tier[ops->tier]++;
                 ops->db_total_points_read++;
 
+                if(unlikely(ops->db_total_points_read >= next_interrupt_check_points)) {
+                    next_interrupt_check_points = ops->db_total_points_read + QUERY_INTERRUPT_CHECK_EVERY_POINTS;
+
+                    // stop reading, the storage engine will drop the work queued for us
+                    if(rrd2rrdr_query_interrupted(r))
+                        break;
+                }
+
                 new_point.start_time = sp.start_time_s;
                 new_point.end_time   = sp.end_time_s;
                 new_point.anomaly    = sp.count ? (NETDATA_DOUBLE)sp.anomaly_count * 100.0 / (NETDATA_DOUBLE)sp.count : 0.0;
@@ -1408,6 +1541,9 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
             }
         }
 
+        if(unlikely(r->result_options & RRDR_RESULT_OPTION_CANCEL))
+            break;
+
         if(unlikely(count_same_end_time)) {
             internal_error(true,
                            "QUERY: '%s', dimension '%s', the database does not advance the query, it returned an end time less or equal to the end time of the last point we got %ld, %zu times",
@@ -2123,10 +2259,7 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
     size_t max_rows = 0;
 
     long dimensions_used = 0, dimensions_nonzero = 0;
-    struct timeval query_start_time;
-    struct timeval query_current_time;
-    if (qt->request.timeout)
-        now_realtime_timeval(&query_start_time);
+    r->internal.started_ut = now_monotonic_usec();
 
     size_t last_db_points_read = 0;
     size_t last_result_points_generated = 0;
@@ -2170,9 +2303,6 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
         last_db_points_read = r->internal.db_points_read;
         last_result_points_generated = r->internal.result_points_generated;
 
-        if (qt->request.timeout)
-            now_realtime_timeval(&query_current_time);
-
         if(r->od[c] & RRDR_DIMENSION_NONZERO)
             dimensions_nonzero++;
 
@@ -2206,11 +2336,8 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
         }
 
         dimensions_used++;
-        if (qt->request.timeout && ((NETDATA_DOUBLE)dt_usec(&query_start_time, &query_current_time) / 1000.0) > (NETDATA_DOUBLE)qt->request.timeout) {
-            log_access("QUERY CANCELED RUNTIME EXCEEDED %0.2f ms (LIMIT %lld ms)",
-                       (NETDATA_DOUBLE)dt_usec(&query_start_time, &query_current_time) / 1000.0, (long long)qt->request.timeout);
-            r->result_options |= RRDR_RESULT_OPTION_CANCEL;
-
+        if (rrd2rrdr_query_interrupted(r)) {
+            // finalizing the prepared queries makes the storage engine drop their pending work
             for(size_t i = c + 1; i < queries_prepared ; i++) {
                 if(ops[i])
                     query_planer_finalize_remaining_plans(ops[i]);
@@ -2266,6 +2393,9 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
     }
 #endif
 
+    if(unlikely(r->result_options & RRDR_RESULT_OPTION_CANCEL))
+        global_statistics_rrdr_query_cancelled(r->internal.timed_out, r->internal.db_points_read);
+
     // free all resources used by the grouping method
     r->internal.grouping_free(r);
 
@@ -2281,3 +2411,403 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
 
     return r;
 }
+
+// ----------------------------------------------------------------------------
+// unittest of the grouping methods that need the order of their values
+
+// the values of these methods, the way they are calculated on a sorted series
+
+static NETDATA_DOUBLE grouping_unittest_sorted_mean(const NETDATA_DOUBLE *series, size_t entries, NETDATA_DOUBLE percent, bool trimmed) {
+    NETDATA_DOUBLE min = series[0];
+    NETDATA_DOUBLE max = series[entries - 1];
+    if(entries == 1 || min == max)
+        return min;
+
+    size_t slots_to_use = (size_t)((NETDATA_DOUBLE)entries * percent);
+    if(!slots_to_use) slots_to_use = 1;
+
+    NETDATA_DOUBLE percent_to_use = (NETDATA_DOUBLE)slots_to_use / (NETDATA_DOUBLE)entries;
+    NETDATA_DOUBLE percent_delta = percent - percent_to_use;
+
+    NETDATA_DOUBLE percent_interpolation_slot = 0.0;
+    NETDATA_DOUBLE percent_last_slot = 0.0;
+    if(percent_delta > 0.0) {
+        NETDATA_DOUBLE percent_1slot = (NETDATA_DOUBLE)(slots_to_use + 1) / (NETDATA_DOUBLE)entries - percent_to_use;
+        percent_interpolation_slot = percent_delta / percent_1slot;
+        percent_last_slot = 1 - percent_interpolation_slot;
+    }
+
+    int offset = trimmed ? (int)((entries - slots_to_use) / 2) : 0;
+    int start_slot, stop_slot, step, last_slot, interpolation_slot;
+    if(min >= 0.0) {
+        start_slot = offset;
+        stop_slot = start_slot + (int)slots_to_use;
+        last_slot = stop_slot - 1;
+        step = 1;
+    }
+    else {
+        start_slot = (int)entries - 1 - offset;
+        stop_slot = start_slot - (int)slots_to_use;
+        last_slot = stop_slot + 1;
+        step = -1;
+    }
+    interpolation_slot = stop_slot;
+
+    NETDATA_DOUBLE value = 0.0;
+    for(int slot = start_slot; slot != stop_slot ; slot += step)
+        value += series[slot];
+
+    size_t counted = slots_to_use;
+    if(percent_interpolation_slot > 0.0 && interpolation_slot >= 0 && interpolation_slot < (int)entries) {
+        value += series[interpolation_slot] * percent_interpolation_slot;
+        value += series[last_slot] * percent_last_slot;
+        counted++;
+    }
+
+    return value / (NETDATA_DOUBLE)counted;
+}
+
+static NETDATA_DOUBLE grouping_unittest_sorted_median(const NETDATA_DOUBLE *series, size_t entries, NETDATA_DOUBLE percent) {
+    if(entries == 1)
+        return series[0];
+
+    size_t start_slot = 0;
+    size_t end_slot = entries - 1;
+
+    if(percent > 0.0) {
+        NETDATA_DOUBLE delta = (series[entries - 1] - series[0]) * percent;
+        NETDATA_DOUBLE wanted_min = series[0] + delta;
+        NETDATA_DOUBLE wanted_max = series[entries - 1] - delta;
+
+        for (start_slot = 0; start_slot < entries; start_slot++)
+            if (series[start_slot] >= wanted_min) break;
+
+        for (end_slot = entries - 1; end_slot > start_slot; end_slot--)
+            if (series[end_slot] <= wanted_max) break;
+    }
+
+    if(start_slot == end_slot)
+        return series[start_slot];
+
+    return median_on_sorted_series(&series[start_slot], end_slot - start_slot + 1);
+}
+
+typedef enum {
+    GROUPING_UNITTEST_PERCENTILE,
+    GROUPING_UNITTEST_TRIMMED_MEAN,
+    GROUPING_UNITTEST_MEDIAN,
+} GROUPING_UNITTEST_KIND;
+
+static struct {
+    const char *name;
+    RRDR_GROUPING group;
+    GROUPING_UNITTEST_KIND kind;
+    NETDATA_DOUBLE percent;         // as the grouping method uses it
+} grouping_unittest_methods[] = {
+    { "percentile95",       RRDR_GROUPING_PERCENTILE95,     GROUPING_UNITTEST_PERCENTILE,   0.95 },
+    { "percentile25",       RRDR_GROUPING_PERCENTILE25,     GROUPING_UNITTEST_PERCENTILE,   0.25 },
+    { "trimmed-mean5",      RRDR_GROUPING_TRIMMED_MEAN5,    GROUPING_UNITTEST_TRIMMED_MEAN, 0.90 },
+    { "trimmed-mean25",     RRDR_GROUPING_TRIMMED_MEAN25,   GROUPING_UNITTEST_TRIMMED_MEAN, 0.50 },
+    { "median",             RRDR_GROUPING_MEDIAN,           GROUPING_UNITTEST_MEDIAN,       0.00 },
+    { "trimmed-median5",    RRDR_GROUPING_TRIMMED_MEDIAN5,  GROUPING_UNITTEST_MEDIAN,       0.05 },
+    { "trimmed-median25",   RRDR_GROUPING_TRIMMED_MEDIAN25, GROUPING_UNITTEST_MEDIAN,       0.25 },
+};
+
+static NETDATA_DOUBLE grouping_unittest_sorted(size_t method, const NETDATA_DOUBLE *sorted, size_t entries) {
+    NETDATA_DOUBLE percent = grouping_unittest_methods[method].percent;
+
+    switch(grouping_unittest_methods[method].kind) {
+        case GROUPING_UNITTEST_PERCENTILE:
+            return grouping_unittest_sorted_mean(sorted, entries, percent, false);
+
+        case GROUPING_UNITTEST_TRIMMED_MEAN:
+            return grouping_unittest_sorted_mean(sorted, entries, percent, true);
+
+        default:
+            return grouping_unittest_sorted_median(sorted, entries, percent);
+    }
+}
+
+static const char *grouping_unittest_distributions[] = {
+    "positive", "mixed", "negative", "duplicates", "ascending", "descending", "sawtooth", "constant",
+};
+
+static void grouping_unittest_fill(NETDATA_DOUBLE *series, size_t entries, size_t distribution, unsigned int *seed) {
+    for(size_t i = 0; i < entries ; i++) {
+        NETDATA_DOUBLE random = (NETDATA_DOUBLE)rand_r(seed) / RAND_MAX;
+
+        switch(distribution) {
+            case 0: series[i] = random * 1000.0; break;
+            case 1: series[i] = random * 1000.0 - 500.0; break;
+            case 2: series[i] = -random * 1000.0; break;
+            case 3: series[i] = (NETDATA_DOUBLE)(rand_r(seed) % 10); break;
+            case 4: series[i] = (NETDATA_DOUBLE)i; break;
+            case 5: series[i] = (NETDATA_DOUBLE)(entries - i); break;
+            case 6: series[i] = (NETDATA_DOUBLE)(i % 37); break;
+            default: series[i] = 42.0; break;
+        }
+    }
+}
+
+// runs a grouping method on groups of entries values, like a query would do
+static NETDATA_DOUBLE grouping_unittest_run(size_t method, const char *options, const NETDATA_DOUBLE *series, size_t entries, size_t groups) {
+    RRDR r = { 0 };
+    r.group = entries;
+    r.internal.owa = onewayalloc_create(0);
+    rrdr_set_grouping_function(&r, grouping_unittest_methods[method].group);
+    r.internal.grouping_create(&r, options);
+
+    NETDATA_DOUBLE value = 0.0;
+    for(size_t g = 0; g < groups ; g++) {
+        for(size_t i = 0; i < entries ; i++)
+            r.internal.grouping_add(&r, series[i]);
+
+        RRDR_VALUE_FLAGS flags = RRDR_VALUE_NOTHING;
+        value = r.internal.grouping_flush(&r, &flags);
+    }
+
+    r.internal.grouping_free(&r);
+    onewayalloc_destroy(r.internal.owa);
+    return value;
+}
+
+static bool grouping_unittest_equal(NETDATA_DOUBLE found, NETDATA_DOUBLE expected, NETDATA_DOUBLE relative_error) {
+    NETDATA_DOUBLE tolerance = fabsndd(expected) * relative_error;
+    if(tolerance < relative_error) tolerance = relative_error;
+
+    return !isgreater(fabsndd(found - expected), tolerance);
+}
+
+static size_t grouping_unittest_check(size_t method, const NETDATA_DOUBLE *series, NETDATA_DOUBLE *sorted, size_t entries, size_t distribution) {
+    size_t errors = 0;
+
+    memcpy(sorted, series, entries * sizeof(NETDATA_DOUBLE));
+    sort_series(sorted, entries);
+    NETDATA_DOUBLE expected = grouping_unittest_sorted(method, sorted, entries);
+
+    // the selection kernels add the same values, in a different order
+    NETDATA_DOUBLE found = grouping_unittest_run(method, NULL, series, entries, 1);
+    if(!grouping_unittest_equal(found, expected, 1e-9)) {
+        fprintf(stderr, "GROUPING: %s of %zu %s values: expected " NETDATA_DOUBLE_FORMAT ", found " NETDATA_DOUBLE_FORMAT "\n",
+                grouping_unittest_methods[method].name, entries, grouping_unittest_distributions[distribution], expected, found);
+        errors++;
+    }
+
+    // the sketch is within its relative error, when the group is big enough for the
+    // quantiles of the sketch to be the ones of the sorted series
+    if(entries >= 1000 && distribution == 0) {
+        found = grouping_unittest_run(method, "sketch", series, entries, 1);
+        if(!grouping_unittest_equal(found, expected, 0.02)) {
+            fprintf(stderr, "GROUPING: %s sketch of %zu %s values: expected " NETDATA_DOUBLE_FORMAT ", found " NETDATA_DOUBLE_FORMAT "\n",
+                    grouping_unittest_methods[method].name, entries, grouping_unittest_distributions[distribution], expected, found);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+static void grouping_unittest_benchmark(size_t method, const NETDATA_DOUBLE *series, NETDATA_DOUBLE *sorted, size_t entries) {
+    // about the same number of points for all group sizes
+    size_t groups = 1000000 / entries;
+    if(!groups) groups = 1;
+
+    usec_t started_ut = now_monotonic_usec();
+    for(size_t g = 0; g < groups ; g++) {
+        memcpy(sorted, series, entries * sizeof(NETDATA_DOUBLE));
+        sort_series(sorted, entries);
+        grouping_unittest_sorted(method, sorted, entries);
+    }
+    usec_t sort_ut = now_monotonic_usec() - started_ut;
+
+    started_ut = now_monotonic_usec();
+    grouping_unittest_run(method, NULL, series, entries, groups);
+    usec_t select_ut = now_monotonic_usec() - started_ut;
+
+    started_ut = now_monotonic_usec();
+    grouping_unittest_run(method, "sketch", series, entries, groups);
+    usec_t sketch_ut = now_monotonic_usec() - started_ut;
+
+    NETDATA_DOUBLE points = (NETDATA_DOUBLE)(groups * entries);
+    fprintf(stderr, "%-18s %8zu values per group: sort %7.2f ns, select %7.2f ns, sketch %7.2f ns per value\n",
+            grouping_unittest_methods[method].name, entries,
+            (double)(sort_ut * 1000 / points), (double)(select_ut * 1000 / points), (double)(sketch_ut * 1000 / points));
+}
+
+int grouping_unittest(bool benchmark) {
+    const size_t sizes[] = { 1, 2, 3, 4, 5, 10, 17, 100, 601, 1000, 10000, 100000 };
+    const size_t max_entries = 100000;
+    size_t errors = 0;
+
+    fprintf(stderr, "\nTesting the percentile, trimmed mean and median grouping methods...\n");
+
+    NETDATA_DOUBLE *series = mallocz(max_entries * sizeof(NETDATA_DOUBLE));
+    NETDATA_DOUBLE *sorted = mallocz(max_entries * sizeof(NETDATA_DOUBLE));
+    unsigned int seed = 1;
+
+    for(size_t m = 0; m < sizeof(grouping_unittest_methods) / sizeof(grouping_unittest_methods[0]) ; m++) {
+        for(size_t d = 0; d < sizeof(grouping_unittest_distributions) / sizeof(grouping_unittest_distributions[0]) ; d++) {
+            for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) ; s++) {
+                grouping_unittest_fill(series, sizes[s], d, &seed);
+                errors += grouping_unittest_check(m, series, sorted, sizes[s], d);
+            }
+        }
+    }
+
+    if(benchmark) {
+        fprintf(stderr, "\nBenchmarking the grouping methods with random values...\n");
+
+        for(size_t m = 0; m < sizeof(grouping_unittest_methods) / sizeof(grouping_unittest_methods[0]) ; m++) {
+            for(size_t entries = 10; entries <= max_entries ; entries *= 10) {
+                grouping_unittest_fill(series, entries, 0, &seed);
+                grouping_unittest_benchmark(m, series, sorted, entries);
+            }
+        }
+    }
+
+    freez(series);
+    freez(sorted);
+
+    fprintf(stderr, "grouping methods: %zu errors\n", errors);
+    return errors ? 1 : 0;
+}
+
+// ----------------------------------------------------------------------------
+// unittest of the query planer
+
+#define QUERY_PLAN_UNITTEST_TIERS 4
+
+static size_t query_plan_unittest_check(const char *name, RRDR_GROUPING group_method, time_t after_wanted, time_t before_wanted, size_t points_wanted,
+                                        bool aggregated, const bool *aligned, const QUERY_PLAN_ENTRY *expected, size_t expected_entries) {
+    // the time the tiers end, aligned to their hourly tier
+    const time_t now_s = 3600 * 472222;
+
+    // a tier every minute, a tier every hour and a daily tier that never fits hourly groups
+    static const struct {
+        time_t update_every_s;
+        time_t duration_s;
+        time_t lag_s;
+    } tiers[QUERY_PLAN_UNITTEST_TIERS] = {
+        { .update_every_s = 1,     .duration_s = 2 * 3600,   .lag_s = 0    },
+        { .update_every_s = 60,    .duration_s = 86400,      .lag_s = 60   },
+        { .update_every_s = 3600,  .duration_s = 7 * 86400,  .lag_s = 3600 },
+        { .update_every_s = 86400, .duration_s = 30 * 86400, .lag_s = 0    },
+    };
+
+    size_t errors = 0;
+    int dummy_handle = 0;
+
+    QUERY_TARGET qt = { 0 };
+    qt.window.group_method = group_method;
+
+    RRDR r = { 0 };
+    r.internal.qt = &qt;
+
+    QUERY_METRIC qm = { 0 };
+    for(size_t tier = 0; tier < QUERY_PLAN_UNITTEST_TIERS ; tier++) {
+        qm.tiers[tier].db_metric_handle = (STORAGE_METRIC_HANDLE *)&dummy_handle;
+        qm.tiers[tier].db_first_time_s = now_s - tiers[tier].duration_s;
+        qm.tiers[tier].db_last_time_s = now_s - tiers[tier].lag_s;
+        qm.tiers[tier].db_update_every_s = tiers[tier].update_every_s;
+    }
+
+    time_t view_update_every = (before_wanted - after_wanted + 1) / (time_t)points_wanted;
+    QUERY_ENGINE_OPS ops = {
+            .r = &r,
+            .qm = &qm,
+            .view_update_every = view_update_every,
+            .query_granularity = 1,
+    };
+
+    if(!query_plan_tiers(&ops, after_wanted, before_wanted, points_wanted)) {
+        fprintf(stderr, "QUERY PLAN: %s: the query could not be planned\n", name);
+        return 1;
+    }
+
+    if(qm.plan.aggregated != aggregated) {
+        fprintf(stderr, "QUERY PLAN: %s: expected the plan %sto be aggregated\n", name, aggregated ? "" : "not ");
+        errors++;
+    }
+
+    for(size_t tier = 0; tier < QUERY_PLAN_UNITTEST_TIERS ; tier++) {
+        if(qm.tiers[tier].aligned != aligned[tier]) {
+            fprintf(stderr, "QUERY PLAN: %s: expected tier %zu %sto be aligned\n", name, tier, aligned[tier] ? "" : "not ");
+            errors++;
+        }
+    }
+
+    if(qm.plan.used != expected_entries) {
+        fprintf(stderr, "QUERY PLAN: %s: expected %zu plans, found %zu\n", name, expected_entries, qm.plan.used);
+        errors++;
+    }
+
+    for(size_t p = 0; p < qm.plan.used && p < expected_entries ; p++) {
+        if(qm.plan.array[p].tier != expected[p].tier ||
+           qm.plan.array[p].after != now_s + expected[p].after ||
+           qm.plan.array[p].before != now_s + expected[p].before) {
+            fprintf(stderr, "QUERY PLAN: %s: plan %zu expected tier %zu from %ld to %ld, found tier %zu from %ld to %ld\n",
+                    name, p,
+                    expected[p].tier, expected[p].after, expected[p].before,
+                    qm.plan.array[p].tier, qm.plan.array[p].after - now_s, qm.plan.array[p].before - now_s);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+int query_plan_unittest(void) {
+    const time_t now_s = 3600 * 472222;
+    size_t errors = 0;
+
+    fprintf(stderr, "\nTesting the query planer...\n");
+
+    size_t old_storage_tiers = storage_tiers;
+    storage_tiers = QUERY_PLAN_UNITTEST_TIERS;
+
+    // 6 hourly points of the last 6 hours: every group is an hourly point,
+    // so the hourly tier is read from the end of the first group, without a
+    // head plan of the daily tier, and the lower tiers fill the end of the query
+    {
+        const bool aligned[QUERY_PLAN_UNITTEST_TIERS] = { true, true, true, false };
+        const QUERY_PLAN_ENTRY expected[] = {
+            { .tier = 2, .after = -5 * 3600, .before = -3600 },
+            { .tier = 1, .after = -3600,     .before = -60   },
+            { .tier = 0, .after = -60,       .before = 0     },
+        };
+        errors += query_plan_unittest_check("average of hourly groups", RRDR_GROUPING_AVERAGE,
+                                            now_s - 6 * 3600 + 1, now_s, 6,
+                                            true, aligned, expected, sizeof(expected) / sizeof(expected[0]));
+    }
+
+    // the same query, with a grouping method that needs all the points
+    {
+        const bool aligned[QUERY_PLAN_UNITTEST_TIERS] = { false, false, false, false };
+        const QUERY_PLAN_ENTRY expected[] = {
+            { .tier = 1, .after = -6 * 3600 + 1, .before = -60 },
+            { .tier = 0, .after = -60,           .before = 0   },
+        };
+        errors += query_plan_unittest_check("median of hourly groups", RRDR_GROUPING_MEDIAN,
+                                            now_s - 6 * 3600 + 1, now_s, 6,
+                                            false, aligned, expected, sizeof(expected) / sizeof(expected[0]));
+    }
+
+    // hourly groups that end a minute after the hourly points: the hourly
+    // tier is not aligned, so it is read from the beginning of the query
+    {
+        const bool aligned[QUERY_PLAN_UNITTEST_TIERS] = { true, true, false, false };
+        const QUERY_PLAN_ENTRY expected[] = {
+            { .tier = 2, .after = -6 * 3600 + 61, .before = -3600 },
+            { .tier = 1, .after = -3600,          .before = -60   },
+            { .tier = 0, .after = -60,            .before = 0     },
+        };
+        errors += query_plan_unittest_check("average of misaligned hourly groups", RRDR_GROUPING_AVERAGE,
+                                            now_s - 6 * 3600 + 61, now_s + 60, 6,
+                                            false, aligned, expected, sizeof(expected) / sizeof(expected[0]));
+    }
+
+    storage_tiers = old_storage_tiers;
+
+    fprintf(stderr, "query planer: %zu errors\n", errors);
+    return errors ? 1 : 0;
+}
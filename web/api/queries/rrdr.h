@@ -119,6 +119,11 @@ typedef struct rrdresult {
         const char *log;
 #endif
 
+        // interruption of the query
+        usec_t started_ut;                  // the monotonic time the query started
+        usec_t next_interrupt_check_ut;     // when to call the interrupt callback again
+        bool timed_out;                     // true when the query was cancelled because of its timeout
+
         // statistics
         size_t db_points_read;
         size_t result_points_generated;
@@ -147,6 +152,9 @@ bool query_target_calculate_window(struct query_target *qt);
 
 bool rrdr_relative_window_to_absolute(time_t *after, time_t *before);
 
+int grouping_unittest(bool benchmark);
+int query_plan_unittest(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,8 +6,16 @@
 #define MAX_POINTS 10000
 int enable_metric_correlations = CONFIG_BOOLEAN_YES;
 int metric_correlations_version = 1;
+int metric_correlations_threads = 4;
 WEIGHTS_METHOD default_metric_correlations_method = WEIGHTS_METHOD_MC_KS2;
 
+// do not start more workers than needed to examine this many metrics each
+#define WEIGHTS_METRICS_PER_WORKER 50
+
+// prune the metrics the KS2 test can skip, only when the windows span at least
+// this many tier 1 points, so that their storage summary is cheap to read
+#define WEIGHTS_PRUNE_MIN_TIER1_POINTS 10
+
 typedef struct weights_stats {
     NETDATA_DOUBLE max_base_high_ratio;
     size_t db_points;
@@ -15,6 +23,8 @@ typedef struct weights_stats {
     size_t db_queries;
     size_t db_points_per_tier[RRD_STORAGE_TIERS];
     size_t binary_searches;
+    size_t pruned_dimensions;
+    bool timed_out;                     // the results are partial
 } WEIGHTS_STATS;
 
 // ----------------------------------------------------------------------------
@@ -62,6 +72,19 @@ struct register_result {
     NETDATA_DOUBLE value;
 };
 
+// The workers keep the result of each metric in the slot of the metric,
+// and the results are registered in the order of the metrics, once all
+// the workers finish, so that the output is grouped per context and chart.
+typedef struct weights_result {
+    RESULT_FLAGS flags;
+    NETDATA_DOUBLE value;       // NAN when there is no result for the metric
+} WEIGHTS_RESULT;
+
+static inline void weights_result_set(WEIGHTS_RESULT *result, NETDATA_DOUBLE value, RESULT_FLAGS flags) {
+    result->value = value;
+    result->flags = flags;
+}
+
 static DICTIONARY *register_result_init() {
     DICTIONARY *results = dictionary_create(DICT_OPTION_SINGLE_THREADED);
     return results;
@@ -122,11 +145,13 @@ static void results_header_to_json(DICTIONARY *results __maybe_unused, BUFFER *w
                        "\t\"after\": %lld,\n"
                        "\t\"before\": %lld,\n"
                        "\t\"duration\": %lld,\n"
-                       "\t\"points\": %zu,\n",
+                       "\t\"points\": %zu,\n"
+                       "\t\"timed_out\": %s,\n",
                        (long long)after,
                        (long long)before,
                        (long long)(before - after),
-                       points
+                       points,
+                       stats->timed_out ? "true" : "false"
                        );
 
     if(method == WEIGHTS_METHOD_MC_KS2 || method == WEIGHTS_METHOD_MC_VOLUME)
@@ -147,12 +172,14 @@ static void results_header_to_json(DICTIONARY *results __maybe_unused, BUFFER *w
                        "\t\t\"db_queries\": %zu,\n"
                        "\t\t\"query_result_points\": %zu,\n"
                        "\t\t\"binary_searches\": %zu,\n"
+                       "\t\t\"pruned_dimensions\": %zu,\n"
                        "\t\t\"db_points_read\": %zu,\n"
                        "\t\t\"db_points_per_tier\": [ ",
                        (double)duration / (double)USEC_PER_MS,
                        stats->db_queries,
                        stats->result_points,
                        stats->binary_searches,
+                       stats->pruned_dimensions,
                        stats->db_points
                    );
 
@@ -560,18 +587,55 @@ NETDATA_DOUBLE *rrd2rrdr_ks2(
     return ret;
 }
 
+// A metric that had the same value during both the baseline and the
+// highlighted windows has nothing to correlate, and the KS2 test would give
+// it a zero score. The storage summary of the metric finds these metrics by
+// reading just a few points per metric from the higher tiers, instead of all
+// the full resolution points of both windows.
+static bool rrdset_metric_correlations_ks2_prune(
+        RRDHOST *host, RRDMETRIC_ACQUIRED *rma,
+        WEIGHTS_RESULT *result,
+        time_t baseline_after, time_t before,
+        WEIGHTS_STATS *stats
+        ) {
+
+    STORAGE_POINT sp;
+    size_t points_per_tier[RRD_STORAGE_TIERS] = { 0 };
+    bool summarized = rrdmetric_acquired_storage_summary(host, rma, baseline_after, before,
+                                                         STORAGE_PRIORITY_NORMAL, &sp, points_per_tier);
+
+    stats->db_queries++;
+    for(size_t tier = 0; tier < storage_tiers ; tier++) {
+        stats->db_points += points_per_tier[tier];
+        stats->db_points_per_tier[tier] += points_per_tier[tier];
+    }
+
+    if(!summarized || sp.min != sp.max)
+        return false;
+
+    // metrics that are always zero are not registered by the KS2 test
+    if(sp.min != 0.0)
+        weights_result_set(result, 0.0, RESULT_IS_BASE_HIGH_RATIO);
+
+    stats->pruned_dimensions++;
+    return true;
+}
+
 static void rrdset_metric_correlations_ks2(
         RRDHOST *host,
         RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria, RRDMETRIC_ACQUIRED *rma,
-        DICTIONARY *results,
+        WEIGHTS_RESULT *result,
         time_t baseline_after, time_t baseline_before,
         time_t after, time_t before,
         size_t points, RRDR_OPTIONS options,
         RRDR_GROUPING group_method, const char *group_options, size_t tier,
-        uint32_t shifts,
-        WEIGHTS_STATS *stats, bool register_zero
+        uint32_t shifts, bool prune,
+        WEIGHTS_STATS *stats
         ) {
 
+    if(prune && rrdset_metric_correlations_ks2_prune(host, rma, result, baseline_after, before, stats))
+        return;
+
     options |= RRDR_OPTION_NATURAL_POINTS;
 
     ONEWAYALLOC *owa = onewayalloc_create(16 * 1024);
@@ -609,7 +673,7 @@ static void rrdset_metric_correlations_ks2(
 
         // to spread the results evenly, 0.0 needs to be the less correlated and 1.0 the most correlated
         // so, we flip the result of kstwo()
-        register_result(results, rca, ria, rma, 1.0 - prob, RESULT_IS_BASE_HIGH_RATIO, stats, register_zero);
+        weights_result_set(result, 1.0 - prob, RESULT_IS_BASE_HIGH_RATIO);
     }
 
 cleanup:
@@ -630,12 +694,12 @@ static void merge_query_value_to_stats(QUERY_VALUE *qv, WEIGHTS_STATS *stats) {
 static void rrdset_metric_correlations_volume(
         RRDHOST *host,
         RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria, RRDMETRIC_ACQUIRED *rma,
-        DICTIONARY *results,
+        WEIGHTS_RESULT *result,
         time_t baseline_after, time_t baseline_before,
         time_t after, time_t before,
         RRDR_OPTIONS options, RRDR_GROUPING group_method, const char *group_options,
         size_t tier,
-        WEIGHTS_STATS *stats, bool register_zero) {
+        WEIGHTS_STATS *stats) {
 
     options |= RRDR_OPTION_MATCH_IDS | RRDR_OPTION_ABSOLUTE | RRDR_OPTION_NATURAL_POINTS;
 
@@ -690,7 +754,7 @@ static void rrdset_metric_correlations_volume(
         pcent = highlight_countif.value;
     }
 
-    register_result(results, rca, ria, rma, pcent, flags, stats, register_zero);
+    weights_result_set(result, pcent, flags);
 }
 
 // ----------------------------------------------------------------------------
@@ -699,11 +763,11 @@ static void rrdset_metric_correlations_volume(
 static void rrdset_weights_anomaly_rate(
         RRDHOST *host,
         RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria, RRDMETRIC_ACQUIRED *rma,
-        DICTIONARY *results,
+        WEIGHTS_RESULT *result,
         time_t after, time_t before,
         RRDR_OPTIONS options, RRDR_GROUPING group_method, const char *group_options,
         size_t tier,
-        WEIGHTS_STATS *stats, bool register_zero) {
+        WEIGHTS_STATS *stats) {
 
     options |= RRDR_OPTION_MATCH_IDS | RRDR_OPTION_ANOMALY_BIT | RRDR_OPTION_NATURAL_POINTS;
 
@@ -714,7 +778,7 @@ static void rrdset_weights_anomaly_rate(
     merge_query_value_to_stats(&qv, stats);
 
     if(netdata_double_isnumber(qv.value))
-        register_result(results, rca, ria, rma, qv.value, 0, stats, register_zero);
+        weights_result_set(result, qv.value, 0);
 }
 
 // ----------------------------------------------------------------------------
@@ -799,6 +863,157 @@ static size_t spread_results_evenly(DICTIONARY *results, WEIGHTS_STATS *stats) {
     return dimensions;
 }
 
+// ----------------------------------------------------------------------------
+// The workers
+//
+// The metrics are examined in parallel by a number of workers. The caller is
+// one of them and the rest are threads started for this query. Each worker
+// picks the next metric to examine, until all are examined or the query times
+// out. The queries of each worker use the one way allocator page cache of its
+// thread, so that the workers do not contend on memory allocations.
+
+typedef struct weights_query {
+    RRDHOST *host;
+    WEIGHTS_METHOD method;
+    RRDR_GROUPING group;
+    const char *group_options;
+    time_t baseline_after;
+    time_t baseline_before;
+    time_t after;
+    time_t before;
+    size_t points;
+    RRDR_OPTIONS options;
+    size_t tier;
+    uint32_t shifts;
+    bool prune;
+
+    struct metric_entry **metrics;
+    WEIGHTS_RESULT *results;            // one slot per metric
+    size_t metrics_count;
+
+    size_t next_metric;                 // atomic - the next metric to be examined
+    usec_t timeout_ut;                  // the realtime the query should finish
+    bool timed_out;                     // atomic - stops all workers
+} WEIGHTS_QUERY;
+
+typedef struct weights_worker {
+    netdata_thread_t thread;
+    WEIGHTS_QUERY *wq;
+    WEIGHTS_STATS stats;
+    size_t examined_dimensions;
+} WEIGHTS_WORKER;
+
+static void *weights_worker_thread(void *ptr) {
+    WEIGHTS_WORKER *ww = ptr;
+    WEIGHTS_QUERY *wq = ww->wq;
+
+    while(!__atomic_load_n(&wq->timed_out, __ATOMIC_RELAXED)) {
+        size_t m = __atomic_fetch_add(&wq->next_metric, 1, __ATOMIC_RELAXED);
+        if(m >= wq->metrics_count)
+            break;
+
+        if(now_realtime_usec() > wq->timeout_ut) {
+            __atomic_store_n(&wq->timed_out, true, __ATOMIC_RELAXED);
+            break;
+        }
+
+        ww->examined_dimensions++;
+
+        struct metric_entry *me = wq->metrics[m];
+        WEIGHTS_RESULT *result = &wq->results[m];
+
+        switch(wq->method) {
+            case WEIGHTS_METHOD_ANOMALY_RATE:
+                rrdset_weights_anomaly_rate(
+                        wq->host,
+                        me->rca, me->ria, me->rma,
+                        result,
+                        wq->after, wq->before,
+                        wq->options, wq->group, wq->group_options, wq->tier,
+                        &ww->stats
+                        );
+                break;
+
+            case WEIGHTS_METHOD_MC_VOLUME:
+                rrdset_metric_correlations_volume(
+                        wq->host,
+                        me->rca, me->ria, me->rma,
+                        result,
+                        wq->baseline_after, wq->baseline_before,
+                        wq->after, wq->before,
+                        wq->options, wq->group, wq->group_options, wq->tier,
+                        &ww->stats
+                        );
+                break;
+
+            default:
+            case WEIGHTS_METHOD_MC_KS2:
+                rrdset_metric_correlations_ks2(
+                        wq->host,
+                        me->rca, me->ria, me->rma,
+                        result,
+                        wq->baseline_after, wq->baseline_before,
+                        wq->after, wq->before, wq->points,
+                        wq->options, wq->group, wq->group_options, wq->tier,
+                        wq->shifts, wq->prune,
+                        &ww->stats
+                        );
+                break;
+        }
+    }
+
+    return ptr;
+}
+
+static void weights_stats_merge(WEIGHTS_STATS *dst, WEIGHTS_STATS *src) {
+    dst->db_points += src->db_points;
+    dst->result_points += src->result_points;
+    dst->db_queries += src->db_queries;
+    dst->binary_searches += src->binary_searches;
+    dst->pruned_dimensions += src->pruned_dimensions;
+
+    for(size_t tier = 0; tier < storage_tiers ; tier++)
+        dst->db_points_per_tier[tier] += src->db_points_per_tier[tier];
+}
+
+// returns the number of metrics examined
+static size_t weights_query_run(WEIGHTS_QUERY *wq, WEIGHTS_STATS *stats) {
+    size_t workers = (size_t)metric_correlations_threads;
+    size_t max_workers = wq->metrics_count / WEIGHTS_METRICS_PER_WORKER + 1;
+    if(workers > max_workers) workers = max_workers;
+    if(workers < 1) workers = 1;
+
+    WEIGHTS_WORKER ww[workers];
+    memset(ww, 0, sizeof(ww));
+
+    for(size_t w = 0; w < workers ;w++)
+        ww[w].wq = wq;
+
+    // the caller is the first worker
+    for(size_t w = 1; w < workers ;w++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "WEIGHTS[%zu]", w);
+        netdata_thread_create(&ww[w].thread, tag,
+                              NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG,
+                              weights_worker_thread, &ww[w]);
+    }
+
+    weights_worker_thread(&ww[0]);
+
+    size_t examined_dimensions = 0;
+    for(size_t w = 0; w < workers ;w++) {
+        if(w)
+            netdata_thread_join(ww[w].thread, NULL);
+
+        weights_stats_merge(stats, &ww[w].stats);
+        examined_dimensions += ww[w].examined_dimensions;
+    }
+
+    stats->timed_out = __atomic_load_n(&wq->timed_out, __ATOMIC_RELAXED);
+
+    return examined_dimensions;
+}
+
 // ----------------------------------------------------------------------------
 // The main function
 
@@ -912,57 +1127,60 @@ int web_api_v1_weights(
     metrics = rrdcontext_all_metrics_to_dict(host, contexts);
     struct metric_entry *me;
 
-    // for every metric_entry in the dictionary
-    dfe_start_read(metrics, me) {
-        usec_t now_usec = now_realtime_usec();
-        if(now_usec - started_usec > timeout_usec) {
-            error = "timed out";
-            resp = HTTP_RESP_GATEWAY_TIMEOUT;
-            goto cleanup;
-        }
+    if(method == WEIGHTS_METHOD_ANOMALY_RATE)
+        options |= RRDR_OPTION_ANOMALY_BIT;
 
-        examined_dimensions++;
+    WEIGHTS_QUERY wq = {
+            .host = host,
+            .method = method,
+            .group = group,
+            .group_options = group_options,
+            .baseline_after = baseline_after,
+            .baseline_before = baseline_before,
+            .after = after,
+            .before = before,
+            .points = points,
+            .options = options,
+            .tier = tier,
+            .shifts = shifts,
+            .prune = false,
+            .timeout_ut = started_usec + timeout_usec,
+    };
 
-        switch(method) {
-            case WEIGHTS_METHOD_ANOMALY_RATE:
-                options |= RRDR_OPTION_ANOMALY_BIT;
-                rrdset_weights_anomaly_rate(
-                        host,
-                        me->rca, me->ria, me->rma,
-                        results,
-                        after, before,
-                        options, group, group_options, tier,
-                        &stats, register_zero
-                        );
-                break;
+    if(method == WEIGHTS_METHOD_MC_KS2 && storage_tiers > 1) {
+        time_t tier1_update_every_s = (time_t)(host->db[1].tier_grouping * host->rrd_update_every);
+        wq.prune = (before - baseline_after) / WEIGHTS_PRUNE_MIN_TIER1_POINTS >= tier1_update_every_s;
+    }
 
-            case WEIGHTS_METHOD_MC_VOLUME:
-                rrdset_metric_correlations_volume(
-                        host,
-                        me->rca, me->ria, me->rma,
-                        results,
-                        baseline_after, baseline_before,
-                        after, before,
-                        options, group, group_options, tier,
-                        &stats, register_zero
-                        );
-                break;
+    // take a snapshot of the metrics, so that the workers can pick them by index
+    wq.metrics_count = metrics ? dictionary_entries(metrics) : 0;
+    wq.metrics = mallocz(MAX(wq.metrics_count, 1) * sizeof(struct metric_entry *));
+    wq.results = mallocz(MAX(wq.metrics_count, 1) * sizeof(WEIGHTS_RESULT));
 
-            default:
-            case WEIGHTS_METHOD_MC_KS2:
-                rrdset_metric_correlations_ks2(
-                        host,
-                        me->rca, me->ria, me->rma,
-                        results,
-                        baseline_after, baseline_before,
-                        after, before, points,
-                        options, group, group_options, tier, shifts,
-                        &stats, register_zero
-                        );
-                break;
-        }
+    size_t m = 0;
+    dfe_start_read(metrics, me) {
+        if(m == wq.metrics_count)
+            break;
+
+        wq.metrics[m] = me;
+        wq.results[m].value = NAN;
+        m++;
     }
     dfe_done(me);
+    wq.metrics_count = m;
+
+    examined_dimensions = weights_query_run(&wq, &stats);
+
+    // register the results in the order of the metrics,
+    // even when the query timed out, to return the partial results
+    for(m = 0; m < wq.metrics_count ;m++) {
+        me = wq.metrics[m];
+        register_result(results, me->rca, me->ria, me->rma,
+                        wq.results[m].value, wq.results[m].flags, &stats, register_zero);
+    }
+
+    freez(wq.metrics);
+    freez(wq.results);
 
     if(!register_zero)
         options |= RRDR_OPTION_NONZERO;
@@ -1002,8 +1220,14 @@ int web_api_v1_weights(
     }
 
     if(!added_dimensions) {
-        error = "no results produced.";
-        resp = HTTP_RESP_NOT_FOUND;
+        if(stats.timed_out) {
+            error = "timed out";
+            resp = HTTP_RESP_GATEWAY_TIMEOUT;
+        }
+        else {
+            error = "no results produced.";
+            resp = HTTP_RESP_NOT_FOUND;
+        }
     }
 
 cleanup:
@@ -18,6 +18,7 @@ typedef enum {
 
 extern int enable_metric_correlations;
 extern int metric_correlations_version;
+extern int metric_correlations_threads;
 extern WEIGHTS_METHOD default_metric_correlations_method;
 
 int web_api_v1_weights (RRDHOST *host, BUFFER *wb, WEIGHTS_METHOD method, WEIGHTS_FORMAT format,
@@ -754,6 +754,8 @@ inline int web_client_api_request_v1_data(RRDHOST *host, struct web_client *w, c
             .charts_labels_filter = chart_labels_filter,
             .query_source = QUERY_SOURCE_API_DATA,
             .priority = STORAGE_PRIORITY_NORMAL,
+            .interrupt_callback = web_client_interrupt_callback,
+            .interrupt_callback_data = w,
     };
     qt = query_target_create(&qtr);
 
@@ -774,6 +776,9 @@ inline int web_client_api_request_v1_data(RRDHOST *host, struct web_client *w, c
             ret = HTTP_RESP_BACKEND_FETCH_FAILED;
             goto cleanup;
         }
+
+        // the query gets the time that is left
+        qt->request.timeout = timeout;
     }
 
     debug(D_WEB_CLIENT, "%llu: API command 'data' for chart '%s', dimensions '%s', after '%lld', before '%lld', points '%d', group '%u', format '%u', options '0x%08x'"
@@ -16,9 +16,13 @@ long web_client_streaming_rate_t = 0L;
 #define WORKER_JOB_RCV_DATA       6
 #define WORKER_JOB_SND_DATA       7
 #define WORKER_JOB_PROCESS        8
+#define WORKER_JOB_OWA_ALLOCATIONS_PER_REQUEST 9
+#define WORKER_JOB_OWA_ALLOCATIONS 10
+#define WORKER_JOB_OWA_PAGES_ALLOCATED 11
+#define WORKER_JOB_OWA_PAGES_REUSED 12
 
-#if (WORKER_UTILIZATION_MAX_JOB_TYPES < 9)
-#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least 8
+#if (WORKER_UTILIZATION_MAX_JOB_TYPES < 13)
+#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least 13
 #endif
 
 /*
@@ -301,14 +305,25 @@ static int web_server_rcv_callback(POLLINFO *pi, short int *events) {
     debug(D_WEB_CLIENT, "%llu: processing received data on fd %d.", w->id, fd);
     worker_is_idle();
     worker_is_busy(WORKER_JOB_PROCESS);
+
+    struct onewayalloc_thread_statistics owa_before, owa_after;
+    onewayalloc_thread_statistics(&owa_before);
+
     web_client_process_request(w);
 
+    onewayalloc_thread_statistics(&owa_after);
+    worker_set_metric(WORKER_JOB_OWA_ALLOCATIONS_PER_REQUEST, (NETDATA_DOUBLE)(owa_after.allocations - owa_before.allocations));
+    worker_set_metric(WORKER_JOB_OWA_ALLOCATIONS, (NETDATA_DOUBLE)owa_after.allocations);
+    worker_set_metric(WORKER_JOB_OWA_PAGES_ALLOCATED, (NETDATA_DOUBLE)owa_after.pages_allocated);
+    worker_set_metric(WORKER_JOB_OWA_PAGES_REUSED, (NETDATA_DOUBLE)owa_after.pages_reused);
+
     if (unlikely(w->mode == WEB_CLIENT_MODE_STREAM)) {
         web_client_send(w);
     }
 
     else if(unlikely(w->mode == WEB_CLIENT_MODE_FILECOPY)) {
-        if(w->pollinfo_filecopy_slot == 0) {
+        // files sent with sendfile() are not read by the poll loop
+        if(w->pollinfo_filecopy_slot == 0 && !web_client_flag_check(w, WEB_CLIENT_FLAG_SENDFILE)) {
             debug(D_WEB_CLIENT, "%llu: FILECOPY DETECTED ON FD %d", w->id, pi->fd);
 
             if (unlikely(w->ifd != -1 && w->ifd != w->ofd && w->ifd != fd)) {
@@ -425,6 +440,10 @@ void *socket_listen_main_static_threaded_worker(void *ptr) {
     worker_register_job_name(WORKER_JOB_RCV_DATA, "receive");
     worker_register_job_name(WORKER_JOB_SND_DATA, "send");
     worker_register_job_name(WORKER_JOB_PROCESS, "process");
+    worker_register_job_custom_metric(WORKER_JOB_OWA_ALLOCATIONS_PER_REQUEST, "query arena allocations per request", "allocations", WORKER_METRIC_ABSOLUTE);
+    worker_register_job_custom_metric(WORKER_JOB_OWA_ALLOCATIONS, "query arena allocations", "allocations/s", WORKER_METRIC_INCREMENTAL_TOTAL);
+    worker_register_job_custom_metric(WORKER_JOB_OWA_PAGES_ALLOCATED, "query arena pages allocated", "pages/s", WORKER_METRIC_INCREMENTAL_TOTAL);
+    worker_register_job_custom_metric(WORKER_JOB_OWA_PAGES_REUSED, "query arena pages reused", "pages/s", WORKER_METRIC_INCREMENTAL_TOTAL);
 
     netdata_thread_cleanup_push(socket_listen_main_static_threaded_worker_cleanup, ptr);
 
@@ -12,6 +12,38 @@ char *web_x_frame_options = NULL;
 int web_enable_gzip = 1, web_gzip_level = 3, web_gzip_strategy = Z_DEFAULT_STRATEGY;
 #endif /* NETDATA_WITH_ZLIB */
 
+#ifdef NETDATA_WITH_ZSTD
+int web_enable_zstd = 1, web_zstd_level = 3;
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+int web_enable_brotli = 1, web_brotli_quality = 4;
+#endif /* NETDATA_WITH_BROTLI */
+
+int web_precompress_static_files = 1;
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#define WEB_CLIENT_HAVE_SENDFILE 1
+#endif
+
+const char *web_content_encoding2str(WEB_CONTENT_ENCODING encoding) {
+    switch(encoding) {
+        case WEB_CONTENT_ENCODING_GZIP:
+            return "gzip";
+
+        case WEB_CONTENT_ENCODING_ZSTD:
+            return "zstd";
+
+        case WEB_CONTENT_ENCODING_BROTLI:
+            return "br";
+
+        default:
+        case WEB_CONTENT_ENCODING_NONE:
+            return "identity";
+    }
+}
+
 inline int web_client_permission_denied(struct web_client *w) {
     w->response.data->contenttype = CT_TEXT_PLAIN;
     buffer_flush(w->response.data);
@@ -67,6 +99,307 @@ char *strip_control_characters(char *url) {
     return url;
 }
 
+// ----------------------------------------------------------------------------
+// response compression
+
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+static void web_client_enable_compression(struct web_client *w, WEB_CONTENT_ENCODING encoding) {
+    if(unlikely(w->response.zinitialized)) {
+        debug(D_DEFLATE, "%llu: Compression has already be initialized for this client.", w->id);
+        return;
+    }
+
+    if(unlikely(w->response.sent)) {
+        error("%llu: Cannot enable compression in the middle of a conversation.", w->id);
+        return;
+    }
+
+    switch(encoding) {
+#ifdef NETDATA_WITH_ZLIB
+        case WEB_CONTENT_ENCODING_GZIP:
+            w->response.zstream.zalloc = Z_NULL;
+            w->response.zstream.zfree = Z_NULL;
+            w->response.zstream.opaque = Z_NULL;
+
+            w->response.zstream.next_in = (Bytef *)w->response.data->buffer;
+            w->response.zstream.avail_in = 0;
+            w->response.zstream.total_in = 0;
+
+            w->response.zstream.next_out = w->response.zbuffer;
+            w->response.zstream.avail_out = 0;
+            w->response.zstream.total_out = 0;
+
+            // Select GZIP compression: windowbits = 15 + 16 = 31
+            if(deflateInit2(&w->response.zstream, web_gzip_level, Z_DEFLATED, 15 + 16, 8, web_gzip_strategy) != Z_OK) {
+                error("%llu: Failed to initialize zlib. Proceeding without compression.", w->id);
+                return;
+            }
+            break;
+#endif /* NETDATA_WITH_ZLIB */
+
+#ifdef NETDATA_WITH_ZSTD
+        case WEB_CONTENT_ENCODING_ZSTD:
+            // the compression context is reset when we first compress,
+            // so that we can give it the size of the response
+            if(!w->response.zstd) {
+                w->response.zstd = ZSTD_createCCtx();
+                if(!w->response.zstd) {
+                    error("%llu: Failed to initialize zstd. Proceeding without compression.", w->id);
+                    return;
+                }
+            }
+            break;
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+        case WEB_CONTENT_ENCODING_BROTLI:
+            // the brotli encoder is created when we first compress,
+            // so that we can give it the size of the response
+            break;
+#endif /* NETDATA_WITH_BROTLI */
+
+        default:
+            return;
+    }
+
+    w->response.zin = 0;
+    w->response.zsent = 0;
+    w->response.zhave = 0;
+    w->response.ztotal = 0;
+    w->response.zpending = 0;
+    w->response.zfinished = 0;
+    w->response.encoding = encoding;
+    w->response.zoutput = 1;
+    w->response.zinitialized = 1;
+    w->flags |= WEB_CLIENT_CHUNKED_TRANSFER;
+
+    debug(D_DEFLATE, "%llu: Initialized %s compression.", w->id, web_content_encoding2str(encoding));
+}
+#endif // NETDATA_WITH_WEB_COMPRESSION
+
+static void web_client_disable_compression(struct web_client *w) {
+    w->response.zoutput = 0;
+
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+    if(w->response.zinitialized) {
+        debug(D_DEFLATE, "%llu: Freeing compression resources.", w->id);
+
+        switch(w->response.encoding) {
+#ifdef NETDATA_WITH_ZLIB
+            case WEB_CONTENT_ENCODING_GZIP:
+                deflateEnd(&w->response.zstream);
+                w->response.zstream.avail_in = 0;
+                w->response.zstream.avail_out = 0;
+                w->response.zstream.total_in = 0;
+                w->response.zstream.total_out = 0;
+                break;
+#endif /* NETDATA_WITH_ZLIB */
+
+#ifdef NETDATA_WITH_ZSTD
+            case WEB_CONTENT_ENCODING_ZSTD:
+                // the context is kept for the next responses of the client,
+                // it is reset when the next response is first compressed
+                break;
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+            case WEB_CONTENT_ENCODING_BROTLI:
+                if(w->response.brotli) {
+                    BrotliEncoderDestroyInstance(w->response.brotli);
+                    w->response.brotli = NULL;
+                }
+                break;
+#endif /* NETDATA_WITH_BROTLI */
+
+            default:
+                break;
+        }
+
+        w->response.zinitialized = 0;
+        w->flags &= ~WEB_CLIENT_CHUNKED_TRANSFER;
+    }
+
+    w->response.zin = 0;
+    w->response.zsent = 0;
+    w->response.zhave = 0;
+    w->response.ztotal = 0;
+    w->response.zpending = 0;
+    w->response.zfinished = 0;
+#endif // NETDATA_WITH_WEB_COMPRESSION
+
+    w->response.encoding = WEB_CONTENT_ENCODING_NONE;
+}
+
+void web_client_free_compressors(struct web_client *w) {
+    web_client_disable_compression(w);
+
+#ifdef NETDATA_WITH_ZSTD
+    if(w->response.zstd) {
+        ZSTD_freeCCtx(w->response.zstd);
+        w->response.zstd = NULL;
+    }
+#endif /* NETDATA_WITH_ZSTD */
+}
+
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+// Compress the data not passed through the compressor yet, into zbuffer.
+// When finish is set, all the data of the response are in the buffer,
+// so the compressor is asked to write the end of the stream.
+static int web_client_compress(struct web_client *w, bool finish) {
+    const char *in = &w->response.data->buffer[w->response.zin];
+    size_t in_len = w->response.data->len - w->response.zin;
+
+    w->response.zhave = 0;
+    w->response.zsent = 0;
+
+    switch(w->response.encoding) {
+#ifdef NETDATA_WITH_ZLIB
+        case WEB_CONTENT_ENCODING_GZIP: {
+            w->response.zstream.next_in = (Bytef *)in;
+            w->response.zstream.avail_in = (uInt)in_len;
+            w->response.zstream.next_out = w->response.zbuffer;
+            w->response.zstream.avail_out = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE;
+
+            int ret = deflate(&w->response.zstream, finish ? Z_FINISH : Z_SYNC_FLUSH);
+            if(ret == Z_STREAM_ERROR)
+                return -1;
+
+            w->response.zin += in_len - w->response.zstream.avail_in;
+            w->response.zhave = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE - w->response.zstream.avail_out;
+            w->response.zfinished = (ret == Z_STREAM_END);
+            w->response.zpending = (!w->response.zfinished && w->response.zstream.avail_out == 0);
+            break;
+        }
+#endif /* NETDATA_WITH_ZLIB */
+
+#ifdef NETDATA_WITH_ZSTD
+        case WEB_CONTENT_ENCODING_ZSTD: {
+            if(!w->response.ztotal && !w->response.zin) {
+                ZSTD_CCtx_reset(w->response.zstd, ZSTD_reset_session_only);
+                ZSTD_CCtx_setParameter(w->response.zstd, ZSTD_c_compressionLevel, web_zstd_level);
+                if(finish)
+                    ZSTD_CCtx_setPledgedSrcSize(w->response.zstd, in_len);
+            }
+
+            ZSTD_inBuffer input = { .src = in, .size = in_len, .pos = 0 };
+            ZSTD_outBuffer output = { .dst = w->response.zbuffer, .size = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE, .pos = 0 };
+
+            size_t remaining = ZSTD_compressStream2(w->response.zstd, &output, &input, finish ? ZSTD_e_end : ZSTD_e_flush);
+            if(ZSTD_isError(remaining)) {
+                error("%llu: zstd compression failed: %s", w->id, ZSTD_getErrorName(remaining));
+                return -1;
+            }
+
+            w->response.zin += input.pos;
+            w->response.zhave = output.pos;
+            w->response.zfinished = (finish && remaining == 0);
+            w->response.zpending = (remaining != 0);
+            break;
+        }
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+        case WEB_CONTENT_ENCODING_BROTLI: {
+            if(!w->response.brotli) {
+                w->response.brotli = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+                if(!w->response.brotli)
+                    return -1;
+
+                BrotliEncoderSetParameter(w->response.brotli, BROTLI_PARAM_QUALITY, (uint32_t)web_brotli_quality);
+                if(finish && in_len <= UINT32_MAX)
+                    BrotliEncoderSetParameter(w->response.brotli, BROTLI_PARAM_SIZE_HINT, (uint32_t)in_len);
+            }
+
+            size_t avail_in = in_len, avail_out = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE;
+            const uint8_t *next_in = (const uint8_t *)in;
+            uint8_t *next_out = w->response.zbuffer;
+
+            if(!BrotliEncoderCompressStream(w->response.brotli, finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH,
+                                            &avail_in, &next_in, &avail_out, &next_out, NULL))
+                return -1;
+
+            w->response.zin += in_len - avail_in;
+            w->response.zhave = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE - avail_out;
+            w->response.zfinished = (finish && BrotliEncoderIsFinished(w->response.brotli));
+            w->response.zpending = BrotliEncoderHasMoreOutput(w->response.brotli) || avail_in;
+            break;
+        }
+#endif /* NETDATA_WITH_BROTLI */
+
+        default:
+            return -1;
+    }
+
+    // keep track of the bytes passed through the compressor
+    w->response.sent = w->response.zin;
+    return 0;
+}
+
+static inline bool http_accept_encoding_has(const char *v, const char *encoding) {
+    size_t len = strlen(encoding);
+
+    while(*v) {
+        while(*v == ' ' || *v == ',') v++;
+
+        const char *token = v;
+        while(*v && *v != ',' && *v != ';' && *v != ' ') v++;
+
+        bool match = ((size_t)(v - token) == len && !strncasecmp(token, encoding, len));
+
+        // check for a zero quality value, which means "not acceptable"
+        bool acceptable = true;
+        while(*v == ' ') v++;
+        if(*v == ';') {
+            const char *q = v + 1;
+            while(*q == ' ') q++;
+            if((*q == 'q' || *q == 'Q') && q[1] == '=') {
+                q += 2;
+                acceptable = (str2ndd(q, NULL) > 0.0);
+            }
+        }
+        while(*v && *v != ',') v++;
+
+        if(match)
+            return acceptable;
+    }
+
+    return false;
+}
+
+static inline void web_client_negotiate_compression(struct web_client *w, const char *accept_encoding) {
+#ifdef NETDATA_WITH_ZSTD
+    if(web_enable_zstd && http_accept_encoding_has(accept_encoding, "zstd")) {
+        web_client_enable_compression(w, WEB_CONTENT_ENCODING_ZSTD);
+        if(w->response.zinitialized) return;
+    }
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+    if(web_enable_brotli && http_accept_encoding_has(accept_encoding, "br")) {
+        web_client_enable_compression(w, WEB_CONTENT_ENCODING_BROTLI);
+        if(w->response.zinitialized) return;
+    }
+#endif /* NETDATA_WITH_BROTLI */
+
+#ifdef NETDATA_WITH_ZLIB
+    if(web_enable_gzip && http_accept_encoding_has(accept_encoding, "gzip"))
+        web_client_enable_compression(w, WEB_CONTENT_ENCODING_GZIP);
+#endif /* NETDATA_WITH_ZLIB */
+}
+#endif // NETDATA_WITH_WEB_COMPRESSION
+
+// the interrupt callback of the queries a web client makes,
+// they should stop when the client closes its connection, or the connection fails
+bool web_client_interrupt_callback(void *data) {
+    struct web_client *w = data;
+
+    // the cloud clients do not have a socket
+    if(w->acl & WEB_CLIENT_ACL_ACLK)
+        return false;
+
+    return sock_peer_has_closed(w->ofd, !web_client_may_half_close(w));
+}
+
 void web_client_request_done(struct web_client *w) {
     web_client_uncrock_socket(w);
 
@@ -78,8 +411,8 @@ void web_client_request_done(struct web_client *w) {
 
         size_t size = (w->mode == WEB_CLIENT_MODE_FILECOPY)?w->response.rlen:w->response.data->len;
         size_t sent = size;
-#ifdef NETDATA_WITH_ZLIB
-        if(likely(w->response.zoutput)) sent = (size_t)w->response.zstream.total_out;
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+        if(likely(w->response.zoutput)) sent = w->response.ztotal;
 #endif
 
         // --------------------------------------------------------------------
@@ -142,7 +475,9 @@ void web_client_request_done(struct web_client *w) {
         if(w->ifd != w->ofd) {
             debug(D_WEB_CLIENT, "%llu: Closing filecopy input file descriptor %d.", w->id, w->ifd);
 
-            if(web_server_mode != WEB_SERVER_MODE_STATIC_THREADED) {
+            // with sendfile() the file is not registered to the poll loop,
+            // so we have to close it ourselves
+            if(web_server_mode != WEB_SERVER_MODE_STATIC_THREADED || web_client_flag_check(w, WEB_CLIENT_FLAG_SENDFILE)) {
                 if (w->ifd != -1){
                     close(w->ifd);
                 }
@@ -151,6 +486,7 @@ void web_client_request_done(struct web_client *w) {
             w->ifd = w->ofd;
         }
     }
+    web_client_flag_clear(w, WEB_CLIENT_FLAG_SENDFILE);
 
     w->last_url[0] = '\0';
     w->cookie1[0] = '\0';
@@ -170,6 +506,7 @@ void web_client_request_done(struct web_client *w) {
     web_client_disable_donottrack(w);
     web_client_disable_tracking_required(w);
     web_client_disable_keepalive(w);
+    web_client_disable_half_close(w);
     w->decoded_url[0] = '\0';
 
     buffer_reset(w->response.header_output);
@@ -185,23 +522,8 @@ void web_client_request_done(struct web_client *w) {
     web_client_enable_wait_receive(w);
     web_client_disable_wait_send(w);
 
-    w->response.zoutput = 0;
-
     // if we had enabled compression, release it
-#ifdef NETDATA_WITH_ZLIB
-    if(w->response.zinitialized) {
-        debug(D_DEFLATE, "%llu: Freeing compression resources.", w->id);
-        deflateEnd(&w->response.zstream);
-        w->response.zsent = 0;
-        w->response.zhave = 0;
-        w->response.zstream.avail_in = 0;
-        w->response.zstream.avail_out = 0;
-        w->response.zstream.total_in = 0;
-        w->response.zstream.total_out = 0;
-        w->response.zinitialized = 0;
-        w->flags &= ~WEB_CLIENT_CHUNKED_TRANSFER;
-    }
-#endif // NETDATA_WITH_ZLIB
+    web_client_disable_compression(w);
 }
 
 static struct {
@@ -272,6 +594,270 @@ static inline uint8_t contenttype_for_filename(const char *filename) {
     return CT_APPLICATION_OCTET_STREAM;
 }
 
+static inline bool contenttype_is_compressible(uint8_t contenttype) {
+    switch(contenttype) {
+        case CT_APPLICATION_JSON:
+        case CT_TEXT_PLAIN:
+        case CT_TEXT_HTML:
+        case CT_APPLICATION_X_JAVASCRIPT:
+        case CT_TEXT_CSS:
+        case CT_TEXT_XML:
+        case CT_APPLICATION_XML:
+        case CT_TEXT_XSL:
+        case CT_APPLICATION_X_FONT_TRUETYPE:
+        case CT_APPLICATION_X_FONT_OPENTYPE:
+        case CT_APPLICATION_VND_MS_FONTOBJ:
+        case CT_IMAGE_SVG_XML:
+        case CT_IMAGE_XICON:
+        case CT_IMAGE_BMP:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static inline bool web_client_uses_tls(struct web_client *w) {
+#ifdef ENABLE_HTTPS
+    return (!web_client_check_unix(w) && netdata_ssl_srv_ctx && w->ssl.conn && !w->ssl.flags);
+#else
+    (void)w;
+    return false;
+#endif
+}
+
+static inline time_t stat_mtime(struct stat *st) {
+#ifdef __APPLE__
+    return st->st_mtimespec.tv_sec;
+#else
+    return st->st_mtim.tv_sec;
+#endif
+}
+
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+// ----------------------------------------------------------------------------
+// precompressed static files
+//
+// Static files are compressed once per encoding and the result is served
+// with sendfile(), instead of compressing them again on every request.
+// A precompressed file is looked up:
+//  1. next to the original file (e.g. main.js.br), as shipped by packaging,
+//     if it is not older than the original file
+//  2. in the cache directory, where netdata writes the files it compresses
+//     itself, with the modification time of the original file
+
+#define WEB_PRECOMPRESS_MIN_SIZE 1024
+#define WEB_PRECOMPRESS_MAX_SIZE (100 * 1024 * 1024)
+
+#define WEB_PRECOMPRESS_GZIP_LEVEL 9
+#define WEB_PRECOMPRESS_ZSTD_LEVEL 15
+#define WEB_PRECOMPRESS_BROTLI_QUALITY 9
+
+static inline const char *web_content_encoding2extension(WEB_CONTENT_ENCODING encoding) {
+    switch(encoding) {
+        case WEB_CONTENT_ENCODING_GZIP:
+            return ".gz";
+
+        case WEB_CONTENT_ENCODING_ZSTD:
+            return ".zst";
+
+        case WEB_CONTENT_ENCODING_BROTLI:
+            return ".br";
+
+        default:
+            return NULL;
+    }
+}
+
+static void *web_precompress_buffer(WEB_CONTENT_ENCODING encoding, const void *src, size_t src_len, size_t *dst_len) {
+    void *dst = NULL;
+    *dst_len = 0;
+
+    switch(encoding) {
+#ifdef NETDATA_WITH_ZLIB
+        case WEB_CONTENT_ENCODING_GZIP: {
+            z_stream zs = { .zalloc = Z_NULL, .zfree = Z_NULL, .opaque = Z_NULL };
+            if(deflateInit2(&zs, WEB_PRECOMPRESS_GZIP_LEVEL, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+                return NULL;
+
+            size_t bound = deflateBound(&zs, src_len);
+            dst = mallocz(bound);
+            zs.next_in = (Bytef *)src;
+            zs.avail_in = (uInt)src_len;
+            zs.next_out = dst;
+            zs.avail_out = (uInt)bound;
+
+            if(deflate(&zs, Z_FINISH) == Z_STREAM_END)
+                *dst_len = zs.total_out;
+
+            deflateEnd(&zs);
+            break;
+        }
+#endif /* NETDATA_WITH_ZLIB */
+
+#ifdef NETDATA_WITH_ZSTD
+        case WEB_CONTENT_ENCODING_ZSTD: {
+            size_t bound = ZSTD_compressBound(src_len);
+            dst = mallocz(bound);
+            size_t ret = ZSTD_compress(dst, bound, src, src_len, WEB_PRECOMPRESS_ZSTD_LEVEL);
+            if(!ZSTD_isError(ret))
+                *dst_len = ret;
+            break;
+        }
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+        case WEB_CONTENT_ENCODING_BROTLI: {
+            size_t bound = BrotliEncoderMaxCompressedSize(src_len);
+            if(!bound) return NULL;
+
+            dst = mallocz(bound);
+            size_t len = bound;
+            if(BrotliEncoderCompress(WEB_PRECOMPRESS_BROTLI_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                     src_len, src, &len, dst) == BROTLI_TRUE)
+                *dst_len = len;
+            break;
+        }
+#endif /* NETDATA_WITH_BROTLI */
+
+        default:
+            return NULL;
+    }
+
+    if(!*dst_len) {
+        freez(dst);
+        return NULL;
+    }
+
+    return dst;
+}
+
+static inline int web_precompressed_open(const char *filename, struct stat *src_st, struct stat *st, bool exact_mtime) {
+    if(stat(filename, st) != 0 || (st->st_mode & S_IFMT) != S_IFREG || !st->st_size)
+        return -1;
+
+    if(exact_mtime ? stat_mtime(st) != stat_mtime(src_st) : stat_mtime(st) < stat_mtime(src_st))
+        return -1;
+
+    return open(filename, O_RDONLY);
+}
+
+static int web_precompressed_create(const char *src_filename, struct stat *src_st, const char *dst_filename, WEB_CONTENT_ENCODING encoding) {
+    if(src_st->st_size > WEB_PRECOMPRESS_MAX_SIZE)
+        return -1;
+
+    int fd = open(src_filename, O_RDONLY);
+    if(fd == -1)
+        return -1;
+
+    size_t src_len = (size_t)src_st->st_size, bytes = 0;
+    char *src = mallocz(src_len);
+    while(bytes < src_len) {
+        ssize_t r = read(fd, &src[bytes], src_len - bytes);
+        if(r <= 0) break;
+        bytes += r;
+    }
+    close(fd);
+
+    if(bytes != src_len) {
+        freez(src);
+        return -1;
+    }
+
+    size_t dst_len;
+    void *dst = web_precompress_buffer(encoding, src, src_len, &dst_len);
+    freez(src);
+
+    if(!dst)
+        return -1;
+
+    // create the directories of the file
+    char dir[FILENAME_MAX + 1];
+    strncpyz(dir, dst_filename, FILENAME_MAX);
+    for(char *s = &dir[1]; *s ; s++) {
+        if(*s == '/') {
+            *s = '\0';
+            if(mkdir(dir, 0755) == -1 && errno != EEXIST) {
+                error("Cannot create directory '%s' for precompressed web files.", dir);
+                freez(dst);
+                return -1;
+            }
+            *s = '/';
+        }
+    }
+
+    // write it to a temporary file and rename it,
+    // so that concurrent requests never see a partial file
+    char tmp_filename[FILENAME_MAX + 1];
+    snprintfz(tmp_filename, FILENAME_MAX, "%s.%d.tmp", dst_filename, gettid());
+
+    int ret = -1;
+    fd = open(tmp_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd != -1) {
+        bytes = 0;
+        while(bytes < dst_len) {
+            ssize_t w = write(fd, &((char *)dst)[bytes], dst_len - bytes);
+            if(w <= 0) break;
+            bytes += w;
+        }
+
+        // the precompressed file gets the modification time of the original,
+        // so that we can detect when the original changes
+        struct timespec times[2] = {
+                { .tv_sec = stat_mtime(src_st), .tv_nsec = 0 },
+                { .tv_sec = stat_mtime(src_st), .tv_nsec = 0 },
+        };
+
+        if(bytes == dst_len && futimens(fd, times) == 0 && close(fd) == 0) {
+            if(rename(tmp_filename, dst_filename) == 0)
+                ret = 0;
+        }
+        else
+            close(fd);
+
+        if(ret != 0) {
+            error("Cannot save precompressed web file '%s'.", dst_filename);
+            unlink(tmp_filename);
+        }
+    }
+    else
+        error("Cannot create precompressed web file '%s'.", tmp_filename);
+
+    freez(dst);
+    return ret;
+}
+
+// returns an open file descriptor of the precompressed variant of the file,
+// or -1 when it is not available
+static int web_precompressed_get(const char *webfilename, struct stat *src_st, WEB_CONTENT_ENCODING encoding, struct stat *st) {
+    const char *ext = web_content_encoding2extension(encoding);
+    if(!ext) return -1;
+
+    char filename[FILENAME_MAX + 1];
+
+    // a precompressed file next to the original
+    snprintfz(filename, FILENAME_MAX, "%s%s", webfilename, ext);
+    int fd = web_precompressed_open(filename, src_st, st, false);
+    if(fd != -1) return fd;
+
+    // a precompressed file in our cache
+    const char *relative = webfilename;
+    size_t web_dir_len = strlen(netdata_configured_web_dir);
+    if(!strncmp(relative, netdata_configured_web_dir, web_dir_len))
+        relative += web_dir_len;
+    while(*relative == '/') relative++;
+
+    snprintfz(filename, FILENAME_MAX, "%s/web/%s%s", netdata_configured_cache_dir, relative, ext);
+    fd = web_precompressed_open(filename, src_st, st, true);
+    if(fd != -1) return fd;
+
+    if(web_precompressed_create(webfilename, src_st, filename, encoding) != 0)
+        return -1;
+
+    return web_precompressed_open(filename, src_st, st, true);
+}
+#endif // NETDATA_WITH_WEB_COMPRESSION
+
 static inline int access_to_file_is_not_permitted(struct web_client *w, const char *filename) {
     w->response.data->contenttype = CT_TEXT_HTML;
     buffer_strcat(w->response.data, "Access to file is not permitted: ");
@@ -340,8 +926,39 @@ int mysendfile(struct web_client *w, char *filename) {
         done = 1;
     }
 
+    w->response.data->contenttype = contenttype_for_filename(webfilename);
+
+    // decide how the file will be compressed
+    // files that do not compress well are sent as they are
+    w->ifd = -1;
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+    if(w->response.zoutput) {
+        if(!contenttype_is_compressible(w->response.data->contenttype) || statbuf.st_size < WEB_PRECOMPRESS_MIN_SIZE)
+            web_client_disable_compression(w);
+
+        else if(web_precompress_static_files) {
+            struct stat zstatbuf;
+            WEB_CONTENT_ENCODING encoding = w->response.encoding;
+            int fd = web_precompressed_get(webfilename, &statbuf, encoding, &zstatbuf);
+            if(fd != -1) {
+                if(zstatbuf.st_size < statbuf.st_size) {
+                    // send the precompressed file as-is
+                    web_client_disable_compression(w);
+                    w->response.encoding = encoding;
+                    w->ifd = fd;
+                    statbuf = zstatbuf;
+                }
+                else
+                    close(fd);
+            }
+        }
+    }
+#endif
+
     // open the file
-    w->ifd = open(webfilename, O_NONBLOCK, O_RDONLY);
+    if(w->ifd == -1)
+        w->ifd = open(webfilename, O_NONBLOCK, O_RDONLY);
+
     if(w->ifd == -1) {
         w->ifd = w->ofd;
 
@@ -364,75 +981,36 @@ int mysendfile(struct web_client *w, char *filename) {
 
     sock_setnonblock(w->ifd);
 
-    w->response.data->contenttype = contenttype_for_filename(webfilename);
-    debug(D_WEB_CLIENT_ACCESS, "%llu: Sending file '%s' (%"PRId64" bytes, ifd %d, ofd %d).", w->id, webfilename, (int64_t)statbuf.st_size, w->ifd, w->ofd);
+    debug(D_WEB_CLIENT_ACCESS, "%llu: Sending file '%s' (%"PRId64" bytes, encoding %s, ifd %d, ofd %d).", w->id, webfilename, (int64_t)statbuf.st_size, web_content_encoding2str(w->response.encoding), w->ifd, w->ofd);
 
     w->mode = WEB_CLIENT_MODE_FILECOPY;
-    web_client_enable_wait_receive(w);
-    web_client_disable_wait_send(w);
     buffer_flush(w->response.data);
-    buffer_need_bytes(w->response.data, (size_t)statbuf.st_size);
     w->response.rlen = (size_t)statbuf.st_size;
-#ifdef __APPLE__
-    w->response.data->date = statbuf.st_mtimespec.tv_sec;
-#else
-    w->response.data->date = statbuf.st_mtim.tv_sec;
-#endif 
-    buffer_cacheable(w->response.data);
-
-    return HTTP_RESP_OK;
-}
-#endif
-
-
 
-#ifdef NETDATA_WITH_ZLIB
-void web_client_enable_deflate(struct web_client *w, int gzip) {
-    if(unlikely(w->response.zinitialized)) {
-        debug(D_DEFLATE, "%llu: Compression has already be initialized for this client.", w->id);
-        return;
+#ifdef WEB_CLIENT_HAVE_SENDFILE
+    if(!w->response.zoutput && !web_client_uses_tls(w)) {
+        // the kernel will copy the file to the socket
+        web_client_flag_set(w, WEB_CLIENT_FLAG_SENDFILE);
+        web_client_disable_wait_receive(w);
+        web_client_enable_wait_send(w);
     }
-
-    if(unlikely(w->response.sent)) {
-        error("%llu: Cannot enable compression in the middle of a conversation.", w->id);
-        return;
+    else
+#endif
+    {
+        web_client_enable_wait_receive(w);
+        web_client_disable_wait_send(w);
+        buffer_need_bytes(w->response.data, (size_t)statbuf.st_size);
     }
 
-    w->response.zstream.zalloc = Z_NULL;
-    w->response.zstream.zfree = Z_NULL;
-    w->response.zstream.opaque = Z_NULL;
-
-    w->response.zstream.next_in = (Bytef *)w->response.data->buffer;
-    w->response.zstream.avail_in = 0;
-    w->response.zstream.total_in = 0;
-
-    w->response.zstream.next_out = w->response.zbuffer;
-    w->response.zstream.avail_out = 0;
-    w->response.zstream.total_out = 0;
-
-    w->response.zstream.zalloc = Z_NULL;
-    w->response.zstream.zfree = Z_NULL;
-    w->response.zstream.opaque = Z_NULL;
+    w->response.data->date = stat_mtime(&statbuf);
+    buffer_cacheable(w->response.data);
 
-//  if(deflateInit(&w->response.zstream, Z_DEFAULT_COMPRESSION) != Z_OK) {
-//      error("%llu: Failed to initialize zlib. Proceeding without compression.", w->id);
-//      return;
-//  }
+    return HTTP_RESP_OK;
+}
+#endif
 
-    // Select GZIP compression: windowbits = 15 + 16 = 31
-    if(deflateInit2(&w->response.zstream, web_gzip_level, Z_DEFLATED, 15 + ((gzip)?16:0), 8, web_gzip_strategy) != Z_OK) {
-        error("%llu: Failed to initialize zlib. Proceeding without compression.", w->id);
-        return;
-    }
 
-    w->response.zsent = 0;
-    w->response.zoutput = 1;
-    w->response.zinitialized = 1;
-    w->flags |= WEB_CLIENT_CHUNKED_TRANSFER;
 
-    debug(D_DEFLATE, "%llu: Initialized compression.", w->id);
-}
-#endif // NETDATA_WITH_ZLIB
 
 void buffer_data_options2string(BUFFER *wb, uint32_t options) {
     int count = 0;
@@ -668,14 +1246,14 @@ const char *web_response_code_to_string(int code) {
 static inline char *http_header_parse(struct web_client *w, char *s, int parse_useragent) {
     static uint32_t hash_origin = 0, hash_connection = 0, hash_donottrack = 0, hash_useragent = 0,
                     hash_authorization = 0, hash_host = 0, hash_forwarded_proto = 0, hash_forwarded_host = 0;
-#ifdef NETDATA_WITH_ZLIB
+#ifdef NETDATA_WITH_WEB_COMPRESSION
     static uint32_t hash_accept_encoding = 0;
 #endif
 
     if(unlikely(!hash_origin)) {
         hash_origin = simple_uhash("Origin");
         hash_connection = simple_uhash("Connection");
-#ifdef NETDATA_WITH_ZLIB
+#ifdef NETDATA_WITH_WEB_COMPRESSION
         hash_accept_encoding = simple_uhash("Accept-Encoding");
 #endif
         hash_donottrack = simple_uhash("DNT");
@@ -720,6 +1298,8 @@ static inline char *http_header_parse(struct web_client *w, char *s, int parse_u
     else if(hash == hash_connection && !strcasecmp(s, "Connection")) {
         if(strcasestr(v, "keep-alive"))
             web_client_enable_keepalive(w);
+        else if(strcasestr(v, "close"))
+            web_client_enable_half_close(w);
     }
     else if(respect_web_browser_do_not_track_policy && hash == hash_donottrack && !strcasecmp(s, "DNT")) {
         if(*v == '0') web_client_disable_donottrack(w);
@@ -733,18 +1313,11 @@ static inline char *http_header_parse(struct web_client *w, char *s, int parse_u
     else if(hash == hash_host && !strcasecmp(s, "Host")){
         strncpyz(w->server_host, v, ((size_t)(ve - v) < sizeof(w->server_host)-1 ? (size_t)(ve - v) : sizeof(w->server_host)-1));
     }
-#ifdef NETDATA_WITH_ZLIB
+#ifdef NETDATA_WITH_WEB_COMPRESSION
     else if(hash == hash_accept_encoding && !strcasecmp(s, "Accept-Encoding")) {
-        if(web_enable_gzip) {
-            if(strcasestr(v, "gzip"))
-                web_client_enable_deflate(w, 1);
-            //
-            // does not seem to work
-            // else if(strcasestr(v, "deflate"))
-            //  web_client_enable_deflate(w, 0);
-        }
+        web_client_negotiate_compression(w, v);
     }
-#endif /* NETDATA_WITH_ZLIB */
+#endif /* NETDATA_WITH_WEB_COMPRESSION */
 #ifdef ENABLE_HTTPS
     else if(hash == hash_forwarded_proto && !strcasecmp(s, "X-Forwarded-Proto")) {
         if(strcasestr(v, "https"))
@@ -962,6 +1535,9 @@ static inline HTTP_VALIDATION http_request_validate(struct web_client *w) {
     // we have the end of encoded_url - remember it
     char *ue = s;
 
+    if(!strncmp(ue, " HTTP/1.0", 9))
+        web_client_enable_half_close(w);
+
     //Variables used to map the variables in the query string case it is present
     int total_variables;
     char *ptr_variables[WEB_FIELDS_MAX];
@@ -1176,8 +1752,10 @@ void web_client_build_http_header(struct web_client *w) {
         buffer_strcat(w->response.header_output, buffer_tostring(w->response.header));
 
     // headers related to the transfer method
-    if(likely(w->response.zoutput))
-        buffer_strcat(w->response.header_output, "Content-Encoding: gzip\r\n");
+    if(likely(w->response.encoding != WEB_CONTENT_ENCODING_NONE)) {
+        buffer_sprintf(w->response.header_output, "Content-Encoding: %s\r\n", web_content_encoding2str(w->response.encoding));
+        buffer_strcat(w->response.header_output, "Vary: Accept-Encoding\r\n");
+    }
 
     if(likely(w->flags & WEB_CLIENT_CHUNKED_TRANSFER))
         buffer_strcat(w->response.header_output, "Transfer-Encoding: chunked\r\n");
@@ -1575,7 +2153,11 @@ void web_client_process_request(struct web_client *w) {
             break;
 
         case WEB_CLIENT_MODE_FILECOPY:
-            if(w->response.rlen) {
+            if(w->response.rlen && web_client_flag_check(w, WEB_CLIENT_FLAG_SENDFILE)) {
+                debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be copying data file of %zu bytes to client with sendfile().", w->id, w->response.rlen);
+                web_client_enable_wait_send(w);
+            }
+            else if(w->response.rlen) {
                 debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be sending data file of %zu bytes to client.", w->id, w->response.rlen);
                 web_client_enable_wait_receive(w);
 
@@ -1671,100 +2253,83 @@ ssize_t web_client_send_chunk_finalize(struct web_client *w)
     return bytes;
 }
 
-#ifdef NETDATA_WITH_ZLIB
-ssize_t web_client_send_deflate(struct web_client *w)
+static inline ssize_t web_client_send_done(struct web_client *w) {
+    if(unlikely(!web_client_has_keepalive(w))) {
+        debug(D_WEB_CLIENT, "%llu: Closing (keep-alive is not enabled). %zu bytes sent.", w->id, w->response.sent);
+        WEB_CLIENT_IS_DEAD(w);
+        return 0;
+    }
+
+    web_client_request_done(w);
+    debug(D_WEB_CLIENT, "%llu: Done sending all data on socket. Waiting for next request on the same socket.", w->id);
+    return 0;
+}
+
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+ssize_t web_client_send_compressed(struct web_client *w)
 {
     ssize_t len = 0, t = 0;
 
     // when using compression,
     // w->response.sent is the amount of bytes passed through compression
 
-    debug(D_DEFLATE, "%llu: web_client_send_deflate(): w->response.data->len = %zu, w->response.sent = %zu, w->response.zhave = %zu, w->response.zsent = %zu, w->response.zstream.avail_in = %u, w->response.zstream.avail_out = %u, w->response.zstream.total_in = %lu, w->response.zstream.total_out = %lu.",
-        w->id, w->response.data->len, w->response.sent, w->response.zhave, w->response.zsent, w->response.zstream.avail_in, w->response.zstream.avail_out, w->response.zstream.total_in, w->response.zstream.total_out);
+    debug(D_DEFLATE, "%llu: web_client_send_compressed(): encoding = %s, w->response.data->len = %zu, w->response.sent = %zu, w->response.zin = %zu, w->response.zhave = %zu, w->response.zsent = %zu, w->response.ztotal = %zu.",
+        w->id, web_content_encoding2str(w->response.encoding), w->response.data->len, w->response.sent, w->response.zin, w->response.zhave, w->response.zsent, w->response.ztotal);
 
-    if(w->response.data->len - w->response.sent == 0 && w->response.zstream.avail_in == 0 && w->response.zhave == w->response.zsent && w->response.zstream.avail_out != 0) {
-        // there is nothing to send
+    if(w->response.zhave == w->response.zsent) {
+        // ask for FINISH if we have all the input
+        bool finish = (w->mode == WEB_CLIENT_MODE_NORMAL
+                       || (w->mode == WEB_CLIENT_MODE_FILECOPY && !web_client_has_wait_receive(w) && w->response.data->len == w->response.rlen));
 
-        debug(D_WEB_CLIENT, "%llu: Out of output data.", w->id);
+        if(w->response.zin == w->response.data->len && !w->response.zpending && (w->response.zfinished || !finish)) {
+            // there is nothing to send
+
+            debug(D_WEB_CLIENT, "%llu: Out of output data.", w->id);
 
-        // finalize the chunk
-        if(w->response.sent != 0) {
+            if(!w->response.zfinished) {
+                // we have to wait, more data will come
+                debug(D_WEB_CLIENT, "%llu: Waiting for more data to become available.", w->id);
+                web_client_disable_wait_send(w);
+                return 0;
+            }
+
+            // finalize the chunk
             t = web_client_send_chunk_finalize(w);
             if(t < 0) return t;
-        }
 
-        if(w->mode == WEB_CLIENT_MODE_FILECOPY && web_client_has_wait_receive(w) && w->response.rlen && w->response.rlen > w->response.data->len) {
-            // we have to wait, more data will come
-            debug(D_WEB_CLIENT, "%llu: Waiting for more data to become available.", w->id);
-            web_client_disable_wait_send(w);
+            web_client_send_done(w);
             return t;
         }
 
-        if(unlikely(!web_client_has_keepalive(w))) {
-            debug(D_WEB_CLIENT, "%llu: Closing (keep-alive is not enabled). %zu bytes sent.", w->id, w->response.sent);
-            WEB_CLIENT_IS_DEAD(w);
-            return t;
-        }
-
-        // reset the client
-        web_client_request_done(w);
-        debug(D_WEB_CLIENT, "%llu: Done sending all data on socket.", w->id);
-        return t;
-    }
-
-    if(w->response.zhave == w->response.zsent) {
         // compress more input data
 
-        // close the previous open chunk
-        if(w->response.sent != 0) {
-            t = web_client_send_chunk_close(w);
-            if(t < 0) return t;
-        }
-
-        debug(D_DEFLATE, "%llu: Compressing %zu new bytes starting from %zu (and %u left behind).", w->id, (w->response.data->len - w->response.sent), w->response.sent, w->response.zstream.avail_in);
-
-        // give the compressor all the data not passed through the compressor yet
-        if(w->response.data->len > w->response.sent) {
-            w->response.zstream.next_in = (Bytef *)&w->response.data->buffer[w->response.sent - w->response.zstream.avail_in];
-            w->response.zstream.avail_in += (uInt) (w->response.data->len - w->response.sent);
-        }
-
-        // reset the compressor output buffer
-        w->response.zstream.next_out = w->response.zbuffer;
-        w->response.zstream.avail_out = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE;
-
-        // ask for FINISH if we have all the input
-        int flush = Z_SYNC_FLUSH;
-        if(w->mode == WEB_CLIENT_MODE_NORMAL
-            || (w->mode == WEB_CLIENT_MODE_FILECOPY && !web_client_has_wait_receive(w) && w->response.data->len == w->response.rlen)) {
-            flush = Z_FINISH;
-            debug(D_DEFLATE, "%llu: Requesting Z_FINISH, if possible.", w->id);
-        }
-        else {
-            debug(D_DEFLATE, "%llu: Requesting Z_SYNC_FLUSH.", w->id);
-        }
+        debug(D_DEFLATE, "%llu: Compressing %zu new bytes starting from %zu, %s.", w->id, (w->response.data->len - w->response.zin), w->response.zin, finish ? "finishing" : "flushing");
 
-        // compress
-        if(deflate(&w->response.zstream, flush) == Z_STREAM_ERROR) {
+        if(web_client_compress(w, finish) != 0) {
             error("%llu: Compression failed. Closing down client.", w->id);
             web_client_request_done(w);
             return(-1);
         }
 
-        w->response.zhave = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE - w->response.zstream.avail_out;
-        w->response.zsent = 0;
+        debug(D_DEFLATE, "%llu: Compression produced %zu bytes.", w->id, w->response.zhave);
 
-        // keep track of the bytes passed through the compressor
-        w->response.sent = w->response.data->len;
+        if(!w->response.zhave)
+            return 0;
 
-        debug(D_DEFLATE, "%llu: Compression produced %zu bytes.", w->id, w->response.zhave);
+        // close the previous open chunk
+        if(w->response.ztotal != 0) {
+            t = web_client_send_chunk_close(w);
+            if(t < 0) return t;
+        }
+
+        w->response.ztotal += w->response.zhave;
 
         // open a new chunk
         ssize_t t2 = web_client_send_chunk_header(w, w->response.zhave);
         if(t2 < 0) return t2;
         t += t2;
     }
-    
+
     debug(D_WEB_CLIENT, "%llu: Sending %zu bytes of data (+%zd of chunk header).", w->id, w->response.zhave - w->response.zsent, t);
 
     len = web_client_send_data(w,&w->response.zbuffer[w->response.zsent], (size_t) (w->response.zhave - w->response.zsent), MSG_DONTWAIT);
@@ -1786,12 +2351,46 @@ ssize_t web_client_send_deflate(struct web_client *w)
 
     return(len);
 }
-#endif // NETDATA_WITH_ZLIB
+#endif // NETDATA_WITH_WEB_COMPRESSION
+
+#ifdef WEB_CLIENT_HAVE_SENDFILE
+static ssize_t web_client_sendfile(struct web_client *w) {
+    if(unlikely(w->response.sent >= w->response.rlen)) {
+        debug(D_WEB_CLIENT, "%llu: Done copying file with sendfile().", w->id);
+        return web_client_send_done(w);
+    }
+
+    off_t offset = (off_t)w->response.sent;
+    ssize_t bytes = sendfile(w->ofd, w->ifd, &offset, w->response.rlen - w->response.sent);
+    if(likely(bytes > 0)) {
+        w->stats_sent_bytes += bytes;
+        w->response.sent += bytes;
+        debug(D_WEB_CLIENT, "%llu: Sent %zd bytes with sendfile().", w->id, bytes);
+    }
+    else if(bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        debug(D_WEB_CLIENT, "%llu: Did not send any bytes to the client.", w->id);
+        bytes = 0;
+    }
+    else {
+        // the file got truncated, or the socket failed
+        error("%llu: sendfile() failed after sending %zu of %zu bytes.", w->id, w->response.sent, w->response.rlen);
+        WEB_CLIENT_IS_DEAD(w);
+        bytes = -1;
+    }
+
+    return bytes;
+}
+#endif // WEB_CLIENT_HAVE_SENDFILE
 
 ssize_t web_client_send(struct web_client *w) {
-#ifdef NETDATA_WITH_ZLIB
-    if(likely(w->response.zoutput)) return web_client_send_deflate(w);
-#endif // NETDATA_WITH_ZLIB
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+    if(likely(w->response.zoutput)) return web_client_send_compressed(w);
+#endif // NETDATA_WITH_WEB_COMPRESSION
+
+#ifdef WEB_CLIENT_HAVE_SENDFILE
+    if(w->mode == WEB_CLIENT_MODE_FILECOPY && web_client_flag_check(w, WEB_CLIENT_FLAG_SENDFILE))
+        return web_client_sendfile(w);
+#endif // WEB_CLIENT_HAVE_SENDFILE
 
     ssize_t bytes;
 
@@ -1811,15 +2410,7 @@ ssize_t web_client_send(struct web_client *w) {
             return 0;
         }
 
-        if(unlikely(!web_client_has_keepalive(w))) {
-            debug(D_WEB_CLIENT, "%llu: Closing (keep-alive is not enabled). %zu bytes sent.", w->id, w->response.sent);
-            WEB_CLIENT_IS_DEAD(w);
-            return 0;
-        }
-
-        web_client_request_done(w);
-        debug(D_WEB_CLIENT, "%llu: Done sending all data on socket. Waiting for next request on the same socket.", w->id);
-        return 0;
+        return web_client_send_done(w);
     }
 
     bytes = web_client_send_data(w,&w->response.data->buffer[w->response.sent], w->response.data->len - w->response.sent, MSG_DONTWAIT);
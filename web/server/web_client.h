@@ -9,6 +9,32 @@
 extern int web_enable_gzip, web_gzip_level, web_gzip_strategy;
 #endif /* NETDATA_WITH_ZLIB */
 
+#ifdef NETDATA_WITH_ZSTD
+#include <zstd.h>
+extern int web_enable_zstd, web_zstd_level;
+#endif /* NETDATA_WITH_ZSTD */
+
+#ifdef NETDATA_WITH_BROTLI
+#include <brotli/encode.h>
+extern int web_enable_brotli, web_brotli_quality;
+#endif /* NETDATA_WITH_BROTLI */
+
+#if defined(NETDATA_WITH_ZLIB) || defined(NETDATA_WITH_ZSTD) || defined(NETDATA_WITH_BROTLI)
+// responses can be compressed with at least one encoding
+#define NETDATA_WITH_WEB_COMPRESSION 1
+#endif
+
+extern int web_precompress_static_files;
+
+typedef enum web_content_encoding {
+    WEB_CONTENT_ENCODING_NONE = 0,
+    WEB_CONTENT_ENCODING_GZIP,
+    WEB_CONTENT_ENCODING_ZSTD,
+    WEB_CONTENT_ENCODING_BROTLI,
+} WEB_CONTENT_ENCODING;
+
+const char *web_content_encoding2str(WEB_CONTENT_ENCODING encoding);
+
 // HTTP_CODES 2XX Success
 #define HTTP_RESP_OK 200
 
@@ -71,6 +97,10 @@ typedef enum web_client_flags {
     WEB_CLIENT_FLAG_DONT_CLOSE_SOCKET = 1 << 9, // don't close the socket when cleaning up (static-threaded web server)
 
     WEB_CLIENT_CHUNKED_TRANSFER = 1 << 10, // chunked transfer (used with zlib compression)
+
+    WEB_CLIENT_FLAG_SENDFILE = 1 << 11, // the file in ifd is copied to the socket with sendfile()
+
+    WEB_CLIENT_FLAG_HALF_CLOSE = 1 << 12, // the client may close its sending side and wait for the response (HTTP/1.0, Connection: close)
 } WEB_CLIENT_FLAGS;
 
 #define web_client_flag_check(w, flag) ((w)->flags & (flag))
@@ -84,6 +114,10 @@ typedef enum web_client_flags {
 #define web_client_enable_keepalive(w) web_client_flag_set(w, WEB_CLIENT_FLAG_KEEPALIVE)
 #define web_client_disable_keepalive(w) web_client_flag_clear(w, WEB_CLIENT_FLAG_KEEPALIVE)
 
+#define web_client_may_half_close(w) web_client_flag_check(w, WEB_CLIENT_FLAG_HALF_CLOSE)
+#define web_client_enable_half_close(w) web_client_flag_set(w, WEB_CLIENT_FLAG_HALF_CLOSE)
+#define web_client_disable_half_close(w) web_client_flag_clear(w, WEB_CLIENT_FLAG_HALF_CLOSE)
+
 #define web_client_has_donottrack(w) web_client_flag_check(w, WEB_CLIENT_FLAG_DO_NOT_TRACK)
 #define web_client_enable_donottrack(w) web_client_flag_set(w, WEB_CLIENT_FLAG_DO_NOT_TRACK)
 #define web_client_disable_donottrack(w) web_client_flag_clear(w, WEB_CLIENT_FLAG_DO_NOT_TRACK)
@@ -126,14 +160,27 @@ struct response {
     size_t rlen; // if non-zero, the excepted size of ifd (input of firecopy)
     size_t sent; // current data length sent to output
 
+    WEB_CONTENT_ENCODING encoding; // the Content-Encoding of the response (compressed on the fly, or precompressed)
     int zoutput; // if set to 1, web_client_send() will send compressed data
 #ifdef NETDATA_WITH_ZLIB
     z_stream zstream;                                    // zlib stream for sending compressed output to client
-    Bytef zbuffer[NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE]; // temporary buffer for storing compressed output
+#endif /* NETDATA_WITH_ZLIB */
+#ifdef NETDATA_WITH_WEB_COMPRESSION
+    unsigned char zbuffer[NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE]; // temporary buffer for storing compressed output
     size_t zsent;                                        // the compressed bytes we have sent to the client
-    size_t zhave;                                        // the compressed bytes that we have received from zlib
+    size_t zhave;                                        // the compressed bytes that we have received from the compressor
+    size_t zin;                                          // the bytes of data consumed by the compressor
+    size_t ztotal;                                       // the compressed bytes produced so far
     unsigned int zinitialized : 1;
-#endif /* NETDATA_WITH_ZLIB */
+    unsigned int zpending : 1;                           // the compressor has more output to give us
+    unsigned int zfinished : 1;                          // the compressor has written the end of the stream
+#endif /* NETDATA_WITH_WEB_COMPRESSION */
+#ifdef NETDATA_WITH_ZSTD
+    ZSTD_CCtx *zstd;                                     // kept across requests of the same client
+#endif /* NETDATA_WITH_ZSTD */
+#ifdef NETDATA_WITH_BROTLI
+    BrotliEncoderState *brotli;
+#endif /* NETDATA_WITH_BROTLI */
 };
 
 struct web_client {
@@ -201,10 +248,12 @@ ssize_t web_client_read_file(struct web_client *w);
 
 void web_client_process_request(struct web_client *w);
 void web_client_request_done(struct web_client *w);
+bool web_client_interrupt_callback(void *data);
 
 void buffer_data_options2string(BUFFER *wb, uint32_t options);
 
 int mysendfile(struct web_client *w, char *filename);
+void web_client_free_compressors(struct web_client *w);
 
 void web_client_build_http_header(struct web_client *w);
 char *strip_control_characters(char *url);
@@ -33,6 +33,11 @@ static void web_client_zero(struct web_client *w) {
     BUFFER *b2 = w->response.header;
     BUFFER *b3 = w->response.header_output;
 
+#ifdef NETDATA_WITH_ZSTD
+    // keep the zstd compression context too
+    ZSTD_CCtx *zstd = w->response.zstd;
+#endif
+
     // empty the buffers
     buffer_flush(b1);
     buffer_flush(b2);
@@ -47,9 +52,14 @@ static void web_client_zero(struct web_client *w) {
     w->response.data = b1;
     w->response.header = b2;
     w->response.header_output = b3;
+
+#ifdef NETDATA_WITH_ZSTD
+    w->response.zstd = zstd;
+#endif
 }
 
 static void web_client_free(struct web_client *w) {
+    web_client_free_compressors(w);
     buffer_free(w->response.header_output);
     buffer_free(w->response.header);
     buffer_free(w->response.data);